@@ -49,6 +49,7 @@ ExternalProject_Add(
              -DWITH_CORE_TOOLS=OFF
              -DWITH_TOOLS=OFF
              -DWITH_TRACE_TOOLS=OFF
+             -DWITH_ZLIB=ON
   ${_overwrite_install_command}
   BUILD_BYPRODUCTS "${SPEEDB_LIBRARY}"
   UPDATE_COMMAND ""
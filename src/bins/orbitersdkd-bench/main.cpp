@@ -0,0 +1,335 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../../tests/sdktestsuite.hpp"
+#include "../../../tests/evmbytecodes.hpp"
+#include "../../contract/templates/erc20.h"
+#include "../../contract/templates/nativewrapper.h"
+#include "../../contract/templates/dexv2/dexv2factory.h"
+#include "../../contract/templates/dexv2/dexv2router02.h"
+
+/**
+ * End-to-end block processing benchmarks.
+ * Every workload runs on its own fresh chain (built with SDKTestSuite), funds one
+ * sender per transaction slot, then produces blocks of `txsPerBlock` transactions
+ * and times State::processNextBlock() for each one (signing, block building and
+ * validation are left out of the measurement). Results are written as JSON.
+ *
+ * Usage: orbitersdkd-bench [--blocks N] [--txs N] [--parallel] [--only WORKLOAD] [--output FILE|-]
+ */
+
+/// Benchmark parameters, from the command line.
+struct BenchParams {
+  uint64_t blocks = 20;                           ///< Measured blocks per workload.
+  uint64_t txsPerBlock = 500;                     ///< Transactions per block (one per sender).
+  bool parallel = false;                          ///< Whether to turn on parallel execution.
+  std::string only;                               ///< Run only the workload with this name (all if empty).
+  std::string output = "orbitersdkd-bench.json";  ///< Where to write the results ("-" for stdout).
+};
+
+/// Timings of a single workload.
+struct BenchResult {
+  std::string name;               ///< Workload name.
+  uint64_t txs = 0;               ///< Total measured transactions.
+  std::vector<double> latencies;  ///< Time taken by every measured block, in milliseconds.
+};
+
+/// Microseconds since epoch, used for block timestamps and DEX deadlines.
+uint64_t nowMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::system_clock::now().time_since_epoch()
+  ).count();
+}
+
+/// Encode a contract call (functor + arguments), the same way SDKTestSuite::callFunction() does.
+template <typename... Args> Bytes encodeCall(const std::string& func, const Args&... args) {
+  Functor functor = ABI::FunctorEncoder::encode<Args...>(func);
+  Bytes data(functor.cbegin(), functor.cend());
+  if constexpr (sizeof...(Args) > 0) Utils::appendBytes(data, ABI::Encoder::encodeData<Args...>(args...));
+  return data;
+}
+
+/// Sign a transaction with an explicit nonce (SDKTestSuite::createNewTx() always takes the account's current one).
+TxBlock signTx(
+  SDKTestSuite& sdk, const TestAccount& from, const Address& to,
+  const uint256_t& value, const Bytes& data, uint64_t nonce
+) {
+  return TxBlock(to, from.address, data, sdk.getOptions().getChainID(),
+    nonce, value, 1000000000, 1000000000, 250000, from.privKey
+  );
+}
+
+/// Produce and process a setup block, without SDKTestSuite::advanceChain()'s progress output.
+void setupBlock(SDKTestSuite& sdk, const std::vector<TxBlock>& txs) {
+  Block block = sdk.createNewBlock(0, txs);
+  if (!sdk.getState().validateNextBlock(block)) throw DynamicException("Benchmark setup block is not valid");
+  sdk.getState().processNextBlock(std::move(block));
+}
+
+/// Send one transaction from the chain owner to every sender in a single block (e.g. to hand out tokens).
+void fundSenders(
+  SDKTestSuite& sdk, const std::vector<TestAccount>& senders,
+  const std::function<std::pair<Address, Bytes>(const TestAccount&)>& makeCall
+) {
+  const TestAccount owner = sdk.getChainOwnerAccount();
+  uint64_t nonce = sdk.getNativeNonce(owner.address);
+  std::vector<TxBlock> txs;
+  txs.reserve(senders.size());
+  for (const TestAccount& sender : senders) {
+    auto [to, data] = makeCall(sender);
+    txs.push_back(signTx(sdk, owner, to, 0, data, nonce++));
+  }
+  setupBlock(sdk, txs);
+}
+
+/**
+ * Produce and process the measured blocks of a workload.
+ * @param sdk The chain to run on.
+ * @param params The benchmark parameters.
+ * @param senders One account per transaction slot.
+ * @param makeTx Build the transaction of a sender for the current block.
+ * @param result Where to record the timings.
+ */
+void runBlocks(
+  SDKTestSuite& sdk, const BenchParams& params, const std::vector<TestAccount>& senders,
+  const std::function<TxBlock(const TestAccount&)>& makeTx, BenchResult& result
+) {
+  for (uint64_t i = 0; i < params.blocks; i++) {
+    std::vector<TxBlock> txs;
+    txs.reserve(senders.size());
+    for (const TestAccount& sender : senders) txs.push_back(makeTx(sender));
+    Block block = sdk.createNewBlock(0, txs);
+    if (!sdk.getState().validateNextBlock(block)) throw DynamicException(
+      "Benchmark block " + std::to_string(i) + " of " + result.name + " is not valid"
+    );
+    auto start = std::chrono::steady_clock::now();
+    sdk.getState().processNextBlock(std::move(block));
+    auto end = std::chrono::steady_clock::now();
+    result.latencies.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    result.txs += txs.size();
+  }
+}
+
+/// Create a fresh chain for a workload, with every sender funded at genesis.
+SDKTestSuite createChain(const std::string& name, const BenchParams& params, std::vector<TestAccount>& senders) {
+  senders.clear();
+  for (uint64_t i = 0; i < params.txsPerBlock; i++) senders.push_back(TestAccount::newRandomAccount());
+  return SDKTestSuite::createNewEnvironment("benchmarks/" + name, senders, nullptr, params.parallel);
+}
+
+/// Native transfers between random accounts.
+BenchResult benchNativeTransfers(const BenchParams& params) {
+  BenchResult result{"native_transfer"};
+  std::vector<TestAccount> senders;
+  SDKTestSuite sdk = createChain(result.name, params, senders);
+  runBlocks(sdk, params, senders, [&](const TestAccount& sender) {
+    return sdk.createNewTx(sender, Address(Utils::randBytes(20)), 1000);
+  }, result);
+  return result;
+}
+
+/// Transfers of the C++ ERC20 contract.
+BenchResult benchCppERC20(const BenchParams& params) {
+  BenchResult result{"cpp_erc20_transfer"};
+  std::vector<TestAccount> senders;
+  SDKTestSuite sdk = createChain(result.name, params, senders);
+  Address token = sdk.deployContract<ERC20>(
+    std::string("TestToken"), std::string("TST"), uint8_t(18), uint256_t("1000000000000000000000000000000")
+  );
+  fundSenders(sdk, senders, [&](const TestAccount& sender) {
+    return std::make_pair(token, encodeCall("transfer", sender.address, uint256_t("1000000000000000000000000")));
+  });
+  runBlocks(sdk, params, senders, [&](const TestAccount& sender) {
+    return sdk.createNewTx(sender, token, 0, encodeCall("transfer", Address(Utils::randBytes(20)), uint256_t(1000)));
+  }, result);
+  return result;
+}
+
+/// Transfers of an OpenZeppelin ERC20 running on the EVM.
+BenchResult benchEvmERC20(const BenchParams& params) {
+  BenchResult result{"evm_erc20_transfer"};
+  std::vector<TestAccount> senders;
+  SDKTestSuite sdk = createChain(result.name, params, senders);
+  TxBlock createTx = sdk.createNewTx(sdk.getChainOwnerAccount(), Address(), 0, erc20Bytecode);
+  setupBlock(sdk, {createTx});
+  Address token = sdk.getEvmContractAddress(createTx.hash());
+  fundSenders(sdk, senders, [&](const TestAccount& sender) {
+    return std::make_pair(token, encodeCall("transfer", sender.address, uint256_t("1000000000000000000000")));
+  });
+  runBlocks(sdk, params, senders, [&](const TestAccount& sender) {
+    return sdk.createNewTx(sender, token, 0, encodeCall("transfer", Address(Utils::randBytes(20)), uint256_t(1000)));
+  }, result);
+  return result;
+}
+
+/// Token to token swaps on a single DEXV2 pair.
+BenchResult benchDEXV2Swaps(const BenchParams& params) {
+  BenchResult result{"dexv2_swap"};
+  std::vector<TestAccount> senders;
+  SDKTestSuite sdk = createChain(result.name, params, senders);
+  const uint256_t supply("1000000000000000000000000000000");
+  Address tokenA = sdk.deployContract<ERC20>(std::string("TokenA"), std::string("TKNA"), uint8_t(18), supply);
+  Address tokenB = sdk.deployContract<ERC20>(std::string("TokenB"), std::string("TKNB"), uint8_t(18), supply);
+  Address wrapped = sdk.deployContract<NativeWrapper>(std::string("WSPARQ"), std::string("WSPARQ"), uint8_t(18));
+  Address factory = sdk.deployContract<DEXV2Factory>(Address());
+  Address router = sdk.deployContract<DEXV2Router02>(factory, wrapped);
+  Address owner = sdk.getChainOwnerAccount().address;
+  const uint256_t deadline = nowMicros() + 86400000000; // Far enough for any run
+  sdk.callFunction(tokenA, &ERC20::approve, router, supply);
+  sdk.callFunction(tokenB, &ERC20::approve, router, supply);
+  sdk.callFunction(router, &DEXV2Router02::addLiquidity, tokenA, tokenB,
+    uint256_t("100000000000000000000000000"), uint256_t("100000000000000000000000000"),
+    uint256_t(0), uint256_t(0), owner, deadline
+  );
+
+  // Every sender gets some tokenA and lets the router spend it
+  fundSenders(sdk, senders, [&](const TestAccount& sender) {
+    return std::make_pair(tokenA, encodeCall("transfer", sender.address, uint256_t("1000000000000000000000")));
+  });
+  std::vector<TxBlock> approvals;
+  for (const TestAccount& sender : senders) {
+    approvals.push_back(sdk.createNewTx(sender, tokenA, 0, encodeCall("approve", router, supply)));
+  }
+  setupBlock(sdk, approvals);
+
+  const std::vector<Address> path = {tokenA, tokenB};
+  runBlocks(sdk, params, senders, [&](const TestAccount& sender) {
+    return sdk.createNewTx(sender, router, 0, encodeCall("swapExactTokensForTokens",
+      uint256_t("1000000000000000000"), uint256_t(0), path, sender.address, deadline
+    ));
+  }, result);
+  return result;
+}
+
+/// Block deserialization, which verifies every signature and recovers every sender.
+BenchResult benchBlockDeserialization(const BenchParams& params) {
+  BenchResult result{"block_deserialization"};
+  std::vector<TestAccount> senders;
+  SDKTestSuite sdk = createChain(result.name, params, senders);
+  const uint64_t chainId = sdk.getOptions().getChainID();
+  for (uint64_t i = 0; i < params.blocks; i++) {
+    std::vector<TxBlock> txs;
+    txs.reserve(senders.size());
+    for (const TestAccount& sender : senders) txs.push_back(sdk.createNewTx(sender, Address(Utils::randBytes(20)), 1000));
+    Bytes serialized = sdk.createNewBlock(0, txs).serializeBlock();
+    auto start = std::chrono::steady_clock::now();
+    Block block(serialized, chainId);
+    auto end = std::chrono::steady_clock::now();
+    if (block.getTxs().size() != txs.size()) throw DynamicException("Deserialized block lost transactions");
+    result.latencies.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    result.txs += txs.size();
+  }
+  return result;
+}
+
+/// Summarize a workload's timings as JSON.
+json summarize(const BenchResult& result) {
+  std::vector<double> sorted = result.latencies;
+  std::sort(sorted.begin(), sorted.end());
+  double total = 0;
+  for (const double& latency : sorted) total += latency;
+  auto percentile = [&](double p) {
+    if (sorted.empty()) return 0.0;
+    uint64_t rank = static_cast<uint64_t>(std::ceil(p * sorted.size()));
+    return sorted[std::clamp<uint64_t>(rank, 1, sorted.size()) - 1];
+  };
+  json ret;
+  ret["name"] = result.name;
+  ret["blocks"] = sorted.size();
+  ret["txs"] = result.txs;
+  ret["totalMs"] = total;
+  ret["txsPerSecond"] = (total > 0) ? (result.txs / (total / 1000)) : 0.0;
+  ret["latencyMs"] = {
+    {"min", sorted.empty() ? 0.0 : sorted.front()},
+    {"p50", percentile(0.50)},
+    {"p99", percentile(0.99)},
+    {"max", sorted.empty() ? 0.0 : sorted.back()},
+    {"mean", sorted.empty() ? 0.0 : total / sorted.size()}
+  };
+  return ret;
+}
+
+/// Parse the command line. Returns false (after printing usage) on invalid arguments.
+bool parseArgs(int argc, char* argv[], BenchParams& params) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = (i + 1 < argc);
+    if (arg == "--parallel") {
+      params.parallel = true;
+    } else if (arg == "--blocks" && hasValue) {
+      params.blocks = std::stoull(argv[++i]);
+    } else if (arg == "--txs" && hasValue) {
+      params.txsPerBlock = std::stoull(argv[++i]);
+    } else if (arg == "--only" && hasValue) {
+      params.only = argv[++i];
+    } else if (arg == "--output" && hasValue) {
+      params.output = argv[++i];
+    } else {
+      std::cerr << "Usage: " << argv[0]
+        << " [--blocks N] [--txs N] [--parallel] [--only WORKLOAD] [--output FILE|-]" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  BenchParams params;
+  if (!parseArgs(argc, argv, params)) return 1;
+  if (std::filesystem::exists("benchmarks")) std::filesystem::remove_all("benchmarks");
+  // The SDKTestSuite helpers used for setup (deployContract(), callFunction()) print to stdout,
+  // keep it for the report alone when that's where it goes
+  std::streambuf* stdoutBuf = std::cout.rdbuf();
+  if (params.output == "-") std::cout.rdbuf(std::cerr.rdbuf());
+
+  const std::vector<std::pair<std::string, std::function<BenchResult(const BenchParams&)>>> workloads = {
+    {"native_transfer", benchNativeTransfers},
+    {"cpp_erc20_transfer", benchCppERC20},
+    {"evm_erc20_transfer", benchEvmERC20},
+    {"dexv2_swap", benchDEXV2Swaps},
+    {"block_deserialization", benchBlockDeserialization}
+  };
+
+  json results = json::array();
+  for (const auto& [name, bench] : workloads) {
+    if (!params.only.empty() && params.only != name) continue;
+    std::cerr << "Running " << name << "..." << std::endl;
+    results.push_back(summarize(bench(params)));
+  }
+  if (results.empty()) {
+    std::cerr << "Unknown workload: " << params.only << std::endl;
+    return 1;
+  }
+
+  json report;
+  report["timestamp"] = nowMicros();
+  report["threads"] = std::thread::hardware_concurrency();
+  report["blocks"] = params.blocks;
+  report["txsPerBlock"] = params.txsPerBlock;
+  report["parallelExecution"] = params.parallel;
+  report["workloads"] = results;
+  if (params.output == "-") {
+    std::cout.rdbuf(stdoutBuf);
+    std::cout << report.dump(2) << std::endl;
+  } else {
+    std::ofstream file(params.output);
+    file << report.dump(2) << std::endl;
+    std::cerr << "Results written to " << params.output << std::endl;
+  }
+  return 0;
+}
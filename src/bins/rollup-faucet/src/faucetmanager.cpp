@@ -86,7 +86,7 @@ namespace Faucet {
         // Update nonce
       } catch (std::exception& e) {
         Utils::safePrint("Error while processing dripToAddress: " + std::string(e.what()));
-        Logger::logToDebug(LogType::ERROR, "FaucetManager", __func__,
+        LOGERROR("FaucetManager",
           std::string("Error while processing dripToAddress: ") + e.what()
         );
       }
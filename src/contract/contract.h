@@ -124,7 +124,15 @@ class BaseContract : public ContractLocals {
       this->contractChainId_ = Utils::bytesToUint64(db.get(std::string("contractChainId_"), this->getDBPrefix()));
     }
 
-    virtual ~BaseContract() = default;  ///< Destructor. All derived classes should override it in order to call DB functions.
+    virtual ~BaseContract() = default;  ///< Destructor.
+
+    /**
+     * Append the contract's state to a database batch. Called by ContractManager
+     * for every contract committed to in a block (and for all of them on shutdown),
+     * so derived classes with state to keep should override it, calling their base's dump() first.
+     * @param batch The batch to append to.
+     */
+    virtual void dump(DBBatch& batch) const {}
 
     /**
      * Invoke a contract function using a tuple of (from, to, gasLimit, gasPrice,
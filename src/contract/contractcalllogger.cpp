@@ -21,12 +21,18 @@ ContractCallLogger::~ContractCallLogger() {
   this->manager_.factory_->clearRecentContracts();
   this->balances_.clear();
   this->usedVars_.clear();
+  this->usedContracts_.clear();
 }
 
 void ContractCallLogger::commit() {
   for (auto rbegin = this->usedVars_.rbegin(); rbegin != this->usedVars_.rend(); rbegin++) {
     rbegin->get().commit();
   }
+  // Whatever was just committed has to be persisted with the block
+  this->manager_.dirtyContracts_.insert(this->usedContracts_.begin(), this->usedContracts_.end());
+  for (const Address& newContract : this->manager_.factory_->getRecentContracts()) {
+    this->manager_.dirtyContracts_.insert(newContract);
+  }
 }
 
 void ContractCallLogger::revert() {
@@ -10,6 +10,7 @@ See the LICENSE.txt file in the project root for more information.
 
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "../utils/safehash.h"
 #include "../utils/strings.h"
@@ -44,6 +45,9 @@ class ContractCallLogger {
      */
     std::vector<std::reference_wrapper<SafeBase>> usedVars_;
 
+    /// Contracts that own the variables in `usedVars_`, marked as dirty in the manager on commit.
+    std::unordered_set<Address, SafeHash> usedContracts_;
+
     bool commitCall_ = false; ///< Indicates whether the current call should be committed or not during logger destruction.
     void commit();  ///< Commit all used SafeVariables registered in the list.
     void revert();  ///< Revert all used SafeVariables registered in the list.
@@ -115,9 +119,13 @@ class ContractCallLogger {
 
     /**
      * Add a SafeVariable to the list of used variables.
+     * @param contract The address of the contract that owns the variable.
      * @param var The variable to add to the list.
      */
-    inline void addUsedVar(SafeBase& var) { this->usedVars_.emplace_back(var); }
+    inline void addUsedVar(const Address& contract, SafeBase& var) {
+      this->usedVars_.emplace_back(var);
+      this->usedContracts_.insert(contract);
+    }
 
     /// Tell the state that the current call should be committed on the destructor.
     inline void shouldCommit() { this->commitCall_ = true; }
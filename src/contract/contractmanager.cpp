@@ -45,6 +45,7 @@ ContractManager::~ContractManager() {
       Utils::stringToBytes(contract->getContractName()),
       DBPrefix::contractManager
     );
+    contract->dump(contractsBatch);
   }
   this->db_.putBatch(contractsBatch);
 }
@@ -268,6 +269,23 @@ void ContractManager::commitEvent(Event&& event) {
   this->eventManager_.commitEvent(std::move(event));
 }
 
+uint64_t ContractManager::flushEvents(DBBatch& batch) {
+  return this->eventManager_.flushEvents(batch);
+}
+
+void ContractManager::flushContracts(DBBatch& batch) {
+  std::shared_lock lock(this->contractsMutex_);
+  for (const Address& address : this->dirtyContracts_) {
+    auto it = this->contracts_.find(address);
+    if (it == this->contracts_.end()) continue;
+    batch.push_back(
+      Bytes(address.asBytes()), Utils::stringToBytes(it->second->getContractName()), DBPrefix::contractManager
+    );
+    it->second->dump(batch);
+  }
+  this->dirtyContracts_.clear();
+}
+
 void ContractManager::updateContractGlobals(
   const Address& coinbase, const Hash& blockHash,
   const uint64_t& blockHeight, const uint64_t& blockTimestamp
@@ -282,8 +300,8 @@ void ContractManager::updateRandomGen(RandomGen* randomGen) const {
   ContractGlobals::randomGen_ = randomGen;
 }
 
-void ContractManagerInterface::registerVariableUse(SafeBase& variable) {
-  this->manager_.callLogger_->addUsedVar(variable);
+void ContractManagerInterface::registerVariableUse(const Address& contract, SafeBase& variable) {
+  this->manager_.callLogger_->addUsedVar(contract, variable);
 }
 
 void ContractManagerInterface::populateBalance(const Address &address) const {
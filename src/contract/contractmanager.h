@@ -11,6 +11,7 @@ See the LICENSE.txt file in the project root for more information.
 #include <memory>
 #include <shared_mutex>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "abi.h"
 #include "contract.h"
@@ -58,6 +59,9 @@ class ContractManager : public BaseContract {
     EventManager eventManager_; ///< Event manager object. Responsible for maintaining events emitted in contract calls.
     mutable std::shared_mutex contractsMutex_;  ///< Mutex that manages read/write access to the contracts.
 
+    /// Contracts created or committed to since the last flushContracts().
+    std::unordered_set<Address, SafeHash> dirtyContracts_;
+
     /**
      * Pointer to the contract factory object. Has to be a pointer due to cyclical reference problems.
      * Responsible for actually creating the contracts and deploying them in the contract manager.
@@ -250,6 +254,21 @@ class ContractManager : public BaseContract {
      */
      void commitEvent(Event&& event);
 
+    /**
+     * Move every committed event to a database batch (see EventManager::flushEvents()).
+     * Called by the State once per processed block.
+     * @param batch The batch to append to.
+     * @return The number of flushed events.
+     */
+    uint64_t flushEvents(DBBatch& batch);
+
+    /**
+     * Dump every contract created or committed to since the last flush to a database batch
+     * (see BaseContract::dump()). Called by the State once per processed block.
+     * @param batch The batch to append to.
+     */
+    void flushContracts(DBBatch& batch);
+
     /**
      * Update the ContractGlobals variables
      * Used by the State (when processing a block) to update the variables.
@@ -291,9 +310,10 @@ class ContractManagerInterface {
 
     /**
      * Register a variable that was used a given contract.
+     * @param contract The address of the contract that owns the variable.
      * @param variable Reference to the variable.
      */
-    void registerVariableUse(SafeBase& variable);
+    void registerVariableUse(const Address& contract, SafeBase& variable);
 
     /// Populate a given address with its balance from the State.
     void populateBalance(const Address& address) const;
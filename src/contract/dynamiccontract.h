@@ -62,7 +62,9 @@ class DynamicContract : public BaseContract {
      * Register a variable that was used by the contract.
      * @param variable Reference to the variable.
      */
-    inline void registerVariableUse(SafeBase& variable) { interface_.registerVariableUse(variable); }
+    inline void registerVariableUse(SafeBase& variable) {
+      interface_.registerVariableUse(this->getContractAddress(), variable);
+    }
 
   protected:
     ContractManagerInterface& interface_; ///< Reference to the contract manager interface.
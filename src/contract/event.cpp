@@ -21,6 +21,48 @@ Event::Event(const std::string& jsonstr) {
   this->anonymous_ = obj["anonymous"].get<bool>();
 }
 
+Event::Event(const BytesArrView bytes) {
+  // Fixed part: format + name size + logIndex + txHash + txIndex + blockHash + blockIndex + address + anonymous + topic count
+  if (bytes.size() < 1 + 2 + 8 + 32 + 8 + 32 + 8 + 20 + 1 + 1) throw DynamicException("Serialized event is too short");
+  if (bytes[0] != 0x01) throw DynamicException("Unknown serialized event format: " + std::to_string(bytes[0]));
+  uint64_t index = 1;
+  uint16_t nameSize = Utils::bytesToUint16(bytes.subspan(index, 2)); index += 2;
+  if (bytes.size() < 1 + 2 + nameSize + 8 + 32 + 8 + 32 + 8 + 20 + 1 + 1) throw DynamicException("Serialized event is too short");
+  this->name_ = std::string(bytes.begin() + index, bytes.begin() + index + nameSize); index += nameSize;
+  this->logIndex_ = Utils::bytesToUint64(bytes.subspan(index, 8)); index += 8;
+  this->txHash_ = Hash(bytes.subspan(index, 32)); index += 32;
+  this->txIndex_ = Utils::bytesToUint64(bytes.subspan(index, 8)); index += 8;
+  this->blockHash_ = Hash(bytes.subspan(index, 32)); index += 32;
+  this->blockIndex_ = Utils::bytesToUint64(bytes.subspan(index, 8)); index += 8;
+  this->address_ = Address(bytes.subspan(index, 20)); index += 20;
+  this->anonymous_ = bytes[index] != 0x00; index += 1;
+  uint8_t topicCount = bytes[index]; index += 1;
+  if (bytes.size() < index + (topicCount * 32)) throw DynamicException("Serialized event is too short");
+  for (uint8_t i = 0; i < topicCount; i++) {
+    this->topics_.emplace_back(bytes.subspan(index, 32)); index += 32;
+  }
+  this->data_ = Bytes(bytes.begin() + index, bytes.end());
+}
+
+Bytes Event::serializeToBytes() const {
+  Bytes ret;
+  ret.reserve(1 + 2 + this->name_.size() + 8 + 32 + 8 + 32 + 8 + 20 + 1 + 1 + (this->topics_.size() * 32) + this->data_.size());
+  ret.push_back(0x01);
+  Utils::appendBytes(ret, Utils::uint16ToBytes(uint16_t(this->name_.size())));
+  ret.insert(ret.end(), this->name_.begin(), this->name_.end());
+  Utils::appendBytes(ret, Utils::uint64ToBytes(this->logIndex_));
+  Utils::appendBytes(ret, this->txHash_);
+  Utils::appendBytes(ret, Utils::uint64ToBytes(this->txIndex_));
+  Utils::appendBytes(ret, this->blockHash_);
+  Utils::appendBytes(ret, Utils::uint64ToBytes(this->blockIndex_));
+  Utils::appendBytes(ret, this->address_);
+  ret.push_back(this->anonymous_ ? 0x01 : 0x00);
+  ret.push_back(uint8_t(this->topics_.size()));
+  for (const Hash& topic : this->topics_) Utils::appendBytes(ret, topic);
+  Utils::appendBytes(ret, this->data_);
+  return ret;
+}
+
 std::string Event::serialize() const {
   json topicArr = json::array();
   for (const Hash& b : this->topics_) topicArr.push_back(b.hex(true).get());
@@ -56,59 +98,136 @@ std::string Event::serializeForRPC() const {
   return obj.dump();
 }
 
+EventBloom::EventBloom(const BytesArrView bytes) {
+  if (bytes.size() != this->bits_.size()) throw DynamicException("Invalid event bloom size: " + std::to_string(bytes.size()));
+  std::copy(bytes.begin(), bytes.end(), this->bits_.begin());
+}
+
+void EventBloom::add(const Event& event) {
+  this->add(event.getAddress().view());
+  for (const Hash& topic : event.getTopics()) this->add(topic.view());
+}
+
+void EventBloom::add(const BytesArrView item) {
+  Hash hash = Utils::sha3(item);
+  for (uint64_t i = 0; i < 6; i += 2) {
+    uint16_t bit = ((uint16_t(hash[i]) << 8) | hash[i + 1]) & 2047;
+    this->bits_[255 - (bit / 8)] |= uint8_t(1 << (bit % 8));
+  }
+}
+
+bool EventBloom::mayContain(const BytesArrView item) const {
+  Hash hash = Utils::sha3(item);
+  for (uint64_t i = 0; i < 6; i += 2) {
+    uint16_t bit = ((uint16_t(hash[i]) << 8) | hash[i + 1]) & 2047;
+    if ((this->bits_[255 - (bit / 8)] & uint8_t(1 << (bit % 8))) == 0) return false;
+  }
+  return true;
+}
+
 EventManager::EventManager(
   DB& db, const Options& options
 ) : db_(db), options_(options) {
-  std::vector<DBEntry> allEvents = this->db_.getBatch(DBPrefix::events);
-  for (const DBEntry& event : allEvents) {
-    Event e(Utils::bytesToString(event.value)); // Create a new Event object by deserializing
-    this->events_.insert(std::move(e)); // Use insert for MultiIndex container
-  }
+  if (!this->db_.has(std::string("version"), DBPrefix::eventBlooms)) this->migrateEvents();
 }
 
 EventManager::~EventManager() {
   DBBatch batchedOperations;
-  {
-    std::unique_lock<std::shared_mutex> lock(this->lock_);
-    for (const auto& e : this->events_) {
-      // Build the key (block height + tx index + log index + address)
-      Bytes key;
-      key.reserve(8 + 8 + 8 + key.size());
-      Utils::appendBytes(key, Utils::uint64ToBytes(e.getBlockIndex()));
-      Utils::appendBytes(key, Utils::uint64ToBytes(e.getTxIndex()));
-      Utils::appendBytes(key, Utils::uint64ToBytes(e.getLogIndex()));
-      Utils::appendBytes(key, e.getAddress().asBytes());
-      // Serialize the value to a JSON string and insert into the batch
-      batchedOperations.push_back(key, Utils::stringToBytes(e.serialize()), DBPrefix::events);
+  if (this->flushEvents(batchedOperations) != 0) this->db_.putBatch(batchedOperations);
+}
+
+Bytes EventManager::eventKey(const Event& event) {
+  // Build the key (block height + tx index + log index + address)
+  Bytes key;
+  key.reserve(8 + 8 + 8 + 20);
+  Utils::appendBytes(key, Utils::uint64ToBytes(event.getBlockIndex()));
+  Utils::appendBytes(key, Utils::uint64ToBytes(event.getTxIndex()));
+  Utils::appendBytes(key, Utils::uint64ToBytes(event.getLogIndex()));
+  Utils::appendBytes(key, event.getAddress().asBytes());
+  return key;
+}
+
+Event EventManager::decodeEvent(const BytesArrView bytes) {
+  if (!bytes.empty() && bytes[0] == '{') return Event(std::string(bytes.begin(), bytes.end()));
+  return Event(bytes);
+}
+
+void EventManager::migrateEvents() {
+  // Older versions stored every event as JSON, with no indexes nor blooms
+  std::vector<DBEntry> allEvents = this->db_.getBatch(DBPrefix::events);
+  for (const DBEntry& entry : allEvents) this->events_.insert(EventManager::decodeEvent(entry.value));
+  DBBatch batch;
+  uint64_t migrated = this->flushEvents(batch);
+  batch.push_back(Utils::stringToBytes("version"), Bytes{0x01}, DBPrefix::eventBlooms);
+  this->db_.putBatch(batch);
+  if (migrated != 0) {
+    LOGINFO(Log::event, "Migrated " + std::to_string(migrated) + " events to binary format");
+  }
+}
+
+uint64_t EventManager::flushEvents(DBBatch& batch) {
+  std::unique_lock<std::shared_mutex> lock(this->lock_);
+  std::map<uint64_t, EventBloom> blooms;
+  std::set<std::pair<Address, uint64_t>> addressEntries;
+  std::set<std::pair<Hash, uint64_t>> topicEntries;
+  for (const auto& e : this->events_) {
+    batch.push_back(EventManager::eventKey(e), e.serializeToBytes(), DBPrefix::events);
+    blooms[e.getBlockIndex()].add(e);
+    addressEntries.emplace(e.getAddress(), e.getBlockIndex());
+    if (!e.getTopics().empty()) topicEntries.emplace(e.getTopics()[0], e.getBlockIndex());
+  }
+  for (auto& [height, bloom] : blooms) {
+    // Events of a block are normally flushed at once, merge just in case they weren't
+    const auto heightBytes = Utils::uint64ToBytes(height);
+    if (this->db_.has(heightBytes, DBPrefix::eventBlooms)) {
+      bloom.merge(EventBloom(this->db_.get(heightBytes, DBPrefix::eventBlooms)));
     }
+    batch.push_back(heightBytes, bloom.serialize(), DBPrefix::eventBlooms);
+  }
+  for (const auto& [address, height] : addressEntries) {
+    Bytes key = address.asBytes();
+    Utils::appendBytes(key, Utils::uint64ToBytes(height));
+    batch.push_back(key, Bytes(), DBPrefix::eventAddressIndex);
   }
-  // Batch save to database and clear the list
-  this->db_.putBatch(batchedOperations);
+  for (const auto& [topic, height] : topicEntries) {
+    Bytes key = topic.asBytes();
+    Utils::appendBytes(key, Utils::uint64ToBytes(height));
+    batch.push_back(key, Bytes(), DBPrefix::eventTopicIndex);
+  }
+  uint64_t flushed = this->events_.size();
   this->events_.clear();
+  return flushed;
+}
+
+std::vector<uint64_t> EventManager::indexedHeights(
+  const Bytes& prefix, const BytesArrView indexKey, const uint64_t& fromBlock, const uint64_t& toBlock
+) const {
+  std::vector<uint64_t> ret;
+  Bytes startBytes(indexKey.begin(), indexKey.end());
+  Bytes endBytes(indexKey.begin(), indexKey.end());
+  Utils::appendBytes(startBytes, Utils::uint64ToBytes(fromBlock));
+  Utils::appendBytes(endBytes, Utils::uint64ToBytes(toBlock));
+  for (const Bytes& key : this->db_.getKeys(prefix, startBytes, endBytes)) {
+    ret.push_back(Utils::bytesToUint64(Utils::create_view_span(key, indexKey.size(), 8)));
+  }
+  return ret;
 }
 
 std::vector<Event> EventManager::getEvents(
   const uint64_t& fromBlock, const uint64_t& toBlock,
   const Address& address, const std::vector<Hash>& topics
 ) const {
-  std::vector<Event> ret;
   // Check if block range is within limits
   uint64_t heightDiff = std::max(fromBlock, toBlock) - std::min(fromBlock, toBlock);
   if (heightDiff > this->options_.getEventBlockCap()) throw std::out_of_range(
     "Block range too large for event querying! Max allowed is " +
     std::to_string(this->options_.getEventBlockCap())
   );
-  // Fetch from memory, then match topics from memory
+  // Fetch from database first (older blocks), then from memory (not flushed yet) if we have space left
+  std::vector<Event> ret = this->filterFromDB(fromBlock, toBlock, address, topics);
   for (const Event& e : this->filterFromMemory(fromBlock, toBlock, address)) {
-    if (this->matchTopics(e, topics) && ret.size() < this->options_.getEventLogCap()) {
-      ret.push_back(e);
-    }
-  }
-  if (ret.size() >= this->options_.getEventLogCap()) return ret;
-  // Fetch from database if we have space left
-  for (const Event& e : this->filterFromDB(fromBlock, toBlock, address, topics)) {
     if (ret.size() >= this->options_.getEventLogCap()) break;
-    ret.push_back(std::move(e));
+    if (this->matchTopics(e, topics)) ret.push_back(e);
   }
   return ret;
 }
@@ -129,10 +248,9 @@ std::vector<Event> EventManager::getEvents(
   Bytes fetchBytes = DBPrefix::events;
   Utils::appendBytes(fetchBytes, Utils::uint64ToBytes(blockIndex));
   Utils::appendBytes(fetchBytes, Utils::uint64ToBytes(txIndex));
-  for (DBEntry entry : this->db_.getBatch(fetchBytes)) {
+  for (const DBEntry& entry : this->db_.getBatch(fetchBytes)) {
     if (ret.size() >= this->options_.getEventLogCap()) break;
-    Event e(Utils::bytesToString(entry.value));
-    ret.push_back(e);
+    ret.push_back(EventManager::decodeEvent(entry.value));
   }
   return ret;
 }
@@ -162,29 +280,54 @@ std::vector<Event> EventManager::filterFromDB(
   const uint64_t& fromBlock, const uint64_t& toBlock,
   const Address& address, const std::vector<Hash>& topics
 ) const {
-  // Filter by block range
   std::vector<Event> ret;
-  std::vector<Bytes> dbKeys;
-  Bytes startBytes;
-  Bytes endBytes;
-  Utils::appendBytes(startBytes, Utils::uint64ToBytes(fromBlock));
-  Utils::appendBytes(endBytes, Utils::uint64ToBytes(toBlock));
+  // Candidate blocks from the most selective index available
+  std::vector<uint64_t> heights;
+  if (address != Address()) {
+    heights = this->indexedHeights(DBPrefix::eventAddressIndex, address.view(), fromBlock, toBlock);
+  } else if (!topics.empty()) {
+    heights = this->indexedHeights(DBPrefix::eventTopicIndex, topics[0].view(), fromBlock, toBlock);
+  } else {
+    // Every block with events has a bloom
+    const BytesArr<8> fromBytes = Utils::uint64ToBytes(fromBlock);
+    const BytesArr<8> toBytes = Utils::uint64ToBytes(toBlock);
+    for (const Bytes& key : this->db_.getKeys(
+      DBPrefix::eventBlooms, Bytes(fromBytes.begin(), fromBytes.end()), Bytes(toBytes.begin(), toBytes.end())
+    )) {
+      if (key.size() == 8) heights.push_back(Utils::bytesToUint64(key));
+    }
+  }
+  if (heights.empty()) return ret;
 
-  // Get the keys first, based on block height, then filter by address if there is one
-  for (Bytes key : this->db_.getKeys(DBPrefix::events, startBytes, endBytes)) {
-    uint64_t nHeight = Utils::bytesToUint64(Utils::create_view_span(key, 0, 8));
-    Address addr(Utils::create_view_span(key, 24, 20));
-    if (
-      (fromBlock <= nHeight && nHeight <= toBlock) &&
-      (address == Address() || address == addr)
-    ) dbKeys.push_back(key);
+  // Drop the candidates whose bloom rules out the rest of the filter
+  if (address != Address() || !topics.empty()) {
+    std::vector<Bytes> bloomKeys;
+    for (const uint64_t& height : heights) {
+      const BytesArr<8> key = Utils::uint64ToBytes(height);
+      bloomKeys.emplace_back(key.begin(), key.end());
+    }
+    std::vector<uint64_t> filtered;
+    for (const DBEntry& entry : this->db_.multiGet(DBPrefix::eventBlooms, bloomKeys)) {
+      EventBloom bloom(entry.value);
+      bool mayMatch = (address == Address() || bloom.mayContain(address.view()));
+      for (const Hash& topic : topics) mayMatch = mayMatch && bloom.mayContain(topic.view());
+      if (mayMatch) filtered.push_back(Utils::bytesToUint64(entry.key));
+    }
+    heights = std::move(filtered);
   }
 
-  // Get the key values
-  for (DBEntry item : this->db_.getBatch(DBPrefix::events, dbKeys)) {
-    if (ret.size() >= this->options_.getEventLogCap()) break;
-    Event e(Utils::bytesToString(item.value));
-    if (this->matchTopics(e, topics)) ret.push_back(e);
+  // Only now read and decode the events of the remaining blocks
+  for (const uint64_t& height : heights) {
+    Bytes fetchBytes = DBPrefix::events;
+    Utils::appendBytes(fetchBytes, Utils::uint64ToBytes(height));
+    for (const DBEntry& entry : this->db_.getBatch(fetchBytes)) {
+      if (ret.size() >= this->options_.getEventLogCap()) return ret;
+      // Address is the last part of the key (after tx index and log index, the height
+      // went away with the prefix), no need to decode events from other addresses
+      if (address != Address() && Address(Utils::create_view_span(entry.key, 16, 20)) != address) continue;
+      Event e = EventManager::decodeEvent(entry.value);
+      if (this->matchTopics(e, topics)) ret.push_back(std::move(e));
+    }
   }
   return ret;
 }
@@ -9,6 +9,9 @@ See the LICENSE.txt file in the project root for more information.
 #define EVENT_H
 
 #include <algorithm>
+#include <array>
+#include <map>
+#include <set>
 #include <shared_mutex>
 #include <source_location>
 #include <string>
@@ -125,6 +128,13 @@ class Event {
      */
     explicit Event(const std::string& jsonstr);
 
+    /**
+     * Constructor from binary deserialization (see serializeToBytes()).
+     * @param bytes The serialized event.
+     * @throw DynamicException if the data is too short or has an unknown format.
+     */
+    explicit Event(const BytesArrView bytes);
+
     /**
      * Set data from the block and transaction that is supposed to emit the event.
      * @param logIndex The event's position on the block.
@@ -167,6 +177,15 @@ class Event {
 
     std::string serialize() const;  ///< Serialize event data from the object to a JSON string.
 
+    /**
+     * Serialize event data to the compact binary format used in the database:
+     * format (1) + name size (2) + name + logIndex (8) + txHash (32) + txIndex (8) +
+     * blockHash (32) + blockIndex (8) + address (20) + anonymous (1) + topic count (1) +
+     * topics (32 each) + data (rest).
+     * The format byte is never '{', so old JSON entries can still be told apart.
+     */
+    Bytes serializeToBytes() const;
+
     /**
      * Serialize event data to a JSON string, formatted to RPC response standards
      * @see https://medium.com/alchemy-api/deep-dive-into-eth-getlogs-5faf6a66fd81
@@ -174,6 +193,41 @@ class Event {
     std::string serializeForRPC() const;
 };
 
+/**
+ * 2048-bit bloom filter over the addresses and topics of the events of a block.
+ * Same scheme as Ethereum's logsBloom: 3 bits per item, taken from its keccak hash.
+ */
+class EventBloom {
+  private:
+    std::array<uint8_t, 256> bits_; ///< Filter bits.
+
+  public:
+    /// Empty constructor.
+    EventBloom() { this->bits_.fill(0x00); }
+
+    /**
+     * Constructor from a serialized filter.
+     * @param bytes The serialized filter.
+     * @throw DynamicException if the size doesn't match.
+     */
+    explicit EventBloom(const BytesArrView bytes);
+
+    /// Add an event's address and topics to the filter.
+    void add(const Event& event);
+
+    /// Add an item (address or topic) to the filter.
+    void add(const BytesArrView item);
+
+    /// Check if an item (address or topic) might have been added to the filter.
+    bool mayContain(const BytesArrView item) const;
+
+    /// Merge another filter into this one.
+    void merge(const EventBloom& other) { for (size_t i = 0; i < this->bits_.size(); i++) this->bits_[i] |= other.bits_[i]; }
+
+    /// Serialize the filter.
+    Bytes serialize() const { return Bytes(this->bits_.begin(), this->bits_.end()); }
+};
+
 /// Multi-index container used for storing events in memory.
 struct event_indices : bmi::indexed_by<
   // Ordered index by blockIndex for range queries
@@ -189,27 +243,71 @@ using EventContainer = bmi::multi_index_container<Event, event_indices>;  ///< A
 /**
  * Class that holds all events emitted by contracts in the blockchain.
  * Responsible for registering, managing and saving/loading events to/from the database.
+ * Events are kept in memory only until flushEvents() is called (once per block by
+ * the State), then live in the database along with:
+ * - a bloom filter per block (DBPrefix::eventBlooms, key = block height);
+ * - an index by address (DBPrefix::eventAddressIndex, key = address + block height);
+ * - an index by first topic (DBPrefix::eventTopicIndex, key = topic + block height).
+ * Range queries use the indexes to find the candidate blocks, the blooms to skip
+ * the ones that can't match, and only then read and decode events.
  */
 class EventManager {
   private:
-    // TODO: keep up to 1000 (maybe 10000? 100000? 1M seems too much) events in memory, dump older ones to DB (this includes checking save/load - maybe this should be a deque?)
-    EventContainer events_;           ///< List of all emitted events in memory. Older ones FIRST, newer ones LAST.
+    EventContainer events_;           ///< List of emitted events not flushed to the database yet. Older ones FIRST, newer ones LAST.
     EventContainer tempEvents_;       ///< List of temporary events waiting to be commited or reverted.
     DB& db_;                          ///< Reference to the database.
     const Options& options_;          ///< Reference to the Options singleton.
     mutable std::shared_mutex lock_;  ///< Mutex for managing read/write access to the permanent events vector.
 
+    /**
+     * Rewrite events stored by older versions (JSON, no indexes) in the current format.
+     * Runs only once per database, called by the constructor.
+     */
+    void migrateEvents();
+
+    /**
+     * Build the database key of an event (block height + tx index + log index + address).
+     * @param event The event.
+     * @return The key, WITHOUT prefix.
+     */
+    static Bytes eventKey(const Event& event);
+
+    /**
+     * Decode an event from the database, in either binary or the older JSON format.
+     * @param bytes The stored value.
+     * @return The decoded event.
+     */
+    static Event decodeEvent(const BytesArrView bytes);
+
+    /**
+     * Get the heights of the blocks that have indexed entries for a given key in a range.
+     * @param prefix The index prefix (DBPrefix::eventAddressIndex or DBPrefix::eventTopicIndex).
+     * @param indexKey The indexed address or topic.
+     * @param fromBlock The starting block range to query.
+     * @param toBlock The ending block range to query.
+     * @return The block heights, in ascending order.
+     */
+    std::vector<uint64_t> indexedHeights(
+      const Bytes& prefix, const BytesArrView indexKey, const uint64_t& fromBlock, const uint64_t& toBlock
+    ) const;
+
   public:
     /**
-     * Constructor; Automatically loads events from the database.
+     * Constructor. Events stay in the database, only old formats are migrated.
      * @param db The database to use.
      * @param options The Options singleton to use (for event caps).
      */
     EventManager(DB& db, const Options& options);
 
-    ~EventManager();  ///< Destructor. Automatically saves events to the database.
+    ~EventManager();  ///< Destructor. Automatically saves unflushed events to the database.
 
-    // TODO: maybe a periodicSaveToDB() just like on Storage?
+    /**
+     * Move every committed event to a database batch, along with its index entries
+     * and the bloom filter of its block, emptying the in-memory list.
+     * @param batch The batch to append to.
+     * @return The number of flushed events.
+     */
+    uint64_t flushEvents(DBBatch& batch);
 
     /**
      * Get all the events emitted under the given inputs.
@@ -252,6 +350,8 @@ class EventManager {
 
     /**
      * Filter events in the database. Used by getEvents().
+     * Candidate blocks come from the address index if there's an address, else from the
+     * first topic index if there are topics, else from every block with events in the range.
      * @param fromBlock The starting block range to query.
      * @param toBlock Tne ending block range to query.
      * @param address The address to look for. Defaults to empty (look for all available addresses).
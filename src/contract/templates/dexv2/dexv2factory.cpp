@@ -59,23 +59,23 @@ DEXV2Factory::DEXV2Factory(
   this->getPair_.enableRegister();
 }
 
-DEXV2Factory::~DEXV2Factory() {
-  DBBatch batchOperations;
-  batchOperations.push_back(Utils::stringToBytes("feeTo_"), this->feeTo_.get().view(), this->getDBPrefix());
-  batchOperations.push_back(Utils::stringToBytes("feeToSetter_"), this->feeToSetter_.get().view(), this->getDBPrefix());
+DEXV2Factory::~DEXV2Factory() = default;
+
+void DEXV2Factory::dump(DBBatch& batch) const {
+  batch.push_back(Utils::stringToBytes("feeTo_"), this->feeTo_.get().view(), this->getDBPrefix());
+  batch.push_back(Utils::stringToBytes("feeToSetter_"), this->feeToSetter_.get().view(), this->getDBPrefix());
   uint32_t index = 0;
-  for (const auto& address : this->allPairs_.get()) batchOperations.push_back(
-    Utils::uint32ToBytes(index), address.view(), this->getNewPrefix("allPairs_")
+  for (const auto& address : this->allPairs_.get()) batch.push_back(
+    Utils::uint32ToBytes(index++), address.view(), this->getNewPrefix("allPairs_")
   );
   for (auto tokenA = this->getPair_.cbegin(); tokenA != this->getPair_.cend(); tokenA++) {
     for (auto tokenB = tokenA->second.cbegin(); tokenB != tokenA->second.cend(); tokenB++) {
       const auto& key = tokenA->first.get();
       Bytes value = tokenB->first.asBytes();
       Utils::appendBytes(value, tokenB->second.asBytes());
-      batchOperations.push_back(key, value, this->getNewPrefix("getPair_"));
+      batch.push_back(key, value, this->getNewPrefix("getPair_"));
     }
   }
-  this->db_.putBatch(batchOperations);
 }
 
 void DEXV2Factory::registerContractFunctions() {
@@ -73,6 +73,9 @@ class DEXV2Factory : public DynamicContract {
     // Destructor.
     ~DEXV2Factory() override;
 
+    /// Dump the contract's state to a database batch (see BaseContract::dump()).
+    void dump(DBBatch& batch) const override;
+
     /// Get the feeTo address of the DEXV2Factory.
     Address feeTo() const;
 
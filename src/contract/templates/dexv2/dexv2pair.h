@@ -117,6 +117,9 @@ class DEXV2Pair : public ERC20 {
     /// Destructor.
     ~DEXV2Pair() override;
 
+    /// Dump the contract's state to a database batch (see BaseContract::dump()).
+    void dump(DBBatch& batch) const override;
+
 
     /**
      * Initialize the contract
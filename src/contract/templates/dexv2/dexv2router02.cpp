@@ -47,15 +47,15 @@ DEXV2Router02::DEXV2Router02(
   this->wrappedNative_.enableRegister();
 }
 
-DEXV2Router02::~DEXV2Router02() {
-  DBBatch batchOperations;
-  batchOperations.push_back(
+DEXV2Router02::~DEXV2Router02() = default;
+
+void DEXV2Router02::dump(DBBatch& batch) const {
+  batch.push_back(
     Utils::stringToBytes("factory_"), this->factory_.get().view(), this->getDBPrefix()
   );
-  batchOperations.push_back(
+  batch.push_back(
     Utils::stringToBytes("wrappedNative_"), this->wrappedNative_.get().view(), this->getDBPrefix()
   );
-  this->db_.putBatch(batchOperations);
 }
 
 void DEXV2Router02::registerContractFunctions() {
@@ -109,6 +109,9 @@ class DEXV2Router02 : public DynamicContract {
     // Destructor.
     ~DEXV2Router02() override;
 
+    /// Dump the contract's state to a database batch (see BaseContract::dump()).
+    void dump(DBBatch& batch) const override;
+
     /// Getter for `factory_`.
     Address factory() const;
 
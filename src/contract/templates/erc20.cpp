@@ -107,17 +107,18 @@ ERC20::ERC20(
   this->allowed_.enableRegister();
 }
 
-ERC20::~ERC20() {
-  DBBatch batchOperations;
-  this->db_.put(std::string("name_"), name_.get(), this->getDBPrefix());
-  this->db_.put(std::string("symbol_"), symbol_.get(), this->getDBPrefix());
-  this->db_.put(std::string("decimals_"), Utils::uint8ToBytes(decimals_.get()), this->getDBPrefix());
-  this->db_.put(std::string("totalSupply_"), Utils::uint256ToBytes(totalSupply_.get()), this->getDBPrefix());
+ERC20::~ERC20() = default;
+
+void ERC20::dump(DBBatch& batch) const {
+  batch.push_back(Utils::stringToBytes("name_"), Utils::stringToBytes(name_.get()), this->getDBPrefix());
+  batch.push_back(Utils::stringToBytes("symbol_"), Utils::stringToBytes(symbol_.get()), this->getDBPrefix());
+  batch.push_back(Utils::stringToBytes("decimals_"), Utils::uint8ToBytes(decimals_.get()), this->getDBPrefix());
+  batch.push_back(Utils::stringToBytes("totalSupply_"), Utils::uint256ToBytes(totalSupply_.get()), this->getDBPrefix());
 
   for (auto it = balances_.cbegin(); it != balances_.cend(); ++it) {
     const auto& key = it->first.get();
     Bytes value = Utils::uintToBytes(it->second);
-    batchOperations.push_back(key, value, this->getNewPrefix("balances_"));
+    batch.push_back(key, value, this->getNewPrefix("balances_"));
   }
   // SafeUnorderedMap<Address, std::unordered_map<Address, uint256_t, SafeHash>>
   for (auto it = allowed_.cbegin(); it != allowed_.cend(); ++it) {
@@ -126,10 +127,9 @@ ERC20::~ERC20() {
       // value = uint256_t
       auto key = it->first.asBytes();
       Utils::appendBytes(key, it2->first.asBytes());
-      batchOperations.push_back(key, Utils::uint256ToBytes(it2->second), this->getNewPrefix("allowed_"));
+      batch.push_back(key, Utils::uint256ToBytes(it2->second), this->getNewPrefix("allowed_"));
     }
   }
-  this->db_.putBatch(batchOperations);
 }
 
 void ERC20::registerContractFunctions() {
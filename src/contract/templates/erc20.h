@@ -111,6 +111,9 @@ class ERC20 : public DynamicContract {
     /// Destructor.
     ~ERC20() override;
 
+    /// Dump the contract's state to a database batch (see BaseContract::dump()).
+    void dump(DBBatch& batch) const override;
+
     // event Transfer(address indexed from, address indexed to, uint256 value);
     void Transfer(const EventParam<Address, true>& from, const EventParam<Address, true>& to, const EventParam<uint256_t, true>& value) {
       this->emitEvent(__func__, std::make_tuple(from, to, value));
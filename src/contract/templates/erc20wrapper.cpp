@@ -35,17 +35,17 @@ ERC20Wrapper::ERC20Wrapper(
   this->tokensAndBalances_.enableRegister();
 }
 
-ERC20Wrapper::~ERC20Wrapper() {
-  DBBatch tokensAndBalancesBatch;
+ERC20Wrapper::~ERC20Wrapper() = default;
+
+void ERC20Wrapper::dump(DBBatch& batch) const {
   for (auto it = tokensAndBalances_.cbegin(); it != tokensAndBalances_.cend(); ++it) {
     for (auto it2 = it->second.cbegin(); it2 != it->second.cend(); ++it2) {
       const auto& key = it->first.get();
       Bytes value = it2->first.asBytes();
       Utils::appendBytes(value, Utils::uintToBytes(it2->second));
-      tokensAndBalancesBatch.push_back(key, value, this->getNewPrefix("tokensAndBalances_"));
+      batch.push_back(key, value, this->getNewPrefix("tokensAndBalances_"));
     }
   }
-  this->db_.putBatch(tokensAndBalancesBatch);
 }
 
 uint256_t ERC20Wrapper::getContractBalance(const Address& token) const {
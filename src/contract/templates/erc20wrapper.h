@@ -81,6 +81,9 @@ class ERC20Wrapper : public DynamicContract {
     /// Destructor.
     ~ERC20Wrapper() override;
 
+    /// Dump the contract's state to a database batch (see BaseContract::dump()).
+    void dump(DBBatch& batch) const override;
+
     /**
      * Get the balance of the contract for a specific token.
      * @param token The address of the token.
@@ -103,25 +103,25 @@ ERC721::ERC721(
   this->operatorAddressApprovals_.enableRegister();
 }
 
-ERC721::~ERC721() {
-  DBBatch batchedOperations;
+ERC721::~ERC721() = default;
 
-  this->db_.put(std::string("name_"), name_.get(), this->getDBPrefix());
-  this->db_.put(std::string("symbol_"), symbol_.get(), this->getDBPrefix());
+void ERC721::dump(DBBatch& batch) const {
+  batch.push_back(Utils::stringToBytes("name_"), Utils::stringToBytes(name_.get()), this->getDBPrefix());
+  batch.push_back(Utils::stringToBytes("symbol_"), Utils::stringToBytes(symbol_.get()), this->getDBPrefix());
 
   for (auto it = owners_.cbegin(), end = owners_.cend(); it != end; ++it) {
     // key: uint -> value: Address
-    batchedOperations.push_back(Utils::uintToBytes(it->first), it->second.get(), this->getNewPrefix("owners_"));
+    batch.push_back(Utils::uintToBytes(it->first), it->second.get(), this->getNewPrefix("owners_"));
   }
 
   for (auto it = balances_.cbegin(), end = balances_.cend(); it != end; ++it) {
     // key: Address -> value: uint
-    batchedOperations.push_back(it->first.get(), Utils::uintToBytes(it->second), this->getNewPrefix("balances_"));
+    batch.push_back(it->first.get(), Utils::uintToBytes(it->second), this->getNewPrefix("balances_"));
   }
 
   for (auto it = tokenApprovals_.cbegin(), end = tokenApprovals_.cend(); it != end; ++it) {
     // key: uint -> value: Address
-    batchedOperations.push_back(Utils::uintToBytes(it->first), it->second.get(), this->getNewPrefix("tokenApprovals_"));
+    batch.push_back(Utils::uintToBytes(it->first), it->second.get(), this->getNewPrefix("tokenApprovals_"));
   }
 
   for (auto it = operatorAddressApprovals_.cbegin(); it != operatorAddressApprovals_.cend(); ++it) {
@@ -130,11 +130,9 @@ ERC721::~ERC721() {
       Bytes key = it->first.asBytes();
       Utils::appendBytes(key, it2->first.asBytes());
       Bytes value = {uint8_t(it2->second)};
-      batchedOperations.push_back(key, value, this->getNewPrefix("operatorAddressApprovals_"));
+      batch.push_back(key, value, this->getNewPrefix("operatorAddressApprovals_"));
     }
   }
-
-  this->db_.putBatch(batchedOperations);
 }
 
 void ERC721::registerContractFunctions() {
@@ -208,6 +208,9 @@ public:
   /// Destructor.
   ~ERC721() override;
 
+  /// Dump the contract's state to a database batch (see BaseContract::dump()).
+  void dump(DBBatch& batch) const override;
+
   /**
    * Get the name of the ERC721 token.
    * Solidity counterpart: function name() external view returns (string
@@ -257,13 +257,15 @@ tokenURI_(this), _ownedTokens(this), _ownedTokensIndex(this), preburnedTokensByO
   preburnedTokensByOwner_.enableRegister();
 }
 
-ERC721Mint::~ERC721Mint() {
-  this->db_.put(std::string("tokenIdCounter_"), Utils::uint256ToBytes(this->tokenIdCounter_.get()), this->getDBPrefix());
-  this->db_.put(std::string("totalSupply_"), Utils::uint256ToBytes(this->totalSupply_.get()), this->getDBPrefix());
-  this->db_.put(std::string("maxSupply_"), Utils::uint256ToBytes(this->maxSupply_.get()), this->getDBPrefix());
-  this->db_.put(std::string("signer_"), this->signer_.get().asBytes(), this->getDBPrefix());
-  this->db_.put(std::string("_tokenBaseURI"), Utils::stringToBytes(this->_tokenBaseURI.get()), this->getDBPrefix());
-  DBBatch batch;
+ERC721Mint::~ERC721Mint() = default;
+
+void ERC721Mint::dump(DBBatch& batch) const {
+  ERC721::dump(batch);
+  batch.push_back(Utils::stringToBytes("tokenIdCounter_"), Utils::uint256ToBytes(this->tokenIdCounter_.get()), this->getDBPrefix());
+  batch.push_back(Utils::stringToBytes("totalSupply_"), Utils::uint256ToBytes(this->totalSupply_.get()), this->getDBPrefix());
+  batch.push_back(Utils::stringToBytes("maxSupply_"), Utils::uint256ToBytes(this->maxSupply_.get()), this->getDBPrefix());
+  batch.push_back(Utils::stringToBytes("signer_"), this->signer_.get().asBytes(), this->getDBPrefix());
+  batch.push_back(Utils::stringToBytes("_tokenBaseURI"), Utils::stringToBytes(this->_tokenBaseURI.get()), this->getDBPrefix());
   for (auto it = this->preBurnedTokens_.cbegin(); it != this->preBurnedTokens_.cend(); ++it) {
     const auto& [ exists, user, v, r, s, rarity] = it->second;
     // Key: tokenId
@@ -323,8 +325,6 @@ ERC721Mint::~ERC721Mint() {
     }
     batch.push_back(it->first.asBytes(), value, this->getNewPrefix("preburnedTokensByOwner_"));
   }
-
-  this->db_.putBatch(batch);
 }
 
 void ERC721Mint::registerContractFunctions() {
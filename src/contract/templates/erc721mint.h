@@ -86,6 +86,9 @@ class ERC721Mint : public ERC721 {
     /// Destructor.
     ~ERC721Mint() override;
 
+    /// Dump the contract's state to a database batch (see BaseContract::dump()).
+    void dump(DBBatch& batch) const override;
+
     void mint(const Address& to);
 
     void preBurn (const uint256_t& tokenId);
@@ -60,6 +60,9 @@ class ERC721Test : public ERC721 {
     /// Destructor.
     ~ERC721Test() override;
 
+    /// Dump the contract's state to a database batch (see BaseContract::dump()).
+    void dump(DBBatch& batch) const override;
+
     /**
      * Mint a single token to the to address.
      * @param to Address to send the token to.
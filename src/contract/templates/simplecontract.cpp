@@ -57,11 +57,13 @@ SimpleContract::SimpleContract(
   this->tuple_.enableRegister();
 }
 
-SimpleContract::~SimpleContract() {
-  this->db_.put(std::string("name_"), Utils::stringToBytes(this->name_.get()), this->getDBPrefix());
-  this->db_.put(std::string("number_"), Utils::uint256ToBytes(this->number_.get()), this->getDBPrefix());
-  this->db_.put(std::string("tuple_name"), Utils::stringToBytes(get<0>(this->tuple_)), this->getDBPrefix());
-  this->db_.put(std::string("tuple_number"), Utils::uint256ToBytes(get<1>(this->tuple_)), this->getDBPrefix());
+SimpleContract::~SimpleContract() = default;
+
+void SimpleContract::dump(DBBatch& batch) const {
+  batch.push_back(Utils::stringToBytes("name_"), Utils::stringToBytes(this->name_.get()), this->getDBPrefix());
+  batch.push_back(Utils::stringToBytes("number_"), Utils::uint256ToBytes(this->number_.get()), this->getDBPrefix());
+  batch.push_back(Utils::stringToBytes("tuple_name"), Utils::stringToBytes(get<0>(this->tuple_)), this->getDBPrefix());
+  batch.push_back(Utils::stringToBytes("tuple_number"), Utils::uint256ToBytes(get<1>(this->tuple_)), this->getDBPrefix());
 }
 
 void SimpleContract::setName(const std::string& argName) {
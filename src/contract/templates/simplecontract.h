@@ -91,6 +91,9 @@ class SimpleContract : public DynamicContract {
 
     ~SimpleContract() override; ///< Destructor.
 
+    /// Dump the contract's state to a database batch (see BaseContract::dump()).
+    void dump(DBBatch& batch) const override;
+
     /// function setName(string memory argName) public
     void setName(const std::string& argName);
 
@@ -0,0 +1,76 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "activityfeed.h"
+#include "storage.h"
+#include "../utils/metrics.h"
+
+#include <iostream>
+
+ActivityFeed::Sample ActivityFeed::sample() const {
+  // Same series as the ones State bumps, registering them here is a no-op if State did it first
+  static Metrics::Counter& blocksProcessed = Metrics::counter(
+    "orbiter_blocks_processed_total", "Blocks processed and appended to the chain."
+  );
+  static Metrics::Counter& txsProcessed = Metrics::counter(
+    "orbiter_txs_processed_total", "Transactions processed as part of a block."
+  );
+  static Metrics::Counter& mempoolTxsAdded = Metrics::counter(
+    "orbiter_mempool_txs_added_total", "Transactions added to the mempool."
+  );
+  Sample result;
+  if (auto latest = this->storage_.latest()) {
+    result.height = latest->getNHeight();
+    result.hash = latest->hash();
+  }
+  result.blocks = blocksProcessed.value();
+  result.txs = txsProcessed.value();
+  result.mempoolTxs = mempoolTxsAdded.value();
+  return result;
+}
+
+std::string ActivityFeed::describe(const Sample& from, const Sample& to, std::chrono::milliseconds elapsed) {
+  uint64_t blocks = to.blocks - from.blocks;
+  uint64_t txs = to.txs - from.txs;
+  uint64_t mempoolTxs = to.mempoolTxs - from.mempoolTxs;
+  if (blocks == 0 && mempoolTxs == 0) return "";
+  std::string seconds = std::to_string(std::chrono::duration<double>(elapsed).count());
+  seconds.resize(seconds.find('.') + 2); // One decimal is enough
+  return "Block " + std::to_string(to.height) + " (" + to.hash.hex(true).get() + ") - "
+    + std::to_string(blocks) + " blocks, " + std::to_string(txs) + " transactions accepted, "
+    + std::to_string(mempoolTxs) + " added to the mempool in the last " + seconds + "s";
+}
+
+void ActivityFeed::loop() {
+  Sample last = this->sample();
+  auto lastTime = std::chrono::steady_clock::now();
+  std::unique_lock lock(this->mutex_);
+  while (!this->cv_.wait_for(lock, this->interval_, [this]() { return this->stop_; })) {
+    lock.unlock();
+    Sample current = this->sample();
+    auto now = std::chrono::steady_clock::now();
+    std::string line = ActivityFeed::describe(
+      last, current, std::chrono::duration_cast<std::chrono::milliseconds>(now - lastTime)
+    );
+    if (!line.empty()) std::cout << line << std::endl;
+    last = current;
+    lastTime = now;
+    lock.lock();
+  }
+}
+
+void ActivityFeed::start() {
+  if (this->loopFuture_.valid()) return;
+  { std::lock_guard lock(this->mutex_); this->stop_ = false; }
+  this->loopFuture_ = std::async(std::launch::async, &ActivityFeed::loop, this);
+}
+
+void ActivityFeed::stop() {
+  { std::lock_guard lock(this->mutex_); this->stop_ = true; }
+  this->cv_.notify_all();
+  if (this->loopFuture_.valid()) this->loopFuture_.get();
+}
@@ -0,0 +1,78 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#ifndef ACTIVITYFEED_H
+#define ACTIVITYFEED_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <string>
+
+#include "../utils/strings.h"
+
+// Forward declaration.
+class Storage;
+
+/**
+ * Human-readable progress on stdout, for dev nodes (`"activityFeed": true` in options.json).
+ * Block processing and the mempool never print anything themselves, they only
+ * bump the metrics counters (see Metrics). The feed samples those counters from
+ * its own thread and prints at most one summary line per interval, so a busy
+ * chain produces a steady trickle of output and the consensus path never
+ * waits on the terminal.
+ */
+class ActivityFeed {
+  public:
+    /// Point-in-time reading of the chain activity.
+    struct Sample {
+      uint64_t height = 0;      ///< Height of the latest block.
+      Hash hash;                ///< Hash of the latest block.
+      uint64_t blocks = 0;      ///< Total blocks processed.
+      uint64_t txs = 0;         ///< Total transactions processed in blocks.
+      uint64_t mempoolTxs = 0;  ///< Total transactions added to the mempool.
+    };
+
+  private:
+    const Storage& storage_;  ///< Reference to the blockchain's storage.
+    const std::chrono::milliseconds interval_;  ///< Minimum time between two lines.
+    std::mutex mutex_;  ///< Mutex for `stop_`.
+    std::condition_variable cv_;  ///< Wakes the feed thread when stopping.
+    bool stop_ = false; ///< Flag for stopping the feed thread.
+    std::future<void> loopFuture_;  ///< Future object holding the feed thread.
+
+    Sample sample() const;  ///< Take a sample of the current activity.
+    void loop();  ///< Routine loop for the feed thread.
+
+  public:
+    /**
+     * Constructor.
+     * @param storage Reference to the blockchain's storage.
+     * @param interval Minimum time between two lines.
+     */
+    explicit ActivityFeed(const Storage& storage, std::chrono::milliseconds interval = std::chrono::seconds(1))
+      : storage_(storage), interval_(interval) {}
+
+    /// Destructor. Automatically stops the feed.
+    ~ActivityFeed() { this->stop(); }
+
+    void start(); ///< Start printing.
+    void stop();  ///< Stop printing.
+
+    /**
+     * Describe the activity between two samples.
+     * @param from The older sample.
+     * @param to The newer sample.
+     * @param elapsed Time between the two samples.
+     * @return The line to print, or an empty string if nothing happened.
+     */
+    static std::string describe(const Sample& from, const Sample& to, std::chrono::milliseconds elapsed);
+};
+
+#endif // ACTIVITYFEED_H
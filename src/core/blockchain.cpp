@@ -14,12 +14,23 @@ Blockchain::Blockchain(const std::string& blockchainPath) :
   state_(db_, storage_, p2p_, options_),
   p2p_(boost::asio::ip::address::from_string("127.0.0.1"), options_, storage_, state_),
   http_(state_, storage_, p2p_, options_),
-  syncer_(*this)
-{}
+  syncer_(*this),
+  feed_(storage_)
+{
+  // Apply the logging options, an invalid level name aborts startup
+  Logger::setLevel(Logger::levelFromString(this->options_.getLogLevel()));
+  for (const auto& [module, level] : this->options_.getLogModuleLevels()) {
+    Logger::setModuleLevel(module, Logger::levelFromString(level));
+  }
+  Logger::setRotation(this->options_.getLogRotateBytes(), this->options_.getLogRotateFiles());
+}
 
-void Blockchain::start() { p2p_.start(); http_.start(); syncer_.start(); }
+void Blockchain::start() {
+  p2p_.start(); http_.start(); syncer_.start();
+  if (options_.getActivityFeed()) feed_.start();
+}
 
-void Blockchain::stop() { syncer_.stop(); http_.stop(); p2p_.stop(); }
+void Blockchain::stop() { feed_.stop(); syncer_.stop(); http_.stop(); p2p_.stop(); }
 
 const std::atomic<bool>& Blockchain::isSynced() const { return this->syncer_.isSynced(); }
 
@@ -27,7 +38,7 @@ void Syncer::updateCurrentlyConnectedNodes() {
   // Get the list of currently connected nodes
   std::vector<P2P::NodeID> connectedNodes = blockchain_.p2p_.getSessionsIDs();
   while (connectedNodes.size() < blockchain_.p2p_.minConnections() && !this->stopSyncer_) {
-    Logger::logToDebug(LogType::INFO, Log::syncer, __func__,
+    LOGINFO(Log::syncer,
       "Waiting for discoveryWorker to connect to more nodes, currently connected to: "
       + std::to_string(connectedNodes.size())
     );
@@ -71,22 +82,25 @@ void Syncer::updateCurrentlyConnectedNodes() {
 bool Syncer::checkLatestBlock() { return (this->latestBlock_ != this->blockchain_.storage_.latest()); }
 
 void Syncer::doSync() {
-  // TODO: Fully implement Sync
-  this->latestBlock_ = blockchain_.storage_.latest();
-  // Get the list of currently connected nodes and their current height
-  this->updateCurrentlyConnectedNodes();
-  std::pair<P2P::NodeID, uint64_t> highestNode = {P2P::NodeID(), 0};
-
-  // Get the highest node.
-  for (auto& [nodeId, nodeInfo] : this->currentlyConnectedNodes_) {
-    if (nodeInfo.latestBlockHeight > highestNode.second) {
-      highestNode = {nodeId, nodeInfo.latestBlockHeight};
+  SyncEngine engine(this->blockchain_.p2p_, this->blockchain_.state_, this->blockchain_.storage_, this->blockchain_.options_);
+  while (!this->stopSyncer_) {
+    // Get the list of currently connected nodes and their current height
+    this->updateCurrentlyConnectedNodes();
+    uint64_t localHeight = this->blockchain_.storage_.latest()->getNHeight();
+    std::unordered_map<P2P::NodeID, uint64_t, SafeHash> peerHeights;
+    for (const auto& [nodeId, nodeInfo] : this->currentlyConnectedNodes_) {
+      if (nodeInfo.latestBlockHeight > localHeight) peerHeights[nodeId] = nodeInfo.latestBlockHeight;
     }
-  }
-
-  // Sync from the best node.
-  if (highestNode.second > this->latestBlock_->getNHeight()) {
-    // TODO: currently we are starting all the nodes from genesis (0)
+    if (peerHeights.empty()) break; // Nobody is ahead of us
+
+    // Download from every node that is ahead, until caught up or no progress can be made
+    SyncEngine::Stats stats = engine.sync(peerHeights, this->stopSyncer_);
+    Utils::safePrint("Synced " + std::to_string(stats.blocks) + " blocks up to height "
+      + std::to_string(this->blockchain_.storage_.latest()->getNHeight()) + " ("
+      + std::to_string(uint64_t(stats.blocksPerSecond())) + " blocks/s, "
+      + std::to_string(uint64_t(stats.bytesPerSecond() / 1024)) + " KiB/s)"
+    );
+    if (stats.blocks == 0) break;
   }
 
   this->latestBlock_ = blockchain_.storage_.latest();
@@ -94,38 +108,33 @@ void Syncer::doSync() {
 }
 
 void Syncer::doValidatorBlock() {
-  // TODO: Improve this somehow.
-  // Wait until we are ready to create the block
-  bool logged = false;
-  while (!this->blockchain_.state_.rdposCanCreateBlock()) {
-    if (!logged) {
-      logged = true;
-      Logger::logToDebug(LogType::INFO, Log::syncer, __func__, "Waiting for rdPoS to be ready to create a block.");
-    }
-    if (this->stopSyncer_) return;
-    std::this_thread::sleep_for(std::chrono::microseconds(10));
+  // Wait until we are ready to create the block (rdPoSWorker publishes it as soon as the quorum is reached)
+  ChainEvents& events = this->blockchain_.storage_.events();
+  if (!this->blockchain_.state_.rdposCanCreateBlock()) {
+    LOGINFO(Log::syncer, "Waiting for rdPoS to be ready to create a block.");
+    while (!events.waitUntil([this]() {
+      return this->blockchain_.state_.rdposCanCreateBlock() || this->stopSyncer_;
+    }, Syncer::idleWakeInterval_)) {}
   }
+  if (this->stopSyncer_) return;
 
   // Wait until we have at least one transaction in the state mempool.
-  logged = false;
+  if (this->blockchain_.state_.getMempoolSize() < 1) {
+    LOGINFO(Log::syncer, "Waiting for at least one transaction in the mempool.");
+  }
   while (this->blockchain_.state_.getMempoolSize() < 1) {
-    if (!logged) {
-      logged = true;
-      Logger::logToDebug(LogType::INFO, Log::syncer, __func__, "Waiting for at least one transaction in the mempool.");
-    }
     if (this->stopSyncer_) return;
-    // Try to get transactions from the network.
+    // Transactions are broadcast to us, only pull them from other nodes if they are late
     auto connectedNodesList = this->blockchain_.p2p_.getSessionsIDs(P2P::NodeType::NORMAL_NODE);
     for (auto const& nodeId : connectedNodesList) {
       if (this->stopSyncer_) break;
-      auto txList = this->blockchain_.p2p_.requestTxs(nodeId);
+      auto txList = this->blockchain_.p2p_.requestNewTxs(nodeId);
       if (this->stopSyncer_) break;
-      for (auto const& tx : txList) {
-        TxBlock txBlock(tx);
-        this->blockchain_.state_.addTx(std::move(txBlock));
-      }
+      for (auto& tx : txList) this->blockchain_.state_.addTx(std::move(tx));
     }
-    std::this_thread::sleep_for(std::chrono::microseconds(10));
+    events.waitUntil([this]() {
+      return this->blockchain_.state_.getMempoolSize() >= 1 || this->stopSyncer_;
+    }, Syncer::peerPullInterval_);
   }
 
   // Create the block.
@@ -172,14 +181,14 @@ void Syncer::doValidatorBlock() {
   this->blockchain_.state_.fillBlockWithTransactions(block);
   this->blockchain_.state_.rdposSignBlock(block);
   if (!this->blockchain_.state_.validateNextBlock(block)) {
-    Logger::logToDebug(LogType::ERROR, Log::syncer, __func__, "Block is not valid!");
+    LOGERROR(Log::syncer, "Block is not valid!");
     throw DynamicException("Block is not valid!");
   }
   if (this->stopSyncer_) return;
   Hash latestBlockHash = block.hash();
   this->blockchain_.state_.processNextBlock(std::move(block));
   if (this->blockchain_.storage_.latest()->hash() != latestBlockHash) {
-    Logger::logToDebug(LogType::ERROR, Log::syncer, __func__, "Block is not valid!");
+    LOGERROR(Log::syncer, "Block is not valid!");
     throw DynamicException("Block is not valid!");
   }
 
@@ -193,7 +202,7 @@ void Syncer::doValidatorTx() const {
 }
 
 void Syncer::validatorLoop() {
-  Logger::logToDebug(LogType::INFO, Log::syncer, __func__, "Starting validator loop.");
+  LOGINFO(Log::syncer, "Starting validator loop.");
   Validator me(Secp256k1::toAddress(Secp256k1::toUPub(this->blockchain_.options_.getValidatorPrivKey())));
   this->blockchain_.state_.rdposStartWorker();
   while (!this->stopSyncer_) {
@@ -209,26 +218,26 @@ void Syncer::validatorLoop() {
     if (this->stopSyncer_) return;
     if (!isBlockCreator) this->doValidatorTx();
 
-    bool logged = false;
-    while (!this->checkLatestBlock() && !this->stopSyncer_) {
-      if (!logged) {
-        Logger::logToDebug(LogType::INFO, Log::syncer, __func__, "Waiting for next block to be created.");
-        logged = true;
-      }
-      // Wait for next block to be created.
-      std::this_thread::sleep_for(std::chrono::microseconds(10));
+    // Wait for next block to be created.
+    if (!this->checkLatestBlock()) {
+      LOGINFO(Log::syncer, "Waiting for next block to be created.");
     }
+    while (!this->blockchain_.storage_.events().waitUntil([this]() {
+      return this->checkLatestBlock() || this->stopSyncer_;
+    }, Syncer::idleWakeInterval_)) {}
   }
 }
 
 void Syncer::nonValidatorLoop() const {
   // TODO: Improve tx broadcasting and syncing
-  while (!this->stopSyncer_) std::this_thread::sleep_for(std::chrono::microseconds(10));
+  while (!this->blockchain_.storage_.events().waitUntil(
+    [this]() { return bool(this->stopSyncer_); }, Syncer::idleWakeInterval_
+  )) {}
 }
 
 bool Syncer::syncerLoop() {
   Utils::safePrint("Starting OrbiterSDK Node...");
-  Logger::logToDebug(LogType::INFO, Log::syncer, __func__, "Starting syncer loop.");
+  LOGINFO(Log::syncer, "Starting syncer loop.");
   // Connect to all seed nodes from the config and start the discoveryThread.
   auto discoveryNodeList = this->blockchain_.options_.getDiscoveryNodes();
   for (const auto &[ipAddress, port]: discoveryNodeList) {
@@ -258,6 +267,7 @@ void Syncer::start() {
 
 void Syncer::stop() {
   this->stopSyncer_ = true;
+  this->blockchain_.storage_.events().wake();
   this->blockchain_.state_.rdposStopWorker(); // Stop the rdPoS worker.
   if (this->syncerLoopFuture_.valid()) this->syncerLoopFuture_.wait();
 }
@@ -11,6 +11,8 @@ See the LICENSE.txt file in the project root for more information.
 #include "storage.h"
 #include "rdpos.h"
 #include "state.h"
+#include "syncengine.h"
+#include "activityfeed.h"
 #include "../net/p2p/managerbase.h"
 #include "../net/http/httpserver.h"
 #include "../utils/options.h"
@@ -36,6 +38,11 @@ class Syncer {
     std::atomic<bool> stopSyncer_ = false;  ///< Flag for stopping the syncer.
     std::atomic<bool> synced_ = false;  ///< Indicates whether or not the syncer is synced.
 
+    /// How long to wait for transactions to be broadcast to us before pulling them from other nodes.
+    static constexpr std::chrono::milliseconds peerPullInterval_{50};
+    /// Upper bound for a single wait on ChainEvents, waits are woken by events and stop() anyway.
+    static constexpr std::chrono::milliseconds idleWakeInterval_{1000};
+
     void updateCurrentlyConnectedNodes(); ///< Update the list of currently connected nodes.
     bool checkLatestBlock();  ///< Check latest block (used by validatorLoop()).
     void doSync(); ///< Do the syncing.
@@ -90,6 +97,7 @@ class Blockchain {
     P2P::ManagerNormal p2p_;  ///< P2P connection manager.
     HTTPServer http_;         ///< HTTP server.
     Syncer syncer_;           ///< Blockchain syncer.
+    ActivityFeed feed_;       ///< Progress on stdout, only started if enabled in the options.
 
   public:
     /**
@@ -98,8 +106,8 @@ class Blockchain {
      */
     explicit Blockchain(const std::string& blockchainPath);
     ~Blockchain() = default;  ///< Default destructor.
-    void start(); ///< Start the blockchain. Initializes P2P, HTTP and Syncer, in this order.
-    void stop();  ///< Stop/shutdown the blockchain. Stops Syncer, HTTP and P2P, in this order (reverse order of start()).
+    void start(); ///< Start the blockchain. Initializes P2P, HTTP, Syncer and the activity feed, in this order.
+    void stop();  ///< Stop/shutdown the blockchain. Stops the activity feed, Syncer, HTTP and P2P, in this order (reverse order of start()).
 
     ///@{
     /** Getter. */
@@ -110,6 +118,7 @@ class Blockchain {
     P2P::ManagerNormal& getP2P() { return this->p2p_; };
     HTTPServer& getHTTP() { return this->http_; };
     Syncer& getSyncer() { return this->syncer_; };
+    ActivityFeed& getActivityFeed() { return this->feed_; };
     ///@}
 
     const std::atomic<bool>& isSynced() const;  ///< Check if the blockchain syncer is synced.
@@ -0,0 +1,43 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "chainevents.h"
+
+#include <vector>
+
+void ChainEvents::notify(Type type) {
+  this->wake();
+  // Copy the callbacks so they can (un)subscribe without deadlocking
+  std::vector<Callback> callbacks;
+  {
+    std::lock_guard lock(this->subscribersMutex_);
+    for (const auto& [id, subscriber] : this->subscribers_) {
+      if (subscriber.first == type) callbacks.push_back(subscriber.second);
+    }
+  }
+  for (const Callback& callback : callbacks) callback(type);
+}
+
+void ChainEvents::wake() {
+  {
+    std::lock_guard lock(this->mutex_);
+    this->sequence_++;
+  }
+  this->cv_.notify_all();
+}
+
+uint64_t ChainEvents::subscribe(Type type, Callback callback) {
+  std::lock_guard lock(this->subscribersMutex_);
+  uint64_t id = this->nextId_++;
+  this->subscribers_.emplace(id, std::make_pair(type, std::move(callback)));
+  return id;
+}
+
+bool ChainEvents::unsubscribe(uint64_t id) {
+  std::lock_guard lock(this->subscribersMutex_);
+  return this->subscribers_.erase(id) != 0;
+}
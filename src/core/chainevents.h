@@ -0,0 +1,96 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#ifndef CHAINEVENTS_H
+#define CHAINEVENTS_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+
+/**
+ * Notification bus for chain-head changes (owned by Storage, see Storage::events()).
+ * Producers publish an event right after the change is visible (and after releasing
+ * their own locks), consumers either block in waitUntil() on a condition over the
+ * chain/mempool state or register a callback with subscribe().
+ * Waiters evaluate their condition WITHOUT holding the bus lock, so conditions can
+ * freely take other locks (e.g. the State's), and a sequence number bumped by every
+ * notification makes sure a change published between the check and the wait is
+ * never missed.
+ */
+class ChainEvents {
+  public:
+    /// Kinds of events.
+    enum class Type {
+      BlockAppended,        ///< A new block was processed and appended to the chain.
+      TxAdded,              ///< A transaction was added to the mempool.
+      ValidatorTxAdded,     ///< A Validator transaction was added to the rdPoS mempool.
+      BlockCreatorReady     ///< The rdPoS worker has a quorum of Validator transactions to create a block.
+    };
+
+    /// Callback for subscribers. Called on the publishing thread, so it should be quick.
+    using Callback = std::function<void(Type)>;
+
+  private:
+    std::mutex mutex_;                    ///< Mutex for `sequence_`.
+    std::condition_variable cv_;          ///< Condition variable for waiters.
+    uint64_t sequence_ = 0;               ///< Bumped on every notification and wake().
+    std::mutex subscribersMutex_;         ///< Mutex for `subscribers_` and `nextId_`.
+    std::map<uint64_t, std::pair<Type, Callback>> subscribers_; ///< Subscribers by ID.
+    uint64_t nextId_ = 0;                 ///< ID of the next subscriber.
+
+  public:
+    /**
+     * Publish an event: wake every waiter and call every subscriber of its type.
+     * @param type The event type.
+     */
+    void notify(Type type);
+
+    /// Wake every waiter so it rechecks its condition (e.g. after setting a stop flag).
+    void wake();
+
+    /**
+     * Register a callback for an event type.
+     * @param type The event type.
+     * @param callback The function to call on every event of that type.
+     * @return The subscription ID, to be used with unsubscribe().
+     */
+    uint64_t subscribe(Type type, Callback callback);
+
+    /**
+     * Remove a subscription.
+     * @param id The subscription ID.
+     * @return `true` if removed, `false` if not found.
+     */
+    bool unsubscribe(uint64_t id);
+
+    /**
+     * Block until a condition is met or a timeout expires.
+     * The condition is checked right away, then again after every notification.
+     * @param condition The condition to wait for.
+     * @param timeout Maximum time to wait.
+     * @return The final value of the condition (`false` means it timed out).
+     */
+    template <typename Condition> bool waitUntil(Condition condition, std::chrono::milliseconds timeout) {
+      const auto deadline = std::chrono::steady_clock::now() + timeout;
+      while (true) {
+        uint64_t seen;
+        { std::unique_lock lock(this->mutex_); seen = this->sequence_; }
+        if (condition()) return true;
+        std::unique_lock lock(this->mutex_);
+        if (!this->cv_.wait_until(lock, deadline, [&]() { return this->sequence_ != seen; })) {
+          lock.unlock();
+          return condition();
+        }
+      }
+    }
+};
+
+#endif // CHAINEVENTS_H
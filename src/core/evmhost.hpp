@@ -8,12 +8,15 @@ See the LICENSE.txt file in the project root for more information.
 #ifndef EVMHOST_HPP
 #define EVMHOST_HPP
 
+#include <unordered_set>
 #include <evmc/evmc.hpp>
 #include "../utils/utils.h"
 #include "../utils/strings.h"
 #include "../utils/hex.h"
 #include "../utils/safehash.h"
 #include "../utils/db.h"
+#include "../utils/lrucache.h"
+#include "../utils/metrics.h"
 #include "storage.h"
 #include "ecrecoverprecompile.h"
 #include <evmone/evmone.h>
@@ -50,6 +53,8 @@ struct EVMEvent {
 class EVMHost : public evmc::Host {
 public:
   EVMHost(const Storage* storage_, DB* db_, const Options* const options_, evmc_vm* vm_) :  storage(storage_), db(db_), options(options_), vm(vm_) {
+    this->storageCache.setBudget(this->options->getEvmStorageCacheBytes());
+    this->codeCache.setBudget(this->options->getEvmCodeCacheBytes());
     /// Load from DB if we have saved based on the current chain height
     if (db) {
       if (db->has(std::string("latest"), DBPrefix::evmHost)) {
@@ -58,63 +63,38 @@ public:
           throw std::runtime_error("EVMHost: Chain height mismatch, DB is corrupted");
         }
 
-        {
-          auto accountsCodeBatch = db->getBatch(DB::makeNewPrefix(DBPrefix::evmHost, "accounts_code"));
-          auto accountsCodeHashBatch = db->getBatch(DB::makeNewPrefix(DBPrefix::evmHost, "accounts_hashcode"));
-          auto contractAddressesBatch = db->getBatch(DB::makeNewPrefix(DBPrefix::evmHost, "contract_addresses"));
-
-          for (const auto& [key, value] : accountsCodeBatch) {
-            this->accounts[Address(key)].code.first = value;
-            this->accounts[Address(key)].code.second = value;
-          }
-
-          for (const auto& [key, value] : accountsCodeHashBatch) {
-            this->accounts[Address(key)].codeHash.first = Hash(value);
-            this->accounts[Address(key)].codeHash.second = Hash(value);
-          }
-
-          for (const auto& [key, value] : contractAddressesBatch) {
-            this->contractAddresses[Hash(key)] = Address(value);
-          }
-        }
-
-        // We put these into their own scope because they use a lot of memory
-        {
-          auto accountsStorageBatch = db->getBatch(DB::makeNewPrefix(DBPrefix::evmHost, "accounts_storage"));
-          for (const auto& [key, value] : accountsStorageBatch) {
-            BytesArrView keyView(key);
-            Address addr(keyView.subspan(0, 20));
-            Hash realKey(keyView.subspan(20));
-            this->accounts[addr].storage[realKey].first = Hash(value);
-            this->accounts[addr].storage[realKey].second = Hash(value);
-          }
+        // Only contract addresses are loaded eagerly (they are few and tell us
+        // which accounts have code), code and storage are faulted in on first access.
+        auto contractAddressesBatch = db->getBatch(DB::makeNewPrefix(DBPrefix::evmHost, "contract_addresses"));
+        for (const auto& [key, value] : contractAddressesBatch) {
+          this->contractAddresses[Hash(key)] = Address(value);
+          this->evmContracts.insert(Address(value));
         }
       }
     }
   }
 
+  /**
+   * Overlay constructor, for speculative execution.
+   * The overlay starts empty and reads through to `base` on first access of
+   * every account, code and storage slot, without ever modifying it. Everything
+   * read from `base` is remembered (see hasConflicts()) and everything written
+   * ends up in the overlay's own dirty sets (see applyOverlay()).
+   * Several overlays of the same base can run in parallel, as long as the base
+   * itself is not modified meanwhile. Overlays never touch the DB.
+   * Speculative overlays run without a random generator and bail out on randomness,
+   * simulated calls (see State::simulateEvmCall()) bring their own.
+   * @param base_ The host to read through to.
+   * @param vm_ The VM to execute with (VM instances must not be shared between threads).
+   */
+  EVMHost(const EVMHost& base_, evmc_vm* vm_) :
+    vm(vm_), storage(base_.storage), db(nullptr), options(base_.options), base(&base_) {}
+
   ~EVMHost() override {
     if (this->db) {
-      uint64_t lastestBlockHeight = this->storage->latest()->getNHeight();
-      this->db->put(std::string("latest"), Utils::uint64ToBytes(lastestBlockHeight), DBPrefix::evmHost);
+      // Whatever was committed but not yet flushed by the State (e.g. standalone usage) goes here.
       DBBatch batch;
-      for (const auto& [address, account] : this->accounts) {
-        batch.push_back(address.asBytes(), account.code.first, DB::makeNewPrefix(DBPrefix::evmHost, "accounts_code"));
-        batch.push_back(address.asBytes(), account.codeHash.first.asBytes(), DB::makeNewPrefix(DBPrefix::evmHost, "accounts_hashcode"));
-
-        for (const auto& [key, value] : account.storage) {
-          // Key for account storage will be address + key
-          // Vaue is value.first.asBytes()
-          Bytes keyBytes = address.asBytes();
-          Utils::appendBytes(keyBytes, key.asBytes());
-          batch.push_back(keyBytes, value.second.asBytes(), DB::makeNewPrefix(DBPrefix::evmHost, "accounts_storage"));
-        }
-      }
-
-      for (const auto& [txHash, address] : this->contractAddresses) {
-        batch.push_back(txHash.asBytes(), address.asBytes(), DB::makeNewPrefix(DBPrefix::evmHost, "contract_addresses"));
-      }
-
+      this->flushDirty(batch, this->storage->latest()->getNHeight());
       this->db->putBatch(batch);
     }
   }
@@ -124,6 +104,7 @@ public:
   const Storage* storage; // Pointer to the storage object
   DB * const db; // Pointer to the DB object
   const Options * const options; // Pointer to the options object
+  const EVMHost * const base = nullptr; // Host this one is an overlay of (speculative execution only)
 
   /**
    * Internal variables for the EVMHost
@@ -136,7 +117,24 @@ public:
    *   - storage (hash + first)
    * contractAddresses
    */
-  std::unordered_map<Address, EVMAccount, SafeHash> accounts;
+  // Storage slots and code are loaded lazily, see loadStorage()/loadCode().
+  // Those are called from const evmc callbacks, hence the mutable caches.
+  mutable std::unordered_map<Address, EVMAccount, SafeHash> accounts;
+  mutable std::unordered_set<Address, SafeHash> loadedCode;  // Accounts whose code was already faulted in from the DB
+  std::unordered_set<Address, SafeHash> evmContracts;      // Every account with committed code, loaded or not
+  static constexpr uint64_t storageSlotCost = 256;         // Approximate memory footprint of a cached slot, in bytes
+  // LRU over the slots currently held in accounts[].storage (key is address + slot key, value is unused).
+  // The budget comes from Options::getEvmStorageCacheBytes(), the value below is only the default.
+  // Only clean slots are ever evicted, and only between blocks (see trimCaches()).
+  mutable LRUCache<FixedBytes<52>, bool, SafeHash> storageCache{uint64_t(512) * 1024 * 1024};
+  static constexpr uint64_t codeEntryCost = 256;           // Approximate memory footprint of a cached account, in bytes (code size is added on top)
+  // LRU over the accounts in loadedCode (value is unused), costed by their code size.
+  // The budget comes from Options::getEvmCodeCacheBytes(), the value below is only the default.
+  // Only clean code is ever evicted, and only between blocks (see trimCaches()).
+  mutable LRUCache<Address, bool, SafeHash> codeCache{uint64_t(128) * 1024 * 1024};
+  const Bytes codePrefix = DB::makeNewPrefix(DBPrefix::evmHost, "accounts_code");
+  const Bytes codeHashPrefix = DB::makeNewPrefix(DBPrefix::evmHost, "accounts_hashcode");
+  const Bytes storagePrefix = DB::makeNewPrefix(DBPrefix::evmHost, "accounts_storage");
   std::vector<Address> accessedAccountsBalances;           // Used to know what accounts were accessed to commit or reverts
   std::vector<Address> accessedAccountsCode;                   // Used to know what accounts were accessed to commit or reverts
   std::vector<Address> accessedAccountsNonces;                   // Used to know what accounts were accessed to commit or reverts
@@ -144,11 +142,20 @@ public:
   std::unordered_map<Hash, Address, SafeHash> contractAddresses; // Used to know what contract addresses were created based on tx Hash
   std::vector<Hash> recentlyCreatedContracts;              // Used to know what contracts were created to clear
   std::vector<Address> accessedTransients;                 // Used to know what transient storages were accessed to clear
+  std::unordered_set<Address, SafeHash> dirtyAccounts;     // Accounts with committed balance/nonce changes not yet flushed to DB (flushed by the State)
+  std::unordered_set<Address, SafeHash> dirtyCode;         // Accounts with committed code changes not yet flushed to DB
+  std::unordered_map<Address, std::unordered_set<Hash, SafeHash>, SafeHash> dirtyStorages; // Committed storage slots not yet flushed to DB
+  std::vector<Hash> dirtyContractAddresses;                // Contract creation tx hashes not yet flushed to DB
   evmc_tx_context currentTxContext = {};                   // Current transaction context
   Hash currentTxHash;                                      // Current transaction hash
   std::vector<std::array<uint8_t, 32>> m_ecrecover_results; // Used to store the results of ecrecover precompile (so we don't have a memory leak)
   std::vector<Bytes> abiPackResults;                       // Used to store the results of abi precompile (so we don't have a memory leak)
   std::vector<EVMEvent> emittedEvents;                     // Used to store the emitted events by current call
+  // Overlay only: what was read from the base host, used to detect conflicts when applying the overlay.
+  // Storage slots read are the ones present in accounts[].storage.
+  mutable std::unordered_set<Address, SafeHash> loadedAccounts; // Accounts whose balance/nonce were read from base
+  mutable std::unordered_set<Address, SafeHash> codeReads;      // Accounts whose code (or lack of it) was looked at
+  mutable bool usedRandomness = false;                          // Randomness depends on execution order, it can't be speculated
   mutable bool shouldRevert = false;                               // Used to know if we should revert or commit in the case of a exception inside any of the calls below
 
   evmc::Result createContract(const ethCallInfo& tx) {
@@ -157,7 +164,7 @@ public:
    //   throw std::runtime_error("Only the chain owner can create contracts");//
    // }
 
-    const auto contractAddress = deriveContractAddress(this->accounts[from].nonce.second, from);
+    const auto contractAddress = deriveContractAddress(this->loadAccount(from).nonce.second, from);
     evmc_message creationMsg;
     creationMsg.kind = evmc_call_kind::EVMC_CREATE;
     creationMsg.gas = static_cast<uint64_t>(gasLimit);
@@ -180,8 +187,9 @@ public:
     }
     // Store contract code into the account
     Bytes code = Utils::cArrayToBytes(creationResult.output_data, creationResult.output_size);
-    this->accounts[contractAddress].codeHash.second = Utils::sha3(code);
-    this->accounts[contractAddress].code.second = code;
+    auto& contractAccount = this->loadCode(contractAddress);
+    contractAccount.codeHash.second = Utils::sha3(code);
+    contractAccount.code.second = code;
     // Stored used to revert in case of exception
     this->recentlyCreatedContracts.push_back(currentTxHash);
     this->contractAddresses[currentTxHash] = contractAddress;
@@ -191,6 +199,10 @@ public:
   }
 
   evmc::Result execute(const ethCallInfo& tx, RandomGen* randomGen_) {
+    static Metrics::Histogram& executeSeconds = Metrics::histogram(
+      "orbiter_evm_execution_seconds", "Time spent executing EVM calls and contract creations."
+    );
+    Metrics::Timer timer(executeSeconds);
     this->randomGen = randomGen_;
     const auto& [from, to, gasLimit, gasPrice, value, functor, data, fullData] = tx;
 
@@ -210,9 +222,10 @@ public:
     msg.depth = 1;
     msg.code_address = to.toEvmcAddress();
 
+    const auto& code = this->loadCode(to).code.second;
     return evmc::Result(evmc_execute(this->vm, &this->get_interface(), this->to_context(),
                evmc_revision::EVMC_LATEST_STABLE_REVISION, &msg,
-                accounts[to].code.second.data(), accounts[to].code.second.size()));
+                code.data(), code.size()));
   }
 
 
@@ -233,7 +246,16 @@ public:
     return Address(Utils::sha3(rlp).view(12));
   }
 
-  bool isEvmContract(const Address& address) {
+  /**
+   * Check if an address has EVM code. Never touches the DB nor the caches,
+   * so it is safe to call while the State is only locked for reading.
+   */
+  bool isEvmContract(const Address& address) const {
+    if (this->evmContracts.contains(address)) return true;
+    if (this->base) {
+      this->codeReads.insert(address);
+      if (!this->loadedCode.contains(address)) return this->base->isEvmContract(address);
+    }
     auto it = this->accounts.find(address);
     if (it == this->accounts.end()) {
       return false;
@@ -241,6 +263,194 @@ public:
     return it->second.code.second.size() > 0;
   }
 
+  /**
+   * Get an account's code without faulting it into the cache.
+   * Safe to call while the State is only locked for reading.
+   */
+  Bytes peekCode(const Address& address) const {
+    auto it = this->accounts.find(address);
+    if (it != this->accounts.end() && (this->loadedCode.contains(address) || !this->db)) {
+      return it->second.code.second;
+    }
+    if (!this->db || !this->evmContracts.contains(address)) return {};
+    return this->db->get(address.asBytes(), this->codePrefix);
+  }
+
+  /**
+   * Get an account's code hash without faulting it into the cache.
+   * Safe to call while the State is only locked for reading.
+   */
+  Hash peekCodeHash(const Address& address) const {
+    auto it = this->accounts.find(address);
+    if (it != this->accounts.end() && (this->loadedCode.contains(address) || !this->db)) {
+      return it->second.codeHash.second;
+    }
+    if (!this->db || !this->evmContracts.contains(address)) return Hash();
+    Bytes codeHash = this->db->get(address.asBytes(), this->codeHashPrefix);
+    return (codeHash.size() == 32) ? Hash(codeHash) : Hash();
+  }
+
+  /**
+   * Get a storage slot's current value without faulting it into the cache.
+   * Safe to call while the State is only locked for reading.
+   */
+  Hash peekStorage(const Address& address, const Hash& key) const {
+    auto acc = this->accounts.find(address);
+    if (acc != this->accounts.end()) {
+      auto slot = acc->second.storage.find(key);
+      if (slot != acc->second.storage.end()) return slot->second.second;
+    }
+    if (!this->db) return Hash();
+    Bytes slotKey = address.asBytes();
+    Utils::appendBytes(slotKey, key.asBytes());
+    Bytes value = this->db->get(slotKey, this->storagePrefix);
+    return (value.size() == 32) ? Hash(value) : Hash();
+  }
+
+  /**
+   * Get an account for reading/writing its balance and nonce.
+   * Overlays fault the balance and nonce in from the base host on first access,
+   * regular hosts always have every account in memory.
+   * @param address The account's address.
+   * @return A reference to the account.
+   */
+  EVMAccount& loadAccount(const Address& address) const {
+    auto& account = this->accounts[address];
+    if (this->base && this->loadedAccounts.insert(address).second) {
+      auto it = this->base->accounts.find(address);
+      if (it != this->base->accounts.end()) {
+        account.balance.first = account.balance.second = it->second.balance.second;
+        account.nonce.first = account.nonce.second = it->second.nonce.second;
+      }
+    }
+    return account;
+  }
+
+  /**
+   * Get an account, faulting its code and code hash in from the DB if needed.
+   * Only to be called while the State is locked for writing.
+   * @param address The account's address.
+   * @return A reference to the account.
+   */
+  EVMAccount& loadCode(const Address& address) const {
+    auto& account = this->accounts[address];
+    if (this->base) {
+      this->codeReads.insert(address);
+      if (this->loadedCode.insert(address).second) {
+        account.code.first = account.code.second = this->base->peekCode(address);
+        account.codeHash.first = account.codeHash.second = this->base->peekCodeHash(address);
+      }
+      return account;
+    }
+    if (!this->loadedCode.insert(address).second) {
+      this->codeCache.touch(address);
+      return account;
+    }
+    if (this->db && this->evmContracts.contains(address)) {
+      Bytes code = this->db->get(address.asBytes(), this->codePrefix);
+      Bytes codeHash = this->db->get(address.asBytes(), this->codeHashPrefix);
+      account.code.first = account.code.second = code;
+      if (codeHash.size() == 32) account.codeHash.first = account.codeHash.second = Hash(codeHash);
+    }
+    // Accounts without code are cached too, they still cost an entry in accounts[]
+    this->cacheCode(address, account);
+    return account;
+  }
+
+  /**
+   * (Re)insert an account into the code LRU, costed by its current code.
+   * Hosts without a DB can't fault code back in, so they never cache it.
+   * @param address The account's address.
+   * @param account The account itself.
+   */
+  void cacheCode(const Address& address, const EVMAccount& account) const {
+    if (!this->db || this->base) return;
+    this->codeCache.put(address, true, codeEntryCost + account.code.second.size());
+  }
+
+  /**
+   * Get a storage slot, faulting it in from the DB if needed.
+   * Slots that don't exist in the DB are cached as zero too, so misses hit the DB only once.
+   * Only to be called while the State is locked for writing.
+   * @param address The account's address.
+   * @param key The slot's key.
+   * @return A reference to the (original, current) slot values.
+   */
+  std::pair<Hash, Hash>& loadStorage(const Address& address, const Hash& key) const {
+    Bytes slotKey = address.asBytes();
+    Utils::appendBytes(slotKey, key.asBytes());
+    auto& storage = this->accounts[address].storage;
+    auto it = storage.find(key);
+    if (it != storage.end()) {
+      this->storageCache.touch(FixedBytes<52>(slotKey));
+      return it->second;
+    }
+    auto& slot = storage[key];
+    if (this->base) {
+      // Overlays are short lived, no need to keep them in the LRU
+      slot.first = slot.second = this->base->peekStorage(address, key);
+      return slot;
+    }
+    if (this->db) {
+      Bytes value = this->db->get(slotKey, this->storagePrefix);
+      if (value.size() == 32) slot.first = slot.second = Hash(value);
+    }
+    this->storageCache.put(FixedBytes<52>(slotKey), true, storageSlotCost);
+    return slot;
+  }
+
+  /**
+   * Evict the least recently used storage slots and code until both caches fit
+   * their budgets again, then drop the accounts that were left empty.
+   * Only clean entries can be evicted, so each cache is left alone while a transaction
+   * is in flight or while it has unflushed entries. Called by the State after every flush.
+   * @return The number of evicted entries (slots and code).
+   */
+  uint64_t trimCaches() {
+    uint64_t evicted = 0;
+    std::unordered_set<Address, SafeHash> touched;
+    if (this->accessedStorages.empty() && this->dirtyStorages.empty()) {
+      evicted += this->storageCache.trim([&](const FixedBytes<52>& slotKey, bool&) {
+        Address address(slotKey.view(0, 20));
+        auto acc = this->accounts.find(address);
+        if (acc != this->accounts.end()) acc->second.storage.erase(Hash(slotKey.view(20, 32)));
+        touched.insert(address);
+      });
+    }
+    if (this->db && this->accessedAccountsCode.empty() && this->dirtyCode.empty()) {
+      evicted += this->codeCache.trim([&](const Address& address, bool&) {
+        // evmContracts still knows it has code, so loadCode() faults it back in
+        auto acc = this->accounts.find(address);
+        if (acc != this->accounts.end()) {
+          acc->second.code = {};
+          acc->second.codeHash = {};
+        }
+        this->loadedCode.erase(address);
+        touched.insert(address);
+      });
+    }
+    for (const auto& address : touched) this->dropIfEmpty(address);
+    return evicted;
+  }
+
+  /**
+   * Drop an account from memory if nothing in it needs to stay resident:
+   * no cached code or storage and no balance or nonce. Accounts with a balance
+   * or nonce are always kept, as the State reads them straight from `accounts`.
+   * @param address The account's address.
+   */
+  void dropIfEmpty(const Address& address) {
+    auto it = this->accounts.find(address);
+    if (it == this->accounts.end()) return;
+    const EVMAccount& account = it->second;
+    if (this->loadedCode.contains(address) || this->dirtyAccounts.contains(address)) return;
+    if (!this->accessedAccountsBalances.empty() || !this->accessedAccountsNonces.empty()) return;
+    if (!account.storage.empty() || !account.transientStorage.empty()) return;
+    if (account.balance.first != 0 || account.balance.second != 0) return;
+    if (account.nonce.first != 0 || account.nonce.second != 0) return;
+    this->accounts.erase(it);
+  }
+
   void setTxContext(const ethCallInfo& tx,
                     const Hash& blockHash,
                     const uint64_t& blockHeight,
@@ -265,8 +475,15 @@ public:
 
     bool account_exists(const evmc::address& addr) const noexcept override {
       try {
+        // Entries in accounts may exist just because a slot was cached, so look at the contents instead
         Address address(addr);
-        return this->accounts.find(address) != this->accounts.end();
+        if (this->isEvmContract(address)) return true;
+        if (this->base) {
+          const auto& acc = this->loadAccount(address);
+          return acc.nonce.second != 0 || acc.balance.second != 0;
+        }
+        const auto acc = this->accounts.find(address);
+        return acc != this->accounts.end() && (acc->second.nonce.second != 0 || acc->second.balance.second != 0);
       } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
         this->shouldRevert = true;
@@ -275,15 +492,7 @@ public:
     }
     evmc::bytes32 get_storage(const evmc::address& addr, const evmc::bytes32& key) const noexcept override {
       try {
-        const auto acc = this->accounts.find(addr);
-        if (acc == this->accounts.end()) {
-          return {};
-        }
-        const auto storage = acc->second.storage.find(key);
-        if (storage == acc->second.storage.end()) {
-          return {};
-        }
-        return storage->second.second.toEvmcBytes32();
+        return this->loadStorage(addr, key).second.toEvmcBytes32();
       } catch (std::exception& e) {
         std::cerr << e.what() << std::endl;
         this->shouldRevert = true;
@@ -292,9 +501,8 @@ public:
     }
 
     evmc_storage_status set_storage(const evmc::address& addr, const evmc::bytes32& key, const evmc::bytes32& value) noexcept override {
-      auto& oldVal = this->accounts[addr].storage[key];
-
       try {
+        auto& oldVal = this->loadStorage(addr, key);
         this->accessedStorages.emplace_back(addr, key);
         // bytes32 is an array of uint8_t bytes[32];, Hash .raw() returns a pointer to the start of a std::array<uint8_t, 32>
         // We can can the pointer to a bytes32
@@ -330,6 +538,7 @@ public:
 
     evmc::uint256be get_balance(const evmc::address& addr) const noexcept override {
       try {
+        if (this->base) return Utils::uint256ToEvmcUint256(this->loadAccount(addr).balance.second);
         const auto acc = this->accounts.find(addr);
         if (acc == this->accounts.end()) {
           return {};
@@ -344,11 +553,8 @@ public:
 
     size_t get_code_size(const evmc::address& addr) const noexcept override {
       try {
-        const auto acc = this->accounts.find(addr);
-        if (acc == this->accounts.end()) {
-          return 0;
-        }
-        return acc->second.code.second.size();
+        if (!this->isEvmContract(addr)) return 0;
+        return this->loadCode(addr).code.second.size();
       } catch (std::exception& e) {
         std::cerr << e.what() << std::endl;
         this->shouldRevert = true;
@@ -358,11 +564,8 @@ public:
 
     evmc::bytes32 get_code_hash(const evmc::address& addr) const noexcept override {
       try {
-        const auto acc = this->accounts.find(addr);
-        if (acc == this->accounts.end()) {
-          return {};
-        }
-        return acc->second.codeHash.second.toEvmcBytes32();
+        if (!this->isEvmContract(addr)) return {};
+        return this->loadCode(addr).codeHash.second.toEvmcBytes32();
       } catch (std::exception& e) {
         std::cerr << e.what() << std::endl;
         this->shouldRevert = true;
@@ -372,11 +575,10 @@ public:
 
     size_t copy_code(const evmc::address& addr, size_t code_offset, uint8_t* buffer_data, size_t buffer_size) const noexcept override {
       try {
-        const auto it = accounts.find(addr);
-        if (it == accounts.end())
+        if (!this->isEvmContract(addr))
           return 0;
 
-        const auto& code = it->second.code.second;
+        const auto& code = this->loadCode(addr).code.second;
 
         if (code_offset >= code.size())
           return 0;
@@ -405,6 +607,14 @@ public:
       }
       if (msg.recipient == RANDOM) {
         static Functor RANDOMNESS(Hex::toBytes("0xaacc5a17"));
+        if (this->base && !this->randomGen) {
+          // The generator's state depends on every call before this one, bail out
+          this->usedRandomness = true;
+          evmc::Result result;
+          result.status_code = EVMC_REVERT;
+          result.output_size = 0;
+          return result;
+        }
         if (msg.input_size < 4) {
           evmc::Result result;
           result.status_code = EVMC_REVERT;
@@ -448,9 +658,10 @@ public:
         return result;
       }
 
+      const auto& code = this->loadCode(msg.recipient).code.second;
       evmc::Result result (evmc_execute(this->vm, &this->get_interface(), this->to_context(),
                evmc_revision::EVMC_LATEST_STABLE_REVISION, &msg,
-               accounts[msg.recipient].code.second.data(), accounts[msg.recipient].code.second.size()));
+               code.data(), code.size()));
       return result;
     }
 
@@ -517,12 +728,13 @@ public:
     }
 
     void setBalance(const Address& address, const uint256_t& balance) {
-      this->accounts[address].balance.second = balance;
+      this->loadAccount(address).balance.second = balance;
     }
 
     void commit() {
       for (const auto& [addr, key] : this->accessedStorages) {
         this->accounts[addr].storage[key].first = this->accounts[addr].storage[key].second;
+        this->dirtyStorages[addr].insert(key);
       }
       for (const auto& addr : this->accessedTransients) {
         this->accounts[addr].transientStorage.clear();
@@ -538,6 +750,7 @@ public:
     void commitBalance() {
       for (const auto& addr : this->accessedAccountsBalances) {
         this->accounts[addr].balance.first = this->accounts[addr].balance.second;
+        this->dirtyAccounts.insert(addr);
       }
       this->accessedAccountsBalances.clear();
     }
@@ -553,7 +766,13 @@ public:
       for (const auto& addr : this->accessedAccountsCode) {
         this->accounts[addr].code.first = this->accounts[addr].code.second;
         this->accounts[addr].codeHash.first = this->accounts[addr].codeHash.second;
+        if (!this->accounts[addr].code.first.empty()) this->evmContracts.insert(addr);
+        this->dirtyCode.insert(addr);
+        this->cacheCode(addr, this->accounts[addr]);
       }
+      this->dirtyContractAddresses.insert(this->dirtyContractAddresses.end(),
+        this->recentlyCreatedContracts.begin(), this->recentlyCreatedContracts.end()
+      );
       this->recentlyCreatedContracts.clear();
       this->accessedAccountsCode.clear();
     }
@@ -569,6 +788,7 @@ public:
     void commitNonce() {
       for (const auto& addr : this->accessedAccountsNonces) {
         this->accounts[addr].nonce.first = this->accounts[addr].nonce.second;
+        this->dirtyAccounts.insert(addr);
       }
       this->accessedAccountsNonces.clear();
     }
@@ -580,6 +800,107 @@ public:
       this->accessedAccountsNonces.clear();
     }
 
+    /**
+     * Check if an overlay read anything this host has written since its last flush.
+     * Called while applying speculative results in order: this host's dirty sets then
+     * hold exactly what the transactions before the overlay's one wrote in the block.
+     * @param overlay The overlay to check (must have this host as its base).
+     * @return `true` if the overlay's reads are stale and it must be re-executed, `false` otherwise.
+     */
+    bool hasConflicts(const EVMHost& overlay) const {
+      for (const auto& address : overlay.loadedAccounts) {
+        if (this->dirtyAccounts.contains(address)) return true;
+      }
+      for (const auto& address : overlay.codeReads) {
+        if (this->dirtyCode.contains(address)) return true;
+      }
+      for (const auto& [address, account] : overlay.accounts) {
+        auto dirty = this->dirtyStorages.find(address);
+        if (dirty == this->dirtyStorages.end()) continue;
+        for (const auto& [key, slot] : account.storage) {
+          if (dirty->second.contains(key)) return true;
+        }
+      }
+      return false;
+    }
+
+    /**
+     * Copy everything an overlay committed into this host, as if it had been
+     * executed here. Only to be called if hasConflicts() is false.
+     * @param overlay The overlay to apply (must have this host as its base).
+     */
+    void applyOverlay(const EVMHost& overlay) {
+      for (const auto& address : overlay.dirtyAccounts) {
+        const auto& source = overlay.accounts.at(address);
+        auto& account = this->accounts[address];
+        account.balance.first = account.balance.second = source.balance.first;
+        account.nonce.first = account.nonce.second = source.nonce.first;
+        this->dirtyAccounts.insert(address);
+      }
+      for (const auto& [address, keys] : overlay.dirtyStorages) {
+        const auto& source = overlay.accounts.at(address).storage;
+        for (const auto& key : keys) {
+          auto& slot = this->loadStorage(address, key);
+          slot.first = slot.second = source.at(key).first;
+          this->dirtyStorages[address].insert(key);
+        }
+      }
+      for (const auto& address : overlay.dirtyCode) {
+        const auto& source = overlay.accounts.at(address);
+        auto& account = this->loadCode(address);
+        account.code.first = account.code.second = source.code.first;
+        account.codeHash.first = account.codeHash.second = source.codeHash.first;
+        if (!account.code.first.empty()) this->evmContracts.insert(address);
+        this->dirtyCode.insert(address);
+        this->cacheCode(address, account);
+      }
+      for (const auto& txHash : overlay.dirtyContractAddresses) {
+        this->contractAddresses[txHash] = overlay.contractAddresses.at(txHash);
+        this->dirtyContractAddresses.push_back(txHash);
+      }
+    }
+
+    /**
+     * Append every committed-but-unflushed code, code hash, storage slot and
+     * contract address to a batch, together with the height they belong to.
+     * Balances and nonces (dirtyAccounts) are left for the State to serialize,
+     * as they live under DBPrefix::nativeAccounts.
+     * Only committed ("first") values are written, so this is safe to call
+     * between transactions but never in the middle of one.
+     * @param batch The batch to append to.
+     * @param blockHeight The height of the block the flushed state belongs to.
+     */
+    void flushDirty(DBBatch& batch, const uint64_t& blockHeight) {
+      const Bytes contractAddressesPrefix = DB::makeNewPrefix(DBPrefix::evmHost, "contract_addresses");
+
+      for (const auto& address : this->dirtyCode) {
+        const auto& account = this->accounts[address];
+        batch.push_back(address.asBytes(), account.code.first, this->codePrefix);
+        batch.push_back(address.asBytes(), account.codeHash.first.asBytes(), this->codeHashPrefix);
+      }
+
+      for (const auto& [address, keys] : this->dirtyStorages) {
+        const auto& account = this->accounts[address];
+        for (const auto& key : keys) {
+          // Key for account storage will be address + key
+          Bytes keyBytes = address.asBytes();
+          Utils::appendBytes(keyBytes, key.asBytes());
+          batch.push_back(keyBytes, account.storage.at(key).first.asBytes(), this->storagePrefix);
+        }
+      }
+
+      for (const auto& txHash : this->dirtyContractAddresses) {
+        auto it = this->contractAddresses.find(txHash);
+        if (it == this->contractAddresses.end()) continue;
+        batch.push_back(txHash.asBytes(), it->second.asBytes(), contractAddressesPrefix);
+      }
+
+      batch.push_back(Utils::stringToBytes("latest"), Utils::uint64ToBytes(blockHeight), DBPrefix::evmHost);
+      this->dirtyCode.clear();
+      this->dirtyStorages.clear();
+      this->dirtyContractAddresses.clear();
+    }
+
     void revert(bool log = false) {
       for (const auto& [addr, key] : this->accessedStorages) {
         this->accounts[addr].storage[key].second = this->accounts[addr].storage[key].first;
@@ -0,0 +1,147 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "mempool.h"
+
+#include <queue>
+
+std::map<uint64_t, TxBlock>::iterator Mempool::erase(
+  std::map<uint64_t, TxBlock>& queue, std::map<uint64_t, TxBlock>::iterator queueIt
+) {
+  const Hash hash = queueIt->second.hash();
+  this->byTip_.erase({Mempool::effectiveTip(queueIt->second), hash});
+  this->index_.erase(hash);
+  return queue.erase(queueIt);
+}
+
+void Mempool::dropIfEmpty(const Address& sender) {
+  auto it = this->senders_.find(sender);
+  if (it != this->senders_.end() && it->second.empty()) this->senders_.erase(it);
+}
+
+void Mempool::evictLowest() {
+  if (this->byTip_.empty()) return;
+  // Later nonces of the same sender can't be executed without it, so they go too
+  const auto [sender, nonce] = this->index_.at(std::get<1>(*this->byTip_.begin()));
+  auto& queue = this->senders_.at(sender);
+  auto it = queue.find(nonce);
+  while (it != queue.end()) it = this->erase(queue, it);
+  this->dropIfEmpty(sender);
+}
+
+TxInvalid Mempool::add(TxBlock&& tx) {
+  if (this->index_.contains(tx.hash())) return TxInvalid::NotInvalid;
+  const Address sender = tx.getFrom();
+  const uint64_t nonce = static_cast<uint64_t>(tx.getNonce());
+  const uint256_t tip = Mempool::effectiveTip(tx);
+
+  // Same sender and nonce: replace the old one only if the new one pays at least 10% more
+  auto senderIt = this->senders_.find(sender);
+  if (senderIt != this->senders_.end()) {
+    auto queueIt = senderIt->second.find(nonce);
+    if (queueIt != senderIt->second.end()) {
+      if (tip * 10 < Mempool::effectiveTip(queueIt->second) * 11) return TxInvalid::Underpriced;
+      this->erase(senderIt->second, queueIt);
+    }
+  }
+
+  // Pool is full: make room by evicting the worst paying transaction, if it pays less than this one
+  if (this->index_.size() >= this->capacity_) {
+    if (tip <= std::get<0>(*this->byTip_.begin())) return TxInvalid::Underpriced;
+    this->evictLowest();
+  }
+
+  const Hash hash = tx.hash();
+  this->byTip_.emplace(tip, hash);
+  this->index_.emplace(hash, std::make_pair(sender, nonce));
+  this->senders_[sender].emplace(nonce, std::move(tx));
+  return TxInvalid::NotInvalid;
+}
+
+uint64_t Mempool::revalidate(const Address& sender, const AccountInfo& account) {
+  auto senderIt = this->senders_.find(sender);
+  if (senderIt == this->senders_.end()) return 0;
+  const auto& [nonce, balance] = account;
+  uint64_t dropped = 0;
+  auto& queue = senderIt->second;
+  auto it = queue.begin();
+  while (it != queue.end()) {
+    if (it->first < nonce || Mempool::maxCost(it->second) > balance) {
+      it = this->erase(queue, it);
+      dropped++;
+    } else {
+      it++;
+    }
+  }
+  this->dropIfEmpty(sender);
+  return dropped;
+}
+
+std::vector<TxBlock> Mempool::collect(const std::function<AccountInfo(const Address&)>& accountOf) const {
+  using QueueIt = std::map<uint64_t, TxBlock>::const_iterator;
+  std::vector<TxBlock> txs;
+  txs.reserve(this->index_.size());
+
+  // Cursor of every executable sender (next transaction, end of its queue and balance left),
+  // and the cursors' transactions ordered by tip (hash breaks ties, so every node picks the same)
+  std::unordered_map<Address, std::tuple<QueueIt, QueueIt, uint256_t>, SafeHash> cursors;
+  std::priority_queue<std::tuple<uint256_t, Hash, Address>> heads;
+  for (const auto& [sender, queue] : this->senders_) {
+    const auto [nonce, balance] = accountOf(sender);
+    auto it = queue.begin();
+    // Stuck behind a nonce gap, or not enough balance for the first transaction
+    if (it->first != nonce || Mempool::maxCost(it->second) > balance) continue;
+    heads.emplace(Mempool::effectiveTip(it->second), it->second.hash(), sender);
+    cursors.emplace(sender, std::make_tuple(it, queue.end(), balance));
+  }
+
+  while (!heads.empty()) {
+    const Address sender = std::get<2>(heads.top());
+    heads.pop();
+    auto& [it, end, balance] = cursors.at(sender);
+    balance -= Mempool::maxCost(it->second);
+    txs.emplace_back(it->second);
+    const uint64_t nonce = it->first;
+    it++;
+    if (it == end || it->first != nonce + 1 || Mempool::maxCost(it->second) > balance) continue;
+    heads.emplace(Mempool::effectiveTip(it->second), it->second.hash(), sender);
+  }
+  return txs;
+}
+
+const TxBlock* Mempool::get(const Hash& txHash) const {
+  auto it = this->index_.find(txHash);
+  if (it == this->index_.end()) return nullptr;
+  return &this->senders_.at(it->second.first).at(it->second.second);
+}
+
+std::vector<Hash> Mempool::hashes() const {
+  std::vector<Hash> hashes;
+  hashes.reserve(this->index_.size());
+  for (const auto& [txHash, location] : this->index_) hashes.emplace_back(txHash);
+  return hashes;
+}
+
+std::unordered_map<uint64_t, TxBlock> Mempool::getByShortIds(const std::unordered_set<uint64_t>& shortIds) const {
+  std::unordered_map<uint64_t, TxBlock> txs;
+  if (shortIds.empty()) return txs;
+  txs.reserve(shortIds.size());
+  for (const auto& [txHash, location] : this->index_) {
+    uint64_t id = Mempool::shortId(txHash);
+    if (shortIds.contains(id)) txs.emplace(id, this->senders_.at(location.first).at(location.second));
+  }
+  return txs;
+}
+
+std::unordered_map<Hash, TxBlock, SafeHash> Mempool::getTxs() const {
+  std::unordered_map<Hash, TxBlock, SafeHash> txs;
+  txs.reserve(this->index_.size());
+  for (const auto& [sender, queue] : this->senders_) {
+    for (const auto& [nonce, tx] : queue) txs.emplace(tx.hash(), tx);
+  }
+  return txs;
+}
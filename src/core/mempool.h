@@ -0,0 +1,163 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#ifndef MEMPOOL_H
+#define MEMPOOL_H
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../utils/tx.h"
+#include "../utils/safehash.h"
+#include "../utils/strings.h"
+
+/// Enum for labeling transaction validity.
+enum TxInvalid { NotInvalid, InvalidNonce, InvalidBalance, Underpriced };
+
+/**
+ * Pool of pending block transactions.
+ * Transactions are kept in per-sender queues ordered by nonce, so a sender can
+ * queue transactions ahead of its current account nonce (up to `senderCapacity_`
+ * of them). A global index sorted by effective tip decides which transaction
+ * gets evicted when the pool is full, and block building picks the best paying
+ * executable transaction of every sender first, always respecting nonce order.
+ * Account state is never read directly, callers pass it in (see State).
+ * NOT thread-safe, callers are expected to provide their own locking.
+ */
+class Mempool {
+  public:
+    /// Account information needed to tell if a queue is executable (nonce and balance).
+    using AccountInfo = std::pair<uint64_t, uint256_t>;
+
+  private:
+    /// Per-sender queues, ordered by nonce.
+    std::unordered_map<Address, std::map<uint64_t, TxBlock>, SafeHash> senders_;
+    /// Lookup index from transaction hash to its sender and nonce.
+    std::unordered_map<Hash, std::pair<Address, uint64_t>, SafeHash> index_;
+    /// Every transaction sorted by effective tip (lowest first), then hash.
+    std::set<std::tuple<uint256_t, Hash>> byTip_;
+    const uint64_t capacity_; ///< Maximum number of transactions in the pool.
+    const uint64_t senderCapacity_; ///< Maximum number of transactions per sender (and how far ahead of the account nonce they can go).
+
+    /**
+     * Remove a transaction from the queue of its sender and from every index.
+     * @param queue The queue of the transaction's sender.
+     * @param queueIt Iterator to the transaction in `queue`.
+     * @return Iterator to the next transaction in the sender's queue.
+     */
+    std::map<uint64_t, TxBlock>::iterator erase(
+      std::map<uint64_t, TxBlock>& queue, std::map<uint64_t, TxBlock>::iterator queueIt
+    );
+
+    /// Drop the queue of a sender if it became empty.
+    void dropIfEmpty(const Address& sender);
+
+    /// Evict the transaction with the lowest tip, along with the later nonces of its sender.
+    void evictLowest();
+
+  public:
+    /**
+     * Constructor.
+     * @param capacity Maximum number of transactions in the pool. Defaults to 8192.
+     * @param senderCapacity Maximum number of transactions per sender. Defaults to 64.
+     */
+    explicit Mempool(uint64_t capacity = 8192, uint64_t senderCapacity = 64)
+      : capacity_(capacity), senderCapacity_(senderCapacity) {}
+
+    /**
+     * Get the tip a transaction effectively pays to the block producer.
+     * There is no base fee, so that's the priority fee capped by the max fee.
+     * @param tx The transaction.
+     * @return The effective tip per gas.
+     */
+    static uint256_t effectiveTip(const TxBlock& tx) {
+      return std::min(tx.getMaxPriorityFeePerGas(), tx.getMaxFeePerGas());
+    }
+
+    /// Get the maximum amount a transaction can cost its sender (value + gas limit * max fee).
+    static uint256_t maxCost(const TxBlock& tx) {
+      return tx.getValue() + (tx.getGasLimit() * tx.getMaxFeePerGas());
+    }
+
+    /**
+     * Add a transaction already validated against the sender's account (see State::addTx()).
+     * A transaction with the same sender and nonce of one in the pool replaces it only
+     * if it pays at least 10% more tip. If the pool is full, the transaction with the
+     * lowest tip is evicted, unless the new one doesn't pay more than it.
+     * @param tx The transaction to add.
+     * @return NotInvalid if added (or already in the pool), Underpriced otherwise.
+     */
+    TxInvalid add(TxBlock&& tx);
+
+    /**
+     * Revalidate the queue of a sender after its account changed (e.g. after a block),
+     * dropping every transaction with an already used nonce or that costs more than the balance.
+     * @param sender The sender to revalidate.
+     * @param account The sender's current account nonce and balance.
+     * @return The number of dropped transactions.
+     */
+    uint64_t revalidate(const Address& sender, const AccountInfo& account);
+
+    /**
+     * Select the transactions to put in a block, best tip first.
+     * Only a contiguous run of nonces starting at each sender's account nonce is
+     * taken, and only while the sender's balance covers the cost of all of them.
+     * @param accountOf Function returning the current nonce and balance of a sender.
+     * @return The selected transactions, in execution order.
+     */
+    std::vector<TxBlock> collect(const std::function<AccountInfo(const Address&)>& accountOf) const;
+
+    /// Check if a transaction is in the pool.
+    bool contains(const Hash& txHash) const { return this->index_.contains(txHash); }
+
+    /**
+     * Get a transaction from the pool.
+     * @param txHash The transaction hash.
+     * @return A pointer to the transaction, or `nullptr` if not found.
+     *         Only valid until the next mutating call.
+     */
+    const TxBlock* get(const Hash& txHash) const;
+
+    /// Get a copy of every transaction in the pool, indexed by hash.
+    std::unordered_map<Hash, TxBlock, SafeHash> getTxs() const;
+
+    /// Get the hashes of every transaction in the pool.
+    std::vector<Hash> hashes() const;
+
+    /// Get the short ID of a transaction (the first 8 bytes of its hash), as used by compact block relay.
+    static uint64_t shortId(const Hash& txHash) { return Utils::bytesToUint64(txHash.view(0, 8)); }
+
+    /**
+     * Get copies of the transactions with the given short IDs (see shortId()).
+     * @param shortIds The short IDs to look for.
+     * @return The transactions found, by short ID.
+     */
+    std::unordered_map<uint64_t, TxBlock> getByShortIds(const std::unordered_set<uint64_t>& shortIds) const;
+
+    /// Get the number of transactions in the pool.
+    uint64_t size() const { return this->index_.size(); }
+
+    /// Get the number of senders with queued transactions.
+    uint64_t senderCount() const { return this->senders_.size(); }
+
+    ///@{
+    /** Getter. */
+    uint64_t capacity() const { return this->capacity_; }
+    uint64_t senderCapacity() const { return this->senderCapacity_; }
+    ///@}
+
+    /// Drop every transaction.
+    void clear() { this->senders_.clear(); this->index_.clear(); this->byTip_.clear(); }
+};
+
+#endif // MEMPOOL_H
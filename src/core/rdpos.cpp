@@ -20,7 +20,7 @@ rdPoS::rdPoS(DB& db, const Storage& storage, P2P::ManagerNormal& p2p, const Opti
 {
   // Initialize blockchain.
   std::unique_lock lock(this->mutex_);
-  Logger::logToDebug(LogType::INFO, Log::rdPoS, __func__, "Initializing rdPoS.");
+  LOGINFO(Log::rdPoS, "Initializing rdPoS.");
   initializeBlockchain();
 
   /**
@@ -32,10 +32,10 @@ rdPoS::rdPoS(DB& db, const Storage& storage, P2P::ManagerNormal& p2p, const Opti
   auto validatorsDb = db_.getBatch(DBPrefix::rdPoS);
   if (validatorsDb.empty()) {
     // No rdPoS in DB, this should have been initialized by Storage.
-    Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__, "No rdPoS in DB, cannot proceed.");
+    LOGERROR(Log::rdPoS, "No rdPoS in DB, cannot proceed.");
     throw DynamicException("No rdPoS in DB.");
   }
-  Logger::logToDebug(LogType::INFO, Log::rdPoS, __func__, "Found " + std::to_string(validatorsDb.size()) + " rdPoS in DB");
+  LOGINFO(Log::rdPoS, "Found " + std::to_string(validatorsDb.size()) + " rdPoS in DB");
   // TODO: check if no index is missing from DB.
   for (const auto& validator : validatorsDb) {
     this->validators_.insert(Validator(Address(validator.value)));
@@ -50,16 +50,20 @@ rdPoS::rdPoS(DB& db, const Storage& storage, P2P::ManagerNormal& p2p, const Opti
 
 rdPoS::~rdPoS() {
   this->stoprdPoSWorker();
-  std::unique_lock lock(this->mutex_);
   DBBatch validatorsBatch;
-  Logger::logToDebug(LogType::INFO, Log::rdPoS, __func__, "Descontructing rdPoS, saving to DB.");
+  LOGINFO(Log::rdPoS, "Descontructing rdPoS, saving to DB.");
   // Save rdPoS to DB.
+  this->dump(validatorsBatch);
+  this->db_.putBatch(validatorsBatch);
+}
+
+void rdPoS::dump(DBBatch& batch) const {
+  std::shared_lock lock(this->mutex_);
   uint64_t index = 0;
   for (const auto &validator : this->validators_) {
-    validatorsBatch.push_back(Utils::uint64ToBytes(index), validator.get(), DBPrefix::rdPoS);
+    batch.push_back(Utils::uint64ToBytes(index), validator.get(), DBPrefix::rdPoS);
     index++;
   }
-  this->db_.putBatch(validatorsBatch);
 }
 
 bool rdPoS::validateBlock(const Block& block) const {
@@ -67,7 +71,7 @@ bool rdPoS::validateBlock(const Block& block) const {
   auto latestBlock = this->storage_.latest();
   // Check if block signature matches randomList[0]
   if (!block.isFinalized()) {
-    Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__,
+    LOGERROR(Log::rdPoS,
       "Block is not finalized, cannot be validated. latest nHeight: "
       + std::to_string(latestBlock->getNHeight())
       + " Block nHeight: " + std::to_string(block.getNHeight())
@@ -76,7 +80,7 @@ bool rdPoS::validateBlock(const Block& block) const {
   }
 
   if (Secp256k1::toAddress(block.getValidatorPubKey()) != randomList_[0]) {
-    Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__,
+    LOGERROR(Log::rdPoS,
       "Block signature does not match randomList[0]. latest nHeight: "
       + std::to_string(latestBlock->getNHeight())
       + " Block nHeight: " + std::to_string(block.getNHeight())
@@ -85,7 +89,7 @@ bool rdPoS::validateBlock(const Block& block) const {
   }
 
   if (block.getTxValidators().size() != this->minValidators_ * 2) {
-    Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__,
+    LOGERROR(Log::rdPoS,
       "Block contains invalid number of TxValidator transactions. latest nHeight: "
       + std::to_string(latestBlock->getNHeight())
       + " Block nHeight: " + std::to_string(block.getNHeight())
@@ -96,7 +100,7 @@ bool rdPoS::validateBlock(const Block& block) const {
   // Check if all transactions are of the same block height
   for (const auto& tx : block.getTxValidators()) {
     if (tx.getNHeight() != block.getNHeight()) {
-      Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__,
+      LOGERROR(Log::rdPoS,
         "TxValidator transaction is not of the same block height. tx nHeight: "
         + std::to_string(tx.getNHeight())
         + " Block nHeight: " + std::to_string(block.getNHeight()));
@@ -116,7 +120,7 @@ bool rdPoS::validateBlock(const Block& block) const {
   std::unordered_map<TxValidator,TxValidator, SafeHash> txHashToSeedMap; // Tx randomHash -> Tx random
   for (uint64_t i = 0; i < this->minValidators_; i++) {
     if (Validator(block.getTxValidators()[i].getFrom()) != randomList_[i+1]) {
-      Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__,
+      LOGERROR(Log::rdPoS,
         "TxValidator randomHash " + std::to_string(i) + " is not ordered correctly."
         + "Expected: " + randomList_[i+1].hex().get()
         + " Got: " + block.getTxValidators()[i].getFrom().hex().get()
@@ -124,7 +128,7 @@ bool rdPoS::validateBlock(const Block& block) const {
       return false;
     }
     if (Validator(block.getTxValidators()[i + this->minValidators_].getFrom()) != randomList_[i+1]) {
-      Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__,
+      LOGERROR(Log::rdPoS,
         "TxValidator random " + std::to_string(i) + " is not ordered correctly."
         + "Expected: " + randomList_[i+1].hex().get()
         + " Got: " + block.getTxValidators()[i].getFrom().hex().get()
@@ -135,7 +139,7 @@ bool rdPoS::validateBlock(const Block& block) const {
   }
 
   if (txHashToSeedMap.size() != this->minValidators_) {
-    Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__, "txHashToSeedMap doesn't match minValidator size.");
+    LOGERROR(Log::rdPoS, "txHashToSeedMap doesn't match minValidator size.");
     return false;
   }
 
@@ -145,20 +149,20 @@ bool rdPoS::validateBlock(const Block& block) const {
     TxValidatorFunction seedTxFunction = rdPoS::getTxValidatorFunction(seedTx);
     // Check if hash tx is invalid by itself.
     if (hashTxFunction == TxValidatorFunction::INVALID) {
-      Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__,
+      LOGERROR(Log::rdPoS,
         std::string("TxValidator ") + hashTx.hash().hex().get()  + " is invalid."
       );
       return false;
     }
     if (seedTxFunction == TxValidatorFunction::INVALID) {
-      Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__,
+      LOGERROR(Log::rdPoS,
         std::string("TxValidator ") + seedTx.hash().hex().get()  + " is invalid."
       );
       return false;
     }
     // Check if senders match.
     if (hashTx.getFrom() != seedTx.getFrom()) {
-      Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__,
+      LOGERROR(Log::rdPoS,
         std::string("TxValidator sender ") + seedTx.hash().hex().get()
         + " does not match TxValidator sender " + hashTx.hash().hex().get()
       );
@@ -166,14 +170,14 @@ bool rdPoS::validateBlock(const Block& block) const {
     }
     // Check if the left sided transaction is a randomHash transaction.
     if (hashTxFunction != TxValidatorFunction::RANDOMHASH) {
-      Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__,
+      LOGERROR(Log::rdPoS,
         std::string("TxValidator ") + hashTx.hash().hex().get() + " is not a randomHash transaction."
       );
       return false;
     }
     // Check if the right sided transaction is a random transaction.
     if (seedTxFunction != TxValidatorFunction::RANDOMSEED) {
-      Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__,
+      LOGERROR(Log::rdPoS,
         std::string("TxValidator ") + seedTx.hash().hex().get() + " is not a random transaction."
       );
       return false;
@@ -186,21 +190,21 @@ bool rdPoS::validateBlock(const Block& block) const {
 
     // Size sanity check, should be 32 bytes.
     if (hash.size() != 32) {
-      Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__,
+      LOGERROR(Log::rdPoS,
         std::string("TxValidator ") + hashTx.hash().hex().get() + " (hash) is not 32 bytes."
       );
       return false;
     }
 
     if (random.size() != 32) {
-      Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__,
+      LOGERROR(Log::rdPoS,
         std::string("TxValidator ") + seedTx.hash().hex().get() + " (random) is not 32 bytes."
       );
       return false;
     }
 
     if (Utils::sha3(random) != hash) {
-      Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__,
+      LOGERROR(Log::rdPoS,
         std::string("TxValidator ") + seedTx.hash().hex().get()
         + " does not match TxValidator " + hashTx.hash().hex().get() + " randomness"
       );
@@ -213,7 +217,7 @@ bool rdPoS::validateBlock(const Block& block) const {
 Hash rdPoS::processBlock(const Block& block) {
   std::unique_lock lock(this->mutex_);
   if (!block.isFinalized()) {
-    Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__, "Block is not finalized.");
+    LOGERROR(Log::rdPoS, "Block is not finalized.");
     throw DynamicException("Block is not finalized.");
   }
   validatorMempool_.clear();
@@ -232,15 +236,33 @@ void rdPoS::signBlock(Block &block) {
   this->worker_.blockCreated();
 }
 
+std::vector<Hash> rdPoS::getMempoolHashes() const {
+  std::shared_lock lock(this->mutex_);
+  std::vector<Hash> hashes;
+  hashes.reserve(this->validatorMempool_.size());
+  for (const auto& [txHash, tx] : this->validatorMempool_) hashes.emplace_back(txHash);
+  return hashes;
+}
+
+std::vector<TxValidator> rdPoS::getMempoolTxs(const std::vector<Hash>& txHashes) const {
+  std::shared_lock lock(this->mutex_);
+  std::vector<TxValidator> txs;
+  for (const Hash& txHash : txHashes) {
+    auto it = this->validatorMempool_.find(txHash);
+    if (it != this->validatorMempool_.end()) txs.emplace_back(it->second);
+  }
+  return txs;
+}
+
 bool rdPoS::addValidatorTx(const TxValidator& tx) {
   std::unique_lock lock(this->mutex_);
   if (this->validatorMempool_.contains(tx.hash())) {
-    // Logger::logToDebug(LogType::INFO, Log::rdPoS, __func__, "TxValidator already exists in mempool.");
+    // LOGINFO(Log::rdPoS, "TxValidator already exists in mempool.");
     return true;
   }
 
   if (tx.getNHeight() != this->storage_.latest()->getNHeight() + 1) {
-    Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__,
+    LOGERROR(Log::rdPoS,
       "TxValidator is not for the next block. Expected: "
       + std::to_string(this->storage_.latest()->getNHeight() + 1)
       + " Got: " + std::to_string(tx.getNHeight())
@@ -257,7 +279,7 @@ bool rdPoS::addValidatorTx(const TxValidator& tx) {
     }
   }
   if (!participates) {
-    Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__,
+    LOGERROR(Log::rdPoS,
       "TxValidator sender is not a validator or is not participating in this rdPoS round."
     );
     return false;
@@ -273,12 +295,12 @@ bool rdPoS::addValidatorTx(const TxValidator& tx) {
     return true;
   } else if (txs.size() == 1) { // We already have one transaction from this sender, check if it is the same function.
     if (txs[0].getFunctor() == tx.getFunctor()) {
-      Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__, "TxValidator sender already has a transaction for this function.");
+      LOGERROR(Log::rdPoS, "TxValidator sender already has a transaction for this function.");
       return false;
     }
     this->validatorMempool_.emplace(tx.hash(), tx);
   } else { // We already have two transactions from this sender, it is the max we can have per validator.
-    Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__, "TxValidator sender already has two transactions.");
+    LOGERROR(Log::rdPoS, "TxValidator sender already has two transactions.");
     return false;
   }
 
@@ -288,7 +310,7 @@ bool rdPoS::addValidatorTx(const TxValidator& tx) {
 void rdPoS::initializeBlockchain() const {
   auto validatorsDb = db_.getBatch(DBPrefix::rdPoS);
   if (validatorsDb.empty()) {
-    Logger::logToDebug(LogType::INFO, Log::rdPoS,__func__, "No rdPoS in DB, initializing.");
+    LOGINFO(Log::rdPoS, "No rdPoS in DB, initializing.");
     // Use the genesis validators from Options, OPTIONS JSON FILE VALIDATOR ARRAY ORDER **MATTERS**
     for (uint64_t i = 0; i < this->options_.getGenesisValidators().size(); ++i) {
       this->db_.put(Utils::uint64ToBytes(i), this->options_.getGenesisValidators()[i].get(), DBPrefix::rdPoS);
@@ -316,7 +338,7 @@ rdPoS::TxValidatorFunction rdPoS::getTxValidatorFunction(const TxValidator &tx)
   constexpr Functor randomHashHash(Bytes{0xcf, 0xff, 0xe7, 0x46});
   constexpr Functor randomSeedHash(Bytes{0x6f, 0xc5, 0xa2, 0xd6});
   if (tx.getData().size() != 36) {
-    Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__, "TxValidator data size is not 36 bytes.");
+    LOGERROR(Log::rdPoS, "TxValidator data size is not 36 bytes.");
     // Both RandomHash and RandomSeed are 32 bytes, so if the data size is not 36 bytes, it is invalid.
     return TxValidatorFunction::INVALID;
   }
@@ -326,7 +348,7 @@ rdPoS::TxValidatorFunction rdPoS::getTxValidatorFunction(const TxValidator &tx)
   } else if (functionABI == randomSeedHash) {
     return TxValidatorFunction::RANDOMSEED;
   } else {
-    Logger::logToDebug(LogType::ERROR, Log::rdPoS, __func__, "TxValidator function ABI is not recognized.");
+    LOGERROR(Log::rdPoS, "TxValidator function ABI is not recognized.");
     return TxValidatorFunction::INVALID;
   }
 }
@@ -370,7 +392,7 @@ bool rdPoSWorker::workerLoop() {
       }
     }
 
-    // After processing everything. wait until the new block is appended to the chain.
+    // After processing everything, wait until the new block is appended to the chain.
     std::unique_ptr<std::tuple<uint64_t, uint64_t, uint64_t>> lastLog = nullptr;
     while (!this->checkLatestBlock() && !this->stopWorker_) {
       if (lastLog == nullptr ||
@@ -382,32 +404,21 @@ bool rdPoSWorker::workerLoop() {
           this->rdpos_.storage_.latest()->getNHeight(),
           this->rdpos_.validatorMempool_.size()
         );
-        Logger::logToDebug(LogType::INFO, Log::rdPoS, __func__,
+        LOGINFO(Log::rdPoS,
           "Waiting for new block to be appended to the chain. (Height: "
           + std::to_string(this->latestBlock_->getNHeight()) + ")" + " latest height: "
           + std::to_string(this->rdpos_.storage_.latest()->getNHeight())
         );
-        Logger::logToDebug(LogType::INFO, Log::rdPoS, __func__,
+        LOGINFO(Log::rdPoS,
           "Currently has " + std::to_string(this->rdpos_.validatorMempool_.size())
           + " transactions in mempool."
         );
       }
-      std::unique_lock mempoolSizeLock(this->rdpos_.mutex_);
-      uint64_t mempoolSize = this->rdpos_.validatorMempool_.size();
-      if (mempoolSize < this->rdpos_.getMinValidators()) { // Always try to fill the mempool to 8 transactions
-        mempoolSizeLock.unlock();
-        // Try to get more transactions from other nodes within the network
-        auto connectedNodesList = this->rdpos_.p2p_.getSessionsIDs(P2P::NodeType::NORMAL_NODE);
-        for (auto const& nodeId : connectedNodesList) {
-          if (this->checkLatestBlock() || this->stopWorker_) break;
-          auto txList = this->rdpos_.p2p_.requestValidatorTxs(nodeId);
-          if (this->checkLatestBlock() || this->stopWorker_) break;
-          for (auto const& tx : txList) this->rdpos_.state_.addValidatorTx(tx);
-        }
-      } else {
-        mempoolSizeLock.unlock();
-      }
-      std::this_thread::sleep_for(std::chrono::microseconds(10));
+      // Always try to fill the mempool to 8 transactions
+      if (this->validatorMempoolSize() < this->rdpos_.getMinValidators()) this->pullValidatorTxs();
+      this->rdpos_.storage_.events().waitUntil(
+        [this]() { return this->checkLatestBlock() || this->stopWorker_; }, rdPoSWorker::peerPullInterval_
+      );
     }
     // Update latest block if necessary.
     if (isBlockCreator) this->canCreateBlock_ = false;
@@ -416,42 +427,51 @@ bool rdPoSWorker::workerLoop() {
   return true;
 }
 
+uint64_t rdPoSWorker::validatorMempoolSize() const {
+  std::unique_lock mempoolSizeLock(this->rdpos_.mutex_);
+  return this->rdpos_.validatorMempool_.size();
+}
+
+void rdPoSWorker::pullValidatorTxs() {
+  auto connectedNodesList = this->rdpos_.p2p_.getSessionsIDs(P2P::NodeType::NORMAL_NODE);
+  for (auto const& nodeId : connectedNodesList) {
+    if (this->checkLatestBlock() || this->stopWorker_) return;
+    auto txList = this->rdpos_.p2p_.requestNewValidatorTxs(nodeId);
+    if (this->checkLatestBlock() || this->stopWorker_) return;
+    for (auto const& tx : txList) this->rdpos_.state_.addValidatorTx(tx);
+  }
+}
+
 void rdPoSWorker::doBlockCreation() {
-  // TODO: add requesting transactions to other nodes when mempool is not filled up
-  Logger::logToDebug(LogType::INFO, Log::rdPoS, __func__, "Block creator: waiting for txs");
-  uint64_t validatorMempoolSize = 0;
+  LOGINFO(Log::rdPoS, "Block creator: waiting for txs");
+  const uint64_t quorum = this->rdpos_.getMinValidators() * 2;
   std::unique_ptr<uint64_t> lastLog = nullptr;
-  while (validatorMempoolSize != this->rdpos_.getMinValidators() * 2 && !this->stopWorker_)
-  {
+  while (!this->stopWorker_) {
+    uint64_t validatorMempoolSize = this->validatorMempoolSize();
+    if (validatorMempoolSize >= quorum) break;
     if (lastLog == nullptr || *lastLog != validatorMempoolSize) {
       lastLog = std::make_unique<uint64_t>(validatorMempoolSize);
-      Logger::logToDebug(LogType::INFO, Log::rdPoS, __func__,
+      LOGINFO(Log::rdPoS,
         "Block creator has: " + std::to_string(validatorMempoolSize) + " transactions in mempool"
       );
     }
-    // Scope for lock.
-    {
-      std::unique_lock mempoolSizeLock(this->rdpos_.mutex_);
-      validatorMempoolSize = this->rdpos_.validatorMempool_.size();
-    }
-    // Try to get more transactions from other nodes within the network
-    auto connectedNodesList = this->rdpos_.p2p_.getSessionsIDs(P2P::NodeType::NORMAL_NODE);
-    for (auto const& nodeId : connectedNodesList) {
-      auto txList = this->rdpos_.p2p_.requestValidatorTxs(nodeId);
-      if (this->stopWorker_) return;
-      for (auto const& tx : txList) this->rdpos_.state_.addValidatorTx(tx);
-    }
-    std::this_thread::sleep_for(std::chrono::microseconds(10));
+    // Transactions are broadcast to us, only pull them from other nodes if they are late
+    this->pullValidatorTxs();
+    this->rdpos_.storage_.events().waitUntil(
+      [&]() { return this->validatorMempoolSize() >= quorum || this->stopWorker_; }, rdPoSWorker::peerPullInterval_
+    );
   }
-  Logger::logToDebug(LogType::INFO, Log::rdPoS, __func__, "Validator ready to create a block");
+  if (this->stopWorker_) return;
+  LOGINFO(Log::rdPoS, "Validator ready to create a block");
   // After processing everything, we can let everybody know that we are ready to create a block
   this->canCreateBlock_ = true;
+  this->rdpos_.storage_.events().notify(ChainEvents::Type::BlockCreatorReady);
 }
 
 void rdPoSWorker::doTxCreation(const uint64_t& nHeight, const Validator& me) {
   Hash randomness = Hash::random();
   Hash randomHash = Utils::sha3(randomness.get());
-  Logger::logToDebug(LogType::INFO, Log::rdPoS, __func__, "Creating random Hash transaction");
+  LOGINFO(Log::rdPoS, "Creating random Hash transaction");
   Bytes randomHashBytes = Hex::toBytes("0xcfffe746");
   randomHashBytes.insert(randomHashBytes.end(), randomHash.get().begin(), randomHash.get().end());
   TxValidator randomHashTx(
@@ -476,42 +496,36 @@ void rdPoSWorker::doTxCreation(const uint64_t& nHeight, const Validator& me) {
   BytesArrView randomHashTxView(randomHashTx.getData());
   BytesArrView randomSeedTxView(seedTx.getData());
   if (Utils::sha3(randomSeedTxView.subspan(4)) != randomHashTxView.subspan(4)) {
-    Logger::logToDebug(LogType::INFO, Log::rdPoS, __func__, "RandomHash transaction is not valid!!!");
+    LOGINFO(Log::rdPoS, "RandomHash transaction is not valid!!!");
     return;
   }
 
   // Append to mempool and broadcast the transaction across all nodes.
-  Logger::logToDebug(LogType::INFO, Log::rdPoS, __func__, "Broadcasting randomHash transaction");
+  LOGINFO(Log::rdPoS, "Broadcasting randomHash transaction");
   this->rdpos_.state_.addValidatorTx(randomHashTx);
   this->rdpos_.p2p_.broadcastTxValidator(randomHashTx);
 
   // Wait until we received all randomHash transactions to broadcast the randomness transaction
-  Logger::logToDebug(LogType::INFO, Log::rdPoS, __func__, "Waiting for randomHash transactions to be broadcasted");
-  uint64_t validatorMempoolSize = 0;
+  LOGINFO(Log::rdPoS, "Waiting for randomHash transactions to be broadcasted");
   std::unique_ptr<uint64_t> lastLog = nullptr;
-  while (validatorMempoolSize < this->rdpos_.getMinValidators() && !this->stopWorker_) {
+  while (!this->stopWorker_) {
+    uint64_t validatorMempoolSize = this->validatorMempoolSize();
+    if (validatorMempoolSize >= this->rdpos_.getMinValidators()) break;
     if (lastLog == nullptr || *lastLog != validatorMempoolSize) {
       lastLog = std::make_unique<uint64_t>(validatorMempoolSize);
-      Logger::logToDebug(LogType::INFO, Log::rdPoS, __func__,
+      LOGINFO(Log::rdPoS,
         "Validator has: " + std::to_string(validatorMempoolSize) + " transactions in mempool"
       );
     }
-    // Scope for lock
-    {
-      std::unique_lock mempoolSizeLock(this->rdpos_.mutex_);
-      validatorMempoolSize = this->rdpos_.validatorMempool_.size();
-    }
-    // Try to get more transactions from other nodes within the network
-    auto connectedNodesList = this->rdpos_.p2p_.getSessionsIDs(P2P::NodeType::NORMAL_NODE);
-    for (auto const& nodeId : connectedNodesList) {
-      if (this->stopWorker_) return;
-      auto txList = this->rdpos_.p2p_.requestValidatorTxs(nodeId);
-      for (auto const& tx : txList) this->rdpos_.state_.addValidatorTx(tx);
-    }
-    std::this_thread::sleep_for(std::chrono::microseconds(10));
+    // Transactions are broadcast to us, only pull them from other nodes if they are late
+    this->pullValidatorTxs();
+    this->rdpos_.storage_.events().waitUntil([this]() {
+      return this->validatorMempoolSize() >= this->rdpos_.getMinValidators() || this->stopWorker_;
+    }, rdPoSWorker::peerPullInterval_);
   }
+  if (this->stopWorker_) return;
 
-  Logger::logToDebug(LogType::INFO, Log::rdPoS, __func__, "Broadcasting random transaction");
+  LOGINFO(Log::rdPoS, "Broadcasting random transaction");
   // Append and broadcast the randomness transaction.
   this->rdpos_.state_.addValidatorTx(seedTx);
   this->rdpos_.p2p_.broadcastTxValidator(seedTx);
@@ -525,6 +539,7 @@ void rdPoSWorker::start() {
 void rdPoSWorker::stop() {
   if (this->workerFuture_.valid()) {
     this->stopWorker_ = true;
+    this->rdpos_.storage_.events().wake();
     this->workerFuture_.wait();
     this->workerFuture_.get();
   }
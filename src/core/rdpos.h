@@ -16,6 +16,7 @@ See the LICENSE.txt file in the project root for more information.
 #include "../utils/options.h"
 #include "../net/p2p/managernormal.h"
 
+#include <chrono>
 #include <optional>
 #include <shared_mutex>
 #include <set>
@@ -85,9 +86,18 @@ class rdPoSWorker {
      */
     bool workerLoop();
 
+    /// How long to wait for Validator transactions to be broadcast to us before pulling them from other nodes.
+    static constexpr std::chrono::milliseconds peerPullInterval_{50};
+
+    /// Get the current size of the rdPoS mempool.
+    uint64_t validatorMempoolSize() const;
+
+    /// Request Validator transactions from every connected node. Stops early if a new block arrives.
+    void pullValidatorTxs();
+
     /**
      * Wait for transactions to be added to the mempool and create a block by rdPoS consesus. Called by workerLoop().
-     * TODO: this function should call State or Blockchain to let them know that we are ready to create a block.
+     * Publishes ChainEvents::Type::BlockCreatorReady once the quorum of Validator transactions is reached.
      */
     void doBlockCreation();
 
@@ -163,6 +173,9 @@ class rdPoS : public BaseContract {
 
     ~rdPoS() override;  ///< Destructor.
 
+    /// Dump the validator list to a database batch (see BaseContract::dump()).
+    void dump(DBBatch& batch) const override;
+
     ///@{
     /** Getter. */
     const std::set<Validator>& getValidators() const {
@@ -193,6 +206,32 @@ class rdPoS : public BaseContract {
     /// Clear the mempool.
     void clearMempool() { std::unique_lock lock(this->mutex_); this->validatorMempool_.clear(); }
 
+    /// Check if a Validator transaction is in the mempool.
+    bool isTxInMempool(const Hash& txHash) const {
+      std::shared_lock lock(this->mutex_); return this->validatorMempool_.contains(txHash);
+    }
+
+    /// Get the hashes of every Validator transaction in the mempool.
+    std::vector<Hash> getMempoolHashes() const;
+
+    /**
+     * Get the Validator transactions with the given hashes from the mempool.
+     * @param txHashes The hashes to look for.
+     * @return The transactions found, in the same order (missing ones are skipped).
+     */
+    std::vector<TxValidator> getMempoolTxs(const std::vector<Hash>& txHashes) const;
+
+    /**
+     * Check if an address is the one expected to create the next block (randomList[0]).
+     * Cheap check for block announcements, validateBlock() still does the full validation.
+     * @param creator The address that signed the block.
+     * @return `true` if the address is the next block creator, `false` otherwise.
+     */
+    bool isNextBlockCreator(const Address& creator) const {
+      std::shared_lock lock(this->mutex_);
+      return !this->randomList_.empty() && this->randomList_[0] == creator;
+    }
+
     /**
      * Validate a block.
      * @param block The block to validate.
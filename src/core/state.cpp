@@ -6,6 +6,7 @@ See the LICENSE.txt file in the project root for more information.
 */
 
 #include "state.h"
+#include "../utils/metrics.h"
 #include <evmone/evmone.h>
 
 State::State(
@@ -44,64 +45,81 @@ contractManager_(db, *this, rdpos_, options), vm_(evmc_create_evmone()), evmHost
   this->evmHost_.commitNonce();
   this->currentRandomGen_ = std::make_unique<RandomGen>(latestBlock->getBlockRandomness());
   this->contractManager_.updateRandomGen(this->currentRandomGen_.get());
+  if (this->options_.getParallelExecution()) {
+    this->executionPool_ = std::make_unique<BS::thread_pool_light>(this->options_.getExecutionThreads());
+  }
 }
 
 State::~State() {
+  this->executionPool_.reset();
+  std::unique_lock lock(this->stateMutex_);
+  evmc_destroy(this->vm_);
+  // Everything up to the latest processed block was already flushed by processNextBlock(),
+  // only leftovers touched outside of a block (e.g. addBalance()) remain.
+  DBBatch batch;
+  this->flushDirtyState(batch, this->storage_.latest()->getNHeight());
+}
+
+void State::flushDirtyState(DBBatch& batch, const uint64_t& blockHeight) {
   // DB is stored as following
   // Under the DBPrefix::nativeAccounts
   // Each key == Address
-  // Each Value == uint256_t + uint256
-  DBBatch accountsBatch;
-  std::unique_lock lock(this->stateMutex_);
-  evmc_destroy(this->vm_);
-  // Delete the vm_ pointer as it is no longer needed.
-  for (const auto& [address, account] : this->evmHost_.accounts) {
+  // Each Value == uint256_t (balance) + uint64_t (nonce)
+  for (const auto& address : this->evmHost_.dirtyAccounts) {
+    const auto& account = this->evmHost_.accounts[address];
     Bytes serializedBytes;
-    Utils::appendBytes(serializedBytes, Utils::uint256ToBytes(account.balance.second));
-    Utils::appendBytes(serializedBytes, Utils::uint64ToBytes(account.nonce.second));
-    accountsBatch.push_back(address.get(), serializedBytes, DBPrefix::nativeAccounts);
+    Utils::appendBytes(serializedBytes, Utils::uint256ToBytes(account.balance.first));
+    Utils::appendBytes(serializedBytes, Utils::uint64ToBytes(account.nonce.first));
+    batch.push_back(address.get(), serializedBytes, DBPrefix::nativeAccounts);
   }
-
-  this->db_.putBatch(accountsBatch);
+  this->evmHost_.dirtyAccounts.clear();
+  this->evmHost_.flushDirty(batch, blockHeight);
+  this->contractManager_.flushContracts(batch);
+  this->rdpos_.dump(batch);
+  this->contractManager_.flushEvents(batch);
+  if (!this->db_.putBatch(batch)) {
+    LOGERROR(Log::state,
+      "Failed to flush state for block height " + std::to_string(blockHeight)
+    );
+  }
+  this->evmHost_.trimCaches();
 }
 
 TxInvalid State::validateTransactionInternal(const TxBlock& tx) const {
   /**
    * Rules for a transaction to be accepted within the current state:
    * Transaction value + txFee (gas * gasPrice) needs to be lower than account balance
-   * Transaction nonce must match account nonce
+   * Transaction nonce must not be lower than account nonce, and can be at most
+   * Mempool::senderCapacity() ahead of it (it waits in the mempool until executable)
    */
 
   // Verify if transaction already exists within the mempool, if on mempool, it has been validated previously.
   if (this->mempool_.contains(tx.hash())) {
-    //Logger::logToDebug(LogType::INFO, Log::state, __func__, "Transaction: " + tx.hash().hex().get() + " already in mempool");
+    //LOGINFO(Log::state, "Transaction: " + tx.hash().hex().get() + " already in mempool");
     return TxInvalid::NotInvalid;
   }
   auto accountIt = this->evmHost_.accounts.find(tx.getFrom());
   if (accountIt == this->evmHost_.accounts.end()) {
-    Logger::logToDebug(LogType::ERROR, Log::state, __func__, "Account " + tx.getFrom().hex(true).get() + "doesn't exist (0 balance and 0 nonce)");
-    auto to = tx.getTo();
-    auto v = tx.getV();
-    auto r = tx.getR();
-    auto s = tx.getS();
-    // LogtoDebug to v r s
-      Logger::logToDebug(LogType::ERROR, Log::state, __func__, "v: " + std::to_string(v) + " r: " + Hex::fromBytes(Utils::uint256ToBytes(r) , true).get() + " s: " + Hex::fromBytes(Utils::uint256ToBytes(s) , true).get());
-      Logger::logToDebug( LogType::ERROR, Log::state, __func__, "to: " + to.hex(true).get());
+    LOGDEBUG(Log::state, "Account " + tx.getFrom().hex(true).get() + " doesn't exist (0 balance and 0 nonce) - v: "
+      + std::to_string(tx.getV()) + " r: " + Hex::fromBytes(Utils::uint256ToBytes(tx.getR()), true).get()
+      + " s: " + Hex::fromBytes(Utils::uint256ToBytes(tx.getS()), true).get() + " to: " + tx.getTo().hex(true).get()
+    );
     return TxInvalid::InvalidBalance;
   }
   const auto& accBalance = accountIt->second.balance.second;
   const auto& accNonce = accountIt->second.nonce.second;
   uint256_t txWithFees = tx.getValue() + (tx.getGasLimit() * tx.getMaxFeePerGas());
   if (txWithFees > accBalance) {
-    Logger::logToDebug(LogType::ERROR, Log::state, __func__,
-                      "Transaction sender: " + tx.getFrom().hex().get() + " doesn't have balance to send transaction"
-                      + " expected: " + txWithFees.str() + " has: " + accBalance.str());
+    LOGDEBUG(Log::state,
+      "Transaction sender: " + tx.getFrom().hex().get() + " doesn't have balance to send transaction"
+      + " expected: " + txWithFees.str() + " has: " + accBalance.str()
+    );
     return TxInvalid::InvalidBalance;
   }
-  // TODO: The blockchain is able to store higher nonce transactions until they are valid. Handle this case.
-  if (accNonce != tx.getNonce()) {
-    Logger::logToDebug(LogType::ERROR, Log::state, __func__, "Transaction: " + tx.hash().hex().get() + " nonce mismatch, expected: " + std::to_string(accNonce)
-                                            + " got: " + tx.getNonce().str());
+  if (tx.getNonce() < accNonce || tx.getNonce() >= uint256_t(accNonce) + this->mempool_.senderCapacity()) {
+    LOGDEBUG(Log::state, "Transaction: " + tx.hash().hex().get() + " nonce out of range, expected: " + std::to_string(accNonce)
+      + " to " + std::to_string(accNonce + this->mempool_.senderCapacity() - 1) + " got: " + tx.getNonce().str()
+    );
     return TxInvalid::InvalidNonce;
   }
   return TxInvalid::NotInvalid;
@@ -113,47 +131,62 @@ void State::processTransaction(const TxBlock& tx, const Hash& blockHash, const u
                  const uint64_t& blockGasLimit,
                  const uint256_t& chainId, const uint64_t& txIndex) {
   // Lock is already called by processNextBlock.
+  std::vector<Event> events;
+  this->executeTransaction(this->evmHost_, tx, blockHash, blockHeight, blockCoinbase,
+    blockTimestamp, blockGasLimit, chainId, txIndex, this->currentRandomGen_.get(), events
+  );
+  for (Event& event : events) this->contractManager_.commitEvent(std::move(event));
+}
+
+void State::executeTransaction(EVMHost& host, const TxBlock& tx, const Hash& blockHash, const uint64_t& blockHeight,
+                 const Address& blockCoinbase,
+                 const uint64_t& blockTimestamp,
+                 const uint64_t& blockGasLimit,
+                 const uint256_t& chainId, const uint64_t& txIndex,
+                 RandomGen* randomGen, std::vector<Event>& events) {
+  static Metrics::Histogram& txSeconds = Metrics::histogram(
+    "orbiter_tx_execution_seconds", "Time spent executing a transaction (speculative executions included)."
+  );
+  static Metrics::Counter& txFailed = Metrics::counter(
+    "orbiter_tx_failed_total", "Transactions that failed (and were reverted) during execution."
+  );
+  Metrics::Timer timer(txSeconds);
   // processNextBlock already calls validateTransaction in every tx,
   // as it calls validateNextBlock as a sanity check.
-  auto& toAccountIt = this->evmHost_.accounts[tx.getTo()];
-  auto accountIt = this->evmHost_.accounts.find(tx.getFrom());
+  auto& toAccountIt = host.loadAccount(tx.getTo());
+  auto& fromAccount = host.loadAccount(tx.getFrom());
   auto& toBalance = toAccountIt.balance.second;
-  auto& balance = accountIt->second.balance.second;
-  auto& nonce = accountIt->second.nonce.second;
-  this->evmHost_.accessedAccountsBalances.emplace_back(tx.getFrom());
-  this->evmHost_.accessedAccountsNonces.emplace_back(tx.getFrom());
-  if (this->evmHost_.isEvmContract(tx.getTo()) || tx.getTo() == Address()) {
+  auto& balance = fromAccount.balance.second;
+  auto& nonce = fromAccount.nonce.second;
+  host.accessedAccountsBalances.emplace_back(tx.getFrom());
+  host.accessedAccountsNonces.emplace_back(tx.getFrom());
+  if (host.isEvmContract(tx.getTo()) || tx.getTo() == Address()) {
     // EVM Call! Set the tx context and then call the contract.
     // First, try transfering the balance!
-    this->evmHost_.accessedAccountsBalances.emplace_back(tx.getFrom());
-    Address realTo = (tx.getTo() == Address()) ? this->evmHost_.deriveContractAddress(tx.getNonce(), tx.getFrom()) : tx.getTo();
+    host.accessedAccountsBalances.emplace_back(tx.getFrom());
+    Address realTo = (tx.getTo() == Address()) ? host.deriveContractAddress(tx.getNonce(), tx.getFrom()) : tx.getTo();
     if (tx.getValue()) {
-      this->evmHost_.accounts[realTo].balance.second += tx.getValue();
+      host.loadAccount(realTo).balance.second += tx.getValue();
       balance -= tx.getValue();
-      this->evmHost_.accessedAccountsBalances.emplace_back(tx.getTo());
+      host.accessedAccountsBalances.emplace_back(realTo);
     }
     // Then set context
     try {
-      this->evmHost_.setTxContext(tx.txToCallInfo(), blockHash, blockHeight, blockCoinbase, blockTimestamp, blockGasLimit, chainId);
-      this->evmHost_.currentTxHash = tx.hash();
-      auto evmCallResult = this->evmHost_.execute(tx.txToCallInfo(), this->currentRandomGen_.get());
-      int64_t gasLeft = evmCallResult.gas_left;
-      gasLeft - 21000;
-      if (gasLeft < 0) {
-        throw DynamicException("Error when executing EVM contract, gas limit is lower than gas left");
-      }
-      uint256_t gasUsed = tx.getGasLimit() - uint256_t(gasLeft);
+      host.setTxContext(tx.txToCallInfo(), blockHash, blockHeight, blockCoinbase, blockTimestamp, blockGasLimit, chainId);
+      host.currentTxHash = tx.hash();
+      auto evmCallResult = host.execute(tx.txToCallInfo(), randomGen);
+      uint256_t gasUsed = tx.getGasLimit() - uint256_t(evmCallResult.gas_left);
       balance -= gasUsed * tx.getMaxFeePerGas();
-      if (evmCallResult.status_code || this->evmHost_.shouldRevert) {
-        std::cout << "should revert: " << this->evmHost_.shouldRevert << std::endl;
+      if (evmCallResult.status_code || host.shouldRevert) {
+        LOGDEBUG(Log::state, "Transaction " + tx.hash().hex().get() + " should revert: " + (host.shouldRevert ? "true" : "false"));
         throw DynamicException("Error when executing EVM contract, evmCallResult.status_code: " + std::string(evmc_status_code_to_string(evmCallResult.status_code)) + " bytes: " + Hex::fromBytes(Utils::cArrayToBytes(evmCallResult.output_data, evmCallResult.output_size)).get());
       }
 
       // After running and everything ok but before committing, we need to register the events
       {
-        for (uint64_t i = 0; i < this->evmHost_.emittedEvents.size(); i++) {
-          const auto& emittedEvent = this->evmHost_.emittedEvents[i];
-          Event sdkEvent = Event(
+        for (uint64_t i = 0; i < host.emittedEvents.size(); i++) {
+          const auto& emittedEvent = host.emittedEvents[i];
+          events.emplace_back(
             "",
             i,
             tx.hash(),
@@ -165,21 +198,22 @@ void State::processTransaction(const TxBlock& tx, const Hash& blockHash, const u
             emittedEvent.topics,
             false
           );
-          this->contractManager_.commitEvent(std::move(sdkEvent));
         }
       }
-      this->evmHost_.commit();
-      this->evmHost_.commitCode();
+      host.commit();
+      host.commitCode();
     } catch (const std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::state, __func__,
+      LOGERROR(Log::state,
         "Transaction: " + tx.hash().hex().get() + " failed to process, reason: " + e.what()
       );
-      this->evmHost_.shouldRevert = false;
+      txFailed.inc();
+      host.shouldRevert = false;
       // Tx went badly, revert the changes.
+      events.clear();
       balance += tx.getValue();
-      this->evmHost_.accounts[realTo].balance.second -= tx.getValue();
-      this->evmHost_.revert();
-      this->evmHost_.revertCode();
+      host.loadAccount(realTo).balance.second -= tx.getValue();
+      host.revert();
+      host.revertCode();
     }
   } else {
     /// Classic OrbiterSDK transaction
@@ -189,19 +223,20 @@ void State::processTransaction(const TxBlock& tx, const Hash& blockHash, const u
       ); // This needs to change with payable contract functions
       balance -= txValueWithFees;
       toBalance += tx.getValue();
+      // Never true for overlays, native contract calls are not speculated (see processTransactionsSpeculatively())
       if (this->contractManager_.isContractCall(tx)) {
-        Utils::safePrint(std::string("Processing transaction call txid: ") + tx.hash().hex().get());
         if (this->contractManager_.isPayable(tx.txToCallInfo())) this->processingPayable_ = true;
         this->contractManager_.callContract(tx, blockHash, txIndex);
         this->processingPayable_ = false;
       }
       // We need to take note of the accessed accounts in other to call commit() or revert() on them to update nonce/balance.
-      this->evmHost_.accessedAccountsBalances.emplace_back(tx.getTo());
-      this->evmHost_.commit();
+      host.accessedAccountsBalances.emplace_back(tx.getTo());
+      host.commit();
     } catch (const std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::state, __func__,
+      LOGERROR(Log::state,
         "Transaction: " + tx.hash().hex().get() + " failed to process, reason: " + e.what()
       );
+      txFailed.inc();
       if(this->processingPayable_) {
         balance += tx.getValue();
         toBalance -= tx.getValue();
@@ -211,33 +246,83 @@ void State::processTransaction(const TxBlock& tx, const Hash& blockHash, const u
     }
   }
   nonce++;
-  this->evmHost_.accessedAccountsNonces.emplace_back(tx.getFrom());
-  this->evmHost_.commitNonce();
-  this->evmHost_.commitBalance();
+  host.accessedAccountsNonces.emplace_back(tx.getFrom());
+  host.commitNonce();
+  host.commitBalance();
 }
 
-void State::refreshMempool(const Block& block) {
-  // No need to lock mutex as function caller (this->processNextBlock) already lock mutex.
-  // Remove all transactions within the block that exists on the unordered_map.
-  for (const auto& tx : block.getTxs()) {
-    const auto it = this->mempool_.find(tx.hash());
-    if (it != this->mempool_.end()) {
-      this->mempool_.erase(it);
+bool State::isSpeculable(const TxBlock& tx) const {
+  // Contract creations derive addresses from nonces and native contracts keep
+  // their own state outside of the EVMHost, both always run serially.
+  return tx.getTo() != Address() && !this->contractManager_.isContractCall(tx);
+}
+
+void State::processTransactionsSpeculatively(const Block& block, const Hash& blockHash, const Address& blockCoinbase) {
+  const auto& txs = block.getTxs();
+  std::vector<SpeculativeTx> results(txs.size());
+
+  // Run every transaction that can be speculated against the pre-block state, in parallel.
+  // Nothing touches evmHost_ until every task is done, so the overlays can safely read through it.
+  for (uint64_t i = 0; i < txs.size(); i++) {
+    if (!this->isSpeculable(txs[i])) continue;
+    this->executionPool_->push_task([this, &txs, &results, &blockHash, &block, &blockCoinbase, i]() {
+      auto& result = results[i];
+      evmc_vm* vm = evmc_create_evmone();
+      result.host = std::make_unique<EVMHost>(this->evmHost_, vm);
+      try {
+        this->executeTransaction(*result.host, txs[i], blockHash, block.getNHeight(), blockCoinbase,
+          block.getTimestamp(), 100000000, this->options_.getChainID(), i, nullptr, result.events
+        );
+        result.valid = !result.host->usedRandomness;
+      } catch (const std::exception&) {
+        result.valid = false;
+      }
+      result.host->vm = nullptr;
+      evmc_destroy(vm);
+    });
+  }
+  this->executionPool_->wait_for_tasks();
+
+  // Commit in block order. A speculative result is only used if nothing it read was
+  // written by a transaction before it, otherwise the transaction runs again on top of
+  // the up-to-date state. Either way the outcome is the same as a serial execution.
+  uint64_t reexecuted = 0;
+  for (uint64_t i = 0; i < txs.size(); i++) {
+    auto& result = results[i];
+    if (result.valid && this->isSpeculable(txs[i]) && !this->evmHost_.hasConflicts(*result.host)) {
+      this->evmHost_.applyOverlay(*result.host);
+      for (Event& event : result.events) this->contractManager_.commitEvent(std::move(event));
+    } else {
+      if (result.host != nullptr) reexecuted++;
+      this->processTransaction(txs[i], blockHash, block.getNHeight(), blockCoinbase,
+        block.getTimestamp(), 100000000, this->options_.getChainID(), i
+      );
     }
+    result.host.reset();
   }
+  static Metrics::Counter& txReexecuted = Metrics::counter(
+    "orbiter_tx_reexecuted_total", "Speculatively executed transactions that had to run again due to conflicts."
+  );
+  txReexecuted.inc(reexecuted);
+  LOGINFO(Log::state,
+    "Block " + blockHash.hex().get() + ": " + std::to_string(txs.size()) + " transactions, "
+    + std::to_string(reexecuted) + " re-executed due to conflicts"
+  );
+}
 
-  // Copy mempool over
-  auto mempoolCopy = this->mempool_;
-  this->mempool_.clear();
-
-  // Verify if the transactions within the old mempool
-  // not added to the block are valid given the current state
-  for (const auto& [hash, tx] : mempoolCopy) {
-    // Calls internal function which doesn't lock mutex.
-    if (!this->validateTransactionInternal(tx)) {
-      this->mempool_.insert({hash, tx});
-    }
+void State::refreshMempool(const Block& block) {
+  // No need to lock mutex as function caller (this->processNextBlock) already lock mutex.
+  std::unordered_set<Address, SafeHash> senders;
+  for (const auto& tx : block.getTxs()) senders.insert(tx.getFrom());
+  uint64_t dropped = 0;
+  for (const auto& sender : senders) {
+    const auto& account = this->evmHost_.accounts[sender];
+    dropped += this->mempool_.revalidate(sender, {account.nonce.second, account.balance.second});
   }
+  LOGINFO(Log::state,
+    "Revalidated " + std::to_string(senders.size()) + " senders, dropped " + std::to_string(dropped)
+    + " transactions, " + std::to_string(this->mempool_.size()) + " left in mempool"
+  );
 }
 
 uint256_t State::getNativeBalance(const Address &addr) const {
@@ -261,7 +346,27 @@ uint64_t State::getNativeNonce(const Address& addr) const {
 
 std::unordered_map<Hash, TxBlock, SafeHash> State::getMempool() const {
   std::shared_lock lock(this->stateMutex_);
-  return this->mempool_;
+  return this->mempool_.getTxs();
+}
+
+std::vector<Hash> State::getMempoolHashes() const {
+  std::shared_lock lock(this->stateMutex_);
+  return this->mempool_.hashes();
+}
+
+std::vector<TxBlock> State::getMempoolTxs(const std::vector<Hash>& txHashes) const {
+  std::shared_lock lock(this->stateMutex_);
+  std::vector<TxBlock> txs;
+  for (const Hash& txHash : txHashes) {
+    const TxBlock* tx = this->mempool_.get(txHash);
+    if (tx != nullptr) txs.emplace_back(*tx);
+  }
+  return txs;
+}
+
+std::unordered_map<uint64_t, TxBlock> State::getMempoolTxsByShortId(const std::unordered_set<uint64_t>& shortIds) const {
+  std::shared_lock lock(this->stateMutex_);
+  return this->mempool_.getByShortIds(shortIds);
 }
 
 bool State::validateNextBlock(const Block& block) const {
@@ -276,7 +381,7 @@ bool State::validateNextBlock(const Block& block) const {
    */
   auto latestBlock = this->storage_.latest();
   if (block.getNHeight() != latestBlock->getNHeight() + 1) {
-    Logger::logToDebug(LogType::ERROR, Log::state, __func__,
+    LOGERROR(Log::state,
       "Block nHeight doesn't match, expected " + std::to_string(latestBlock->getNHeight() + 1)
       + " got " + std::to_string(block.getNHeight())
     );
@@ -284,7 +389,7 @@ bool State::validateNextBlock(const Block& block) const {
   }
 
   if (block.getPrevBlockHash() != latestBlock->hash()) {
-    Logger::logToDebug(LogType::ERROR, Log::state, __func__,
+    LOGERROR(Log::state,
       "Block prevBlockHash doesn't match, expected " + latestBlock->hash().hex().get()
       + " got: " + block.getPrevBlockHash().hex().get()
     );
@@ -292,7 +397,7 @@ bool State::validateNextBlock(const Block& block) const {
   }
 
   if (latestBlock->getTimestamp() > block.getTimestamp()) {
-    Logger::logToDebug(LogType::ERROR, Log::state, __func__,
+    LOGERROR(Log::state,
       "Block timestamp is lower than latest block, expected higher than "
       + std::to_string(latestBlock->getTimestamp()) + " got " + std::to_string(block.getTimestamp())
     );
@@ -300,30 +405,64 @@ bool State::validateNextBlock(const Block& block) const {
   }
 
   if (!this->rdpos_.validateBlock(block)) {
-    Logger::logToDebug(LogType::ERROR, Log::state, __func__, "Invalid rdPoS in block");
+    LOGERROR(Log::state, "Invalid rdPoS in block");
     return false;
   }
 
+  // A sender can have several transactions in the same block, so nonces must follow
+  // each other and the balance must cover all of them (see Mempool::collect())
   std::shared_lock verifyingBlockTxs(this->stateMutex_);
+  std::unordered_map<Address, Mempool::AccountInfo, SafeHash> senders;
   for (const auto& tx : block.getTxs()) {
-    if (this->validateTransactionInternal(tx)) {
-      Logger::logToDebug(LogType::ERROR, Log::state, __func__,
-        "Transaction " + tx.hash().hex().get() + " within block is invalid"
+    auto senderIt = senders.find(tx.getFrom());
+    if (senderIt == senders.end()) {
+      auto accountIt = this->evmHost_.accounts.find(tx.getFrom());
+      if (accountIt == this->evmHost_.accounts.end()) {
+        LOGERROR(Log::state,
+          "Transaction " + tx.hash().hex().get() + " within block is invalid, sender " + tx.getFrom().hex(true).get() + " doesn't exist"
+        );
+        return false;
+      }
+      senderIt = senders.emplace(tx.getFrom(), Mempool::AccountInfo(
+        accountIt->second.nonce.second, accountIt->second.balance.second
+      )).first;
+    }
+    auto& [nonce, balance] = senderIt->second;
+    const uint256_t cost = Mempool::maxCost(tx);
+    if (tx.getNonce() != nonce || cost > balance) {
+      LOGERROR(Log::state,
+        "Transaction " + tx.hash().hex().get() + " within block is invalid, expected nonce " + std::to_string(nonce)
+        + " got " + tx.getNonce().str() + ", cost " + cost.str() + " balance left " + balance.str()
       );
       return false;
     }
+    nonce++;
+    balance -= cost;
   }
 
-  Logger::logToDebug(LogType::INFO, Log::state, __func__,
+  LOGINFO(Log::state,
     "Block " + block.hash().hex().get() + " is valid. (Sanity Check Passed)"
   );
   return true;
 }
 
 void State::processNextBlock(Block&& block) {
+  static Metrics::Histogram& blockSeconds = Metrics::histogram(
+    "orbiter_block_processing_seconds", "Time spent validating and processing a block."
+  );
+  static Metrics::Counter& blocksProcessed = Metrics::counter(
+    "orbiter_blocks_processed_total", "Blocks processed and appended to the chain."
+  );
+  static Metrics::Counter& txsProcessed = Metrics::counter(
+    "orbiter_txs_processed_total", "Transactions processed as part of a block."
+  );
+  static Metrics::Gauge& blockHeight = Metrics::gauge(
+    "orbiter_block_height", "Height of the latest block."
+  );
+  Metrics::Timer timer(blockSeconds);
   // Sanity check - if it passes, the block is valid and will be processed
   if (!this->validateNextBlock(block)) {
-    Logger::logToDebug(LogType::ERROR, Log::state, __func__,
+    LOGERROR(Log::state,
       "Sanity check failed - blockchain is trying to append a invalid block, throwing"
     );
     throw DynamicException("Invalid block detected during processNextBlock sanity check");
@@ -338,17 +477,21 @@ void State::processNextBlock(Block&& block) {
   this->contractManager_.updateRandomGen(this->currentRandomGen_.get());
 
   // Process transactions of the block within the current state
-  uint64_t txIndex = 0;
-  for (auto const& tx : block.getTxs()) {
-    this->processTransaction(tx,
-      blockHash,
-      block.getNHeight(),
-      Secp256k1::toAddress(block.getValidatorPubKey()),
-      block.getTimestamp(),
-      100000000,
-      this->options_.getChainID(),
-      txIndex);
-    txIndex++;
+  if (this->executionPool_ != nullptr && block.getTxs().size() > 1) {
+    this->processTransactionsSpeculatively(block, blockHash, Secp256k1::toAddress(block.getValidatorPubKey()));
+  } else {
+    uint64_t txIndex = 0;
+    for (auto const& tx : block.getTxs()) {
+      this->processTransaction(tx,
+        blockHash,
+        block.getNHeight(),
+        Secp256k1::toAddress(block.getValidatorPubKey()),
+        block.getTimestamp(),
+        100000000,
+        this->options_.getChainID(),
+        txIndex);
+      txIndex++;
+    }
   }
 
   // Process rdPoS State
@@ -356,19 +499,31 @@ void State::processNextBlock(Block&& block) {
 
   // Refresh the mempool based on the block transactions
   this->refreshMempool(block);
-  Logger::logToDebug(LogType::INFO, Log::state, __func__, "Block " + block.hash().hex().get() + " processed successfully.");
-  Utils::safePrint("Block: " + block.hash().hex().get() + " height: " + std::to_string(block.getNHeight()) + " was added to the blockchain");
-  for (const auto& tx : block.getTxs()) {
-    Utils::safePrint("Transaction: " + tx.hash().hex().get() + " was accepted in the blockchain");
-  }
 
-  // Move block to storage
+  // Persist the block and what it touched in one go before handing it over to storage
+  DBBatch blockBatch;
+  this->storage_.batchBlock(block, blockBatch, true);
+  this->flushDirtyState(blockBatch, block.getNHeight());
+  LOGINFO(Log::state, "Block " + block.hash().hex().get() + " processed successfully.");
+
+  blocksProcessed.inc();
+  txsProcessed.inc(block.getTxs().size());
+  blockHeight.set(block.getNHeight());
+
+  // Move block to storage, then let everyone waiting for it know (outside of the lock)
   this->storage_.pushBack(std::move(block));
+  lock.unlock();
+  this->storage_.events().notify(ChainEvents::Type::BlockAppended);
 }
 
 void State::fillBlockWithTransactions(Block& block) const {
   std::shared_lock lock(this->stateMutex_);
-  for (const auto& [hash, tx] : this->mempool_) block.appendTx(tx);
+  auto txs = this->mempool_.collect([this](const Address& sender) {
+    auto it = this->evmHost_.accounts.find(sender);
+    if (it == this->evmHost_.accounts.end()) return Mempool::AccountInfo(0, 0);
+    return Mempool::AccountInfo(it->second.nonce.second, it->second.balance.second);
+  });
+  for (const auto& tx : txs) block.appendTx(tx);
 }
 
 TxInvalid State::validateTransaction(const TxBlock& tx) const {
@@ -377,18 +532,32 @@ TxInvalid State::validateTransaction(const TxBlock& tx) const {
 }
 
 TxInvalid State::addTx(TxBlock&& tx) {
-  auto TxInvalid = this->validateTransaction(tx);
-  if (TxInvalid) return TxInvalid;
-  std::unique_lock lock(this->stateMutex_);
+  static Metrics::Counter& mempoolTxsAdded = Metrics::counter(
+    "orbiter_mempool_txs_added_total", "Transactions added to the mempool."
+  );
   auto txHash = tx.hash();
-  this->mempool_.insert({txHash, std::move(tx)});
-  Utils::safePrint("Transaction: " + tx.hash().hex().get() + " was added to the mempool");
-  return TxInvalid;
+  {
+    std::unique_lock lock(this->stateMutex_);
+    auto TxInvalid = this->validateTransactionInternal(tx);
+    if (TxInvalid) return TxInvalid;
+    bool isNew = !this->mempool_.contains(txHash);
+    TxInvalid = this->mempool_.add(std::move(tx));
+    if (TxInvalid) return TxInvalid;
+    if (isNew) { this->txInventory_.add(txHash); mempoolTxsAdded.inc(); }
+  }
+  this->storage_.events().notify(ChainEvents::Type::TxAdded);
+  return TxInvalid::NotInvalid;
 }
 
 bool State::addValidatorTx(const TxValidator& tx) {
-  std::unique_lock lock(this->stateMutex_);
-  return this->rdpos_.addValidatorTx(tx);
+  {
+    std::unique_lock lock(this->stateMutex_);
+    bool isNew = !this->rdpos_.isTxInMempool(tx.hash());
+    if (!this->rdpos_.addValidatorTx(tx)) return false;
+    if (isNew) this->validatorTxInventory_.add(tx.hash());
+  }
+  this->storage_.events().notify(ChainEvents::Type::ValidatorTxAdded);
+  return true;
 }
 
 bool State::isTxInMempool(const Hash& txHash) const {
@@ -398,77 +567,71 @@ bool State::isTxInMempool(const Hash& txHash) const {
 
 std::unique_ptr<TxBlock> State::getTxFromMempool(const Hash &txHash) const {
   std::shared_lock lock(this->stateMutex_);
-  auto it = this->mempool_.find(txHash);
-  if (it == this->mempool_.end()) return nullptr;
-  return std::make_unique<TxBlock>(it->second);
+  const TxBlock* tx = this->mempool_.get(txHash);
+  if (tx == nullptr) return nullptr;
+  return std::make_unique<TxBlock>(*tx);
 }
 
 void State::addBalance(const Address& addr) {
   std::unique_lock lock(this->stateMutex_);
   this->evmHost_.accounts[addr].balance.first += uint256_t("1000000000000000000000");
   this->evmHost_.accounts[addr].balance.second += uint256_t("1000000000000000000000");
+  this->evmHost_.dirtyAccounts.insert(addr);
+}
+
+evmc::Result State::simulateEvmCall(const ethCallInfo& callInfo) const {
+  const auto& [from, to, gasLimit, gasPrice, value, functor, data, fullData] = callInfo;
+  // The call reads through an overlay of evmHost_ and writes only to it, so evmHost_
+  // is never touched and any number of calls can run alongside each other.
+  evmc_vm* vm = evmc_create_evmone();
+  EVMHost overlay(this->evmHost_, vm);
+  auto latestBlock = this->storage_.latest();
+  RandomGen randomGen(latestBlock->getBlockRandomness());
+  ethCallInfo realCallInfo = callInfo;
+  if (gasLimit > maxCallGas_) std::get<2>(realCallInfo) = maxCallGas_;
+  evmc::Result evmCallResult;
+  try {
+    if (value) {
+      Address realTo = (to == Address()) ? overlay.deriveContractAddress(overlay.loadAccount(from).nonce.second, from) : to;
+      overlay.loadAccount(from).balance.second -= value;
+      overlay.loadAccount(realTo).balance.second += value;
+    }
+    overlay.setTxContext(realCallInfo,
+      latestBlock->hash(),
+      latestBlock->getNHeight(),
+      Secp256k1::toAddress(latestBlock->getValidatorPubKey()),
+      latestBlock->getTimestamp(),
+      100000000,
+      this->options_.getChainID());
+    evmCallResult = overlay.execute(realCallInfo, &randomGen);
+  } catch (const std::exception&) {
+    overlay.vm = nullptr;
+    evmc_destroy(vm);
+    throw;
+  }
+  overlay.vm = nullptr;
+  evmc_destroy(vm);
+  return evmCallResult;
 }
 
 Bytes State::ethCall(const ethCallInfo& callInfo) const {
   const auto& [from, to, gasLimit, gasPrice, value, functor, data, fullData] = callInfo;
 
   std::shared_lock lock(this->stateMutex_);
-  auto &address = std::get<1>(callInfo);
-  if (this->contractManager_.isContractAddress(address)) {
-    this->currentRandomGen_ = std::make_unique<RandomGen>(storage_.latest()->getBlockRandomness());
-    this->contractManager_.updateRandomGen(this->currentRandomGen_.get());
+  if (this->contractManager_.isContractAddress(to)) {
+    // View functions only read the contracts. The random generator is left alone, it is
+    // thread-safe and processNextBlock() seeds it again before it is used for real.
     return this->contractManager_.callContract(callInfo);
-  } else {
-    if (this->evmHost_.isEvmContract(to) || to == Address()) {
-      lock.unlock();
-      std::unique_lock unique(this->stateMutex_);
-      this->currentRandomGen_ = std::make_unique<RandomGen>(storage_.latest()->getBlockRandomness());
-      Utils::safePrint("Estimating gas from evm...");
-      if (value) {
-        auto realTo = (to == Address()) ? this->evmHost_.deriveContractAddress(this->getNativeNonce(from), from) : to;
-        this->evmHost_.accounts[from].balance.second -= value;
-        this->evmHost_.accounts[realTo].balance.second += value;
-        this->evmHost_.accessedAccountsBalances.push_back(from);
-        this->evmHost_.accessedAccountsBalances.push_back(realTo);
-      }
-      uint256_t realGasLimit = gasLimit;
-      auto latestBlock = this->storage_.latest();
-      evmc::Result evmCallResult;
-      if (gasLimit > std::numeric_limits<int64_t>::max() - 10) {
-        auto newCallInfo = callInfo;
-        realGasLimit = std::numeric_limits<int64_t>::max() - 10;
-        std::get<2>(newCallInfo) = std::numeric_limits<int64_t>::max() - 10;
-        this->evmHost_.setTxContext(newCallInfo,
-        latestBlock->hash(),
-        latestBlock->getNHeight(),
-        Secp256k1::toAddress(latestBlock->getValidatorPubKey()),
-        latestBlock->getTimestamp(),
-        100000000,
-        this->options_.getChainID());
-        evmCallResult = this->evmHost_.execute(newCallInfo, this->currentRandomGen_.get());
-      } else {
-        this->evmHost_.setTxContext(callInfo,
-          latestBlock->hash(),
-          latestBlock->getNHeight(),
-          Secp256k1::toAddress(latestBlock->getValidatorPubKey()),
-          latestBlock->getTimestamp(),
-          100000000,
-          this->options_.getChainID());
-        evmCallResult = this->evmHost_.execute(callInfo, this->currentRandomGen_.get());
-      }
-
-      // Revert EVERYTHING from the call.
-      this->evmHost_.revert();
-      this->evmHost_.revertCode();
-      this->evmHost_.revertBalance();
-
-      if (evmCallResult.status_code) {
-        throw DynamicException("Error when estimating gas, evmCallResult.status_code: " + std::string(evmc_status_code_to_string(evmCallResult.status_code)) + " bytes: " + Hex::fromBytes(Utils::cArrayToBytes(evmCallResult.output_data, evmCallResult.output_size)).get());
-      }
-      return Utils::cArrayToBytes(evmCallResult.output_data, evmCallResult.output_size);
+  }
+  if (this->evmHost_.isEvmContract(to) || to == Address()) {
+    LOGDEBUG(Log::state, "Calling evm...");
+    evmc::Result evmCallResult = this->simulateEvmCall(callInfo);
+    if (evmCallResult.status_code) {
+      throw DynamicException("Error when estimating gas, evmCallResult.status_code: " + std::string(evmc_status_code_to_string(evmCallResult.status_code)) + " bytes: " + Hex::fromBytes(Utils::cArrayToBytes(evmCallResult.output_data, evmCallResult.output_size)).get());
     }
-    return {};
+    return Utils::cArrayToBytes(evmCallResult.output_data, evmCallResult.output_size);
   }
+  return {};
 }
 
 uint256_t State::estimateGas(const ethCallInfo& callInfo) {
@@ -477,73 +640,35 @@ uint256_t State::estimateGas(const ethCallInfo& callInfo) {
   const auto& [from, to, gasLimit, gasPrice, value, functor, data, fullData] = callInfo;
 
   // Check balance/gasLimit/gasPrice if available.
-  if (from && value) {
+  auto hasBalance = [&]() {
+    if (!from || !value) return true;
     uint256_t totalGas = 0;
     if (gasLimit && gasPrice) {
       totalGas = gasLimit * gasPrice;
     }
     auto it = this->evmHost_.accounts.find(from);
-    if (it == this->evmHost_.accounts.end()) return 0;
-    if (it->second.balance.second < value + totalGas) return 0;
-  }
+    return it != this->evmHost_.accounts.end() && it->second.balance.second >= value + totalGas;
+  };
+  if (!hasBalance()) return 0;
 
   if (this->contractManager_.isContractAddress(to)) {
-    Utils::safePrint("Estimating gas from state...");
+    // C++ contracts keep their state in their own variables, which have no overlay to
+    // run on: the call has to really run (and be reverted), so it can't share the state.
+    // A block may have been processed while the lock was released, so check the balance again.
+    lock.unlock();
+    std::unique_lock unique(this->stateMutex_);
+    if (!hasBalance()) return 0;
+    LOGDEBUG(Log::state, "Estimating gas from state...");
     this->currentRandomGen_ = std::make_unique<RandomGen>(storage_.latest()->getBlockRandomness());
     this->contractManager_.updateRandomGen(this->currentRandomGen_.get());
     this->contractManager_.validateCallContractWithTx(callInfo);
+    return baseGas;
   }
 
   if (this->evmHost_.isEvmContract(to) || to == Address()) {
-    lock.unlock();
-    this->currentRandomGen_ = std::make_unique<RandomGen>(storage_.latest()->getBlockRandomness());
-    std::unique_lock unique(this->stateMutex_);
-    Utils::safePrint("Estimating gas from evm..." + gasLimit.str());
-    if (value) {
-      Address realTo = (to == Address()) ? this->evmHost_.deriveContractAddress(this->getNativeNonce(from), from) : to;
-      this->evmHost_.accounts[from].balance.second -= value;
-      this->evmHost_.accounts[realTo].balance.second += value;
-      this->evmHost_.accessedAccountsBalances.push_back(from);
-      this->evmHost_.accessedAccountsBalances.push_back(realTo);
-    }
-    uint256_t realGasLimit = gasLimit;
-    auto latestBlock = this->storage_.latest();
-    evmc::Result evmCallResult;
-    if (gasLimit > std::numeric_limits<int64_t>::max() - 10) {
-      auto newCallInfo = callInfo;
-      realGasLimit = std::numeric_limits<int64_t>::max() - 10;
-      std::get<2>(newCallInfo) = std::numeric_limits<int64_t>::max() - 10;
-      this->evmHost_.setTxContext(newCallInfo,
-      latestBlock->hash(),
-      latestBlock->getNHeight(),
-      Secp256k1::toAddress(latestBlock->getValidatorPubKey()),
-      latestBlock->getTimestamp(),
-      100000000,
-      this->options_.getChainID());
-      evmCallResult = this->evmHost_.execute(newCallInfo, this->currentRandomGen_.get());
-    } else {
-      this->evmHost_.setTxContext(callInfo,
-        latestBlock->hash(),
-        latestBlock->getNHeight(),
-        Secp256k1::toAddress(latestBlock->getValidatorPubKey()),
-        latestBlock->getTimestamp(),
-        100000000,
-        this->options_.getChainID());
-      evmCallResult = this->evmHost_.execute(callInfo, this->currentRandomGen_.get());
-    }
-
-    // Revert EVERYTHING from the call.
-
-    this->evmHost_.revert(true);
-    this->evmHost_.revertCode();
-    this->evmHost_.revertBalance();
-
-    int64_t gasLeft = evmCallResult.gas_left;
-    gasLeft - 21000;
-    if (gasLeft < 0) {
-      throw DynamicException("Error when estimating gas, gasLimit is lower than gas left");
-    }
-
+    LOGDEBUG(Log::state, "Estimating gas from evm..." + gasLimit.str());
+    uint256_t realGasLimit = std::min(gasLimit, uint256_t(maxCallGas_));
+    evmc::Result evmCallResult = this->simulateEvmCall(callInfo);
     if (evmCallResult.status_code) {
       throw DynamicException("Error when estimating gas, evmCallResult.status_code: " + std::string(evmc_status_code_to_string(evmCallResult.status_code)) + " bytes: " + Hex::fromBytes(Utils::cArrayToBytes(evmCallResult.output_data, evmCallResult.output_size)).get());
     }
@@ -560,6 +685,7 @@ void State::processContractPayable(const std::unordered_map<Address, uint256_t,
   );
   for (const auto& [address, amount] : payableMap) {
     this->evmHost_.accessedAccountsBalances.push_back(this->contractManager_.getContractAddress());
+    this->evmHost_.accessedAccountsBalances.push_back(address);
     this->evmHost_.accounts[address].balance.second = amount;
   }
 }
@@ -585,7 +711,7 @@ bool State::isEvmContract(const Address& addr) const {
 
 Bytes State::getContractCode(const Address& addr) const {
   std::shared_lock lock(this->stateMutex_);
-  return this->evmHost_.accounts[addr].code.second;
+  return this->evmHost_.peekCode(addr);
 }
 
 Address State::getEvmContractAddress(const Hash& txHash) const {
@@ -15,13 +15,20 @@ See the LICENSE.txt file in the project root for more information.
 #include "../utils/db.h"
 #include "storage.h"
 #include "rdpos.h"
+#include "mempool.h"
+#include "txinventory.h"
 #include "../utils/randomgen.h"
+#include "../libs/BS_thread_pool_light.hpp"
 
 // TODO: We could possibly change the bool functions into an enum function,
 // to be able to properly return each error case. We need this in order to slash invalid rdPoS blocks.
 
-/// Enum for labeling transaction validity.
-enum TxInvalid { NotInvalid, InvalidNonce, InvalidBalance };
+/// Outcome of a transaction executed speculatively against the pre-block state.
+struct SpeculativeTx {
+  std::unique_ptr<EVMHost> host;  ///< Overlay holding everything the transaction read and wrote.
+  std::vector<Event> events;      ///< Events emitted by the transaction, committed only if the result is used.
+  bool valid = false;             ///< Whether the result can be used at all (e.g. not if it needed randomness).
+};
 
 /// Abstraction of the blockchain's current state at the current block.
 class State {
@@ -34,13 +41,17 @@ class State {
     rdPoS rdpos_; ///< rdPoS object (consensus).
     ContractManager contractManager_; ///< Contract Manager.
     mutable EVMHost evmHost_; ///< EVM Host. mutable because we are funnnyyyy :)))
-    std::unordered_map<Hash, TxBlock, SafeHash> mempool_; ///< TxBlock mempool.
+    Mempool mempool_; ///< TxBlock mempool.
+    TxInventory txInventory_; ///< Sequenced log of the transactions added to `mempool_`, for gossip.
+    TxInventory validatorTxInventory_; ///< Sequenced log of the Validator transactions added to the rdPoS mempool, for gossip.
     mutable std::shared_mutex stateMutex_;  ///< Mutex for managing read/write access to the state object.
     bool processingPayable_ = false;  ///< Indicates whether the state is currently processing a payable contract function.
     mutable std::unique_ptr<RandomGen> currentRandomGen_; ///< RandomGen object for the current state.s
+    std::unique_ptr<BS::thread_pool_light> executionPool_; ///< Workers for speculative execution, only set if Options::getParallelExecution() is on.
 
     /**
      * Verify if a transaction can be accepted within the current state.
+     * Nonces ahead of the account nonce are accepted, as long as they fit the sender's mempool queue.
      * @param tx The transaction to check.
      * @return An enum telling if the block is invalid or not.
      */
@@ -60,14 +71,78 @@ class State {
                  const uint256_t& chainId, const uint64_t& txIndex);
 
     /**
-     * Update the mempool, remove transactions that are in the given block, and leave only valid transactions in it.
-     * Called by processNewBlock(), used to filter the current mempool based on transactions that have been
-     * accepted on the block, and verify if transactions on the mempool are valid given the new state after
-     * processing the block itself.
-     * @param block The block to use for pruning transactions from the mempool.
+     * Execute a transaction on a given host. Shared by processTransaction() (on evmHost_)
+     * and processTransactionsSpeculatively() (on overlays of evmHost_).
+     * Events are returned instead of being committed, so speculative results can be thrown away.
+     * @param host The host to execute on.
+     * @param tx The transaction to process.
+     * @param blockHash The hash of the block being processed.
+     * @param txIndex The index of the transaction inside the block that is being processed.
+     * @param randomGen The random generator for the EVM, nullptr for overlays.
+     * @param events Output for the events emitted by the transaction.
+     */
+    void executeTransaction(EVMHost& host, const TxBlock& tx, const Hash& blockHash, const uint64_t& blockHeight,
+                 const Address& blockCoinbase,
+                 const uint64_t& blockTimestamp,
+                 const uint64_t& blockGasLimit,
+                 const uint256_t& chainId, const uint64_t& txIndex,
+                 RandomGen* randomGen, std::vector<Event>& events);
+
+    /**
+     * Check if a transaction can be executed speculatively (i.e. it only touches the EVMHost).
+     * @param tx The transaction to check.
+     * @return `true` if the transaction is a plain transfer or an EVM call, `false` otherwise.
+     */
+    bool isSpeculable(const TxBlock& tx) const;
+
+    /**
+     * Process all transactions of a block with optimistic parallel execution.
+     * Every speculable transaction first runs in parallel on its own overlay of evmHost_,
+     * then results are applied in block order, re-executing serially only the transactions
+     * that read something written by an earlier one (or that couldn't be speculated at all).
+     * The final state is the same as processing the block serially.
+     * Mutex must already be locked by the caller.
+     * @param block The block being processed.
+     * @param blockHash The block's hash.
+     * @param blockCoinbase The block's validator address.
+     */
+    void processTransactionsSpeculatively(const Block& block, const Hash& blockHash, const Address& blockCoinbase);
+
+    /// Maximum gas for simulated EVM calls (evmc takes the gas limit as an int64_t).
+    static constexpr int64_t maxCallGas_ = std::numeric_limits<int64_t>::max() - 10;
+
+    /**
+     * Simulate an EVM call or contract creation on top of the latest block, for
+     * ethCall() and estimateGas(). The call runs on its own overlay of evmHost_,
+     * with its own VM and random generator, and the overlay is thrown away after,
+     * so the state is never modified and calls can run concurrently.
+     * Mutex must already be locked by the caller, a shared lock is enough.
+     * @param callInfo Tuple with info about the call (gas limit is capped at `maxCallGas_`).
+     * @return The result of the call.
+     */
+    evmc::Result simulateEvmCall(const ethCallInfo& callInfo) const;
+
+    /**
+     * Update the mempool after processing a block. Only the senders of the block's
+     * transactions had their nonce or balance lowered, so only their queues are
+     * revalidated, which also drops the transactions included in the block.
+     * Called by processNextBlock().
+     * @param block The block that was just processed.
      */
     void refreshMempool(const Block& block);
 
+    /**
+     * Flush every account, storage slot, contract (C++ ones included, along with
+     * the rdPoS validators) and event touched since the last flush to the database,
+     * as a single atomic batch tagged with the given block height.
+     * Called by processNextBlock() after each block (with the block itself already
+     * in the batch), so a crash or restart loses at most the block being processed.
+     * Mutex must already be locked by the caller.
+     * @param batch The batch to append to and write.
+     * @param blockHeight The height of the block the flushed state belongs to.
+     */
+    void flushDirtyState(DBBatch& batch, const uint64_t& blockHeight);
+
   public:
     /**
      * Constructor.
@@ -95,9 +170,13 @@ class State {
     const uint32_t& rdposGetMinValidators() const { return this->rdpos_.getMinValidators(); }
     void rdposClearMempool() { return this->rdpos_.clearMempool(); }
     bool rdposValidateBlock(const Block& block) const { return this->rdpos_.validateBlock(block); }
+    bool rdposIsNextBlockCreator(const Address& creator) const { return this->rdpos_.isNextBlockCreator(creator); }
     Hash rdposProcessBlock(const Block& block) { return this->rdpos_.processBlock(block); }
     void rdposSignBlock(Block& block) { this->rdpos_.signBlock(block); }
     bool rdposAddValidatorTx(const TxValidator& tx) { return this->rdpos_.addValidatorTx(tx); }
+    bool rdposIsTxInMempool(const Hash& txHash) const { return this->rdpos_.isTxInMempool(txHash); }
+    std::vector<Hash> rdposGetMempoolHashes() const { return this->rdpos_.getMempoolHashes(); }
+    std::vector<TxValidator> rdposGetMempoolTxs(const std::vector<Hash>& txHashes) const { return this->rdpos_.getMempoolTxs(txHashes); }
     const std::atomic<bool>& rdposCanCreateBlock() const { return this->rdpos_.canCreateBlock(); }
     void rdposStartWorker() { this->rdpos_.startrdPoSWorker(); }
     void rdposStopWorker() { this->rdpos_.stoprdPoSWorker(); }
@@ -124,6 +203,30 @@ class State {
     //std::unordered_map<Address, Account, SafeHash> getAccounts() const; ///< Getter for `accounts_`. Returns a copy.
     std::unordered_map<Hash, TxBlock, SafeHash> getMempool() const; ///< Getter for `mempool_`. Returns a copy.
 
+    /// Get the hashes of every transaction in the mempool.
+    std::vector<Hash> getMempoolHashes() const;
+
+    /**
+     * Get the transactions with the given hashes from the mempool.
+     * @param txHashes The hashes to look for.
+     * @return The transactions found, in the same order (missing ones are skipped).
+     */
+    std::vector<TxBlock> getMempoolTxs(const std::vector<Hash>& txHashes) const;
+
+    /**
+     * Get the transactions with the given short IDs from the mempool (see Mempool::shortId()).
+     * The copies keep their already recovered senders, so they don't need to be verified again.
+     * @param shortIds The short IDs to look for.
+     * @return The transactions found, by short ID.
+     */
+    std::unordered_map<uint64_t, TxBlock> getMempoolTxsByShortId(const std::unordered_set<uint64_t>& shortIds) const;
+
+    ///@{
+    /** Getter for the inventory of the respective mempool. Thread-safe on its own. */
+    const TxInventory& getTxInventory() const { return this->txInventory_; }
+    const TxInventory& getValidatorTxInventory() const { return this->validatorTxInventory_; }
+    ///@}
+
     /// Get the mempool's current size.
     inline size_t getMempoolSize() const {
       std::shared_lock<std::shared_mutex> lock (this->stateMutex_);
@@ -141,7 +244,7 @@ class State {
 
     /**
      * Process the next block given current state from the network. DOES update the state.
-     * Appends block to Storage after processing.
+     * Appends block to Storage after processing, then publishes ChainEvents::Type::BlockAppended.
      * @param block The block to process.
      * @throw DynamicException if block is invalid.
      */
@@ -153,7 +256,8 @@ class State {
 
    void setRandomGen(RandomGen* randomGen) { this->contractManager_.updateRandomGen(randomGen); }
     /**
-     * Fill a block with all transactions currently in the mempool. DOES NOT FINALIZE THE BLOCK.
+     * Fill a block with the executable transactions currently in the mempool, best tip first
+     * and in nonce order for each sender. DOES NOT FINALIZE THE BLOCK.
      * @param block The block to fill.
      */
     void fillBlockWithTransactions(Block& block) const;
@@ -167,7 +271,8 @@ class State {
     TxInvalid validateTransaction(const TxBlock& tx) const;
 
     /**
-     * Add a transaction to the mempool, if valid.
+     * Add a transaction to the mempool, if valid (see Mempool::add() for replacement and eviction rules).
+     * Publishes ChainEvents::Type::TxAdded when added.
      * @param tx The transaction to add.
      * @return An enum telling if the transaction is valid or not.
      */
@@ -175,6 +280,7 @@ class State {
 
     /**
      * Add a Validator transaction to the rdPoS mempool, if valid.
+     * Publishes ChainEvents::Type::ValidatorTxAdded when accepted.
      * @param tx The transaction to add.
      * @return `true` if transaction is valid, `false` otherwise.
      */
@@ -213,6 +319,7 @@ class State {
 
     /**
      * Simulate an `eth_call` to a contract.
+     * Only takes a shared lock, so calls run concurrently with each other (see simulateEvmCall()).
      * @param callInfo Tuple with info about the call (from, to, gasLimit, gasPrice, value, data).
      * @return The return of the called function as a data string.
      */
@@ -224,6 +331,8 @@ class State {
     /**
      * Estimate gas for callInfo in RPC.
      * Doesn't really "estimate" gas, but rather tells if the transaction is valid or not.
+     * EVM calls only take a shared lock (see simulateEvmCall()), calls to C++ contracts
+     * have to run on the contracts themselves and take an exclusive one.
      * @param callInfo Tuple with info about the call (from, to, gasLimit, gasPrice, value, data).
      * @return `true` if the call is valid, `false` otherwise.
      */
@@ -7,18 +7,20 @@ See the LICENSE.txt file in the project root for more information.
 
 #include "storage.h"
 
-Storage::Storage(DB& db, const Options& options) : db_(db), options_(options) {
-  Logger::logToDebug(LogType::INFO, Log::storage, __func__, "Loading blockchain from DB");
+Storage::Storage(DB& db, const Options& options)
+  : db_(db), options_(options), cachedBlocks_(cachedBlocksBudget_), cachedTxs_(cachedTxsBudget_)
+{
+  LOGINFO(Log::storage, "Loading blockchain from DB");
 
   // Initialize the blockchain if latest block doesn't exist.
   initializeBlockchain();
 
   // Get the latest block from the database
-  Logger::logToDebug(LogType::INFO, Log::storage, __func__, "Loading latest block");
+  LOGINFO(Log::storage, "Loading latest block");
   auto blockBytes = this->db_.get(Utils::stringToBytes("latest"), DBPrefix::blocks);
   Block latest(blockBytes, this->options_.getChainID());
   uint64_t depth = latest.getNHeight();
-  Logger::logToDebug(LogType::INFO, Log::storage, __func__,
+  LOGINFO(Log::storage,
     std::string("Got latest block: ") + latest.hash().hex().get()
     + std::string(" - height ") + std::to_string(depth)
   );
@@ -26,12 +28,12 @@ Storage::Storage(DB& db, const Options& options) : db_(db), options_(options) {
   std::unique_lock<std::shared_mutex> lock(this->chainLock_);
 
   // Parse block mappings (hash -> height / height -> hash) from DB
-  Logger::logToDebug(LogType::INFO, Log::storage, __func__, "Parsing block mappings");
+  LOGINFO(Log::storage, "Parsing block mappings");
   std::vector<DBEntry> maps = this->db_.getBatch(DBPrefix::blockHeightMaps);
   for (DBEntry& map : maps) {
     // TODO: Check if a block is missing.
     // Might be interesting to change DB::getBatch to return a map instead of a vector
-    Logger::logToDebug(LogType::DEBUG, Log::storage, __func__, std::string(": ")
+    LOGDEBUG(Log::storage, std::string(": ")
       + std::to_string(Utils::bytesToUint64(map.key))
       + std::string(", hash ") + Hash(map.value).hex().get()
     );
@@ -40,9 +42,9 @@ Storage::Storage(DB& db, const Options& options) : db_(db), options_(options) {
   }
 
   // Append up to 500 most recent blocks from DB to chain
-  Logger::logToDebug(LogType::INFO, Log::storage, __func__, "Appending recent blocks");
+  LOGINFO(Log::storage, "Appending recent blocks");
   for (uint64_t i = 0; i <= 500 && i <= depth; i++) {
-    Logger::logToDebug(LogType::DEBUG, Log::storage, __func__,
+    LOGDEBUG(Log::storage,
       std::string("Height: ") + std::to_string(depth - i) + ", Hash: "
       + this->blockHashByHeight_[depth - i].hex().get()
     );
@@ -50,10 +52,13 @@ Storage::Storage(DB& db, const Options& options) : db_(db), options_(options) {
     this->pushFrontInternal(std::move(block));
   }
 
-  Logger::logToDebug(LogType::INFO, Log::storage, __func__, "Blockchain successfully loaded");
+  LOGINFO(Log::storage, "Blockchain successfully loaded");
+  this->periodicSaveThread_ = std::thread(&Storage::periodicSaveToDB, this);
 }
 
 Storage::~Storage() {
+  this->stopPeriodicSaveToDB();
+  if (this->periodicSaveThread_.joinable()) this->periodicSaveThread_.join();
   DBBatch batchedOperations;
   std::shared_ptr<const Block> latest;
   {
@@ -63,20 +68,10 @@ Storage::~Storage() {
       // Batch block to be saved to the database.
       // We can't call this->popBack() because of the mutex
       std::shared_ptr<const Block> block = this->chain_.front();
-      batchedOperations.push_back(block->hash().get(), block->serializeBlock(), DBPrefix::blocks);
-      batchedOperations.push_back(Utils::uint64ToBytes(block->getNHeight()), block->hash().get(), DBPrefix::blockHeightMaps);
-
-      // Batch txs to be saved to the database and delete them from the mappings
-      auto Txs = block->getTxs();
-      for (uint32_t i = 0; i < Txs.size(); i++) {
-        const auto TxHash = Txs[i].hash();
-        Bytes value = block->hash().asBytes();
-        value.reserve(value.size() + 4 + 8);
-        Utils::appendBytes(value, Utils::uint32ToBytes(i));
-        Utils::appendBytes(value, Utils::uint64ToBytes(block->getNHeight()));
-        batchedOperations.push_back(TxHash.get(), value, DBPrefix::txToBlocks);
-        this->txByHash_.erase(TxHash);
-      }
+      this->batchBlock(*block, batchedOperations);
+
+      // Delete txs from the mappings
+      for (const auto& tx : block->getTxs()) this->txByHash_.erase(tx.hash());
 
       // Delete block from internal mappings and the chain
       this->blockByHash_.erase(block->hash());
@@ -89,6 +84,24 @@ Storage::~Storage() {
   this->db_.put(std::string("latest"), latest->serializeBlock(), DBPrefix::blocks);
 }
 
+void Storage::batchBlock(const Block& block, DBBatch& batch, bool isLatest) const {
+  const Hash blockHash = block.hash();
+  const Bytes serialized = block.serializeBlock();
+  batch.push_back(blockHash.get(), serialized, DBPrefix::blocks);
+  batch.push_back(Utils::uint64ToBytes(block.getNHeight()), blockHash.get(), DBPrefix::blockHeightMaps);
+  if (isLatest) batch.push_back(Utils::stringToBytes("latest"), serialized, DBPrefix::blocks);
+
+  // Txs are stored as tx hash -> block hash + tx index + block height
+  const auto& txs = block.getTxs();
+  for (uint32_t i = 0; i < txs.size(); i++) {
+    Bytes value = blockHash.asBytes();
+    value.reserve(value.size() + 4 + 8);
+    Utils::appendBytes(value, Utils::uint32ToBytes(i));
+    Utils::appendBytes(value, Utils::uint64ToBytes(block.getNHeight()));
+    batch.push_back(txs[i].hash().get(), value, DBPrefix::txToBlocks);
+  }
+}
+
 void Storage::initializeBlockchain() {
   if (!this->db_.has(std::string("latest"), DBPrefix::blocks)) {
     // Genesis block comes from Options, not hardcoded
@@ -99,7 +112,7 @@ void Storage::initializeBlockchain() {
     this->db_.put(std::string("latest"), genesis.serializeBlock(), DBPrefix::blocks);
     this->db_.put(Utils::uint64ToBytes(genesis.getNHeight()), genesis.hash().get(), DBPrefix::blockHeightMaps);
     this->db_.put(genesis.hash().get(), genesis.serializeBlock(), DBPrefix::blocks);
-    Logger::logToDebug(LogType::INFO, Log::storage, __func__,
+    LOGINFO(Log::storage,
       std::string("Created genesis block: ") + Hex::fromBytes(genesis.hash().get()).get()
     );
   }
@@ -108,7 +121,7 @@ void Storage::initializeBlockchain() {
   const auto genesisInDBHash = Hash(this->db_.get(Utils::uint64ToBytes(0), DBPrefix::blockHeightMaps));
   const auto genesisInDB = Block(this->db_.get(genesisInDBHash, DBPrefix::blocks), this->options_.getChainID());
   if (genesis != genesisInDB) {
-    Logger::logToDebug(LogType::ERROR, Log::storage, __func__, "Sanity Check! Genesis block in DB does not match genesis block in Options");
+    LOGERROR(Log::storage, "Sanity Check! Genesis block in DB does not match genesis block in Options");
     throw DynamicException("Sanity Check! Genesis block in DB does not match genesis block in Options");
   }
 }
@@ -279,16 +292,12 @@ std::shared_ptr<const Block> Storage::getBlock(const Hash& hash) const {
     case StorageStatus::OnChain: {
       return this->blockByHash_.at(hash);
     }
-    case StorageStatus::OnCache: {
-      return this->cachedBlocks_.at(hash);
-    }
+    case StorageStatus::OnCache:
     case StorageStatus::OnDB: {
-      lockCache.unlock(); // Unlock shared lock so we can lock uniquely and insert into cache
-      std::unique_lock<std::shared_mutex> lock(this->cacheLock_);
-      this->cachedBlocks_.insert({hash, std::make_shared<Block>(
-        this->db_.get(hash.get(), DBPrefix::blocks), this->options_.getChainID()
-      )});
-      return this->cachedBlocks_.at(hash);
+      // Block is not in the chain, so it's already in the database even if evicted from the cache meanwhile
+      lockCache.unlock();
+      lockChain.unlock();
+      return this->loadBlock(hash);
     }
   }
   return nullptr;
@@ -300,7 +309,7 @@ std::shared_ptr<const Block> Storage::getBlock(const uint64_t& height) const {
   std::shared_lock<std::shared_mutex> lockCache(this->cacheLock_);
   StorageStatus blockStatus = this->blockExistsInternal(height);
   if (blockStatus == StorageStatus::NotFound) return nullptr;
-  Logger::logToDebug(LogType::INFO, Log::storage, __func__, "height: " + std::to_string(height));
+  LOGINFO(Log::storage, "height: " + std::to_string(height));
   switch (blockStatus) {
     case StorageStatus::NotFound: {
       return nullptr;
@@ -308,17 +317,12 @@ std::shared_ptr<const Block> Storage::getBlock(const uint64_t& height) const {
     case StorageStatus::OnChain: {
       return this->blockByHash_.at(this->blockHashByHeight_.at(height));
     }
-    case StorageStatus::OnCache: {
-      Hash hash = this->blockHashByHeight_.find(height)->second;
-      return this->cachedBlocks_.find(hash)->second;
-    }
+    case StorageStatus::OnCache:
     case StorageStatus::OnDB: {
-      lockCache.unlock(); // Unlock shared lock so we can lock uniquely and insert into cache
-      std::unique_lock<std::shared_mutex> lock(this->cacheLock_);
       Hash hash = this->blockHashByHeight_.find(height)->second;
-      auto blockData = this->db_.get(hash.get(), DBPrefix::blocks);
-      this->cachedBlocks_.insert({hash, std::make_shared<Block>(blockData, this->options_.getChainID())});
-      return this->cachedBlocks_.at(hash);
+      lockCache.unlock();
+      lockChain.unlock();
+      return this->loadBlock(hash);
     }
   }
   return nullptr;
@@ -345,21 +349,11 @@ std::tuple<
       if (transaction.hash() != tx) throw DynamicException("Tx hash mismatch");
       return {std::make_shared<const TxBlock>(transaction), blockHash, blockIndex, blockHeight};
     }
-    case StorageStatus::OnCache: {
-      return this->cachedTxs_.at(tx);
-    }
+    case StorageStatus::OnCache:
     case StorageStatus::OnDB: {
       lockCache.unlock();
-      Bytes txData(this->db_.get(tx.get(), DBPrefix::txToBlocks));
-      BytesArrView txDataView(txData);
-      auto blockHash = Hash(txDataView.subspan(0, 32));
-      uint64_t blockIndex = Utils::bytesToUint32(txDataView.subspan(32, 4));
-      uint64_t blockHeight = Utils::bytesToUint64(txDataView.subspan(36,8));
-      Bytes blockData(this->db_.get(blockHash.get(), DBPrefix::blocks));
-      auto Tx = this->getTxFromBlockWithIndex(blockData, blockIndex);
-      std::unique_lock<std::shared_mutex> lock(this->cacheLock_);
-      this->cachedTxs_.insert({tx, {std::make_shared<const TxBlock>(Tx), blockHash, blockIndex, blockHeight}});
-      return this->cachedTxs_.at(tx);
+      lockChain.unlock();
+      return this->loadTx(tx);
     }
   }
   return { nullptr, Hash(), 0, 0 };
@@ -386,18 +380,12 @@ std::tuple<
       }
       return {std::make_shared<const TxBlock>(transaction), txBlockHash, txBlockIndex, txBlockHeight};
     }
-    case StorageStatus::OnCache: {
-      auto txHash = this->cachedBlocks_.at(blockHash)->getTxs()[blockIndex].hash();
-      return this->cachedTxs_.at(txHash);
-    }
+    case StorageStatus::OnCache:
     case StorageStatus::OnDB: {
-      lockCache.unlock();
-      Bytes blockData = this->db_.get(blockHash.get(), DBPrefix::blocks);
-      auto tx = this->getTxFromBlockWithIndex(blockData, blockIndex);
-      std::unique_lock<std::shared_mutex> lock(this->cacheLock_);
       auto blockHeight = this->blockHeightByHash_.at(blockHash);
-      this->cachedTxs_.insert({tx.hash(), {std::make_shared<TxBlock>(tx), blockHash, blockIndex, blockHeight}});
-      return this->cachedTxs_.at(tx.hash());
+      lockCache.unlock();
+      lockChain.unlock();
+      return this->loadTxByBlockIndex(blockHash, blockIndex, blockHeight);
     }
   }
   return { nullptr, Hash(), 0, 0 };
@@ -422,20 +410,12 @@ std::tuple<
       const auto& [txBlockHash, txBlockIndex, txBlockHeight] = this->txByHash_.at(txHash);
       return {std::make_shared<TxBlock>(transaction), txBlockHash, txBlockIndex, txBlockHeight};
     }
-    case StorageStatus::OnCache: {
-      auto blockHash = this->blockHashByHeight_.find(blockHeight)->second;
-      auto txHash = this->cachedBlocks_.at(blockHash)->getTxs()[blockIndex].hash();
-      return this->cachedTxs_.at(txHash);
-    }
+    case StorageStatus::OnCache:
     case StorageStatus::OnDB: {
-      lockCache.unlock();
       auto blockHash = this->blockHashByHeight_.find(blockHeight)->second;
-      Bytes blockData = this->db_.get(blockHash.get(), DBPrefix::blocks);
-      auto tx = this->getTxFromBlockWithIndex(blockData, blockIndex);
-      std::unique_lock<std::shared_mutex> lock(this->cacheLock_);
-      auto blockHeight2 = this->blockHeightByHash_.at(blockHash);
-      this->cachedTxs_.insert({tx.hash(), { std::make_shared<TxBlock>(tx), blockHash, blockIndex, blockHeight2}});
-      return this->cachedTxs_.at(tx.hash());
+      lockCache.unlock();
+      lockChain.unlock();
+      return this->loadTxByBlockIndex(blockHash, blockIndex, blockHeight);
     }
   }
   return { nullptr, Hash(), 0, 0 };
@@ -451,23 +431,133 @@ uint64_t Storage::currentChainSize() const {
   return this->latest()->getNHeight() + 1;
 }
 
+uint64_t Storage::approxSize(const Block& block) {
+  uint64_t size = sizeof(Block);
+  for (const auto& tx : block.getTxs()) size += Storage::approxSize(tx);
+  for (const auto& tx : block.getTxValidators()) size += sizeof(TxValidator) + tx.getData().size();
+  return size;
+}
+
+uint64_t Storage::approxSize(const TxBlock& tx) { return sizeof(TxBlock) + tx.getData().size(); }
+
+std::shared_ptr<const Block> Storage::loadBlock(const Hash& hash) const {
+  {
+    std::unique_lock<std::shared_mutex> lock(this->cacheLock_);
+    if (auto cached = this->cachedBlocks_.get(hash)) return *cached;
+  }
+  // Parse outside the lock, a concurrent load of the same block just replaces the entry
+  auto block = std::make_shared<const Block>(this->db_.get(hash.get(), DBPrefix::blocks), this->options_.getChainID());
+  std::unique_lock<std::shared_mutex> lock(this->cacheLock_);
+  this->cachedBlocks_.put(hash, block, Storage::approxSize(*block));
+  this->cachedBlocks_.trim();
+  return block;
+}
+
+Storage::CachedTx Storage::loadTx(const Hash& tx) const {
+  {
+    std::unique_lock<std::shared_mutex> lock(this->cacheLock_);
+    if (auto cached = this->cachedTxs_.get(tx)) return *cached;
+  }
+  Bytes txData(this->db_.get(tx.get(), DBPrefix::txToBlocks));
+  BytesArrView txDataView(txData);
+  auto blockHash = Hash(txDataView.subspan(0, 32));
+  uint64_t blockIndex = Utils::bytesToUint32(txDataView.subspan(32, 4));
+  uint64_t blockHeight = Utils::bytesToUint64(txDataView.subspan(36,8));
+  Bytes blockData(this->db_.get(blockHash.get(), DBPrefix::blocks));
+  auto Tx = std::make_shared<const TxBlock>(this->getTxFromBlockWithIndex(blockData, blockIndex));
+  std::unique_lock<std::shared_mutex> lock(this->cacheLock_);
+  CachedTx ret{Tx, blockHash, blockIndex, blockHeight};
+  this->cachedTxs_.put(tx, ret, Storage::approxSize(*Tx));
+  this->cachedTxs_.trim();
+  return ret;
+}
+
+Storage::CachedTx Storage::loadTxByBlockIndex(
+  const Hash& blockHash, const uint64_t& blockIndex, const uint64_t& blockHeight
+) const {
+  {
+    std::unique_lock<std::shared_mutex> lock(this->cacheLock_);
+    if (auto cached = this->cachedBlocks_.get(blockHash)) {
+      const auto& transactionList = (*cached)->getTxs();
+      if (transactionList.size() <= blockIndex) throw DynamicException("Tx index out of bounds");
+      return {std::make_shared<const TxBlock>(transactionList[blockIndex]), blockHash, blockIndex, blockHeight};
+    }
+  }
+  Bytes blockData = this->db_.get(blockHash.get(), DBPrefix::blocks);
+  auto tx = std::make_shared<const TxBlock>(this->getTxFromBlockWithIndex(blockData, blockIndex));
+  std::unique_lock<std::shared_mutex> lock(this->cacheLock_);
+  CachedTx ret{tx, blockHash, blockIndex, blockHeight};
+  this->cachedTxs_.put(tx->hash(), ret, Storage::approxSize(*tx));
+  this->cachedTxs_.trim();
+  return ret;
+}
+
+uint64_t Storage::trimChain() {
+  uint64_t evicted = 0;
+  while (true) {
+    // Pick the oldest blocks over the limits, the latest block always stays
+    std::vector<std::shared_ptr<const Block>> blocks;
+    {
+      std::shared_lock<std::shared_mutex> lock(this->chainLock_);
+      uint64_t chainTxs = this->txByHash_.size();
+      for (uint64_t i = 0; i + 1 < this->chain_.size() && blocks.size() < saveBatchSize_; i++) {
+        if (this->chain_.size() - blocks.size() <= maxChainBlocks_ && chainTxs <= maxChainTxs_) break;
+        blocks.push_back(this->chain_[i]);
+        chainTxs -= this->chain_[i]->getTxs().size();
+      }
+    }
+    if (blocks.empty()) break;
+
+    // Blocks processed by State were written to the database along with their state, only save the others
+    DBBatch batch;
+    uint64_t toSave = 0;
+    for (const auto& block : blocks) {
+      if (this->db_.has(block->hash().get(), DBPrefix::blocks)) continue;
+      this->batchBlock(*block, batch);
+      toSave++;
+    }
+    if (toSave != 0 && !this->db_.putBatch(batch)) {
+      LOGERROR(Log::storage,
+        "Failed to save " + std::to_string(toSave) + " blocks to DB, keeping them in memory"
+      );
+      break;
+    }
+
+    // Unlink them from the chain, stop if it changed meanwhile (e.g. popFront())
+    std::unique_lock<std::shared_mutex> lock(this->chainLock_);
+    for (const auto& block : blocks) {
+      if (this->chain_.empty() || this->chain_.front() != block) break;
+      for (const TxBlock& tx : block->getTxs()) this->txByHash_.erase(tx.hash());
+      this->blockByHash_.erase(block->hash());
+      this->chain_.pop_front();
+      evicted++;
+    }
+  }
+  return evicted;
+}
+
 void Storage::periodicSaveToDB() {
+  std::unique_lock<std::mutex> lock(this->periodicSaveMutex_);
   while (!this->stopPeriodicSave_) {
-    std::this_thread::sleep_for(std::chrono::seconds(this->periodicSaveCooldown_));
-    if (!this->stopPeriodicSave_ &&
-      (this->cachedBlocks_.size() > 1000 || this->cachedTxs_.size() > 1000000)
-    ) {
-      // TODO: Properly implement periodic save to DB, saveToDB() function saves **everything** to DB.
-      // Requirements:
-      // 1. Save up to 50% of current block list size to DB (e.g. 500 blocks if there are 1000 blocks).
-      // 2. Save all tx references existing on these blocks to DB.
-      // 3. Check if block is **unique** to Storage class (use shared_ptr::use_count()), if it is, save it to DB.
-      // 4. Take max 1 second, Storage::periodicSaveToDB() should never lock this->chainLock_ for too long, otherwise chain might stall.
-      // use_count() of blocks inside Storage would be 2 if on chain (this->chain + this->blockByHash_) and not being used anywhere else on the program.
-      // or 1 if on cache (cachedBlocks).
-      // if ct > 3 (or 1), we have to wait until whoever is using the block
-      // to stop using it so we can save it.
+    this->periodicSaveCv_.wait_for(lock, std::chrono::seconds(this->periodicSaveCooldown_),
+      [this]() { return this->stopPeriodicSave_; }
+    );
+    if (this->stopPeriodicSave_) break;
+    lock.unlock();
+    uint64_t evicted = this->trimChain();
+    if (evicted != 0) {
+      LOGINFO(Log::storage,
+        "Saved and evicted " + std::to_string(evicted) + " blocks from memory"
+      );
     }
+    lock.lock();
   }
 }
 
+void Storage::stopPeriodicSaveToDB() {
+  {
+    std::unique_lock<std::mutex> lock(this->periodicSaveMutex_);
+    this->stopPeriodicSave_ = true;
+  }
+  this->periodicSaveCv_.notify_all();
+}
@@ -8,7 +8,10 @@ See the LICENSE.txt file in the project root for more information.
 #ifndef STORAGE_H
 #define STORAGE_H
 
+#include <condition_variable>
+#include <mutex>
 #include <shared_mutex>
+#include <thread>
 
 #include "../utils/block.h"
 #include "../utils/db.h"
@@ -17,6 +20,9 @@ See the LICENSE.txt file in the project root for more information.
 #include "../utils/safehash.h"
 #include "../utils/utils.h"
 #include "../utils/options.h"
+#include "../utils/lrucache.h"
+
+#include "chainevents.h"
 
 /// Enum for the status of a block or transaction inside the storage.
 enum StorageStatus { NotFound, OnChain, OnCache, OnDB };
@@ -32,10 +38,14 @@ class Storage {
     DB& db_;  ///< Reference to the database that contains the blockchain's entire history.
     const Options& options_;  ///< Reference to the options singleton.
 
+    /// Cached transaction info (tx, txBlockHash, txBlockIndex, txBlockHeight).
+    using CachedTx = std::tuple<std::shared_ptr<const TxBlock>, Hash, uint64_t, uint64_t>;
+
     /**
      * Recent blockchain history, up to the 1000 most recent blocks or 1M transactions, whichever comes first.
      * This limit is required because it would be too expensive to keep every single transaction in memory
-     * all the time, so once it reaches the limit, or every now and then, older blocks are dumped to the database.
+     * all the time, so once it reaches the limit, older blocks are dumped to the database by the periodic
+     * save thread (see trimChain()).
      * This keeps the blockchain lightweight in memory and extremely responsive.
      * Older blocks always at FRONT, newer blocks always at BACK.
      */
@@ -53,19 +63,26 @@ class Storage {
     /// Map that indexes all block hashes in the chain by their respective heights.
     std::unordered_map<uint64_t, const Hash, SafeHash> blockHashByHeight_;
 
-    /// Cache space for blocks that will be included in the blockchain.
-    mutable std::unordered_map<Hash, const std::shared_ptr<const Block>, SafeHash> cachedBlocks_;
+    /// Cache for blocks read from the database, budgeted by approximate size in bytes.
+    mutable LRUCache<Hash, std::shared_ptr<const Block>, SafeHash> cachedBlocks_;
 
-    /// Cache space for transactions that will be included in the blockchain (tx, txBlockHash, txBlockIndex, txBlockHeight).
-    mutable std::unordered_map<Hash,
-      const std::tuple<const std::shared_ptr<const TxBlock>, const Hash, const uint64_t, const uint64_t>,
-    SafeHash> cachedTxs_;
+    /// Cache for transactions read from the database, budgeted by approximate size in bytes.
+    mutable LRUCache<Hash, CachedTx, SafeHash> cachedTxs_;
 
     mutable std::shared_mutex chainLock_; ///< Mutex for managing read/write access to the blockchain.
-    mutable std::shared_mutex cacheLock_; ///< Mutex to manage read/write access to the cache.
+    mutable std::shared_mutex cacheLock_; ///< Mutex to manage read/write access to the cache. Lookups reorder the LRU, so they lock it uniquely.
     std::thread periodicSaveThread_;  ///< Thread that periodically saves the blockchain history to the database.
     uint64_t periodicSaveCooldown_ = 15;  ///< Cooldown for the periodic save thread, in seconds.
     bool stopPeriodicSave_ = false; ///< Flag for stopping the periodic save thread, if required.
+    std::mutex periodicSaveMutex_; ///< Mutex for `stopPeriodicSave_`.
+    std::condition_variable periodicSaveCv_; ///< Wakes the periodic save thread up when stopping.
+    mutable ChainEvents events_; ///< Chain-head notification bus, shared by every component holding the storage.
+
+    static constexpr uint64_t maxChainBlocks_ = 1000; ///< Maximum number of blocks kept in `chain_`.
+    static constexpr uint64_t maxChainTxs_ = 1000000; ///< Maximum number of transactions kept in `chain_`.
+    static constexpr uint64_t saveBatchSize_ = 100; ///< Blocks saved and evicted from `chain_` per `chainLock_` acquisition.
+    static constexpr uint64_t cachedBlocksBudget_ = 64 * 1024 * 1024; ///< Memory budget for `cachedBlocks_`, in bytes.
+    static constexpr uint64_t cachedTxsBudget_ = 16 * 1024 * 1024; ///< Memory budget for `cachedTxs_`, in bytes.
 
     /**
      * Add a block to the end of the chain.
@@ -121,6 +138,43 @@ class Storage {
      */
     StorageStatus txExistsInternal(const Hash& tx) const;
 
+    ///@{
+    /** Approximate in-memory size of a block or transaction, in bytes. Used as cache cost. */
+    static uint64_t approxSize(const Block& block);
+    static uint64_t approxSize(const TxBlock& tx);
+    ///@}
+
+    /**
+     * Get a block from the cache, or load it from the database and cache it.
+     * Must be called WITHOUT `cacheLock_` locked.
+     * @param hash The block hash. Must exist in the database.
+     * @return A pointer to the block.
+     */
+    std::shared_ptr<const Block> loadBlock(const Hash& hash) const;
+
+    /**
+     * Get a transaction from the cache, or load it from the database and cache it.
+     * Must be called WITHOUT `cacheLock_` locked.
+     * @param tx The transaction hash. Must exist in the database.
+     * @return The transaction info.
+     */
+    CachedTx loadTx(const Hash& tx) const;
+
+    /**
+     * Get a transaction by its position in a block that is not in the chain.
+     * Uses the cached block if there is one, otherwise loads only the transaction
+     * from the database and caches it. Must be called WITHOUT `cacheLock_` locked.
+     * @param blockHash The block hash. Must exist in the database.
+     * @param blockIndex The index of the transaction within the block.
+     * @param blockHeight The block height.
+     * @return The transaction info.
+     * @throw DynamicException if the index is out of bounds.
+     */
+    CachedTx loadTxByBlockIndex(const Hash& blockHash, const uint64_t& blockIndex, const uint64_t& blockHeight) const;
+
+    /// Periodic save thread loop, calls trimChain() every `periodicSaveCooldown_` seconds until stopped.
+    void periodicSaveToDB();
+
   public:
     /**
      * Constructor. Automatically loads the chain from the database
@@ -129,7 +183,7 @@ class Storage {
      * @param options Reference to the options singleton.
      */
     Storage(DB& db, const Options& options);
-    ~Storage(); ///< Destructor. Automatically saves the chain to the database.
+    ~Storage(); ///< Destructor. Stops the periodic save thread and saves the chain to the database.
     void pushBack(Block&& block); ///< Wrapper for `pushBackInternal()`. Use this as it properly locks `chainLock_`.
     void pushFront(Block&& block);  ///< Wrapper for `pushFrontInternal()`. Use this as it properly locks `chainLock_`.
     void popBack(); ///< Remove a block from the end of the chain.
@@ -202,19 +256,39 @@ class Storage {
       const std::shared_ptr<const TxBlock>, const Hash, const uint64_t, const uint64_t
     > getTxByBlockNumberAndIndex(const uint64_t& blockHeight, const uint64_t blockIndex) const;
 
+    /**
+     * Append everything needed to persist a block (the block itself, its height
+     * mapping and its tx-to-block mappings) to a batch. Does not touch the chain.
+     * @param block The block to persist.
+     * @param batch The batch to append to.
+     * @param isLatest If `true`, also marks the block as the latest one in the database.
+     */
+    void batchBlock(const Block& block, DBBatch& batch, bool isLatest = false) const;
+
     /// Get the most recently added block from the chain.
     std::shared_ptr<const Block> latest() const;
 
+    /// Get the chain-head notification bus. Mutable through const references, as it doesn't change the chain.
+    ChainEvents& events() const { return this->events_; }
+
     /// Get the number of blocks currently in the chain (nHeight of latest block + 1).
     uint64_t currentChainSize() const;
 
-    // TODO: both functions below should be called by the ctor/dtor respectively.
+    /// Get the statistics of every column family of the database (see DB::getStats()).
+    std::vector<DBFamilyStats> getDBStats() const { return this->db_.getStats(); }
 
-    /// Start the periodic save thread.
-    void periodicSaveToDB();
+    /**
+     * Save the oldest blocks of the chain to the database (unless they're already there)
+     * and evict them from memory, until the chain fits `maxChainBlocks_` and `maxChainTxs_`.
+     * Works in batches of `saveBatchSize_` blocks, holding `chainLock_` uniquely only
+     * to unlink each batch from the chain, never while writing to the database.
+     * Called by the periodic save thread.
+     * @return The number of evicted blocks.
+     */
+    uint64_t trimChain();
 
-    /// Stop the periodic save thread.
-    void stopPeriodicSaveToDB() { this->stopPeriodicSave_ = true; }
+    /// Stop the periodic save thread. Called by the destructor.
+    void stopPeriodicSaveToDB();
 };
 
 #endif  // STORAGE_H
@@ -0,0 +1,229 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "syncengine.h"
+#include "state.h"
+#include "storage.h"
+
+#include <algorithm>
+
+SyncEngine::SyncEngine(
+  P2P::ManagerNormal& p2p, State& state, const Storage& storage,
+  const Options& options, unsigned int decodeThreads
+) : p2p_(p2p), state_(state), storage_(storage), options_(options),
+  decodePool_(decodeThreads == 0 ? std::thread::hardware_concurrency() : decodeThreads)
+{}
+
+std::pair<uint64_t, uint64_t> SyncEngine::takeRange(uint64_t peerHeight) {
+  auto it = this->pending_.begin();
+  while (it != this->pending_.end()) {
+    uint64_t from = it->first;
+    uint64_t count = it->second;
+    // Drop what was applied meanwhile (e.g. blocks broadcast to us while syncing)
+    if (from + count <= this->nextHeight_) { it = this->pending_.erase(it); continue; }
+    if (from < this->nextHeight_) {
+      it = this->pending_.erase(it);
+      count -= this->nextHeight_ - from;
+      from = this->nextHeight_;
+      it = this->pending_.emplace_hint(it, from, count);
+    }
+    // Ranges are sorted, so if this one is out of reach, every other one is too
+    if (from >= this->nextHeight_ + SyncEngine::rangeSize_ * SyncEngine::windowRanges_) break;
+    if (from > peerHeight) break;
+    uint64_t take = std::min({count, peerHeight - from + 1, SyncEngine::rangeSize_});
+    this->pending_.erase(it);
+    if (take < count) this->pending_.emplace(from + take, count - take);
+    return {from, take};
+  }
+  return {0, 0};
+}
+
+void SyncEngine::downloader(P2P::NodeID peer, uint64_t peerHeight, const std::atomic<bool>& stop) {
+  const std::string peerStr = peer.first.to_string() + ":" + std::to_string(peer.second);
+  uint64_t failures = 0;
+  while (true) {
+    std::pair<uint64_t, uint64_t> range = {0, 0};
+    {
+      std::unique_lock lock(this->mutex_);
+      this->cv_.wait_for(lock, SyncEngine::pollInterval_, [&]() {
+        if (stop || this->done_ || this->badPeers_.contains(peer)) return true;
+        range = this->takeRange(peerHeight);
+        return range.second != 0;
+      });
+      if (stop || this->done_ || this->badPeers_.contains(peer)) break;
+    }
+    if (range.second == 0) continue;
+
+    auto [from, count] = range;
+    P2P::BlocksAnswer answer = this->p2p_.requestBlocks(peer, from, count, SyncEngine::requestTimeout_);
+    const std::vector<BytesArrView>& rawBlocks = answer.blocks;
+    std::unique_lock lock(this->mutex_);
+    if (rawBlocks.empty() || rawBlocks.size() > count) {
+      this->pending_.emplace(from, count);
+      this->cv_.notify_all();
+      if (++failures >= SyncEngine::maxPeerFailures_) {
+        LOGWARNING(Log::syncEngine,
+          "Dropping " + peerStr + " from the sync after " + std::to_string(failures) + " failed requests"
+        );
+        break;
+      }
+      continue;
+    }
+    failures = 0;
+    if (rawBlocks.size() < count) this->pending_.emplace(from + rawBlocks.size(), count - rawBlocks.size());
+
+    // Hand the blocks over to the decoding workers right away, the applier waits on the futures
+    DecodedRange decoded{peer, {}};
+    decoded.blocks.reserve(rawBlocks.size());
+    const uint64_t chainId = this->options_.getChainID();
+    for (const BytesArrView& rawBlock : rawBlocks) {
+      this->bytesDownloaded_ += rawBlock.size();
+      // The task holds the answer, so the block is parsed right out of it
+      decoded.blocks.emplace_back(this->decodePool_.submit(
+        [message = answer.message, rawBlock, chainId]() { return Block(rawBlock, chainId); }
+      ));
+    }
+    this->decoded_.insert_or_assign(from, std::move(decoded));
+    this->cv_.notify_all();
+  }
+  std::unique_lock lock(this->mutex_);
+  this->activeDownloaders_--;
+  this->cv_.notify_all();
+}
+
+void SyncEngine::applyRange(uint64_t from, DecodedRange& range) {
+  for (uint64_t i = 0; i < range.blocks.size(); i++) {
+    uint64_t height = from + i;
+    if (height < this->storage_.latest()->getNHeight() + 1) continue; // Already applied
+    try {
+      this->state_.processNextBlock(range.blocks[i].get());
+      this->blocksApplied_++;
+    } catch (std::exception& e) {
+      // The block may have been broadcast to us and applied in the meantime
+      if (height < this->storage_.latest()->getNHeight() + 1) continue;
+      LOGERROR(Log::syncEngine,
+        "Invalid block " + std::to_string(height) + " from " + range.peer.first.to_string() + ":"
+        + std::to_string(range.peer.second) + ": " + e.what() + " - disconnecting it"
+      );
+      {
+        std::unique_lock lock(this->mutex_);
+        this->badPeers_.insert(range.peer);
+        this->pending_.emplace(height, range.blocks.size() - i);
+      }
+      this->p2p_.disconnectSession(range.peer);
+      return;
+    }
+  }
+}
+
+SyncEngine::Stats SyncEngine::sync(
+  const std::unordered_map<P2P::NodeID, uint64_t, SafeHash>& peerHeights,
+  const std::atomic<bool>& stop
+) {
+  // Download from the highest peers
+  std::vector<std::pair<P2P::NodeID, uint64_t>> peers(peerHeights.begin(), peerHeights.end());
+  std::sort(peers.begin(), peers.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+  if (peers.size() > SyncEngine::maxPeers_) peers.resize(SyncEngine::maxPeers_);
+
+  uint64_t targetHeight = peers.empty() ? 0 : peers.front().second;
+  {
+    std::unique_lock lock(this->mutex_);
+    this->nextHeight_ = this->storage_.latest()->getNHeight() + 1;
+    this->pending_.clear();
+    this->decoded_.clear();
+    this->badPeers_.clear();
+    this->done_ = false;
+    if (targetHeight >= this->nextHeight_) {
+      this->pending_.emplace(this->nextHeight_, targetHeight - this->nextHeight_ + 1);
+    }
+    this->activeDownloaders_ = peers.size();
+  }
+  this->blocksApplied_ = 0;
+  this->bytesDownloaded_ = 0;
+  this->startTime_ = std::chrono::steady_clock::now().time_since_epoch().count();
+  this->endTime_ = 0;
+  LOGINFO(Log::syncEngine,
+    "Syncing from " + std::to_string(peers.size()) + " peers, from height "
+    + std::to_string(this->nextHeight_) + " to " + std::to_string(targetHeight)
+  );
+
+  std::vector<std::future<void>> downloaders;
+  for (const auto& [peer, peerHeight] : peers) {
+    downloaders.emplace_back(std::async(std::launch::async,
+      &SyncEngine::downloader, this, peer, peerHeight, std::cref(stop)
+    ));
+  }
+
+  // Apply the ranges in order as they get decoded
+  auto lastProgress = std::chrono::steady_clock::now();
+  while (!stop) {
+    uint64_t next = this->storage_.latest()->getNHeight() + 1;
+    if (next > targetHeight) break;
+    std::unique_lock lock(this->mutex_);
+    this->nextHeight_ = next;
+    // Find the range holding the next block, dropping the ones that are behind it
+    while (!this->decoded_.empty()) {
+      auto it = this->decoded_.begin();
+      if (it->first + it->second.blocks.size() > next) break;
+      this->decoded_.erase(it);
+    }
+    auto it = this->decoded_.begin();
+    if (it == this->decoded_.end() || it->first > next) {
+      if (this->activeDownloaders_ == 0) break; // Every peer gave up, can't go any further
+      this->cv_.notify_all(); // The window moved, let the downloaders know
+      this->cv_.wait_for(lock, SyncEngine::pollInterval_);
+      continue;
+    }
+    uint64_t from = it->first;
+    DecodedRange range = std::move(it->second);
+    this->decoded_.erase(it);
+    lock.unlock();
+    this->applyRange(from, range);
+
+    if (std::chrono::steady_clock::now() - lastProgress >= SyncEngine::progressInterval_) {
+      lastProgress = std::chrono::steady_clock::now();
+      Stats current = this->stats();
+      LOGINFO(Log::syncEngine,
+        "Synced up to " + std::to_string(this->storage_.latest()->getNHeight()) + "/" + std::to_string(targetHeight)
+        + " - " + std::to_string(current.blocksPerSecond()) + " blocks/s, "
+        + std::to_string(current.bytesPerSecond()) + " bytes/s"
+      );
+    }
+  }
+
+  {
+    std::unique_lock lock(this->mutex_);
+    this->done_ = true;
+    this->cv_.notify_all();
+  }
+  for (auto& downloader : downloaders) downloader.wait();
+  this->decodePool_.wait_for_tasks();
+  {
+    std::unique_lock lock(this->mutex_);
+    this->pending_.clear();
+    this->decoded_.clear();
+  }
+  this->endTime_ = std::chrono::steady_clock::now().time_since_epoch().count();
+
+  Stats result = this->stats();
+  LOGINFO(Log::syncEngine,
+    "Applied " + std::to_string(result.blocks) + " blocks (" + std::to_string(result.bytes) + " bytes) in "
+    + std::to_string(std::chrono::duration<double>(result.elapsed).count()) + "s - "
+    + std::to_string(result.blocksPerSecond()) + " blocks/s, " + std::to_string(result.bytesPerSecond()) + " bytes/s"
+  );
+  return result;
+}
+
+SyncEngine::Stats SyncEngine::stats() const {
+  auto end = this->endTime_.load();
+  if (end == 0) end = std::chrono::steady_clock::now().time_since_epoch().count();
+  Stats result;
+  result.blocks = this->blocksApplied_;
+  result.bytes = this->bytesDownloaded_;
+  result.elapsed = std::chrono::steady_clock::duration(end - this->startTime_.load());
+  return result;
+}
@@ -0,0 +1,159 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#ifndef SYNCENGINE_H
+#define SYNCENGINE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <map>
+#include <mutex>
+#include <unordered_set>
+
+#include "../libs/BS_thread_pool_light.hpp"
+#include "../net/p2p/managernormal.h"
+#include "../utils/block.h"
+#include "../utils/options.h"
+#include "../utils/safehash.h"
+
+// Forward declarations.
+class Storage;
+class State;
+
+/**
+ * Downloads the blocks the node is missing from its peers and applies them.
+ * The chain is split into ranges that are fetched with `RequestBlocks` by one
+ * downloader per peer, so several peers are downloaded from concurrently.
+ * As soon as a range arrives, its blocks are deserialized (which checks every
+ * signature) on a worker pool, while the calling thread applies the blocks that are
+ * already decoded, strictly in height order, through State::processNextBlock().
+ * Downloaders only fetch ranges within a window ahead of the applier, so memory
+ * stays bounded no matter how far behind the node is.
+ */
+class SyncEngine {
+  public:
+    /// Throughput of a sync run.
+    struct Stats {
+      uint64_t blocks = 0; ///< Number of blocks applied.
+      uint64_t bytes = 0;  ///< Number of serialized block bytes downloaded.
+      std::chrono::steady_clock::duration elapsed{}; ///< Time spent syncing.
+
+      /// Blocks applied per second.
+      double blocksPerSecond() const {
+        double seconds = std::chrono::duration<double>(this->elapsed).count();
+        return (seconds > 0) ? this->blocks / seconds : 0;
+      }
+
+      /// Bytes downloaded per second.
+      double bytesPerSecond() const {
+        double seconds = std::chrono::duration<double>(this->elapsed).count();
+        return (seconds > 0) ? this->bytes / seconds : 0;
+      }
+    };
+
+  private:
+    /// A downloaded range, being (or already) decoded by the worker pool.
+    struct DecodedRange {
+      P2P::NodeID peer; ///< The node that sent the range.
+      std::vector<std::future<Block>> blocks; ///< One future per block, in height order.
+    };
+
+    P2P::ManagerNormal& p2p_;   ///< Reference to the P2P connection manager.
+    State& state_;              ///< Reference to the blockchain's state.
+    const Storage& storage_;    ///< Reference to the blockchain's storage.
+    const Options& options_;    ///< Reference to the options singleton.
+    BS::thread_pool_light decodePool_; ///< Workers that deserialize the downloaded blocks.
+
+    std::mutex mutex_;              ///< Mutex for everything below that is not atomic.
+    std::condition_variable cv_;    ///< Wakes downloaders and the applier on progress.
+    std::map<uint64_t, uint64_t> pending_;  ///< Ranges still to be downloaded (first height -> count).
+    std::map<uint64_t, DecodedRange> decoded_; ///< Downloaded ranges by first height.
+    std::unordered_set<P2P::NodeID, SafeHash> badPeers_; ///< Peers that sent invalid blocks.
+    uint64_t nextHeight_ = 0;       ///< Height of the next block to apply.
+    uint64_t activeDownloaders_ = 0; ///< Number of downloaders still running.
+    bool done_ = false;             ///< Set by the applier when the run is over.
+
+    std::atomic<uint64_t> blocksApplied_ = 0;    ///< Blocks applied in the current run.
+    std::atomic<uint64_t> bytesDownloaded_ = 0;  ///< Bytes downloaded in the current run.
+    std::atomic<std::chrono::steady_clock::rep> startTime_ = 0; ///< Start of the current run.
+    std::atomic<std::chrono::steady_clock::rep> endTime_ = 0;   ///< End of the last run (0 while running).
+
+    /// Number of blocks asked for in a single `RequestBlocks`.
+    static constexpr uint64_t rangeSize_ = 64;
+    /// How far ahead of the applier ranges are downloaded, in ranges.
+    static constexpr uint64_t windowRanges_ = 16;
+    /// Maximum number of peers downloaded from at once.
+    static constexpr uint64_t maxPeers_ = 8;
+    /// Number of consecutive failed requests after which a peer is dropped from the run.
+    static constexpr uint64_t maxPeerFailures_ = 3;
+    /// Timeout for a single `RequestBlocks`.
+    static constexpr std::chrono::milliseconds requestTimeout_{10000};
+    /// Upper bound for a single wait, so the stop flag is checked regularly.
+    static constexpr std::chrono::milliseconds pollInterval_{100};
+    /// Interval between progress logs.
+    static constexpr std::chrono::seconds progressInterval_{5};
+
+    /**
+     * Take the lowest pending range a peer can serve, within the download window.
+     * Must be called with `mutex_` locked.
+     * @param peerHeight The latest height of the peer.
+     * @return The first height and count of the range, or `{0, 0}` if there is none.
+     */
+    std::pair<uint64_t, uint64_t> takeRange(uint64_t peerHeight);
+
+    /**
+     * Downloader loop for a single peer, run on its own thread.
+     * @param peer The peer to download from.
+     * @param peerHeight The latest height of the peer.
+     * @param stop Flag for stopping the run.
+     */
+    void downloader(P2P::NodeID peer, uint64_t peerHeight, const std::atomic<bool>& stop);
+
+    /**
+     * Apply the blocks of a decoded range, in order.
+     * On an invalid block, the peer that sent it is disconnected and the rest of
+     * the range is put back to be downloaded from someone else.
+     * @param from The first height of the range.
+     * @param range The decoded range.
+     */
+    void applyRange(uint64_t from, DecodedRange& range);
+
+  public:
+    /**
+     * Constructor.
+     * @param p2p Reference to the P2P connection manager.
+     * @param state Reference to the blockchain's state.
+     * @param storage Reference to the blockchain's storage.
+     * @param options Reference to the options singleton.
+     * @param decodeThreads Number of block deserialization workers (0 = hardware concurrency).
+     */
+    SyncEngine(
+      P2P::ManagerNormal& p2p, State& state, const Storage& storage,
+      const Options& options, unsigned int decodeThreads = 0
+    );
+
+    /**
+     * Sync the chain up to the highest of the given peers.
+     * Blocks the calling thread, which is the one that applies the blocks.
+     * Returns when the target height is reached, when no peer can make progress
+     * anymore, or when `stop` is set.
+     * @param peerHeights The peers to download from, with their latest heights.
+     * @param stop Flag for stopping the sync.
+     * @return The throughput of the run.
+     */
+    Stats sync(
+      const std::unordered_map<P2P::NodeID, uint64_t, SafeHash>& peerHeights,
+      const std::atomic<bool>& stop
+    );
+
+    /// Get the throughput of the current (or last) run. Safe to call from any thread.
+    Stats stats() const;
+};
+
+#endif // SYNCENGINE_H
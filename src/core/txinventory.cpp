@@ -0,0 +1,34 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "txinventory.h"
+
+uint64_t TxInventory::add(const Hash& txHash) {
+  std::lock_guard lock(this->mutex_);
+  this->log_.emplace_back(++this->sequence_, txHash);
+  while (this->log_.size() > this->capacity_) this->log_.pop_front();
+  return this->sequence_;
+}
+
+TxInventory::Delta TxInventory::since(uint64_t sequence, uint64_t max) const {
+  std::lock_guard lock(this->mutex_);
+  Delta delta;
+  // A sequence from the future means we restarted, one before the log means the caller fell behind
+  uint64_t oldest = this->log_.empty() ? this->sequence_ + 1 : this->log_.front().first;
+  if (sequence > this->sequence_ || sequence + 1 < oldest) {
+    delta.sequence = this->sequence_;
+    delta.complete = false;
+    return delta;
+  }
+  // Sequences in the log are contiguous, so the first one to send is at a known offset
+  delta.sequence = sequence;
+  for (uint64_t i = sequence + 1 - oldest; i < this->log_.size() && delta.hashes.size() < max; i++) {
+    delta.hashes.emplace_back(this->log_[i].second);
+    delta.sequence = this->log_[i].first;
+  }
+  return delta;
+}
@@ -0,0 +1,71 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#ifndef TXINVENTORY_H
+#define TXINVENTORY_H
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "../utils/strings.h"
+
+/**
+ * Sequenced log of the transaction hashes that entered a mempool, used for
+ * inventory-based gossip (see P2P::ManagerNormal::requestNewTxs()).
+ * Every new transaction gets the next sequence number, so peers can ask for
+ * "everything after sequence N" instead of the whole mempool. The log is bounded:
+ * once a peer falls behind its oldest entry (or the node restarted and its
+ * sequence went back), since() tells it to start over from the full list.
+ * Hashes are never removed when their transaction leaves the mempool, peers
+ * simply won't get them when asking for the transactions themselves.
+ * Thread-safe.
+ */
+class TxInventory {
+  public:
+    /// Answer to since().
+    struct Delta {
+      uint64_t sequence = 0;      ///< Sequence to ask from next time.
+      bool complete = true;       ///< `false` if the log doesn't go back far enough, the caller should send everything.
+      std::vector<Hash> hashes;   ///< The hashes added after the asked sequence, oldest first.
+    };
+
+  private:
+    mutable std::mutex mutex_;                      ///< Mutex for managing read/write access to the log.
+    std::deque<std::pair<uint64_t, Hash>> log_;     ///< Sequence numbers and hashes, oldest first.
+    uint64_t sequence_ = 0;                         ///< Sequence of the latest hash.
+    const uint64_t capacity_;                       ///< Maximum number of hashes kept in the log.
+
+  public:
+    /**
+     * Constructor.
+     * @param capacity Maximum number of hashes kept in the log. Defaults to 16384.
+     */
+    explicit TxInventory(uint64_t capacity = 16384) : capacity_(capacity) {}
+
+    /**
+     * Record a new transaction.
+     * @param txHash The hash of the transaction.
+     * @return The sequence number given to it.
+     */
+    uint64_t add(const Hash& txHash);
+
+    /**
+     * Get the hashes recorded after a given sequence.
+     * @param sequence The last sequence the caller already knows (0 for none).
+     * @param max Maximum number of hashes to return. If reached, the returned
+     *            sequence is the one of the last returned hash, so the caller
+     *            gets the rest next time.
+     * @return The delta.
+     */
+    Delta since(uint64_t sequence, uint64_t max) const;
+
+    /// Get the sequence of the latest hash.
+    uint64_t sequence() const { std::lock_guard lock(this->mutex_); return this->sequence_; }
+};
+
+#endif // TXINVENTORY_H
@@ -0,0 +1,171 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include <algorithm>
+
+#include "filters.h"
+#include "../../core/state.h"
+#include "../../utils/metrics.h"
+
+/// Get the gauge with the number of filters.
+static Metrics::Gauge& filtersGauge() {
+  static Metrics::Gauge& gauge = Metrics::gauge("orbiter_rpc_filters", "Installed eth_newFilter/eth_newBlockFilter/eth_newPendingTransactionFilter filters.");
+  return gauge;
+}
+
+uint64_t Filters::latestHeight() const {
+  auto latest = this->storage_.latest();
+  return (latest != nullptr) ? latest->getNHeight() : 0;
+}
+
+void Filters::sweep(bool force) {
+  const auto now = std::chrono::steady_clock::now();
+  if (!force && now - this->lastSweep_ < this->timeout_ / 10) return;
+  std::erase_if(this->filters_, [this, &now](const auto& entry) { return this->expired(*entry.second, now); });
+  this->lastSweep_ = now;
+  filtersGauge().set(this->filters_.size());
+}
+
+std::string Filters::add(std::shared_ptr<Filter> filter) {
+  std::lock_guard lock(this->mutex_);
+  this->sweep();
+  if (this->filters_.size() >= this->maxFilters_) this->sweep(true);
+  if (this->filters_.size() >= this->maxFilters_) throw DynamicException(
+    "Too many filters, max is " + std::to_string(this->maxFilters_)
+  );
+  std::string id;
+  do { id = Hex::fromBytes(Utils::randBytes(16), true).get(); } while (this->filters_.contains(id));
+  this->filters_.emplace(id, std::move(filter));
+  filtersGauge().set(this->filters_.size());
+  return id;
+}
+
+std::shared_ptr<Filters::Filter> Filters::find(const std::string& id) {
+  std::lock_guard lock(this->mutex_);
+  this->sweep();
+  auto it = this->filters_.find(id);
+  const auto now = std::chrono::steady_clock::now();
+  if (it == this->filters_.end() || this->expired(*it->second, now)) throw DynamicException("Filter not found");
+  it->second->lastPoll = now;
+  return it->second;
+}
+
+json Filters::logChanges(Filter& filter) {
+  std::lock_guard lock(filter.mutex);
+  json ret = json::array();
+  const uint64_t latest = this->latestHeight();
+  const uint64_t to = filter.toBlock ? std::min(*filter.toBlock, latest) : latest;
+  if (filter.nextBlock > to) return ret;
+
+  // Scan as much as a single eth_getLogs call is allowed to
+  const uint64_t end = std::min(to, filter.nextBlock + this->options_.getEventBlockCap());
+  const std::vector<Event> events = this->state_.getEvents(filter.nextBlock, end, filter.address, filter.topics);
+  std::vector<const Event*> sorted;
+  sorted.reserve(events.size());
+  for (const Event& e : events) sorted.push_back(&e);
+  std::sort(sorted.begin(), sorted.end(), [](const Event* a, const Event* b) {
+    return std::tuple(a->getBlockIndex(), a->getTxIndex(), a->getLogIndex())
+      < std::tuple(b->getBlockIndex(), b->getTxIndex(), b->getLogIndex());
+  });
+  for (const Event* e : sorted) {
+    if (
+      filter.lastEvent && e->getBlockIndex() == filter.nextBlock &&
+      std::pair(e->getTxIndex(), e->getLogIndex()) <= *filter.lastEvent
+    ) continue; // Already returned by the previous poll
+    ret.push_back(json::parse(e->serializeForRPC()));
+  }
+
+  // Hitting the log cap means there may be more, so resume right after the last event we have
+  if (events.size() >= this->options_.getEventLogCap() && !sorted.empty()) {
+    const Event* last = sorted.back();
+    if (ret.empty()) {
+      // A single block with more matches than the cap, the rest of it can't ever be returned
+      LOGWARNING(Log::httpServer, "Block " + std::to_string(last->getBlockIndex())
+        + " has more matching events than the event log cap, skipping the rest of it"
+      );
+      filter.nextBlock = last->getBlockIndex() + 1;
+      filter.lastEvent.reset();
+    } else {
+      filter.nextBlock = last->getBlockIndex();
+      filter.lastEvent = std::pair(last->getTxIndex(), last->getLogIndex());
+    }
+  } else {
+    filter.nextBlock = end + 1;
+    filter.lastEvent.reset();
+  }
+  return ret;
+}
+
+json Filters::blockChanges(Filter& filter) {
+  std::lock_guard lock(filter.mutex);
+  json ret = json::array();
+  const uint64_t latest = this->latestHeight();
+  for (; filter.nextBlock <= latest && ret.size() < this->maxHashesPerPoll_; filter.nextBlock++) {
+    if (auto block = this->storage_.getBlock(filter.nextBlock)) ret.push_back(block->hash().hex(true).get());
+  }
+  return ret;
+}
+
+json Filters::txChanges(Filter& filter) {
+  std::lock_guard lock(filter.mutex);
+  json ret = json::array();
+  auto delta = this->state_.getTxInventory().since(filter.txSequence, this->maxHashesPerPoll_);
+  filter.txSequence = delta.sequence;
+  for (const Hash& hash : delta.hashes) ret.push_back(hash.hex(true).get());
+  return ret;
+}
+
+std::string Filters::newLogFilter(
+  const std::tuple<std::optional<uint64_t>, std::optional<uint64_t>, Address, std::vector<Hash>>& info
+) {
+  const auto& [fromBlock, toBlock, address, topics] = info;
+  const uint64_t from = fromBlock.value_or(this->latestHeight() + 1);
+  auto filter = std::make_shared<Filter>(Type::Logs, from, toBlock, address, topics);
+  filter->nextBlock = from;
+  return this->add(std::move(filter));
+}
+
+std::string Filters::newBlockFilter() {
+  auto filter = std::make_shared<Filter>(Type::Blocks);
+  filter->nextBlock = this->latestHeight() + 1;
+  return this->add(std::move(filter));
+}
+
+std::string Filters::newPendingTransactionFilter() {
+  auto filter = std::make_shared<Filter>(Type::PendingTransactions);
+  filter->txSequence = this->state_.getTxInventory().sequence();
+  return this->add(std::move(filter));
+}
+
+bool Filters::uninstall(const std::string& id) {
+  std::lock_guard lock(this->mutex_);
+  bool removed = this->filters_.erase(id) > 0;
+  filtersGauge().set(this->filters_.size());
+  return removed;
+}
+
+json Filters::changes(const std::string& id) {
+  auto filter = this->find(id);
+  switch (filter->type) {
+    case Type::Logs: return this->logChanges(*filter);
+    case Type::Blocks: return this->blockChanges(*filter);
+    case Type::PendingTransactions: return this->txChanges(*filter);
+  }
+  return json::array();
+}
+
+json Filters::logs(const std::string& id) {
+  auto filter = this->find(id);
+  if (filter->type != Type::Logs) throw DynamicException("Filter is not a log filter");
+  json ret = json::array();
+  const uint64_t to = filter->toBlock.value_or(this->latestHeight());
+  if (filter->fromBlock > to) return ret;
+  for (const Event& e : this->state_.getEvents(filter->fromBlock, to, filter->address, filter->topics)) {
+    ret.push_back(json::parse(e.serializeForRPC()));
+  }
+  return ret;
+}
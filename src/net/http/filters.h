@@ -0,0 +1,209 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#ifndef FILTERS_H
+#define FILTERS_H
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../../libs/json.hpp"
+#include "../../utils/strings.h"
+
+using json = nlohmann::ordered_json;
+
+// Forward declarations.
+class State;
+class Storage;
+class Options;
+
+/**
+ * Registry of the server-side filters (`eth_newFilter`, `eth_newBlockFilter` and
+ * `eth_newPendingTransactionFilter`), polled with `eth_getFilterChanges`.
+ * Every filter keeps a cursor of what it already returned, so a poll only looks
+ * at what is new instead of re-scanning the whole range like `eth_getLogs` does:
+ * - log filters keep the next block to scan plus the position (tx index, log index)
+ *   of the last event returned from it, since a single poll is still bound by the
+ *   event block/log caps (see Options) and may stop in the middle of a block;
+ * - block filters keep the next block height;
+ * - pending transaction filters keep their State's TxInventory sequence.
+ * Filters that aren't polled for a while expire, and the number of filters is capped.
+ */
+class Filters {
+  public:
+    /// Kinds of filters.
+    enum class Type { Logs, Blocks, PendingTransactions };
+
+  private:
+    /// A single filter.
+    struct Filter {
+      const Type type;        ///< Kind of the filter.
+      const uint64_t fromBlock = 0;   ///< First block to match (logs only).
+      const std::optional<uint64_t> toBlock;  ///< Last block to match, empty to follow the chain (logs only).
+      const Address address;  ///< Events must come from this address (logs only, empty for any).
+      const std::vector<Hash> topics; ///< Events must have these topics (logs only).
+      std::mutex mutex;       ///< Mutex for the cursor (polls of the same filter are serialized).
+      uint64_t nextBlock = 0; ///< Next block to scan (logs and blocks).
+      std::optional<std::pair<uint64_t, uint64_t>> lastEvent; ///< Tx and log index of the last event returned from `nextBlock` (logs only).
+      uint64_t txSequence = 0; ///< Latest TxInventory sequence returned (pending transactions only).
+      std::atomic<std::chrono::steady_clock::time_point> lastPoll; ///< When the filter was last used.
+
+      /**
+       * Constructor.
+       * @param type Kind of the filter.
+       * @param fromBlock First block to match.
+       * @param toBlock Last block to match.
+       * @param address Address filter.
+       * @param topics Topic filter.
+       */
+      Filter(
+        Type type, uint64_t fromBlock = 0, std::optional<uint64_t> toBlock = std::nullopt,
+        Address address = Address(), std::vector<Hash> topics = {}
+      ) : type(type), fromBlock(fromBlock), toBlock(toBlock), address(std::move(address)),
+        topics(std::move(topics)), lastPoll(std::chrono::steady_clock::now()) {}
+    };
+
+    State& state_;            ///< Reference to the blockchain's state.
+    const Storage& storage_;  ///< Reference to the blockchain's storage.
+    const Options& options_;  ///< Reference to the options singleton (for the event caps).
+    const uint64_t maxFilters_; ///< Maximum number of filters.
+    const std::chrono::milliseconds timeout_; ///< Filters not used for this long are removed.
+    mutable std::mutex mutex_;  ///< Mutex for `filters_` and `lastSweep_`.
+    std::map<std::string, std::shared_ptr<Filter>> filters_; ///< Filters by ID.
+    std::chrono::steady_clock::time_point lastSweep_; ///< When expired filters were last removed.
+
+    /// Maximum number of block or transaction hashes returned by a single poll.
+    static constexpr uint64_t maxHashesPerPoll_ = 4096;
+
+    /// Get the height of the latest block.
+    uint64_t latestHeight() const;
+
+    /**
+     * Check if a filter expired.
+     * @param filter The filter.
+     * @param now The current time.
+     */
+    bool expired(const Filter& filter, std::chrono::steady_clock::time_point now) const {
+      return now - filter.lastPoll.load() > this->timeout_;
+    }
+
+    /**
+     * Remove expired filters. Must be called with `mutex_` held.
+     * @param force If `false`, only sweeps if the last sweep was a while ago.
+     */
+    void sweep(bool force = false);
+
+    /**
+     * Register a new filter.
+     * @param filter The filter.
+     * @return The filter ID.
+     * @throw DynamicException if there are too many filters.
+     */
+    std::string add(std::shared_ptr<Filter> filter);
+
+    /**
+     * Find a filter, marking it as used.
+     * @param id The filter ID.
+     * @return The filter.
+     * @throw DynamicException if not found (or expired).
+     */
+    std::shared_ptr<Filter> find(const std::string& id);
+
+    /// Get the logs of a log filter that are new since the last poll.
+    json logChanges(Filter& filter);
+
+    /// Get the blocks that are new since the last poll.
+    json blockChanges(Filter& filter);
+
+    /// Get the mempool transactions that are new since the last poll.
+    json txChanges(Filter& filter);
+
+  public:
+    /// Default maximum number of filters.
+    static constexpr uint64_t defaultMaxFilters = 10000;
+
+    /// Default time after which unused filters are removed.
+    static constexpr std::chrono::milliseconds defaultTimeout = std::chrono::minutes(5);
+
+    /**
+     * Constructor.
+     * @param state Reference to the blockchain's state.
+     * @param storage Reference to the blockchain's storage.
+     * @param options Reference to the options singleton.
+     * @param maxFilters Maximum number of filters.
+     * @param timeout Time after which unused filters are removed.
+     */
+    Filters(
+      State& state, const Storage& storage, const Options& options,
+      uint64_t maxFilters = defaultMaxFilters, std::chrono::milliseconds timeout = defaultTimeout
+    ) : state_(state), storage_(storage), options_(options), maxFilters_(maxFilters), timeout_(timeout),
+      lastSweep_(std::chrono::steady_clock::now()) {}
+
+    /**
+     * Create a log filter (`eth_newFilter`).
+     * The first poll returns the matching logs from `fromBlock` on, or only
+     * the ones of new blocks if no `fromBlock` was given.
+     * @param info A tuple of first block (empty for the next one), last block
+     *             (empty to follow the chain), address and a list of topics.
+     * @return The filter ID.
+     * @throw DynamicException if there are too many filters.
+     */
+    std::string newLogFilter(
+      const std::tuple<std::optional<uint64_t>, std::optional<uint64_t>, Address, std::vector<Hash>>& info
+    );
+
+    /**
+     * Create a block filter (`eth_newBlockFilter`).
+     * @return The filter ID.
+     * @throw DynamicException if there are too many filters.
+     */
+    std::string newBlockFilter();
+
+    /**
+     * Create a pending transaction filter (`eth_newPendingTransactionFilter`).
+     * @return The filter ID.
+     * @throw DynamicException if there are too many filters.
+     */
+    std::string newPendingTransactionFilter();
+
+    /**
+     * Remove a filter (`eth_uninstallFilter`).
+     * @param id The filter ID.
+     * @return `true` if removed, `false` if not found.
+     */
+    bool uninstall(const std::string& id);
+
+    /**
+     * Get what's new since the last poll (`eth_getFilterChanges`) and move the cursor.
+     * @param id The filter ID.
+     * @return Log objects for log filters, block or transaction hashes otherwise.
+     * @throw DynamicException if the filter is not found.
+     */
+    json changes(const std::string& id);
+
+    /**
+     * Get every log matching a log filter (`eth_getFilterLogs`), like `eth_getLogs` would.
+     * Doesn't move the cursor.
+     * @param id The filter ID.
+     * @return The log objects.
+     * @throw DynamicException if the filter is not found or is not a log filter.
+     * @throw std::out_of_range if the filter's range exceeds the event block cap.
+     */
+    json logs(const std::string& id);
+
+    /// Get the number of filters (including expired ones that weren't removed yet).
+    uint64_t size() const { std::lock_guard lock(this->mutex_); return this->filters_.size(); }
+};
+
+#endif // FILTERS_H
@@ -9,10 +9,11 @@ See the LICENSE.txt file in the project root for more information.
 
 HTTPListener::HTTPListener(
   net::io_context& ioc, tcp::endpoint ep, const std::shared_ptr<const std::string>& docroot,
-  State& state, const Storage& storage,
-  P2P::ManagerNormal& p2p, const Options& options
+  State& state, const Storage& storage, P2P::ManagerNormal& p2p,
+  const Options& options, Filters& filters, ResponseCache& cache, Subscriptions& subscriptions
 ) : ioc_(ioc), acc_(net::make_strand(ioc)), docroot_(docroot), state_(state),
-  storage_(storage), p2p_(p2p), options_(options)
+  storage_(storage), p2p_(p2p), options_(options), filters_(filters), cache_(cache),
+  subscriptions_(subscriptions)
 {
   beast::error_code ec;
   this->acc_.open(ep.protocol(), ec);  // Open the acceptor
@@ -37,7 +38,7 @@ void HTTPListener::on_accept(beast::error_code ec, tcp::socket sock) {
   } else {
     std::make_shared<HTTPSession>(
       std::move(sock), this->docroot_, this->state_, this->storage_, this->p2p_,
-      this->options_
+      this->options_, this->filters_, this->cache_, this->subscriptions_
     )->start(); // Create the http session and run it
   }
   this->do_accept(); // Accept another connection
@@ -35,6 +35,15 @@ class HTTPListener : public std::enable_shared_from_this<HTTPListener> {
     /// Reference to the options singleton.
     const Options& options_;
 
+    /// Reference to the filter registry.
+    Filters& filters_;
+
+    /// Reference to the response cache.
+    ResponseCache& cache_;
+
+    /// Reference to the subscription registry.
+    Subscriptions& subscriptions_;
+
     /// Accept an incoming connection from the endpoint. The new connection gets its own strand.
     void do_accept();
 
@@ -56,11 +65,14 @@ class HTTPListener : public std::enable_shared_from_this<HTTPListener> {
      * @param storage Reference pointer to the blockchain's storage.
      * @param p2p Reference pointer to the P2P connection manager.
      * @param options Reference pointer to the options singleton.
+     * @param filters Reference pointer to the filter registry.
+     * @param cache Reference pointer to the response cache.
+     * @param subscriptions Reference pointer to the subscription registry.
      */
     HTTPListener(
       net::io_context& ioc, tcp::endpoint ep, const std::shared_ptr<const std::string>& docroot,
-      State& state, const Storage& storage,
-      P2P::ManagerNormal& p2p, const Options& options
+      State& state, const Storage& storage, P2P::ManagerNormal& p2p,
+      const Options& options, Filters& filters, ResponseCache& cache, Subscriptions& subscriptions
     );
 
     void start(); ///< Start accepting incoming connections.
@@ -6,28 +6,168 @@ See the LICENSE.txt file in the project root for more information.
 */
 
 #include "httpparser.h"
+#include "../../core/state.h"
+#include "filters.h"
+#include "responsecache.h"
+#include "../../utils/metrics.h"
+#include "../../libs/BS_thread_pool_light.hpp"
 
-std::string parseJsonRpcRequest(
-  const std::string& body,
+/// Metrics of a JSON-RPC method.
+struct RpcMethodMetrics {
+  Metrics::Counter& requests; ///< Requests handled.
+  Metrics::Counter& errors;   ///< Requests that ended in an internal error.
+  Metrics::Histogram& seconds; ///< Time spent handling a request.
+};
+
+/**
+ * Get the metrics of a JSON-RPC method.
+ * Every known method is registered on the first call, so lookups never take the registry's lock.
+ * @param method The method (`invalid` for unknown methods and malformed requests).
+ * @return The method's metrics.
+ */
+static const RpcMethodMetrics& rpcMethodMetrics(const JsonRPC::Methods& method) {
+  static const std::unordered_map<JsonRPC::Methods, RpcMethodMetrics> metrics = []() {
+    std::unordered_map<JsonRPC::Methods, RpcMethodMetrics> ret;
+    auto add = [&ret](const JsonRPC::Methods& method, const std::string& name) {
+      const std::string labels = "method=\"" + name + "\"";
+      ret.emplace(method, RpcMethodMetrics{
+        Metrics::counter("orbiter_rpc_requests_total", "JSON-RPC requests handled, by method.", labels),
+        Metrics::counter("orbiter_rpc_errors_total", "JSON-RPC requests that ended in an internal error, by method.", labels),
+        Metrics::histogram("orbiter_rpc_request_seconds", "Time spent handling a JSON-RPC request, by method.", labels)
+      });
+    };
+    add(JsonRPC::Methods::invalid, "invalid");
+    for (const auto& [name, method] : JsonRPC::methodsLookupTable) add(method, name);
+    return ret;
+  }();
+  auto it = metrics.find(method);
+  return (it != metrics.end()) ? it->second : metrics.at(JsonRPC::Methods::invalid);
+}
+
+/**
+ * Record a handled JSON-RPC request.
+ * @param metrics The metrics of the request's method.
+ * @param start When the request started being handled.
+ * @param error Whether the request ended in an internal error.
+ */
+static void recordRpcRequest(
+  const RpcMethodMetrics& metrics, const std::chrono::steady_clock::time_point& start, bool error
+) {
+  metrics.requests.inc();
+  if (error) metrics.errors.inc();
+  metrics.seconds.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+}
+
+std::string serveMetrics(const State& state, const Storage& storage, const P2P::ManagerNormal& p2p) {
+  // Values that are cheaper to read on scrape than to keep up to date
+  static Metrics::Gauge& peers = Metrics::gauge("orbiter_p2p_peers", "Connected P2P peers.");
+  static Metrics::Gauge& mempoolTxs = Metrics::gauge("orbiter_mempool_txs", "Transactions in the mempool.");
+  peers.set(p2p.getPeerCount());
+  mempoolTxs.set(state.getMempoolSize());
+  for (const DBFamilyStats& stats : storage.getDBStats()) {
+    const std::string labels = "family=\"" + stats.name + "\"";
+    Metrics::gauge("orbiter_db_estimated_keys", "Estimated number of keys, by column family.", labels).set(stats.estimatedKeys);
+    Metrics::gauge("orbiter_db_live_data_bytes", "Estimated size of live data, by column family.", labels).set(stats.liveDataSize);
+    Metrics::gauge("orbiter_db_sst_files_bytes", "Total size of the SST files, by column family.", labels).set(stats.sstFilesSize);
+    Metrics::gauge("orbiter_db_memtables_bytes", "Size of the memtables, by column family.", labels).set(stats.memtablesSize);
+    Metrics::gauge("orbiter_db_block_cache_usage_bytes", "Block cache usage, by column family.", labels).set(stats.blockCacheUsage);
+    Metrics::gauge("orbiter_db_block_cache_capacity_bytes", "Block cache capacity, by column family.", labels).set(stats.blockCacheCapacity);
+  }
+  // SeenMessages keeps its own totals, the counters catch up with them on every scrape
+  // (under a lock, so concurrent scrapes don't both add the same difference)
+  static std::mutex duplicatesMutex;
+  static const std::vector<std::pair<P2P::CommandType, Metrics::Counter*>> duplicates = []() {
+    std::vector<std::pair<P2P::CommandType, Metrics::Counter*>> ret;
+    auto add = [&ret](P2P::CommandType command, const std::string& name) {
+      ret.emplace_back(command, &Metrics::counter("orbiter_p2p_duplicates_suppressed_total",
+        "Duplicate P2P broadcasts suppressed, by command.", "command=\"" + name + "\""
+      ));
+    };
+    add(P2P::BroadcastValidatorTx, "BroadcastValidatorTx");
+    add(P2P::BroadcastTx, "BroadcastTx");
+    add(P2P::BroadcastBlock, "BroadcastBlock");
+    add(P2P::BroadcastCompactBlock, "BroadcastCompactBlock");
+    return ret;
+  }();
+  {
+    std::unique_lock lock(duplicatesMutex);
+    for (const auto& [command, counter] : duplicates) {
+      uint64_t total = p2p.getSeenMessages().duplicates(command);
+      if (total > counter->value()) counter->inc(total - counter->value());
+    }
+  }
+  return Metrics::Registry::instance().serialize();
+}
+
+/**
+ * Get the id of a request, to echo it back in the response.
+ * Clients match the responses of a batch by id, so every response must carry one.
+ * @param request The request.
+ * @return The id, or `null` if the request has none (or one of an invalid type).
+ */
+static json requestId(const json& request) {
+  if (!request.is_object()) return nullptr;
+  auto it = request.find("id");
+  if (it == request.end() || !(it->is_string() || it->is_number())) return nullptr;
+  return *it;
+}
+
+/**
+ * Build the response for a request that failed with an internal error.
+ * @param what The error description.
+ * @param id The id of the request (see requestId()).
+ * @return The response object.
+ */
+static json internalError(const std::string& what, const json& id = nullptr) {
+  json error;
+  error["jsonrpc"] = "2.0";
+  error["id"] = id;
+  error["error"]["code"] = -32603;
+  error["error"]["message"] = "Internal error: " + what;
+  return error;
+}
+
+/**
+ * Handle a single JSON-RPC request object.
+ * Blocks and receipts come already serialized from the response cache, and
+ * are spliced into the response as they are.
+ * @param request The request. Different requests can be handled concurrently.
+ * @param state Reference pointer to the blockchain's state.
+ * @param storage Reference pointer to the blockchain's storage.
+ * @param p2p Reference pointer to the P2P connection manager.
+ * @param options Reference pointer to the options singleton.
+ * @param filters Reference pointer to the filter registry.
+ * @param cache Reference pointer to the response cache.
+ * @return The serialized response.
+ */
+static std::string handleJsonRpcRequest(
+  json& request,
   State& state,
   const Storage& storage,
   P2P::ManagerNormal& p2p,
-  const Options& options
+  const Options& options,
+  Filters& filters,
+  ResponseCache& cache
 ) {
   json ret;
-  uint64_t id = 0;
+  ResponseCache::Entry cached; // Serialized result, if it came from the cache
+  const auto start = std::chrono::steady_clock::now();
+  const RpcMethodMetrics* metrics = &rpcMethodMetrics(JsonRPC::Methods::invalid);
   try {
-    json request = json::parse(body);
     if (!JsonRPC::Decoding::checkJsonRPCSpec(request)) {
+      ret["jsonrpc"] = "2.0";
+      ret["id"] = requestId(request);
       ret["error"]["code"] = -32600;
       ret["error"]["message"] = "Invalid request - does not conform to JSON-RPC 2.0 spec";
+      recordRpcRequest(*metrics, start, false);
       return ret.dump();
     }
 
     auto RequestMethod = JsonRPC::Decoding::getMethod(request);
+    metrics = &rpcMethodMetrics(RequestMethod);
     switch (RequestMethod) {
       case JsonRPC::Methods::invalid:
-        Utils::safePrint("INVALID METHOD: " + request["method"].get<std::string>());
+        LOGDEBUG(Log::httpServer, "Invalid method: " + request["method"].get<std::string>());
         ret["error"]["code"] = -32601;
         ret["error"]["message"] = "Method not found";
         break;
@@ -54,16 +194,16 @@ std::string parseJsonRpcRequest(
         JsonRPC::Decoding::eth_protocolVersion(request);
         ret = JsonRPC::Encoding::eth_protocolVersion(options);
         break;
-      case JsonRPC::Methods::eth_getBlockByHash:
-        ret = JsonRPC::Encoding::eth_getBlockByHash(
-          JsonRPC::Decoding::eth_getBlockByHash(request), storage
-        );
+      case JsonRPC::Methods::eth_getBlockByHash: {
+        const auto [blockHash, includeTxs] = JsonRPC::Decoding::eth_getBlockByHash(request);
+        cached = cache.getBlock(storage.getBlock(blockHash), includeTxs);
         break;
-      case JsonRPC::Methods::eth_getBlockByNumber:
-        ret = JsonRPC::Encoding::eth_getBlockByNumber(
-          JsonRPC::Decoding::eth_getBlockByNumber(request, storage), storage
-        );
+      }
+      case JsonRPC::Methods::eth_getBlockByNumber: {
+        const auto [blockNumber, includeTxs] = JsonRPC::Decoding::eth_getBlockByNumber(request, storage);
+        cached = cache.getBlock(storage.getBlock(blockNumber), includeTxs);
         break;
+      }
       case JsonRPC::Methods::eth_getBlockTransactionCountByHash:
         ret = JsonRPC::Encoding::eth_getBlockTransactionCountByHash(
           JsonRPC::Decoding::eth_getBlockTransactionCountByHash(request), storage
@@ -110,6 +250,28 @@ std::string parseJsonRpcRequest(
           JsonRPC::Decoding::eth_getLogs(request, storage), state
         );
         break;
+      case JsonRPC::Methods::eth_newFilter:
+        ret = JsonRPC::Encoding::eth_newFilter(
+          JsonRPC::Decoding::eth_newFilter(request, storage), filters
+        );
+        break;
+      case JsonRPC::Methods::eth_newBlockFilter:
+        JsonRPC::Decoding::eth_newBlockFilter(request);
+        ret = JsonRPC::Encoding::eth_newBlockFilter(filters);
+        break;
+      case JsonRPC::Methods::eth_newPendingTransactionFilter:
+        JsonRPC::Decoding::eth_newPendingTransactionFilter(request);
+        ret = JsonRPC::Encoding::eth_newPendingTransactionFilter(filters);
+        break;
+      case JsonRPC::Methods::eth_uninstallFilter:
+        ret = JsonRPC::Encoding::eth_uninstallFilter(JsonRPC::Decoding::filterId(request), filters);
+        break;
+      case JsonRPC::Methods::eth_getFilterChanges:
+        ret = JsonRPC::Encoding::eth_getFilterChanges(JsonRPC::Decoding::filterId(request), filters);
+        break;
+      case JsonRPC::Methods::eth_getFilterLogs:
+        ret = JsonRPC::Encoding::eth_getFilterLogs(JsonRPC::Decoding::filterId(request), filters);
+        break;
       case JsonRPC::Methods::eth_getBalance:
         ret = JsonRPC::Encoding::eth_getBalance(
           JsonRPC::Decoding::eth_getBalance(request, storage), state
@@ -149,33 +311,135 @@ std::string parseJsonRpcRequest(
         );
         break;
       case JsonRPC::Methods::eth_getTransactionReceipt:
-        ret = JsonRPC::Encoding::eth_getTransactionReceipt(
-          JsonRPC::Decoding::eth_getTransactionReceipt(request), storage, state
-        );
+        cached = cache.getReceipt(JsonRPC::Decoding::eth_getTransactionReceipt(request));
         break;
       default:
         ret["error"]["code"] = -32601;
         ret["error"]["message"] = "Method not found";
         break;
     }
-    if (request["id"].is_string()) {
-      ret["id"] = request["id"].get<std::string>();
-    } else if (request["id"].is_number()) {
-      ret["id"] = request["id"].get<uint64_t>();
-    } else if(request["id"].is_null()) {
-      ret["id"] = nullptr;
-    } else {
+    if (!request["id"].is_string() && !request["id"].is_number() && !request["id"].is_null()) {
       throw DynamicException("Invalid id type");
     }
+    if (!ret.contains("jsonrpc")) ret["jsonrpc"] = "2.0"; // Errors don't come from the encoders
+    ret["id"] = requestId(request);
   } catch (std::exception &e) {
+    recordRpcRequest(*metrics, start, true);
+    return internalError(e.what(), requestId(request)).dump();
+  }
+  recordRpcRequest(*metrics, start, false);
+  if (cached != nullptr) {
+    return R"({"jsonrpc":"2.0","result":)" + *cached + R"(,"id":)" + ret["id"].dump() + "}";
+  }
+  return ret.dump();
+}
+
+/// Get the workers that answer the read-only requests of batches.
+static BS::thread_pool_light& rpcBatchPool() {
+  static BS::thread_pool_light pool(std::thread::hardware_concurrency());
+  return pool;
+}
+
+/**
+ * Handle a JSON-RPC batch request.
+ * Read-only requests are spread over rpcBatchPool(), while the ones in
+ * JsonRPC::orderedMethods wait for everything before them and run alone, so
+ * a batch that sends a transaction and then queries it sees its own effects.
+ * @param batch The requests.
+ * @param state Reference pointer to the blockchain's state.
+ * @param storage Reference pointer to the blockchain's storage.
+ * @param p2p Reference pointer to the P2P connection manager.
+ * @param options Reference pointer to the options singleton.
+ * @param filters Reference pointer to the filter registry.
+ * @param cache Reference pointer to the response cache.
+ * @return The serialized responses, in the same order as the requests.
+ */
+static std::string handleJsonRpcBatch(
+  json& batch,
+  State& state,
+  const Storage& storage,
+  P2P::ManagerNormal& p2p,
+  const Options& options,
+  Filters& filters,
+  ResponseCache& cache
+) {
+  static Metrics::Histogram& batchSeconds = Metrics::histogram(
+    "orbiter_rpc_batch_seconds", "Time spent handling a JSON-RPC batch request."
+  );
+  static Metrics::Histogram& batchSizes = Metrics::histogram(
+    "orbiter_rpc_batch_size", "Number of requests in a JSON-RPC batch request.", "",
+    {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000}
+  );
+  static Metrics::Counter& batchesRejected = Metrics::counter(
+    "orbiter_rpc_batch_rejected_total", "JSON-RPC batch requests rejected for being empty or too large."
+  );
+  if (batch.empty() || batch.size() > options.getRpcMaxBatchSize()) {
+    batchesRejected.inc();
     json error;
-    error["id"] = id;
-    error["jsonrpc"] = 2.0;
-    error["error"]["code"] = -32603;
-    error["error"]["message"] = "Internal error: " + std::string(e.what());
+    error["jsonrpc"] = "2.0";
+    error["id"] = nullptr;
+    error["error"]["code"] = -32600;
+    error["error"]["message"] = batch.empty() ? "Invalid request - empty batch"
+      : "Invalid request - batch is larger than " + std::to_string(options.getRpcMaxBatchSize()) + " requests";
     return error.dump();
   }
-  // Set back to the original id
-  return ret.dump();
+  Metrics::Timer timer(batchSeconds);
+  batchSizes.observe(double(batch.size()));
+
+  std::vector<std::string> responses(batch.size());
+  auto handle = [&](size_t i) {
+    responses[i] = handleJsonRpcRequest(batch[i], state, storage, p2p, options, filters, cache);
+  };
+  auto isOrdered = [](const json& request) {
+    if (!request.is_object() || !request.contains("method") || !request["method"].is_string()) return false;
+    auto it = JsonRPC::methodsLookupTable.find(request["method"].get<std::string>());
+    return it != JsonRPC::methodsLookupTable.end() && JsonRPC::orderedMethods.contains(it->second);
+  };
+  if (batch.size() == 1) {
+    handle(0);
+  } else {
+    std::vector<std::future<void>> running;
+    // Every task references `responses`, so they must all be done before anything can throw
+    auto waitRunning = [&running]() {
+      for (auto& f : running) f.wait();
+      for (auto& f : running) f.get();
+      running.clear();
+    };
+    for (size_t i = 0; i < batch.size(); i++) {
+      if (isOrdered(batch[i])) {
+        waitRunning();
+        handle(i);
+      } else {
+        running.emplace_back(rpcBatchPool().submit(handle, i));
+      }
+    }
+    waitRunning();
+  }
+  std::string ret = "[";
+  for (size_t i = 0; i < responses.size(); i++) {
+    if (i > 0) ret += ",";
+    ret += responses[i];
+  }
+  return ret + "]";
+}
+
+std::string parseJsonRpcRequest(
+  const std::string& body,
+  State& state,
+  const Storage& storage,
+  P2P::ManagerNormal& p2p,
+  const Options& options,
+  Filters& filters,
+  ResponseCache& cache
+) {
+  json request;
+  try {
+    request = json::parse(body);
+  } catch (std::exception &e) {
+    recordRpcRequest(rpcMethodMetrics(JsonRPC::Methods::invalid), std::chrono::steady_clock::now(), true);
+    return internalError(e.what()).dump();
+  }
+  if (request.is_array()) return handleJsonRpcBatch(request, state, storage, p2p, options, filters, cache);
+  return handleJsonRpcRequest(request, state, storage, p2p, options, filters, cache);
 }
 
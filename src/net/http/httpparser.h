@@ -58,6 +58,8 @@ using tcp = boost::asio::ip::tcp;       // from <boost/asio/ip/tcp.hpp>
 // The parser functions never access any of these members, only passes them around.
 class State;
 class Storage;
+class Filters;
+class ResponseCache;
 namespace P2P { class ManagerNormal; }
 
 /**
@@ -67,6 +69,8 @@ namespace P2P { class ManagerNormal; }
  * @param storage Reference pointer to the blockchain's storage.
  * @param p2p Reference pointer to the P2P connection manager.
  * @param options Reference pointer to the options singleton.
+ * @param filters Reference pointer to the filter registry.
+ * @param cache Reference pointer to the response cache.
  * @return The response string.
  */
 std::string parseJsonRpcRequest(
@@ -74,9 +78,20 @@ std::string parseJsonRpcRequest(
   State& state,
   const Storage& storage,
   P2P::ManagerNormal& p2p,
-  const Options& options
+  const Options& options,
+  Filters& filters,
+  ResponseCache& cache
 );
 
+/**
+ * Serialize every metric for the `/metrics` path, in the Prometheus text format.
+ * @param state Reference pointer to the blockchain's state.
+ * @param storage Reference pointer to the blockchain's storage.
+ * @param p2p Reference pointer to the P2P connection manager.
+ * @return The metrics.
+ */
+std::string serveMetrics(const State& state, const Storage& storage, const P2P::ManagerNormal& p2p);
+
 /**
  * Produce an HTTP response for a given request.
  * The type of the response object depends on the contents of the request,
@@ -88,12 +103,14 @@ std::string parseJsonRpcRequest(
  * @param storage Reference pointer to the blockchain's storage.
  * @param p2p Reference pointer to the P2P connection manager.
  * @param options Reference pointer to the options singleton.
+ * @param filters Reference pointer to the filter registry.
+ * @param cache Reference pointer to the response cache.
  */
 template<class Body, class Allocator, class Send> void handle_request(
   [[maybe_unused]] beast::string_view docroot,
   http::request<Body, http::basic_fields<Allocator>>&& req,
   Send&& send, State& state, const Storage& storage,
-  P2P::ManagerNormal& p2p, const Options& options
+  P2P::ManagerNormal& p2p, const Options& options, Filters& filters, ResponseCache& cache
 ) {
   // Returns a bad request response
   const auto bad_request = [&req](beast::string_view why){
@@ -128,6 +145,17 @@ template<class Body, class Allocator, class Send> void handle_request(
     return res;
   };
 
+  // Metrics for Prometheus-style scrapers, the only thing served over GET
+  if (req.method() == http::verb::get && req.target() == "/metrics") {
+    http::response<http::string_body> res{http::status::ok, req.version()};
+    res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    res.set(http::field::content_type, "text/plain; version=0.0.4");
+    res.keep_alive(req.keep_alive());
+    res.body() = serveMetrics(state, storage, p2p);
+    res.prepare_payload();
+    return send(std::move(res));
+  }
+
   // Make sure we can handle the method
   if (req.method() != http::verb::post && req.method() != http::verb::options)
     return send(bad_request("Unknown HTTP-method"));
@@ -150,10 +178,10 @@ template<class Body, class Allocator, class Send> void handle_request(
     res.keep_alive(req.keep_alive());
     return send(std::move(res));
   }
-  Utils::safePrint("HTTP Request: " + req.body());
+  LOGDEBUG(Log::httpServer, "HTTP Request: " + req.body());
   std::string request = req.body();
   std::string answer = parseJsonRpcRequest(
-    request, state, storage, p2p, options
+    request, state, storage, p2p, options, filters, cache
   );
 
   http::response<http::string_body> res{http::status::ok, req.version()};
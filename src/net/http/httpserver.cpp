@@ -13,7 +13,8 @@ bool HTTPServer::run() {
   auto docroot = std::make_shared<const std::string>(".");
   this->listener_ = std::make_shared<HTTPListener>(
     this->ioc_, tcp::endpoint{address, this->port_}, docroot, this->state_,
-    this->storage_, this->p2p_, this->options_
+    this->storage_, this->p2p_, this->options_, this->filters_,
+    this->cache_, this->subscriptions_
   );
   this->listener_->start();
 
@@ -21,31 +22,35 @@ bool HTTPServer::run() {
   std::vector<std::thread> v;
   v.reserve(4 - 1);
   for (int i = 4 - 1; i > 0; i--) v.emplace_back([&]{ this->ioc_.run(); });
-  Logger::logToDebug(LogType::INFO, Log::httpServer, __func__,
+  LOGINFO(Log::httpServer,
     std::string("HTTP Server Started at port: ") + std::to_string(port_)
   );
   this->ioc_.run();
 
   // If we get here, it means we got a SIGINT or SIGTERM. Block until all the threads exit
   for (std::thread& t : v) t.join();
-  Logger::logToDebug(LogType::INFO, Log::httpServer, __func__, "HTTP Server Stopped");
+  LOGINFO(Log::httpServer, "HTTP Server Stopped");
   return true;
 }
 
 void HTTPServer::start() {
   if (this->runFuture_.valid()) {
-    Logger::logToDebug(LogType::ERROR, Log::httpServer, __func__, "HTTP Server is already running");
+    LOGERROR(Log::httpServer, "HTTP Server is already running");
     return;
   }
+  this->cache_.start();
+  this->subscriptions_.start();
   this->runFuture_ = std::async(std::launch::async, &HTTPServer::run, this);
 }
 
 void HTTPServer::stop() {
   if (!this->runFuture_.valid()) {
-    Logger::logToDebug(LogType::ERROR, Log::httpServer, __func__, "HTTP Server is not running");
+    LOGERROR(Log::httpServer, "HTTP Server is not running");
     return;
   }
   this->ioc_.stop();
   this->runFuture_.get();
+  this->subscriptions_.stop();
+  this->cache_.stop();
 }
 
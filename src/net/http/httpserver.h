@@ -10,6 +10,9 @@ See the LICENSE.txt file in the project root for more information.
 
 #include "httpparser.h"
 #include "httplistener.h"
+#include "filters.h"
+#include "responsecache.h"
+#include "subscriptions.h"
 
 /// Abstraction of an HTTP server.
 class HTTPServer {
@@ -26,6 +29,15 @@ class HTTPServer {
     /// Reference pointer to the options singleton.
     const Options& options_;
 
+    /// Filters installed with eth_newFilter and friends.
+    Filters filters_;
+
+    /// Serialized blocks and receipts, shared by every session.
+    ResponseCache cache_;
+
+    /// eth_subscribe subscriptions of the WebSocket sessions (outlives every session).
+    Subscriptions subscriptions_;
+
     /// Provides core I/O functionality ({x} = max threads the object can use).
     net::io_context ioc_{4};
 
@@ -52,7 +64,9 @@ class HTTPServer {
     HTTPServer(
       State& state, const Storage& storage,
       P2P::ManagerNormal& p2p, const Options& options
-    ) : state_(state), storage_(storage), p2p_(p2p), options_(options), port_(options.getHttpPort())
+    ) : state_(state), storage_(storage), p2p_(p2p), options_(options),
+      filters_(state, storage, options), cache_(state, storage), subscriptions_(state, storage),
+      port_(options.getHttpPort())
     {}
 
     /**
@@ -64,6 +78,15 @@ class HTTPServer {
     void start(); ///< Start the server.
     void stop(); ///< Stop the server.
 
+    /// Get the filters installed with eth_newFilter and friends.
+    const Filters& getFilters() const { return this->filters_; }
+
+    /// Get the cache of serialized blocks and receipts.
+    const ResponseCache& getResponseCache() const { return this->cache_; }
+
+    /// Get the eth_subscribe subscriptions of the WebSocket sessions.
+    const Subscriptions& getSubscriptions() const { return this->subscriptions_; }
+
     /**
      * Check if the server is currently active and running.
      * @return `true` if the server is running, `false` otherwise.
@@ -6,6 +6,7 @@ See the LICENSE.txt file in the project root for more information.
 */
 
 #include "httpsession.h"
+#include "websocketsession.h"
 
 HTTPQueue::HTTPQueue(HTTPSession& session) : session_(session) {
   assert(this->limit_ > 0);
@@ -59,10 +60,18 @@ void HTTPSession::on_read(beast::error_code ec, std::size_t bytes) {
   // This means the other side closed the connection
   if (ec == http::error::end_of_stream) return this->do_close();
   if (ec) return fail("HTTPSession", __func__, ec, "Failed to close connection");
+  // WebSocket clients (eth_subscribe) upgrade on the same port, the connection is theirs from now on
+  if (websocket::is_upgrade(this->parser_->get())) {
+    std::make_shared<WebsocketSession>(
+      this->stream_.release_socket(), this->state_, this->storage_, this->p2p_,
+      this->options_, this->filters_, this->cache_, this->subscriptions_
+    )->start(this->parser_->release());
+    return;
+  }
   // Send the response
   handle_request(
     *this->docroot_, this->parser_->release(), this->queue_, this->state_,
-    this->storage_, this->p2p_, this->options_
+    this->storage_, this->p2p_, this->options_, this->filters_, this->cache_
   );
   // If queue still has free space, try to pipeline another request
   if (!this->queue_.full()) this->do_read();
@@ -13,6 +13,8 @@ See the LICENSE.txt file in the project root for more information.
 // Forward declarations.
 class HTTPSession;  // HTTPQueue depends on HTTPSession and vice-versa
 class State;
+class Filters;
+class Subscriptions;
 class Storage;
 namespace P2P { class ManagerNormal; }
 
@@ -92,12 +94,22 @@ class HTTPSession : public std::enable_shared_from_this<HTTPSession> {
     /// Reference pointer to the options singleton.
     const Options& options_;
 
+    /// Reference pointer to the filter registry.
+    Filters& filters_;
+
+    /// Reference pointer to the response cache.
+    ResponseCache& cache_;
+
+    /// Reference pointer to the subscription registry, for sessions upgraded to WebSocket.
+    Subscriptions& subscriptions_;
+
     /// Read whatever is on the internal buffer.
     void do_read();
 
     /**
      * Callback for do_read().
-     * Tries to pipeline another request if the queue isn't full.
+     * Hands the connection over to a WebsocketSession if the request is an upgrade,
+     * otherwise tries to pipeline another request if the queue isn't full.
      * @param ec The error code to parse.
      * @param bytes The number of read bytes.
      */
@@ -124,15 +136,22 @@ class HTTPSession : public std::enable_shared_from_this<HTTPSession> {
      * @param storage Reference pointer to the blockchain's storage.
      * @param p2p Reference pointer to the P2P connection manager.
      * @param options Reference pointer to the options singleton.
+     * @param filters Reference pointer to the filter registry.
+     * @param cache Reference pointer to the response cache.
+     * @param subscriptions Reference pointer to the subscription registry.
      */
     HTTPSession(tcp::socket&& sock,
       const std::shared_ptr<const std::string>& docroot,
       State& state,
       const Storage& storage,
       P2P::ManagerNormal& p2p,
-      const Options& options
+      const Options& options,
+      Filters& filters,
+      ResponseCache& cache,
+      Subscriptions& subscriptions
     ) : stream_(std::move(sock)), docroot_(docroot), queue_(*this), state_(state),
-      storage_(storage), p2p_(p2p), options_(options)
+      storage_(storage), p2p_(p2p), options_(options), filters_(filters), cache_(cache),
+      subscriptions_(subscriptions)
     {
       stream_.expires_never();
     }
@@ -26,7 +26,7 @@ namespace JsonRPC::Decoding {
 
       return true;
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while checking json RPC spec: ") + e.what()
       );
       throw DynamicException("Error while checking json RPC spec: " + std::string(e.what()));
@@ -40,7 +40,7 @@ namespace JsonRPC::Decoding {
       if (it == methodsLookupTable.end()) return Methods::invalid;
       return it->second;
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while getting method: ") + e.what()
       );
       throw DynamicException("Error while checking json RPC spec: " + std::string(e.what()));
@@ -54,7 +54,7 @@ namespace JsonRPC::Decoding {
         "web3_clientVersion does not need params"
       );
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding web3_clientVersion: ") + e.what()
       );
       throw DynamicException(
@@ -73,7 +73,7 @@ namespace JsonRPC::Decoding {
       if (!Hex::isValid(data, true)) throw DynamicException("Invalid hex string");
       return Hex::toBytes(data);
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding web3_sha3: ") + e.what()
       );
       throw DynamicException("Error while decoding web3_sha3: " + std::string(e.what()));
@@ -87,7 +87,7 @@ namespace JsonRPC::Decoding {
         "net_version does not need params"
       );
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding net_version: ") + e.what()
       );
       throw DynamicException("Error while decoding net_version: " + std::string(e.what()));
@@ -101,7 +101,7 @@ namespace JsonRPC::Decoding {
         "net_listening does not need params"
       );
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding net_listening: ") + e.what()
       );
       throw DynamicException("Error while decoding net_listening: " + std::string(e.what()));
@@ -115,7 +115,7 @@ namespace JsonRPC::Decoding {
         "net_peerCount does not need params"
       );
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding net_peerCount: ") + e.what()
       );
       throw DynamicException("Error while decoding net_peerCount: " + std::string(e.what()));
@@ -129,7 +129,7 @@ namespace JsonRPC::Decoding {
         "eth_protocolVersion does not need params"
       );
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding eth_protocolVersion: ") + e.what()
       );
       throw DynamicException("Error while decoding eth_protocolVersion: " + std::string(e.what()));
@@ -144,7 +144,7 @@ namespace JsonRPC::Decoding {
       if (!std::regex_match(blockHash, hashFilter)) throw DynamicException("Invalid block hash hex");
       return std::make_pair(Hash(Hex::toBytes(blockHash)), includeTxs);
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding eth_getBlockByHash: ") + e.what()
       );
       throw DynamicException("Error while decoding eth_getBlockByHash: " + std::string(e.what()));
@@ -165,7 +165,7 @@ namespace JsonRPC::Decoding {
       if (!std::regex_match(blockNum, numFilter)) throw DynamicException("Invalid block hash hex");
       return std::make_pair(uint64_t(Hex(blockNum).getUint()), includeTxs);
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding eth_getBlockByNumber: ") + e.what()
       );
       throw DynamicException("Error while decoding eth_getBlockByNumber: " + std::string(e.what()));
@@ -180,7 +180,7 @@ namespace JsonRPC::Decoding {
       if (!std::regex_match(blockHash, hashFilter)) throw DynamicException("Invalid block hash hex");
       return Hash(Hex::toBytes(blockHash));
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding eth_getBlockTransactionCountByHash: ") + e.what()
       );
       throw DynamicException(
@@ -200,7 +200,7 @@ namespace JsonRPC::Decoding {
       if (!std::regex_match(blockNum, numFilter)) throw DynamicException("Invalid block hash hex");
       return uint64_t(Hex(blockNum).getUint());
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding eth_getBlockTransactionCountByNumber: ") + e.what()
       );
       throw DynamicException(
@@ -214,7 +214,7 @@ namespace JsonRPC::Decoding {
       // No params are needed.
       if (!request["params"].empty()) throw DynamicException("eth_chainId does not need params");
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__, std::string("Error while decoding eth_chainId: ") + e.what());
+      LOGERROR(Log::JsonRPCDecoding, std::string("Error while decoding eth_chainId: ") + e.what());
       throw DynamicException("Error while decoding eth_chainId: " + std::string(e.what()));
     }
   }
@@ -224,7 +224,7 @@ namespace JsonRPC::Decoding {
       // No params are needed.
       if (!request["params"].empty()) throw DynamicException("eth_syncing does not need params");
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding eth_syncing: ") + e.what()
       );
       throw DynamicException("Error while decoding eth_syncing: " + std::string(e.what()));
@@ -236,7 +236,7 @@ namespace JsonRPC::Decoding {
       // No params are needed.
       if (!request["params"].empty()) throw DynamicException("eth_coinbase does not need params");
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding eth_coinbase: ") + e.what()
       );
       throw DynamicException("Error while decoding eth_coinbase: " + std::string(e.what()));
@@ -249,7 +249,7 @@ namespace JsonRPC::Decoding {
       if (!request["params"].empty()) throw DynamicException("eth_blockNumber does not need params");
       return;
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding eth_blockNumber: ") + e.what()
       );
       throw DynamicException("Error while decoding eth_blockNumber: " + std::string(e.what()));
@@ -321,7 +321,7 @@ namespace JsonRPC::Decoding {
       }
       return result;
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding eth_call: ") + e.what()
       );
       throw DynamicException("Error while decoding eth_call: " + std::string(e.what()));
@@ -398,7 +398,7 @@ namespace JsonRPC::Decoding {
       }
       return result;
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding eth_estimateGas: ") + e.what()
       );
       throw DynamicException("Error while decoding eth_estimateGas: " + std::string(e.what()));
@@ -409,7 +409,7 @@ namespace JsonRPC::Decoding {
     try {
       if (!request["params"].empty()) throw DynamicException("eth_gasPrice does not need params");
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding eth_gasPrice: ") + e.what()
       );
       throw DynamicException("Error while decoding eth_gasPrice: " + std::string(e.what()));
@@ -484,13 +484,103 @@ namespace JsonRPC::Decoding {
 
       return std::make_tuple(fromBlock, toBlock, address, topics);
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding eth_getLogs: ") + e.what()
       );
       throw DynamicException("Error while decoding eth_getLogs: " + std::string(e.what()));
     }
   }
 
+  std::tuple<std::optional<uint64_t>, std::optional<uint64_t>, Address, std::vector<Hash>> eth_newFilter(
+    const json& request, const Storage& storage
+  ) {
+    static const std::regex addFilter("^0x[0-9,a-f,A-F]{40}$");
+    static const std::regex numFilter("^0x([1-9a-f]+[0-9a-f]*|0)$");
+    static const std::regex hashFilter("^0x[0-9a-f]{64}$");
+    try {
+      std::optional<uint64_t> fromBlock; // Next block by default
+      std::optional<uint64_t> toBlock; // Follow the chain by default
+      auto address = Address();  // Empty by default
+      std::vector<Hash> topics = {}; // Empty by default
+      json filterObject = request["params"].at(0);
+
+      // Empty for "latest"
+      auto parseBlock = [](const std::string& blockHex) -> std::optional<uint64_t> {
+        if (blockHex == "latest") return std::nullopt;
+        if (blockHex == "earliest") return 0;
+        if (blockHex == "pending") throw DynamicException("Pending block is not supported");
+        if (std::regex_match(blockHex, numFilter)) return uint64_t(Hex(blockHex).getUint());
+        throw DynamicException("Invalid block hex");
+      };
+      if (filterObject.contains("fromBlock")) {
+        fromBlock = parseBlock(filterObject["fromBlock"].get<std::string>()).value_or(storage.latest()->getNHeight());
+      }
+      if (filterObject.contains("toBlock")) toBlock = parseBlock(filterObject["toBlock"].get<std::string>());
+
+      if (filterObject.contains("address")) {
+        std::string addressHex = filterObject["address"].get<std::string>();
+        if (!std::regex_match(addressHex, addFilter)) throw DynamicException("Invalid address hex");
+        address = Address(Hex::toBytes(addressHex));
+      }
+
+      if (filterObject.contains("topics")) {
+        if (!filterObject.at("topics").is_array()) {
+          throw DynamicException("topics is not an array");
+        }
+        auto topicsArray = filterObject.at("topics").get<std::vector<std::string>>();
+        for (const auto& topic : topicsArray) {
+          if (!std::regex_match(topic, hashFilter)) throw DynamicException("Invalid topic hex");
+          topics.emplace_back(Hex::toBytes(topic));
+        }
+      }
+
+      return std::make_tuple(fromBlock, toBlock, address, topics);
+    } catch (std::exception& e) {
+      LOGERROR(Log::JsonRPCDecoding,
+        std::string("Error while decoding eth_newFilter: ") + e.what()
+      );
+      throw DynamicException("Error while decoding eth_newFilter: " + std::string(e.what()));
+    }
+  }
+
+  void eth_newBlockFilter(const json& request) {
+    try {
+      // No params are needed.
+      if (!request["params"].empty()) throw DynamicException("eth_newBlockFilter does not need params");
+    } catch (std::exception& e) {
+      LOGERROR(Log::JsonRPCDecoding,
+        std::string("Error while decoding eth_newBlockFilter: ") + e.what()
+      );
+      throw DynamicException("Error while decoding eth_newBlockFilter: " + std::string(e.what()));
+    }
+  }
+
+  void eth_newPendingTransactionFilter(const json& request) {
+    try {
+      // No params are needed.
+      if (!request["params"].empty()) throw DynamicException("eth_newPendingTransactionFilter does not need params");
+    } catch (std::exception& e) {
+      LOGERROR(Log::JsonRPCDecoding,
+        std::string("Error while decoding eth_newPendingTransactionFilter: ") + e.what()
+      );
+      throw DynamicException("Error while decoding eth_newPendingTransactionFilter: " + std::string(e.what()));
+    }
+  }
+
+  std::string filterId(const json& request) {
+    static const std::regex idFilter("^0x[0-9a-f]+$");
+    try {
+      std::string id = request["params"].at(0).get<std::string>();
+      if (!std::regex_match(id, idFilter)) throw DynamicException("Invalid filter ID: " + id);
+      return id;
+    } catch (std::exception& e) {
+      LOGERROR(Log::JsonRPCDecoding,
+        std::string("Error while decoding filter ID: ") + e.what()
+      );
+      throw DynamicException("Error while decoding filter ID: " + std::string(e.what()));
+    }
+  }
+
   Address eth_getBalance(const json& request, const Storage& storage) {
     static const std::regex addFilter("^0x[0-9,a-f,A-F]{40}$");
     static const std::regex numFilter("^0x([1-9a-f]+[0-9a-f]*|0)$");
@@ -505,7 +595,7 @@ namespace JsonRPC::Decoding {
       if (!std::regex_match(address, addFilter)) throw DynamicException("Invalid address hex");
       return Address(Hex::toBytes(address));
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding eth_getBalance: ") + e.what()
       );
       throw DynamicException("Error while decoding eth_getBalance: " + std::string(e.what()));
@@ -526,7 +616,7 @@ namespace JsonRPC::Decoding {
       if (!std::regex_match(address, addFilter)) throw DynamicException("Invalid address hex");
       return Address(Hex::toBytes(address));
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding eth_getTransactionCount: ") + e.what()
       );
       throw DynamicException("Error while decoding eth_getTransactionCount: " + std::string(e.what()));
@@ -547,7 +637,7 @@ namespace JsonRPC::Decoding {
       if (!std::regex_match(address, addFilter)) throw DynamicException("Invalid address hex");
       return Address(Hex::toBytes(address));
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding eth_getCode: ") + e.what()
       );
       throw DynamicException("Error while decoding eth_getCode: " + std::string(e.what()));
@@ -560,7 +650,7 @@ namespace JsonRPC::Decoding {
       if (!Hex::isValid(txHex, true)) throw DynamicException("Invalid transaction hex");
       return TxBlock(Hex::toBytes(txHex), requiredChainId);
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding eth_sendRawTransaction: ") + e.what()
       );
       throw DynamicException("Error while decoding eth_sendRawTransaction: " + std::string(e.what()));
@@ -574,7 +664,7 @@ namespace JsonRPC::Decoding {
       if (!std::regex_match(hash, hashFilter)) throw DynamicException("Invalid hash hex");
       return Hash(Hex::toBytes(hash));
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding eth_getTransactionByHash: ") + e.what()
       );
       throw DynamicException("Error while decoding eth_getTransactionByHash: " + std::string(e.what()));
@@ -591,7 +681,7 @@ namespace JsonRPC::Decoding {
       if (!std::regex_match(index, numFilter)) throw DynamicException("Invalid index hex");
       return std::make_pair(Hash(Hex::toBytes(blockHash)), uint64_t(Hex(index).getUint()));
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding eth_getTransactionByBlockHashAndIndex: ") + e.what()
       );
       throw DynamicException(
@@ -616,7 +706,7 @@ namespace JsonRPC::Decoding {
         uint64_t(Hex(blockNum).getUint()), uint64_t(Hex(index).getUint())
       );
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding eth_getTransactionByBlockNumberAndIndex: ") + e.what()
       );
       throw DynamicException(
@@ -632,7 +722,7 @@ namespace JsonRPC::Decoding {
       if (!std::regex_match(txHash, hashFilter)) throw DynamicException("Invalid Hex: " + txHash);
       return Hash(Hex::toBytes(txHash));
     } catch (std::exception& e) {
-      Logger::logToDebug(LogType::ERROR, Log::JsonRPCDecoding, __func__,
+      LOGERROR(Log::JsonRPCDecoding,
         std::string("Error while decoding eth_getTransactionReceipt: ") + e.what()
       );
       throw DynamicException(
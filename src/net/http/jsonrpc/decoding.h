@@ -168,6 +168,37 @@ namespace JsonRPC::Decoding {
     const json& request, const Storage& storage
   );
 
+  /**
+   * Parse an `eth_newFilter` call's parameters.
+   * Same as `eth_getLogs`, except that a missing `fromBlock` means "from the next block"
+   * and a missing (or "latest") `toBlock` means "follow the chain".
+   * @param request The request object.
+   * @param storage Reference pointer to the blockchain's storage.
+   * @return A tuple with starting and ending block height (if any), address and a list of topics.
+   */
+  std::tuple<std::optional<uint64_t>, std::optional<uint64_t>, Address, std::vector<Hash>> eth_newFilter(
+    const json& request, const Storage& storage
+  );
+
+  /**
+   * Check if `eth_newBlockFilter` is valid.
+   * @param request The request object.
+   */
+  void eth_newBlockFilter(const json& request);
+
+  /**
+   * Check if `eth_newPendingTransactionFilter` is valid.
+   * @param request The request object.
+   */
+  void eth_newPendingTransactionFilter(const json& request);
+
+  /**
+   * Parse the filter ID of an `eth_uninstallFilter`, `eth_getFilterChanges` or `eth_getFilterLogs` call.
+   * @param request The request object.
+   * @return The filter ID.
+   */
+  std::string filterId(const json& request);
+
   /**
    * Parse an `eth_getBalance` address and check if it is valid.
    * @param request The request object.
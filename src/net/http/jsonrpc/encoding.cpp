@@ -9,6 +9,7 @@ See the LICENSE.txt file in the project root for more information.
 
 #include "../../../core/storage.h"
 #include "../../../core/state.h"
+#include "../filters.h"
 
 namespace JsonRPC::Encoding {
   json getBlockJson(const std::shared_ptr<const Block>& block, bool includeTransactions) {
@@ -196,7 +197,6 @@ namespace JsonRPC::Encoding {
       ret["error"]["code"] = -32000;
       ret["error"]["message"] = "Internal error: " + std::string(e.what());
     }
-    Utils::safePrint("Estimate gas encoding returning!");
     return ret;
   }
 
@@ -225,6 +225,76 @@ namespace JsonRPC::Encoding {
     return ret;
   }
 
+  json eth_newFilter(
+    const std::tuple<std::optional<uint64_t>, std::optional<uint64_t>, Address, std::vector<Hash>>& info,
+    Filters& filters
+  ) {
+    json ret;
+    ret["jsonrpc"] = "2.0";
+    try {
+      ret["result"] = filters.newLogFilter(info);
+    } catch (std::exception& e) {
+      ret["error"]["code"] = -32000;
+      ret["error"]["message"] = "Internal error: " + std::string(e.what());
+    }
+    return ret;
+  }
+
+  json eth_newBlockFilter(Filters& filters) {
+    json ret;
+    ret["jsonrpc"] = "2.0";
+    try {
+      ret["result"] = filters.newBlockFilter();
+    } catch (std::exception& e) {
+      ret["error"]["code"] = -32000;
+      ret["error"]["message"] = "Internal error: " + std::string(e.what());
+    }
+    return ret;
+  }
+
+  json eth_newPendingTransactionFilter(Filters& filters) {
+    json ret;
+    ret["jsonrpc"] = "2.0";
+    try {
+      ret["result"] = filters.newPendingTransactionFilter();
+    } catch (std::exception& e) {
+      ret["error"]["code"] = -32000;
+      ret["error"]["message"] = "Internal error: " + std::string(e.what());
+    }
+    return ret;
+  }
+
+  json eth_uninstallFilter(const std::string& id, Filters& filters) {
+    json ret;
+    ret["jsonrpc"] = "2.0";
+    ret["result"] = filters.uninstall(id);
+    return ret;
+  }
+
+  json eth_getFilterChanges(const std::string& id, Filters& filters) {
+    json ret;
+    ret["jsonrpc"] = "2.0";
+    try {
+      ret["result"] = filters.changes(id);
+    } catch (std::exception& e) {
+      ret["error"]["code"] = -32000;
+      ret["error"]["message"] = "Internal error: " + std::string(e.what());
+    }
+    return ret;
+  }
+
+  json eth_getFilterLogs(const std::string& id, Filters& filters) {
+    json ret;
+    ret["jsonrpc"] = "2.0";
+    try {
+      ret["result"] = filters.logs(id);
+    } catch (std::exception& e) {
+      ret["error"]["code"] = -32000;
+      ret["error"]["message"] = "Internal error: " + std::string(e.what());
+    }
+    return ret;
+  }
+
   json eth_getBalance(const Address& address, const State& state) {
     json ret;
     ret["jsonrpc"] = "2.0";
@@ -247,7 +317,7 @@ namespace JsonRPC::Encoding {
   }
 
   json eth_sendRawTransaction(const TxBlock& tx, State& state, P2P::ManagerNormal& p2p) {
-    Utils::safePrint("eth_sendRawTransaction: " + Hex::fromBytes(tx.rlpSerialize()).get());
+    LOGDEBUG(Log::JsonRPCEncoding, "eth_sendRawTransaction: " + Hex::fromBytes(tx.rlpSerialize()).get());
     json ret;
     ret["jsonrpc"] = "2.0";
     const auto& txHash = tx.hash();
@@ -267,6 +337,9 @@ namespace JsonRPC::Encoding {
         case TxInvalid::InvalidBalance:
           ret["error"]["message"] = "Invalid balance";
           break;
+        case TxInvalid::Underpriced:
+          ret["error"]["message"] = "Transaction underpriced";
+          break;
         case TxInvalid::NotInvalid:
           break;
       }
@@ -18,6 +18,7 @@ See the LICENSE.txt file in the project root for more information.
 namespace P2P { class ManagerNormal; }
 class Storage;
 class State;
+class Filters;
 
 /// Namespace for encoding JSON-RPC data.
 namespace JsonRPC::Encoding {
@@ -177,6 +178,55 @@ namespace JsonRPC::Encoding {
     const State& state
   );
 
+  /**
+   * Encode a `eth_newFilter` response.
+   * @param info A tuple of starting and ending block (if any), address and a list of topics.
+   * @param filters Reference pointer to the filter registry.
+   * @return The encoded JSON response.
+   */
+  json eth_newFilter(
+    const std::tuple<std::optional<uint64_t>, std::optional<uint64_t>, Address, std::vector<Hash>>& info,
+    Filters& filters
+  );
+
+  /**
+   * Encode a `eth_newBlockFilter` response.
+   * @param filters Reference pointer to the filter registry.
+   * @return The encoded JSON response.
+   */
+  json eth_newBlockFilter(Filters& filters);
+
+  /**
+   * Encode a `eth_newPendingTransactionFilter` response.
+   * @param filters Reference pointer to the filter registry.
+   * @return The encoded JSON response.
+   */
+  json eth_newPendingTransactionFilter(Filters& filters);
+
+  /**
+   * Encode a `eth_uninstallFilter` response.
+   * @param id The filter ID.
+   * @param filters Reference pointer to the filter registry.
+   * @return The encoded JSON response.
+   */
+  json eth_uninstallFilter(const std::string& id, Filters& filters);
+
+  /**
+   * Encode a `eth_getFilterChanges` response.
+   * @param id The filter ID.
+   * @param filters Reference pointer to the filter registry.
+   * @return The encoded JSON response.
+   */
+  json eth_getFilterChanges(const std::string& id, Filters& filters);
+
+  /**
+   * Encode a `eth_getFilterLogs` response.
+   * @param id The filter ID.
+   * @param filters Reference pointer to the filter registry.
+   * @return The encoded JSON response.
+   */
+  json eth_getFilterLogs(const std::string& id, Filters& filters);
+
   /**
    * Encode a `eth_getBalance` response.
    * @param address The address to get the balance from.
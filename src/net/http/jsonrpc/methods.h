@@ -9,6 +9,7 @@ See the LICENSE.txt file in the project root for more information.
 #define JSONRPC_METHODS_H
 
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
 
 /**
@@ -53,12 +54,12 @@ namespace JsonRPC {
    * eth_gasPrice ============================== DONE
    * eth_maxPriorityFeePerGas ================== TODO: IMPLEMENT THIS
    * eth_feeHistory ============================ TODO: IMPLEMENT THIS, SEE https://docs.alchemy.com/reference/eth-feehistory
-   * eth_newFilter ============================= NOT IMPLEMENTED: WE DON'T SUPPORT FILTERS (FOR NOW)
-   * eth_newBlockFilter ======================== NOT IMPLEMENTED: WE DON'T SUPPORT FILTERS (FOR NOW)
-   * eth_newPendingTransactionFilter =========== NOT IMPLEMENTED: WE DON'T SUPPORT FILTERS (FOR NOW)
-   * eth_uninstallFilter ======================= NOT IMPLEMENTED: WE DON'T SUPPORT FILTERS (FOR NOW)
-   * eth_getFilterChanges ====================== NOT IMPLEMENTED: WE DON'T SUPPORT FILTERS (FOR NOW)
-   * eth_getFilterLogs ========================= NOT IMPLEMENTED: WE DON'T SUPPORT FILTERS (FOR NOW)
+   * eth_newFilter ============================= DONE
+   * eth_newBlockFilter ======================== DONE
+   * eth_newPendingTransactionFilter =========== DONE
+   * eth_uninstallFilter ======================= DONE
+   * eth_getFilterChanges ====================== DONE
+   * eth_getFilterLogs ========================= DONE
    * eth_getLogs =============================== DONE
    * eth_mining ================================ NOT IMPLEMENTED: WE ARE RDPOS NOT POW
    * eth_hashrate ============================== NOT IMPLEMENTED: WE ARE RDPOS NOT POW
@@ -153,6 +154,12 @@ namespace JsonRPC {
     { "eth_call", eth_call },
     { "eth_estimateGas", eth_estimateGas },
     { "eth_gasPrice", eth_gasPrice },
+    { "eth_newFilter", eth_newFilter },
+    { "eth_newBlockFilter", eth_newBlockFilter },
+    { "eth_newPendingTransactionFilter", eth_newPendingTransactionFilter },
+    { "eth_uninstallFilter", eth_uninstallFilter },
+    { "eth_getFilterChanges", eth_getFilterChanges },
+    { "eth_getFilterLogs", eth_getFilterLogs },
       { "eth_getLogs", eth_getLogs },
     { "eth_getBalance", eth_getBalance },
     { "eth_getTransactionCount", eth_getTransactionCount },
@@ -164,6 +171,21 @@ namespace JsonRPC {
     { "eth_getTransactionByBlockNumberAndIndex", eth_getTransactionByBlockNumberAndIndex },
     { "eth_getTransactionReceipt", eth_getTransactionReceipt }
   };
+
+  /**
+   * Methods that change something on the node (mempool, filters), which run in
+   * the order they appear in a batch request. Every other method only reads, so
+   * the items of a batch between two of these are answered concurrently.
+   */
+  inline extern const std::unordered_set<Methods> orderedMethods = {
+    eth_sendTransaction,
+    eth_sendRawTransaction,
+    eth_newFilter,
+    eth_newBlockFilter,
+    eth_newPendingTransactionFilter,
+    eth_uninstallFilter,
+    eth_getFilterChanges
+  };
 }
 
 #endif // JSONRPC_METHODS_H
@@ -0,0 +1,115 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "responsecache.h"
+#include "jsonrpc/encoding.h"
+#include "../../core/state.h"
+#include "../../utils/metrics.h"
+
+/// Metrics of the cache.
+struct ResponseCacheMetrics {
+  Metrics::Counter& hits;   ///< Results served from the cache.
+  Metrics::Counter& misses; ///< Results serialized on request.
+  Metrics::Gauge& bytes;    ///< Size of the cached results.
+};
+
+/// Get the metrics of the cache.
+static const ResponseCacheMetrics& responseCacheMetrics() {
+  static const ResponseCacheMetrics metrics{
+    Metrics::counter("orbiter_rpc_cache_hits_total", "Block and receipt results served from the response cache."),
+    Metrics::counter("orbiter_rpc_cache_misses_total", "Block and receipt results serialized on request."),
+    Metrics::gauge("orbiter_rpc_cache_bytes", "Size of the serialized results in the response cache.")
+  };
+  return metrics;
+}
+
+const ResponseCache::Entry& ResponseCache::null() {
+  static const Entry entry = std::make_shared<const std::string>("null");
+  return entry;
+}
+
+ResponseCache::Entry ResponseCache::find(const Key& key) {
+  std::lock_guard lock(this->mutex_);
+  Entry* entry = this->cache_.get(key);
+  return (entry != nullptr) ? *entry : nullptr;
+}
+
+void ResponseCache::insert(const Key& key, const Entry& entry) {
+  std::lock_guard lock(this->mutex_);
+  this->cache_.put(key, entry, entry->size());
+  this->cache_.trim();
+  responseCacheMetrics().bytes.set(this->cache_.cost());
+}
+
+ResponseCache::Entry ResponseCache::getBlock(const std::shared_ptr<const Block>& block, bool includeTxs) {
+  if (block == nullptr) return ResponseCache::null();
+  const Key key(block->hash(), includeTxs ? Kind::BlockWithTxs : Kind::Block);
+  if (Entry entry = this->find(key)) { responseCacheMetrics().hits.inc(); return entry; }
+  responseCacheMetrics().misses.inc();
+  json response = JsonRPC::Encoding::getBlockJson(block, includeTxs);
+  if (!response.contains("result")) throw DynamicException(response["error"]["message"].get<std::string>());
+  Entry entry = std::make_shared<const std::string>(response["result"].dump());
+  this->insert(key, entry);
+  return entry;
+}
+
+ResponseCache::Entry ResponseCache::getReceipt(const Hash& txHash) {
+  const Key key(txHash, Kind::Receipt);
+  if (Entry entry = this->find(key)) { responseCacheMetrics().hits.inc(); return entry; }
+  responseCacheMetrics().misses.inc();
+  json response = JsonRPC::Encoding::eth_getTransactionReceipt(txHash, this->storage_, this->state_);
+  if (response["result"].is_null()) return ResponseCache::null(); // Might still make it into a block
+  Entry entry = std::make_shared<const std::string>(response["result"].dump());
+  this->insert(key, entry);
+  return entry;
+}
+
+void ResponseCache::warm(const std::shared_ptr<const Block>& block) {
+  this->getBlock(block, false);
+  this->getBlock(block, true);
+  for (const auto& tx : block->getTxs()) this->getReceipt(tx.hash());
+}
+
+void ResponseCache::loop() {
+  auto latestHeight = [this]() -> uint64_t {
+    auto latest = this->storage_.latest();
+    return (latest != nullptr) ? latest->getNHeight() : 0;
+  };
+  while (!this->stop_) {
+    this->storage_.events().waitUntil([&]() {
+      return this->stop_ || latestHeight() >= this->nextHeight_;
+    }, std::chrono::seconds(1));
+    if (this->stop_) break;
+    // Blocks that came in too fast to keep up with are left for the requests
+    const uint64_t latest = latestHeight();
+    if (latest < this->nextHeight_) continue;
+    if (latest - this->nextHeight_ >= this->maxWarmBlocks_) this->nextHeight_ = latest - this->maxWarmBlocks_ + 1;
+    for (; this->nextHeight_ <= latest && !this->stop_; this->nextHeight_++) {
+      auto block = this->storage_.getBlock(this->nextHeight_);
+      if (block == nullptr) continue;
+      try {
+        this->warm(block);
+      } catch (std::exception& e) {
+        LOGWARNING(Log::httpServer, "Failed to cache block " + std::to_string(this->nextHeight_) + ": " + e.what());
+      }
+    }
+  }
+}
+
+void ResponseCache::start() {
+  if (this->loopFuture_.valid()) return;
+  auto latest = this->storage_.latest();
+  this->nextHeight_ = (latest != nullptr) ? latest->getNHeight() + 1 : 0;
+  this->stop_ = false;
+  this->loopFuture_ = std::async(std::launch::async, &ResponseCache::loop, this);
+}
+
+void ResponseCache::stop() {
+  this->stop_ = true;
+  this->storage_.events().wake();
+  if (this->loopFuture_.valid()) this->loopFuture_.get();
+}
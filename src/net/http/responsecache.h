@@ -0,0 +1,132 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#ifndef RESPONSECACHE_H
+#define RESPONSECACHE_H
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "../../utils/lrucache.h"
+#include "../../utils/safehash.h"
+#include "../../utils/strings.h"
+
+// Forward declarations.
+class Block;
+class State;
+class Storage;
+
+/**
+ * Cache of serialized JSON-RPC results for blocks (`eth_getBlockByHash`/`eth_getBlockByNumber`,
+ * with and without full transactions) and receipts (`eth_getTransactionReceipt`).
+ * Both never change once their block is in the chain, so they are serialized once
+ * and the very same bytes are spliced into every response (see parseJsonRpcRequest()).
+ * A worker thread fills the cache for every new block as it is appended, since
+ * recent blocks are the ones clients ask for the most, and anything else is cached
+ * on first request. The cache is bounded by the size of the serialized results,
+ * evicting the least recently used ones.
+ * Thread-safe.
+ */
+class ResponseCache {
+  public:
+    /// A serialized result, shared by every response that uses it.
+    using Entry = std::shared_ptr<const std::string>;
+
+  private:
+    /// Kinds of cached results.
+    enum class Kind : uint8_t { Block, BlockWithTxs, Receipt };
+
+    /// Cache key, the hash of the block or transaction plus what was serialized from it.
+    using Key = std::pair<Hash, Kind>;
+
+    /// Hasher for Key.
+    struct KeyHash {
+      size_t operator()(const Key& key) const { return SafeHash()(key.first) ^ size_t(key.second); }
+    };
+
+    State& state_;            ///< Reference to the blockchain's state.
+    const Storage& storage_;  ///< Reference to the blockchain's storage.
+    mutable std::mutex mutex_;  ///< Mutex for `cache_`.
+    LRUCache<Key, Entry, KeyHash> cache_; ///< Serialized results, cost is their size in bytes.
+    uint64_t nextHeight_ = 0; ///< Height of the next block to cache (worker thread only).
+    std::atomic<bool> stop_ = false;  ///< Flag for stopping the worker thread.
+    std::future<void> loopFuture_;    ///< Future object holding the worker thread.
+
+    /// Maximum number of blocks cached in a row by the worker thread (the rest are cached on request).
+    static constexpr uint64_t maxWarmBlocks_ = 8;
+
+    /**
+     * Get a cached result.
+     * @param key The key.
+     * @return The result, or `nullptr` if not cached.
+     */
+    Entry find(const Key& key);
+
+    /**
+     * Cache a result.
+     * @param key The key.
+     * @param entry The result.
+     */
+    void insert(const Key& key, const Entry& entry);
+
+    /**
+     * Cache every result of a block: the block itself (both ways) and the receipts of its transactions.
+     * @param block The block.
+     */
+    void warm(const std::shared_ptr<const Block>& block);
+
+    void loop(); ///< Routine loop for the worker thread.
+
+  public:
+    /// Default maximum size of the serialized results.
+    static constexpr uint64_t defaultMaxBytes = 64 * 1024 * 1024;
+
+    /**
+     * Constructor. Does NOT automatically start the worker thread.
+     * @param state Reference to the blockchain's state.
+     * @param storage Reference to the blockchain's storage.
+     * @param maxBytes Maximum size of the serialized results.
+     */
+    ResponseCache(State& state, const Storage& storage, uint64_t maxBytes = defaultMaxBytes)
+      : state_(state), storage_(storage), cache_(maxBytes) {}
+
+    /// Destructor. Automatically stops the worker thread.
+    ~ResponseCache() { this->stop(); }
+
+    void start(); ///< Start caching new blocks as they are appended.
+    void stop();  ///< Stop caching new blocks.
+
+    /// Get the serialized `null` result, for blocks and transactions that don't exist.
+    static const Entry& null();
+
+    /**
+     * Get the serialized result for a block.
+     * @param block The block (`nullptr` for the `null` result).
+     * @param includeTxs If `true`, includes the whole transactions instead of only their hashes.
+     * @return The serialized result.
+     * @throw DynamicException if the block can't be serialized.
+     */
+    Entry getBlock(const std::shared_ptr<const Block>& block, bool includeTxs);
+
+    /**
+     * Get the serialized result for a transaction receipt.
+     * @param txHash The transaction hash.
+     * @return The serialized result (`null` if the transaction is not in a block, which is not cached).
+     */
+    Entry getReceipt(const Hash& txHash);
+
+    ///@{
+    /** Getter. */
+    uint64_t size() const { std::lock_guard lock(this->mutex_); return this->cache_.size(); }
+    uint64_t bytes() const { std::lock_guard lock(this->mutex_); return this->cache_.cost(); }
+    ///@}
+};
+
+#endif // RESPONSECACHE_H
@@ -0,0 +1,202 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include <regex>
+
+#include "subscriptions.h"
+#include "websocketsession.h"
+#include "../../core/state.h"
+#include "../../utils/metrics.h"
+
+/// Get the gauge with the number of subscriptions.
+static Metrics::Gauge& subscriptionsGauge() {
+  static Metrics::Gauge& gauge = Metrics::gauge("orbiter_ws_subscriptions", "Active eth_subscribe subscriptions.");
+  return gauge;
+}
+
+std::vector<std::shared_ptr<Subscriptions::Subscription>> Subscriptions::collect(Type type) {
+  std::vector<std::shared_ptr<Subscription>> ret;
+  std::lock_guard lock(this->mutex_);
+  for (auto it = this->subscriptions_.begin(); it != this->subscriptions_.end();) {
+    if (it->second->session.expired()) { it = this->subscriptions_.erase(it); continue; }
+    if (it->second->type == type) ret.emplace_back(it->second);
+    it++;
+  }
+  subscriptionsGauge().set(this->subscriptions_.size());
+  return ret;
+}
+
+void Subscriptions::publish(const std::shared_ptr<Subscription>& sub, const std::string& result) {
+  static Metrics::Counter& notifications = Metrics::counter(
+    "orbiter_ws_notifications_total", "eth_subscription notifications queued to WebSocket sessions."
+  );
+  static Metrics::Counter& dropped = Metrics::counter(
+    "orbiter_ws_notifications_dropped_total",
+    "eth_subscription notifications dropped because the session wasn't keeping up."
+  );
+  auto session = sub->session.lock();
+  if (session == nullptr) return;
+  std::string message = R"({"jsonrpc":"2.0","method":"eth_subscription","params":{"subscription":")"
+    + sub->id + R"(","result":)" + result + "}}";
+  if (session->notify(sub, std::move(message))) notifications.inc(); else dropped.inc();
+}
+
+void Subscriptions::notifyBlock(
+  uint64_t height, const std::vector<std::shared_ptr<Subscription>>& heads,
+  const std::vector<std::shared_ptr<Subscription>>& logs
+) {
+  if (heads.empty() && logs.empty()) return;
+  auto block = this->storage_.getBlock(height);
+  if (block == nullptr) return;
+  // A failure only costs the notifications it was building, never the other subscriptions
+  if (!heads.empty()) {
+    try {
+      const std::string header = JsonRPC::Encoding::getBlockJson(block, false)["result"].dump();
+      for (const auto& sub : heads) Subscriptions::publish(sub, header);
+    } catch (std::exception& e) {
+      LOGWARNING(Log::subscriptions, "Failed to notify block " + std::to_string(height) + " to newHeads: " + e.what());
+    }
+  }
+  for (const auto& sub : logs) {
+    try {
+      for (const Event& event : this->state_.getEvents(height, height, sub->address, sub->topics)) {
+        Subscriptions::publish(sub, event.serializeForRPC());
+      }
+    } catch (std::exception& e) {
+      LOGWARNING(Log::subscriptions,
+        "Failed to notify logs of block " + std::to_string(height) + " to subscription " + sub->id + ": " + e.what()
+      );
+    }
+  }
+}
+
+void Subscriptions::notifyTxs() {
+  auto delta = this->state_.getTxInventory().since(this->txSequence_, this->maxTxsPerRound_);
+  this->txSequence_ = delta.sequence;
+  if (!delta.complete) {
+    LOGDEBUG(Log::subscriptions, "Fell behind the mempool inventory, skipping to sequence " + std::to_string(delta.sequence));
+  }
+  if (delta.hashes.empty()) return;
+  auto subs = this->collect(Type::NewPendingTransactions);
+  for (const Hash& hash : delta.hashes) {
+    const std::string result = "\"" + hash.hex(true).get() + "\"";
+    for (const auto& sub : subs) Subscriptions::publish(sub, result);
+  }
+}
+
+void Subscriptions::loop() {
+  const TxInventory& txInventory = this->state_.getTxInventory();
+  auto latestHeight = [this]() -> uint64_t {
+    auto latest = this->storage_.latest();
+    return (latest != nullptr) ? latest->getNHeight() : 0;
+  };
+  while (!this->stop_) {
+    // Cursors always move forward, even with no subscribers, so new ones only get what's new
+    this->storage_.events().waitUntil([&]() {
+      return this->stop_ || latestHeight() >= this->nextHeight_ || txInventory.sequence() > this->txSequence_;
+    }, this->idleWakeInterval_);
+    if (this->stop_) break;
+    const uint64_t latest = latestHeight();
+    if (latest >= this->nextHeight_) {
+      auto heads = this->collect(Type::NewHeads);
+      auto logs = this->collect(Type::Logs);
+      for (; this->nextHeight_ <= latest && !this->stop_; this->nextHeight_++) {
+        try {
+          this->notifyBlock(this->nextHeight_, heads, logs);
+        } catch (std::exception& e) {
+          LOGWARNING(Log::subscriptions, "Failed to notify block " + std::to_string(this->nextHeight_) + ": " + e.what());
+        }
+      }
+    }
+    try {
+      this->notifyTxs();
+    } catch (std::exception& e) {
+      LOGWARNING(Log::subscriptions, std::string("Failed to notify pending transactions: ") + e.what());
+    }
+  }
+}
+
+void Subscriptions::start() {
+  if (this->loopFuture_.valid()) return;
+  auto latest = this->storage_.latest();
+  this->nextHeight_ = (latest != nullptr) ? latest->getNHeight() + 1 : 0;
+  this->txSequence_ = this->state_.getTxInventory().sequence();
+  this->stop_ = false;
+  this->loopFuture_ = std::async(std::launch::async, &Subscriptions::loop, this);
+}
+
+void Subscriptions::stop() {
+  this->stop_ = true;
+  this->storage_.events().wake();
+  if (this->loopFuture_.valid()) this->loopFuture_.get();
+}
+
+std::string Subscriptions::subscribe(const json& params, const std::shared_ptr<WebsocketSession>& session) {
+  static const std::regex addFilter("^0x[0-9,a-f,A-F]{40}$");
+  static const std::regex hashFilter("^0x[0-9a-f]{64}$");
+  if (!params.is_array() || params.empty() || !params.at(0).is_string()) {
+    throw DynamicException("Missing subscription type");
+  }
+  const std::string name = params.at(0).get<std::string>();
+  Type type;
+  Address address;
+  std::vector<Hash> topics;
+  if (name == "newHeads") {
+    type = Type::NewHeads;
+  } else if (name == "newPendingTransactions") {
+    type = Type::NewPendingTransactions;
+  } else if (name == "logs") {
+    // Same filter as eth_getLogs, minus the block range
+    type = Type::Logs;
+    if (params.size() > 1) {
+      const json& filter = params.at(1);
+      if (!filter.is_object()) throw DynamicException("logs filter is not an object");
+      if (filter.contains("address")) {
+        std::string addressHex = filter["address"].get<std::string>();
+        if (!std::regex_match(addressHex, addFilter)) throw DynamicException("Invalid address hex");
+        address = Address(Hex::toBytes(addressHex));
+      }
+      if (filter.contains("topics")) {
+        if (!filter["topics"].is_array()) throw DynamicException("topics is not an array");
+        for (const auto& topic : filter["topics"].get<std::vector<std::string>>()) {
+          if (!std::regex_match(topic, hashFilter)) throw DynamicException("Invalid topic hex");
+          topics.emplace_back(Hex::toBytes(topic));
+        }
+      }
+    }
+  } else {
+    throw DynamicException("Unsupported subscription type: " + name);
+  }
+
+  std::lock_guard lock(this->mutex_);
+  std::string id;
+  do { id = Hex::fromBytes(Utils::randBytes(16), true).get(); } while (this->subscriptions_.contains(id));
+  this->subscriptions_.emplace(id, std::make_shared<Subscription>(
+    id, type, std::move(address), std::move(topics), session
+  ));
+  subscriptionsGauge().set(this->subscriptions_.size());
+  return id;
+}
+
+bool Subscriptions::unsubscribe(const std::string& id, const WebsocketSession* session) {
+  std::lock_guard lock(this->mutex_);
+  auto it = this->subscriptions_.find(id);
+  if (it == this->subscriptions_.end() || it->second->session.lock().get() != session) return false;
+  this->subscriptions_.erase(it);
+  subscriptionsGauge().set(this->subscriptions_.size());
+  return true;
+}
+
+void Subscriptions::unsubscribeAll(const WebsocketSession* session) {
+  // Called from the session's destructor, by then its own weak pointers are already expired
+  std::lock_guard lock(this->mutex_);
+  std::erase_if(this->subscriptions_, [session](const auto& entry) {
+    auto owner = entry.second->session.lock();
+    return owner == nullptr || owner.get() == session;
+  });
+  subscriptionsGauge().set(this->subscriptions_.size());
+}
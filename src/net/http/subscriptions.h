@@ -0,0 +1,155 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#ifndef SUBSCRIPTIONS_H
+#define SUBSCRIPTIONS_H
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../../libs/json.hpp"
+#include "../../utils/strings.h"
+
+using json = nlohmann::ordered_json;
+
+// Forward declarations.
+class State;
+class Storage;
+class WebsocketSession;
+
+/**
+ * Registry of the `eth_subscribe` subscriptions of every WebSocket session.
+ * A single worker thread follows the chain through ChainEvents: for every new
+ * block it sends the header to `newHeads` subscribers and the matching events
+ * (queried through the event indexes, like `eth_getLogs`) to `logs` subscribers,
+ * and for every transaction added to the mempool (through State's TxInventory)
+ * it sends the hash to `newPendingTransactions` subscribers. Notifications are
+ * built once per block/transaction and handed over to the sessions, so neither
+ * the consensus path nor the mempool ever wait on a client.
+ * Every subscription can only have a bounded number of notifications waiting to
+ * be written to its session, past which new ones are dropped (see WebsocketSession::notify()).
+ */
+class Subscriptions {
+  public:
+    /// Kinds of subscriptions.
+    enum class Type { NewHeads, Logs, NewPendingTransactions };
+
+    /// A single subscription.
+    struct Subscription {
+      const std::string id;   ///< Subscription ID, as returned to the client.
+      const Type type;        ///< Kind of the subscription.
+      const Address address;  ///< Events must come from this address (`logs` only, empty for any).
+      const std::vector<Hash> topics; ///< Events must have these topics (`logs` only).
+      const std::weak_ptr<WebsocketSession> session; ///< The session that owns the subscription.
+      std::atomic<uint64_t> pending = 0;  ///< Notifications queued on the session but not written yet.
+      std::atomic<uint64_t> dropped = 0;  ///< Notifications dropped because too many were pending.
+
+      /**
+       * Constructor.
+       * @param id Subscription ID.
+       * @param type Kind of the subscription.
+       * @param address Address filter.
+       * @param topics Topic filter.
+       * @param session The session that owns the subscription.
+       */
+      Subscription(
+        std::string id, Type type, Address address, std::vector<Hash> topics,
+        std::weak_ptr<WebsocketSession> session
+      ) : id(std::move(id)), type(type), address(std::move(address)), topics(std::move(topics)),
+        session(std::move(session)) {}
+    };
+
+    /// Maximum number of notifications of a single subscription waiting to be written.
+    static constexpr uint64_t maxPendingPerSubscription = 1024;
+
+  private:
+    State& state_;            ///< Reference to the blockchain's state.
+    const Storage& storage_;  ///< Reference to the blockchain's storage.
+    mutable std::mutex mutex_;  ///< Mutex for `subscriptions_`.
+    std::map<std::string, std::shared_ptr<Subscription>> subscriptions_; ///< Subscriptions by ID.
+    uint64_t nextHeight_ = 0;   ///< Height of the next block to notify (worker thread only).
+    uint64_t txSequence_ = 0;   ///< Latest TxInventory sequence notified (worker thread only).
+    std::atomic<bool> stop_ = false;  ///< Flag for stopping the worker thread.
+    std::future<void> loopFuture_;    ///< Future object holding the worker thread.
+
+    /// Maximum number of mempool transactions notified per round.
+    static constexpr uint64_t maxTxsPerRound_ = 1024;
+    /// Upper bound for a single wait on ChainEvents, waits are woken by events and stop() anyway.
+    static constexpr std::chrono::milliseconds idleWakeInterval_{1000};
+
+    /// Get every live subscription of a kind, dropping the ones whose session is gone.
+    std::vector<std::shared_ptr<Subscription>> collect(Type type);
+
+    /**
+     * Send a notification to a subscription.
+     * @param sub The subscription.
+     * @param result The `result` of the notification, already serialized.
+     */
+    static void publish(const std::shared_ptr<Subscription>& sub, const std::string& result);
+
+    /**
+     * Notify the subscribers of a new block.
+     * @param height The block's height.
+     * @param heads The `newHeads` subscriptions.
+     * @param logs The `logs` subscriptions.
+     */
+    void notifyBlock(
+      uint64_t height, const std::vector<std::shared_ptr<Subscription>>& heads,
+      const std::vector<std::shared_ptr<Subscription>>& logs
+    );
+
+    void notifyTxs(); ///< Notify the `newPendingTransactions` subscribers of new mempool transactions.
+    void loop(); ///< Routine loop for the worker thread.
+
+  public:
+    /**
+     * Constructor. Does NOT automatically start the worker thread.
+     * @param state Reference to the blockchain's state.
+     * @param storage Reference to the blockchain's storage.
+     */
+    Subscriptions(State& state, const Storage& storage) : state_(state), storage_(storage) {}
+
+    /// Destructor. Automatically stops the worker thread.
+    ~Subscriptions() { this->stop(); }
+
+    void start(); ///< Start following the chain, from its current head.
+    void stop();  ///< Stop following the chain.
+
+    /**
+     * Add a subscription (`eth_subscribe`).
+     * @param params The request's params (the kind, plus the filter for `logs`).
+     * @param session The session that asked for it.
+     * @return The subscription ID.
+     * @throw DynamicException if the params are invalid.
+     */
+    std::string subscribe(const json& params, const std::shared_ptr<WebsocketSession>& session);
+
+    /**
+     * Remove a subscription (`eth_unsubscribe`).
+     * @param id The subscription ID.
+     * @param session The session that asked for it (sessions can only remove their own subscriptions).
+     * @return `true` if removed, `false` if not found.
+     */
+    bool unsubscribe(const std::string& id, const WebsocketSession* session);
+
+    /**
+     * Remove every subscription of a session (when it is closed).
+     * @param session The session.
+     */
+    void unsubscribeAll(const WebsocketSession* session);
+
+    /// Get the number of subscriptions.
+    uint64_t size() const { std::lock_guard lock(this->mutex_); return this->subscriptions_.size(); }
+};
+
+#endif // SUBSCRIPTIONS_H
@@ -0,0 +1,183 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "websocketsession.h"
+
+WebsocketSession::~WebsocketSession() { this->subscriptions_.unsubscribeAll(this); }
+
+void WebsocketSession::start(http::request<http::string_body>&& req) {
+  // The HTTP session never expires, the WebSocket layer has its own idle timeout
+  beast::get_lowest_layer(this->ws_).expires_never();
+  this->ws_.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
+  this->ws_.set_option(websocket::stream_base::decorator([](websocket::response_type& res) {
+    res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+  }));
+  this->ws_.read_message_max(this->maxMessageSize_);
+  this->ws_.async_accept(req, beast::bind_front_handler(
+    &WebsocketSession::on_accept, this->shared_from_this()
+  ));
+}
+
+void WebsocketSession::on_accept(beast::error_code ec) {
+  if (ec) return fail("WebsocketSession", __func__, ec, "Failed to accept WebSocket handshake");
+  this->do_read();
+}
+
+void WebsocketSession::do_read() {
+  this->ws_.async_read(this->buf_, beast::bind_front_handler(
+    &WebsocketSession::on_read, this->shared_from_this()
+  ));
+}
+
+void WebsocketSession::on_read(beast::error_code ec, std::size_t bytes) {
+  boost::ignore_unused(bytes);
+  // This means the other side closed the connection
+  if (ec == websocket::error::closed) return this->do_close();
+  if (ec) { fail("WebsocketSession", __func__, ec, "Failed to read message"); return this->do_close(); }
+  std::string message = beast::buffers_to_string(this->buf_.data());
+  this->buf_.consume(this->buf_.size());
+  LOGDEBUG(Log::websocketSession, "WebSocket Request: " + message);
+  this->enqueue(this->handleMessage(message), nullptr);
+  this->do_read();
+}
+
+std::string WebsocketSession::handleMessage(const std::string& message) {
+  // Subscriptions belong to this session, everything else is answered exactly like over HTTP
+  try {
+    json request = json::parse(message);
+    if (request.is_object() && request.contains("method") && request["method"].is_string()) {
+      const std::string& method = request["method"].get_ref<const std::string&>();
+      if (method == "eth_subscribe" || method == "eth_unsubscribe") {
+        return this->handleSubscriptionRequest(request).dump();
+      }
+    }
+  } catch (std::exception&) {} // Let parseJsonRpcRequest() answer with the error
+  return parseJsonRpcRequest(
+    message, this->state_, this->storage_, this->p2p_, this->options_, this->filters_, this->cache_
+  );
+}
+
+json WebsocketSession::handleSubscriptionRequest(const json& request) {
+  json ret;
+  // Echoed back even on errors, clients match the answers by id
+  const json id = (request.contains("id") && (request["id"].is_string() || request["id"].is_number()))
+    ? request["id"] : json();
+  try {
+    if (!JsonRPC::Decoding::checkJsonRPCSpec(request)) {
+      ret["jsonrpc"] = "2.0";
+      ret["id"] = id;
+      ret["error"]["code"] = -32600;
+      ret["error"]["message"] = "Invalid request - does not conform to JSON-RPC 2.0 spec";
+      return ret;
+    }
+    const json params = request.value("params", json::array());
+    ret["jsonrpc"] = "2.0";
+    if (request["method"].get<std::string>() == "eth_subscribe") {
+      ret["result"] = this->subscriptions_.subscribe(params, this->shared_from_this());
+    } else {
+      if (!params.is_array() || params.empty() || !params.at(0).is_string()) {
+        throw DynamicException("Missing subscription ID");
+      }
+      ret["result"] = this->subscriptions_.unsubscribe(params.at(0).get<std::string>(), this);
+    }
+    if (request.contains("id") && !request["id"].is_null() && id.is_null()) throw DynamicException("Invalid id type");
+    ret["id"] = id;
+  } catch (std::exception& e) {
+    json error;
+    error["jsonrpc"] = "2.0";
+    error["id"] = id;
+    error["error"]["code"] = -32603;
+    error["error"]["message"] = "Internal error: " + std::string(e.what());
+    return error;
+  }
+  return ret;
+}
+
+bool WebsocketSession::notify(
+  const std::shared_ptr<Subscriptions::Subscription>& subscription, std::string&& message
+) {
+  if (subscription->pending.fetch_add(1) >= Subscriptions::maxPendingPerSubscription) {
+    subscription->pending--;
+    subscription->dropped++;
+    return false;
+  }
+  net::post(this->ws_.get_executor(), [self = this->shared_from_this(), subscription, message = std::move(message)]() mutable {
+    self->enqueue(std::move(message), std::move(subscription));
+  });
+  return true;
+}
+
+void WebsocketSession::enqueue(std::string&& message, std::shared_ptr<Subscriptions::Subscription> subscription) {
+  if (this->closing_) {
+    if (subscription != nullptr) subscription->pending--;
+    return;
+  }
+  this->queuedBytes_ += message.size();
+  this->queue_.push_back({std::move(message), std::move(subscription)});
+  if (this->queuedBytes_ > this->maxQueuedBytes_) {
+    LOGDEBUG(Log::websocketSession, "Client is not reading its messages, closing the session");
+    return this->do_close();
+  }
+  if (this->queue_.size() == 1) this->do_write();
+}
+
+void WebsocketSession::do_write() {
+  this->ws_.text(true);
+  this->ws_.async_write(net::buffer(this->queue_.front().message), beast::bind_front_handler(
+    &WebsocketSession::on_write, this->shared_from_this()
+  ));
+}
+
+void WebsocketSession::on_write(beast::error_code ec, std::size_t bytes) {
+  boost::ignore_unused(bytes);
+  // Only dropped now, the write was using its buffer until here
+  Outgoing& written = this->queue_.front();
+  this->queuedBytes_ -= written.message.size();
+  if (written.subscription != nullptr) written.subscription->pending--;
+  this->queue_.pop_front();
+  if (ec) {
+    if (!this->closing_) fail("WebsocketSession", __func__, ec, "Failed to write message");
+    this->closing_ = true;
+    for (const Outgoing& item : this->queue_) {
+      if (item.subscription != nullptr) item.subscription->pending--;
+    }
+    this->queue_.clear();
+    this->queuedBytes_ = 0;
+    beast::get_lowest_layer(this->ws_).close();
+    return;
+  }
+  // do_close() left only this message in the queue, it's the close frame's turn now
+  if (this->closing_) return this->send_close();
+  if (!this->queue_.empty()) this->do_write();
+}
+
+void WebsocketSession::do_close() {
+  if (this->closing_) return;
+  this->closing_ = true;
+  // The front message is being written and its buffer must outlive the write, on_write() drops it
+  auto first = this->queue_.empty() ? this->queue_.end() : std::next(this->queue_.begin());
+  for (auto it = first; it != this->queue_.end(); it++) {
+    this->queuedBytes_ -= it->message.size();
+    if (it->subscription != nullptr) it->subscription->pending--;
+  }
+  this->queue_.erase(first, this->queue_.end());
+  if (this->queue_.empty()) this->send_close();
+}
+
+void WebsocketSession::send_close() {
+  // The peer closed first, Beast already answered its close frame
+  if (!this->ws_.is_open()) return beast::get_lowest_layer(this->ws_).close();
+  this->ws_.async_close(websocket::close_code::normal, beast::bind_front_handler(
+    &WebsocketSession::on_close, this->shared_from_this()
+  ));
+}
+
+void WebsocketSession::on_close(beast::error_code ec) {
+  if (ec) fail("WebsocketSession", __func__, ec, "Failed to close WebSocket");
+  // Either way the session goes away with the last pending handler
+  beast::get_lowest_layer(this->ws_).close();
+}
@@ -0,0 +1,185 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#ifndef WEBSOCKETSESSION_H
+#define WEBSOCKETSESSION_H
+
+#include <deque>
+
+#include "httpparser.h"
+#include "subscriptions.h"
+
+/**
+ * Class that handles a JSON-RPC connection over WebSocket.
+ * Sessions are upgraded from HTTPSession, so they share the HTTP port. Every
+ * text message is a JSON-RPC request (or batch) answered like over HTTP, plus
+ * `eth_subscribe`/`eth_unsubscribe`, which only make sense on a persistent connection.
+ * Outgoing messages (answers and notifications) are queued and written one at a
+ * time. Notifications are bounded per subscription (see notify()), and the whole
+ * queue is bounded in bytes: a client that can't keep up with even that is disconnected.
+ */
+class WebsocketSession : public std::enable_shared_from_this<WebsocketSession> {
+  private:
+    /// A queued outgoing message.
+    struct Outgoing {
+      std::string message; ///< The message.
+      std::shared_ptr<Subscriptions::Subscription> subscription; ///< The subscription it notifies, null for answers.
+    };
+
+    /// Maximum size of an incoming message, same as an HTTP request body.
+    static constexpr size_t maxMessageSize_ = 512000;
+
+    /// Maximum size of every queued outgoing message together.
+    static constexpr uint64_t maxQueuedBytes_ = 16 * 1024 * 1024;
+
+    /// WebSocket stream.
+    websocket::stream<beast::tcp_stream> ws_;
+
+    /// Internal buffer to read into.
+    beast::flat_buffer buf_;
+
+    /// Outgoing messages, the front one is being written (strand only).
+    std::deque<Outgoing> queue_;
+
+    /// Size of every message in `queue_` (strand only).
+    uint64_t queuedBytes_ = 0;
+
+    /// Whether the session is being closed (strand only).
+    bool closing_ = false;
+
+    /// Reference pointer to the blockchain's state.
+    State& state_;
+
+    /// Reference pointer to the blockchain's storage.
+    const Storage& storage_;
+
+    /// Reference pointer to the P2P connection manager.
+    P2P::ManagerNormal& p2p_;
+
+    /// Reference pointer to the options singleton.
+    const Options& options_;
+
+    /// Reference pointer to the filter registry.
+    Filters& filters_;
+
+    /// Reference pointer to the response cache.
+    ResponseCache& cache_;
+
+    /// Reference pointer to the subscription registry.
+    Subscriptions& subscriptions_;
+
+    /**
+     * Callback for the WebSocket handshake.
+     * @param ec The error code to parse.
+     */
+    void on_accept(beast::error_code ec);
+
+    /// Read the next message.
+    void do_read();
+
+    /**
+     * Callback for do_read().
+     * Answers the message and reads the next one.
+     * @param ec The error code to parse.
+     * @param bytes The number of read bytes.
+     */
+    void on_read(beast::error_code ec, std::size_t bytes);
+
+    /**
+     * Answer a message.
+     * @param message The message (a JSON-RPC request or batch).
+     * @return The answer.
+     */
+    std::string handleMessage(const std::string& message);
+
+    /**
+     * Answer an `eth_subscribe` or `eth_unsubscribe` request.
+     * @param request The request.
+     * @return The answer.
+     */
+    json handleSubscriptionRequest(const json& request);
+
+    /**
+     * Queue a message to be written (strand only).
+     * @param message The message.
+     * @param subscription The subscription it notifies, null for answers.
+     */
+    void enqueue(std::string&& message, std::shared_ptr<Subscriptions::Subscription> subscription);
+
+    /// Write the front message of the queue (strand only).
+    void do_write();
+
+    /**
+     * Callback for do_write().
+     * Writes the next message, if any.
+     * @param ec The error code to parse.
+     * @param bytes The number of written bytes.
+     */
+    void on_write(beast::error_code ec, std::size_t bytes);
+
+    /**
+     * Close the connection, dropping whatever is queued (strand only).
+     * A message already being written is kept until the write completes,
+     * then the close frame is sent (see send_close()).
+     */
+    void do_close();
+
+    /// Send the WebSocket close frame, once nothing is being written (strand only).
+    void send_close();
+
+    /**
+     * Callback for send_close().
+     * Closes the underlying socket.
+     * @param ec The error code to parse.
+     */
+    void on_close(beast::error_code ec);
+
+  public:
+    /**
+     * Constructor.
+     * @param sock The socket to take ownership of (already read the upgrade request from).
+     * @param state Reference pointer to the blockchain's state.
+     * @param storage Reference pointer to the blockchain's storage.
+     * @param p2p Reference pointer to the P2P connection manager.
+     * @param options Reference pointer to the options singleton.
+     * @param filters Reference pointer to the filter registry.
+     * @param cache Reference pointer to the response cache.
+     * @param subscriptions Reference pointer to the subscription registry.
+     */
+    WebsocketSession(tcp::socket&& sock,
+      State& state,
+      const Storage& storage,
+      P2P::ManagerNormal& p2p,
+      const Options& options,
+      Filters& filters,
+      ResponseCache& cache,
+      Subscriptions& subscriptions
+    ) : ws_(std::move(sock)), state_(state), storage_(storage), p2p_(p2p),
+      options_(options), filters_(filters), cache_(cache), subscriptions_(subscriptions)
+    {}
+
+    /// Destructor. Removes every subscription of the session.
+    ~WebsocketSession();
+
+    /**
+     * Start the WebSocket session.
+     * @param req The HTTP upgrade request.
+     */
+    void start(http::request<http::string_body>&& req);
+
+    /**
+     * Send a notification. Safe to call from any thread.
+     * If the subscription already has too many notifications waiting to be
+     * written, the notification is dropped instead.
+     * @param subscription The subscription it notifies.
+     * @param message The notification.
+     * @return `true` if queued, `false` if dropped.
+     */
+    bool notify(const std::shared_ptr<Subscriptions::Subscription>& subscription, std::string&& message);
+};
+
+#endif  // WEBSOCKETSESSION_H
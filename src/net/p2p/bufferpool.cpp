@@ -0,0 +1,43 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "bufferpool.h"
+
+namespace P2P {
+  Bytes BufferPool::acquire(size_t capacity) {
+    Bytes buffer;
+    const size_t sizeClass = BufferPool::ceilClass(capacity);
+    if (sizeClass < this->buckets_.size()) {
+      {
+        // Own class or the one above only, so small requests never take much larger buffers
+        std::lock_guard lock(this->mutex_);
+        for (size_t i = sizeClass; i < std::min(sizeClass + 2, this->buckets_.size()); i++) {
+          if (this->buckets_[i].empty()) continue;
+          buffer = std::move(this->buckets_[i].back());
+          this->buckets_[i].pop_back();
+          this->count_--;
+          this->bytes_ -= buffer.capacity();
+          break;
+        }
+      }
+      capacity = std::min(size_t(1) << (sizeClass + minClassShift_), this->maxCapacity_);
+    }
+    buffer.reserve(capacity);
+    return buffer;
+  }
+
+  void BufferPool::release(Bytes&& buffer) {
+    const size_t capacity = buffer.capacity();
+    if ((capacity >> minClassShift_) == 0 || capacity > this->maxCapacity_) return;
+    buffer.clear();
+    std::lock_guard lock(this->mutex_);
+    if (this->count_ >= this->maxBuffers_ || this->bytes_ + capacity > this->maxBytes_) return;
+    this->buckets_[BufferPool::floorClass(capacity)].emplace_back(std::move(buffer));
+    this->count_++;
+    this->bytes_ += capacity;
+  }
+};
@@ -0,0 +1,87 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#ifndef P2P_BUFFER_POOL_H
+#define P2P_BUFFER_POOL_H
+
+#include <bit>
+#include <mutex>
+#include <vector>
+
+#include "../../utils/utils.h"
+
+namespace P2P {
+  /**
+   * Pool of reusable byte buffers for %P2P messages.
+   * Messages take their buffer from the pool when they are encoded or read from
+   * a socket, and give it back when they are destroyed, so a busy node keeps
+   * reusing the same allocations instead of hitting the allocator for every
+   * message. Free buffers are bucketed by power of two size classes, and a request
+   * is only served from its own class or the one above, so small messages never
+   * pin large buffers. Buffers that grew too large are not kept, and neither are
+   * buffers beyond the pool's count or byte limits, so the memory it holds stays bounded.
+   */
+  class BufferPool {
+    private:
+      static constexpr size_t minClassShift_ = 6;  ///< Smallest size class is 2^6 = 64 bytes, smaller buffers are not kept.
+      mutable std::mutex mutex_;    ///< Mutex for `buckets_`, `count_` and `bytes_`.
+      std::vector<std::vector<Bytes>> buckets_;  ///< Free buffers by size class, most recently released last.
+      size_t count_ = 0;            ///< Number of free buffers in all buckets.
+      size_t bytes_ = 0;            ///< Total capacity of the free buffers in all buckets.
+      const size_t maxBuffers_;     ///< Maximum number of free buffers kept.
+      const size_t maxCapacity_;    ///< Maximum capacity of a buffer to be kept.
+      const size_t maxBytes_;       ///< Maximum total capacity of the free buffers kept.
+
+      /// Get the size class every buffer of the given capacity can serve (rounding down).
+      static size_t floorClass(size_t capacity) { return std::bit_width(capacity) - 1 - minClassShift_; }
+
+      /// Get the size class that serves a request of the given size (rounding up).
+      static size_t ceilClass(size_t size) {
+        return (size <= (size_t(1) << minClassShift_)) ? 0 : std::bit_width(size - 1) - minClassShift_;
+      }
+
+    public:
+      /**
+       * Constructor.
+       * @param maxBuffers Maximum number of free buffers kept.
+       * @param maxCapacity Maximum capacity of a buffer to be kept, in bytes.
+       * @param maxBytes Maximum total capacity of the free buffers kept, in bytes.
+       */
+      explicit BufferPool(
+        size_t maxBuffers = 1024, size_t maxCapacity = 4 * 1024 * 1024, size_t maxBytes = 64 * 1024 * 1024
+      ) : buckets_((maxCapacity >> minClassShift_) ? floorClass(maxCapacity) + 1 : 0),
+        maxBuffers_(maxBuffers), maxCapacity_(maxCapacity), maxBytes_(maxBytes) {}
+
+      BufferPool(const BufferPool&) = delete; ///< Not copyable.
+      BufferPool& operator=(const BufferPool&) = delete; ///< Not copyable.
+
+      /// Get the pool shared by every message.
+      static BufferPool& instance() { static BufferPool pool; return pool; }
+
+      /**
+       * Take an empty buffer from the pool (or a new one if no free buffer fits).
+       * New buffers are rounded up to their size class, so they fit it once released.
+       * @param capacity The capacity to reserve in the buffer.
+       * @return The buffer.
+       */
+      Bytes acquire(size_t capacity);
+
+      /**
+       * Give a buffer back to the pool. Dropped if the pool is full or the buffer too small or too large.
+       * @param buffer The buffer to give back.
+       */
+      void release(Bytes&& buffer);
+
+      /// Get the number of free buffers in the pool.
+      size_t size() const { std::lock_guard lock(this->mutex_); return this->count_; }
+
+      /// Get the total capacity of the free buffers in the pool, in bytes.
+      size_t bytes() const { std::lock_guard lock(this->mutex_); return this->bytes_; }
+  };
+};
+
+#endif // P2P_BUFFER_POOL_H
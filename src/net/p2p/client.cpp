@@ -15,7 +15,7 @@ namespace P2P {
   }
 
   bool ClientFactory::run() {
-    Logger::logToDebug(LogType::INFO, Log::P2PClientFactory, __func__,
+    LOGINFO(Log::P2PClientFactory,
                       "Starting P2P Client Factory "
     );
 
@@ -33,7 +33,7 @@ namespace P2P {
 
   bool ClientFactory::start() {
     if (this->executor_.valid()) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PClientFactory, __func__, "P2P Client Factory already started.");
+      LOGERROR(Log::P2PClientFactory, "P2P Client Factory already started.");
       return false;
     }
     this->executor_ = std::async(std::launch::async, &ClientFactory::run, this);
@@ -42,7 +42,7 @@ namespace P2P {
 
   bool ClientFactory::stop() {
     if (!this->executor_.valid()) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PClientFactory, __func__, "P2P Client Factory not started.");
+      LOGERROR(Log::P2PClientFactory, "P2P Client Factory not started.");
       return false;
     }
     this->io_context_.stop();
@@ -0,0 +1,44 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "compression.h"
+#include "bufferpool.h"
+
+#include <zlib.h>
+
+namespace P2P {
+  Bytes Compression::compress(const BytesArrView payload) {
+    uLongf compressedSize = compressBound(payload.size());
+    Bytes compressed = BufferPool::instance().acquire(8 + compressedSize);
+    Utils::appendBytes(compressed, Utils::uint64ToBytes(payload.size()));
+    compressed.resize(8 + compressedSize);
+    // Level 1: payloads are compressed on the session's write path, speed matters more than ratio
+    if (compress2(compressed.data() + 8, &compressedSize, payload.data(), payload.size(), Z_BEST_SPEED) != Z_OK) {
+      throw DynamicException("Failed to compress payload");
+    }
+    compressed.resize(8 + compressedSize);
+    return compressed;
+  }
+
+  Bytes Compression::decompress(const BytesArrView compressed, const uint64_t& maxSize) {
+    if (compressed.size() < 8) throw DynamicException("Invalid compressed payload size");
+    uint64_t size = Utils::bytesToUint64(compressed.subspan(0, 8));
+    if (size > maxSize) {
+      throw DynamicException("Decompressed payload too large: " + std::to_string(size));
+    }
+    Bytes payload = BufferPool::instance().acquire(size);
+    payload.resize(size);
+    uLongf payloadSize = size;
+    if (uncompress(payload.data(), &payloadSize, compressed.data() + 8, compressed.size() - 8) != Z_OK
+      || payloadSize != size
+    ) {
+      BufferPool::instance().release(std::move(payload));
+      throw DynamicException("Invalid compressed payload");
+    }
+    return payload;
+  }
+};
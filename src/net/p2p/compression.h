@@ -0,0 +1,39 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#ifndef P2P_COMPRESSION_H
+#define P2P_COMPRESSION_H
+
+#include "../../utils/utils.h"
+
+namespace P2P {
+  /**
+   * Compression of %P2P message payloads, used by sessions whose peers negotiated it.
+   * A compressed payload is the 8-byte size of the original payload followed by
+   * its zlib stream, so the receiver can allocate the whole buffer up front and
+   * refuse oversized payloads before inflating them.
+   */
+  namespace Compression {
+    /**
+     * Compress a payload. The result is taken from the BufferPool.
+     * @param payload The payload to compress.
+     * @return The compressed payload.
+     */
+    Bytes compress(const BytesArrView payload);
+
+    /**
+     * Decompress a payload. The result is taken from the BufferPool.
+     * @param compressed The compressed payload.
+     * @param maxSize The maximum size allowed for the original payload.
+     * @return The original payload.
+     * @throw DynamicException if the payload is malformed or too large.
+     */
+    Bytes decompress(const BytesArrView compressed, const uint64_t& maxSize);
+  };
+};
+
+#endif // P2P_COMPRESSION_H
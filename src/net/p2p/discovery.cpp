@@ -51,7 +51,7 @@ namespace P2P {
 
   bool DiscoveryWorker::discoverLoop() {
     bool discoveryPass = false;
-    Logger::logToDebug(LogType::INFO, Log::P2PDiscoveryWorker, __func__, "Discovery thread started minConnections: "
+    LOGINFO(Log::P2PDiscoveryWorker, "Discovery thread started minConnections: "
                         + std::to_string(this->manager_.minConnections()) + " maxConnections: " + std::to_string(this->manager_.maxConnections()));
     uint64_t lastLogged = 0;
     while (!this->stopWorker_) {
@@ -63,13 +63,13 @@ namespace P2P {
       }
 
       if (lastLogged != sessionSize) {
-        Logger::logToDebug(LogType::INFO, Log::P2PDiscoveryWorker, __func__, "DiscoveryWorker current sessionSize: " + std::to_string(sessionSize));
+        LOGINFO(Log::P2PDiscoveryWorker, "DiscoveryWorker current sessionSize: " + std::to_string(sessionSize));
         lastLogged = sessionSize;
       }
 
       std::this_thread::sleep_for(std::chrono::milliseconds(100));
       if (sessionSize >= this->manager_.maxConnections()) {
-         Logger::logToDebug(LogType::INFO, Log::P2PDiscoveryWorker, __func__, "Max connections reached, sleeping...");
+         LOGINFO(Log::P2PDiscoveryWorker, "Max connections reached, sleeping...");
          std::this_thread::sleep_for(std::chrono::seconds(10));
          continue;
       }
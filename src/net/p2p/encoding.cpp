@@ -6,6 +6,7 @@ See the LICENSE.txt file in the project root for more information.
 */
 
 #include "encoding.h"
+#include "../../utils/sigverifier.h"
 
 namespace P2P {
   RequestID::RequestID(const uint64_t& value) { this->data_ = Utils::uint64ToBytes(value); }
@@ -32,17 +33,49 @@ namespace P2P {
 
   const Bytes& getRequestTypePrefix(const RequestType& type) { return typePrefixes[type]; }
 
+  /**
+   * Start a message in a buffer taken from the pool (see BufferPool).
+   * @param type The request type of the message.
+   * @param size The expected size of the rest of the message (ID, command and data), for reserving.
+   * @return The buffer, holding the request type prefix.
+   */
+  static Bytes newMessage(const RequestType& type, size_t size) {
+    Bytes message = BufferPool::instance().acquire(1 + size);
+    Utils::appendBytes(message, getRequestTypePrefix(type));
+    return message;
+  }
+
+  /**
+   * Set the ID of a broadcast message, which is a hash of its data.
+   * @param message The whole message, with a placeholder ID.
+   */
+  static void setBroadcastId(Bytes& message) {
+    // We need to use FNVHash instead of SafeHash
+    // Because hashing with SafeHash will always be different between nodes
+    BytesArr<8> id = Utils::uint64ToBytes(FNVHash()(BytesArrView(message).subspan(11)));
+    std::memcpy(message.data() + 1, id.data(), 8);
+  }
+
   Message RequestEncoder::ping() {
-    Bytes message = getRequestTypePrefix(Requesting);
-    message.reserve(message.size() + 8 + 2);
+    Bytes message = newMessage(Requesting, 8 + 2);
     Utils::appendBytes(message, Utils::randBytes(8));
     Utils::appendBytes(message, getCommandPrefix(Ping));
     return Message(std::move(message));
   }
 
+  /// Marker in the first 7 bytes of the ID of a capabilities ping (the last one holds the flags).
+  static const BytesArr<7> capabilitiesMarker = {'O', 'R', 'B', 'C', 'A', 'P', 'S'};
+
+  Message RequestEncoder::capabilities(uint8_t flags) {
+    Bytes message = newMessage(Requesting, 8 + 2);
+    Utils::appendBytes(message, capabilitiesMarker);
+    message.push_back(flags);
+    Utils::appendBytes(message, getCommandPrefix(Ping));
+    return Message(std::move(message));
+  }
+
   Message RequestEncoder::info(const std::shared_ptr<const Block>& latestBlock, const Options& options) {
-    Bytes message = getRequestTypePrefix(Requesting);
-    message.reserve(message.size() + 8 + 2 + 8 + 8 + 8 + 32);
+    Bytes message = newMessage(Requesting, 8 + 2 + 8 + 8 + 8 + 32);
     Utils::appendBytes(message, Utils::randBytes(8));
     Utils::appendBytes(message, getCommandPrefix(Info));
     Utils::appendBytes(message, Utils::uint64ToBytes(options.getVersion()));
@@ -56,33 +89,76 @@ namespace P2P {
   }
 
   Message RequestEncoder::requestNodes() {
-    Bytes message = getRequestTypePrefix(Requesting);
-    message.reserve(message.size() + 8 + 2);
+    Bytes message = newMessage(Requesting, 8 + 2);
     Utils::appendBytes(message, Utils::randBytes(8));
     Utils::appendBytes(message, getCommandPrefix(RequestNodes));
     return Message(std::move(message));
   }
 
   Message RequestEncoder::requestValidatorTxs() {
-    Bytes message = getRequestTypePrefix(Requesting);
+    Bytes message = newMessage(Requesting, 8 + 2);
     Utils::appendBytes(message, Utils::randBytes(8));
     Utils::appendBytes(message, getCommandPrefix(RequestValidatorTxs));
     return Message(std::move(message));
   }
 
   Message RequestEncoder::requestTxs() {
-    Bytes message = getRequestTypePrefix(Requesting);
+    Bytes message = newMessage(Requesting, 8 + 2);
     Utils::appendBytes(message, Utils::randBytes(8));
     Utils::appendBytes(message, getCommandPrefix(RequestTxs));
     return Message(std::move(message));
   }
 
+  Message RequestEncoder::requestBlocks(const uint64_t& fromHeight, const uint64_t& count) {
+    Bytes message = newMessage(Requesting, 8 + 2 + 8 + 8);
+    Utils::appendBytes(message, Utils::randBytes(8));
+    Utils::appendBytes(message, getCommandPrefix(RequestBlocks));
+    Utils::appendBytes(message, Utils::uint64ToBytes(fromHeight));
+    Utils::appendBytes(message, Utils::uint64ToBytes(count));
+    return Message(std::move(message));
+  }
+
+  Message RequestEncoder::requestTxInventory(const TxPool& pool, const uint64_t& sinceSequence) {
+    Bytes message = newMessage(Requesting, 8 + 2 + 1 + 8);
+    Utils::appendBytes(message, Utils::randBytes(8));
+    Utils::appendBytes(message, getCommandPrefix(RequestTxInventory));
+    Utils::appendBytes(message, Utils::uint8ToBytes(pool));
+    Utils::appendBytes(message, Utils::uint64ToBytes(sinceSequence));
+    return Message(std::move(message));
+  }
+
+  Message RequestEncoder::requestTxsByHash(const TxPool& pool, const std::vector<Hash>& txHashes) {
+    Bytes message = newMessage(Requesting, 8 + 2 + 1 + (txHashes.size() * 32));
+    Utils::appendBytes(message, Utils::randBytes(8));
+    Utils::appendBytes(message, getCommandPrefix(RequestTxsByHash));
+    Utils::appendBytes(message, Utils::uint8ToBytes(pool));
+    for (const Hash& txHash : txHashes) Utils::appendBytes(message, txHash);
+    return Message(std::move(message));
+  }
+
+  Message RequestEncoder::requestBlockTxs(const Hash& blockHash, const std::vector<uint32_t>& indexes) {
+    Bytes message = newMessage(Requesting, 8 + 2 + 32 + (indexes.size() * 4));
+    Utils::appendBytes(message, Utils::randBytes(8));
+    Utils::appendBytes(message, getCommandPrefix(RequestBlockTxs));
+    Utils::appendBytes(message, blockHash);
+    for (const uint32_t& index : indexes) Utils::appendBytes(message, Utils::uint32ToBytes(index));
+    return Message(std::move(message));
+  }
+
   bool RequestDecoder::ping(const Message& message) {
     if (message.size() != 11) { return false; }
     if (message.command() != Ping) { return false; }
     return true;
   }
 
+  std::optional<uint8_t> RequestDecoder::capabilities(const Message& message) {
+    if (message.size() != 11) { return std::nullopt; }
+    if (message.command() != Ping) { return std::nullopt; }
+    const RequestID id = message.id();
+    if (!std::equal(capabilitiesMarker.begin(), capabilitiesMarker.end(), id.cbegin())) { return std::nullopt; }
+    return id[7];
+  }
+
   NodeInfo RequestDecoder::info(const Message& message) {
     if (message.size() != 67) { throw DynamicException("Invalid Info message size."); }
     if (message.command() != Info) { throw DynamicException("Invalid Info message command."); }
@@ -111,9 +187,47 @@ namespace P2P {
     return true;
   }
 
+  std::pair<uint64_t, uint64_t> RequestDecoder::requestBlocks(const Message& message) {
+    if (message.size() != 27) { throw DynamicException("Invalid RequestBlocks message size."); }
+    if (message.command() != RequestBlocks) { throw DynamicException("Invalid RequestBlocks message command."); }
+    uint64_t fromHeight = Utils::bytesToUint64(message.message().subspan(0, 8));
+    uint64_t count = Utils::bytesToUint64(message.message().subspan(8, 8));
+    return {fromHeight, count};
+  }
+
+  std::pair<TxPool, uint64_t> RequestDecoder::requestTxInventory(const Message& message) {
+    if (message.size() != 20) { throw DynamicException("Invalid RequestTxInventory message size."); }
+    if (message.command() != RequestTxInventory) { throw DynamicException("Invalid RequestTxInventory message command."); }
+    uint8_t pool = Utils::bytesToUint8(message.message().subspan(0, 1));
+    if (pool > ValidatorTxPool) { throw DynamicException("Invalid RequestTxInventory pool."); }
+    return {static_cast<TxPool>(pool), Utils::bytesToUint64(message.message().subspan(1, 8))};
+  }
+
+  std::pair<TxPool, std::vector<Hash>> RequestDecoder::requestTxsByHash(const Message& message) {
+    if (message.size() < 12 || (message.size() - 12) % 32 != 0) { throw DynamicException("Invalid RequestTxsByHash message size."); }
+    if (message.command() != RequestTxsByHash) { throw DynamicException("Invalid RequestTxsByHash message command."); }
+    uint8_t pool = Utils::bytesToUint8(message.message().subspan(0, 1));
+    if (pool > ValidatorTxPool) { throw DynamicException("Invalid RequestTxsByHash pool."); }
+    std::vector<Hash> txHashes;
+    BytesArrView data = message.message().subspan(1);
+    txHashes.reserve(data.size() / 32);
+    for (size_t index = 0; index < data.size(); index += 32) txHashes.emplace_back(data.subspan(index, 32));
+    return {static_cast<TxPool>(pool), std::move(txHashes)};
+  }
+
+  std::pair<Hash, std::vector<uint32_t>> RequestDecoder::requestBlockTxs(const Message& message) {
+    if (message.size() < 43 || (message.size() - 43) % 4 != 0) { throw DynamicException("Invalid RequestBlockTxs message size."); }
+    if (message.command() != RequestBlockTxs) { throw DynamicException("Invalid RequestBlockTxs message command."); }
+    Hash blockHash(message.message().subspan(0, 32));
+    std::vector<uint32_t> indexes;
+    BytesArrView data = message.message().subspan(32);
+    indexes.reserve(data.size() / 4);
+    for (size_t index = 0; index < data.size(); index += 4) indexes.emplace_back(Utils::bytesToUint32(data.subspan(index, 4)));
+    return {blockHash, std::move(indexes)};
+  }
+
   Message AnswerEncoder::ping(const Message& request) {
-    Bytes message = getRequestTypePrefix(Answering);
-    message.reserve(message.size() + 8 + 2);
+    Bytes message = newMessage(Answering, 8 + 2);
     Utils::appendBytes(message, request.id());
     Utils::appendBytes(message, getCommandPrefix(Ping));
     return Message(std::move(message));
@@ -123,8 +237,7 @@ namespace P2P {
     const std::shared_ptr<const Block>& latestBlock,
     const Options& options
   ) {
-    Bytes message = getRequestTypePrefix(Answering);
-    message.reserve(message.size() + 8 + 2 + 8 + 8 + 8 + 32);
+    Bytes message = newMessage(Answering, 8 + 2 + 8 + 8 + 8 + 32);
     Utils::appendBytes(message, request.id());
     Utils::appendBytes(message, getCommandPrefix(Info));
     Utils::appendBytes(message, Utils::uint64ToBytes(options.getVersion()));
@@ -140,7 +253,7 @@ namespace P2P {
   Message AnswerEncoder::requestNodes(const Message& request,
     const std::unordered_map<NodeID, NodeType, SafeHash>& nodes
   ) {
-    Bytes message = getRequestTypePrefix(Answering);
+    Bytes message = newMessage(Answering, 8 + 2);
     Utils::appendBytes(message, request.id());
     Utils::appendBytes(message, getCommandPrefix(RequestNodes));
     for (const auto& [nodeId, nodeType] : nodes) {
@@ -162,7 +275,7 @@ namespace P2P {
   Message AnswerEncoder::requestValidatorTxs(const Message& request,
     const std::unordered_map<Hash, TxValidator, SafeHash>& txs
   ) {
-    Bytes message = getRequestTypePrefix(Answering);
+    Bytes message = newMessage(Answering, 8 + 2);
     Utils::appendBytes(message, request.id());
     Utils::appendBytes(message, getCommandPrefix(RequestValidatorTxs));
     for (const auto& [validatorTxHash, validatorTx] : txs) {
@@ -176,7 +289,7 @@ namespace P2P {
   Message AnswerEncoder::requestTxs(const Message& request,
     const std::unordered_map<Hash, TxBlock, SafeHash>& txs
   ) {
-    Bytes message = getRequestTypePrefix(Answering);
+    Bytes message = newMessage(Answering, 8 + 2);
     Utils::appendBytes(message, request.id());
     Utils::appendBytes(message, getCommandPrefix(RequestTxs));
     for (const auto& [txHash, tx] : txs) {
@@ -187,6 +300,71 @@ namespace P2P {
     return Message(std::move(message));
   }
 
+  Message AnswerEncoder::requestBlocks(const Message& request,
+    const std::vector<std::shared_ptr<const Block>>& blocks, const uint64_t& maxSize
+  ) {
+    Bytes message = newMessage(Answering, 8 + 2);
+    Utils::appendBytes(message, request.id());
+    Utils::appendBytes(message, getCommandPrefix(RequestBlocks));
+    for (const auto& block : blocks) {
+      if (message.size() >= maxSize) break;
+      // Serialize straight into the message, then fill in the size prefix
+      size_t sizeLoc = message.size();
+      message.insert(message.end(), 4, 0x00);
+      block->serializeBlock(message);
+      BytesArr<4> blockSize = Utils::uint32ToBytes(message.size() - sizeLoc - 4);
+      std::memcpy(message.data() + sizeLoc, blockSize.data(), 4);
+    }
+    return Message(std::move(message));
+  }
+
+  Message AnswerEncoder::requestTxInventory(const Message& request,
+    const uint64_t& sequence, const std::vector<Hash>& txHashes
+  ) {
+    Bytes message = newMessage(Answering, 8 + 2 + 8 + (txHashes.size() * 32));
+    Utils::appendBytes(message, request.id());
+    Utils::appendBytes(message, getCommandPrefix(RequestTxInventory));
+    Utils::appendBytes(message, Utils::uint64ToBytes(sequence));
+    for (const Hash& txHash : txHashes) Utils::appendBytes(message, txHash);
+    return Message(std::move(message));
+  }
+
+  Message AnswerEncoder::requestTxsByHash(const Message& request, const std::vector<TxBlock>& txs) {
+    Bytes message = newMessage(Answering, 8 + 2);
+    Utils::appendBytes(message, request.id());
+    Utils::appendBytes(message, getCommandPrefix(RequestTxsByHash));
+    for (const auto& tx : txs) {
+      Bytes rlp = tx.rlpSerialize();
+      Utils::appendBytes(message, Utils::uint32ToBytes(rlp.size()));
+      message.insert(message.end(), rlp.begin(), rlp.end());
+    }
+    return Message(std::move(message));
+  }
+
+  Message AnswerEncoder::requestTxsByHash(const Message& request, const std::vector<TxValidator>& txs) {
+    Bytes message = newMessage(Answering, 8 + 2);
+    Utils::appendBytes(message, request.id());
+    Utils::appendBytes(message, getCommandPrefix(RequestTxsByHash));
+    for (const auto& tx : txs) {
+      Bytes rlp = tx.rlpSerialize();
+      Utils::appendBytes(message, Utils::uint32ToBytes(rlp.size()));
+      message.insert(message.end(), rlp.begin(), rlp.end());
+    }
+    return Message(std::move(message));
+  }
+
+  Message AnswerEncoder::requestBlockTxs(const Message& request, const std::vector<TxBlock>& txs) {
+    Bytes message = newMessage(Answering, 8 + 2);
+    Utils::appendBytes(message, request.id());
+    Utils::appendBytes(message, getCommandPrefix(RequestBlockTxs));
+    for (const auto& tx : txs) {
+      Bytes rlp = tx.rlpSerialize();
+      Utils::appendBytes(message, Utils::uint32ToBytes(rlp.size()));
+      message.insert(message.end(), rlp.begin(), rlp.end());
+    }
+    return Message(std::move(message));
+  }
+
   bool AnswerDecoder::ping(const Message& message) {
     if (message.size() != 11) { return false; }
     if (message.type() != Answering) { return false; }
@@ -243,7 +421,7 @@ namespace P2P {
   ) {
     if (message.type() != Answering) { throw DynamicException("Invalid message type."); }
     if (message.command() != RequestValidatorTxs) { throw DynamicException("Invalid command."); }
-    std::vector<TxValidator> txs;
+    std::vector<BytesArrView> rawTxs;
     BytesArrView data = message.message();
     size_t index = 0;
     while (index < data.size()) {
@@ -251,11 +429,10 @@ namespace P2P {
       uint32_t txSize = Utils::bytesToUint32(data.subspan(index, 4));
       index += 4;
       if (data.size() < txSize) { throw DynamicException("Invalid data size."); }
-      BytesArrView txData = data.subspan(index, txSize);
+      rawTxs.emplace_back(data.subspan(index, txSize));
       index += txSize;
-      txs.emplace_back(txData, requiredChainId);
     }
-    return txs;
+    return SigVerifier::instance().verifyBatch<TxValidator>(rawTxs, requiredChainId);
   }
 
   std::vector<TxBlock> AnswerDecoder::requestTxs(
@@ -263,7 +440,7 @@ namespace P2P {
   ) {
     if (message.type() != Answering) { throw DynamicException("Invalid message type."); }
     if (message.command() != RequestTxs) { throw DynamicException("Invalid command."); }
-    std::vector<TxBlock> txs;
+    std::vector<BytesArrView> rawTxs;
     BytesArrView data = message.message();
     size_t index = 0;
     while (index < data.size()) {
@@ -271,41 +448,129 @@ namespace P2P {
       uint32_t txSize = Utils::bytesToUint32(data.subspan(index, 4));
       index += 4;
       if (data.size() < txSize) { throw DynamicException("Invalid data size."); }
-      BytesArrView txData = data.subspan(index, txSize);
+      rawTxs.emplace_back(data.subspan(index, txSize));
       index += txSize;
-      txs.emplace_back(txData, requiredChainId);
     }
-    return txs;
+    return SigVerifier::instance().verifyBatch<TxBlock>(rawTxs, requiredChainId);
+  }
+
+  std::vector<BytesArrView> AnswerDecoder::requestBlocks(const Message& message) {
+    if (message.type() != Answering) { throw DynamicException("Invalid message type."); }
+    if (message.command() != RequestBlocks) { throw DynamicException("Invalid command."); }
+    std::vector<BytesArrView> blocks;
+    BytesArrView data = message.message();
+    size_t index = 0;
+    while (index < data.size()) {
+      if (data.size() - index < 4) { throw DynamicException("Invalid data size."); }
+      uint32_t blockSize = Utils::bytesToUint32(data.subspan(index, 4));
+      index += 4;
+      if (data.size() - index < blockSize) { throw DynamicException("Invalid data size."); }
+      blocks.emplace_back(data.subspan(index, blockSize));
+      index += blockSize;
+    }
+    return blocks;
+  }
+
+  std::pair<uint64_t, std::vector<Hash>> AnswerDecoder::requestTxInventory(const Message& message) {
+    if (message.type() != Answering) { throw DynamicException("Invalid message type."); }
+    if (message.command() != RequestTxInventory) { throw DynamicException("Invalid command."); }
+    BytesArrView data = message.message();
+    if (data.size() < 8 || (data.size() - 8) % 32 != 0) { throw DynamicException("Invalid data size."); }
+    uint64_t sequence = Utils::bytesToUint64(data.subspan(0, 8));
+    std::vector<Hash> txHashes;
+    txHashes.reserve((data.size() - 8) / 32);
+    for (size_t index = 8; index < data.size(); index += 32) txHashes.emplace_back(data.subspan(index, 32));
+    return {sequence, std::move(txHashes)};
+  }
+
+  /**
+   * Split the length-prefixed transactions of an answer.
+   * @param data The answer data.
+   * @return The serialized transactions.
+   */
+  static std::vector<BytesArrView> splitTxs(const BytesArrView data) {
+    std::vector<BytesArrView> rawTxs;
+    size_t index = 0;
+    while (index < data.size()) {
+      if (data.size() - index < 4) { throw DynamicException("Invalid data size."); }
+      uint32_t txSize = Utils::bytesToUint32(data.subspan(index, 4));
+      index += 4;
+      if (data.size() - index < txSize) { throw DynamicException("Invalid data size."); }
+      rawTxs.emplace_back(data.subspan(index, txSize));
+      index += txSize;
+    }
+    return rawTxs;
+  }
+
+  std::vector<TxBlock> AnswerDecoder::requestTxsByHash(
+    const Message& message, const uint64_t& requiredChainId
+  ) {
+    if (message.type() != Answering) { throw DynamicException("Invalid message type."); }
+    if (message.command() != RequestTxsByHash) { throw DynamicException("Invalid command."); }
+    return SigVerifier::instance().verifyBatch<TxBlock>(splitTxs(message.message()), requiredChainId);
+  }
+
+  std::vector<TxValidator> AnswerDecoder::requestValidatorTxsByHash(
+    const Message& message, const uint64_t& requiredChainId
+  ) {
+    if (message.type() != Answering) { throw DynamicException("Invalid message type."); }
+    if (message.command() != RequestTxsByHash) { throw DynamicException("Invalid command."); }
+    return SigVerifier::instance().verifyBatch<TxValidator>(splitTxs(message.message()), requiredChainId);
+  }
+
+  std::vector<TxBlock> AnswerDecoder::requestBlockTxs(
+    const Message& message, const uint64_t& requiredChainId
+  ) {
+    if (message.type() != Answering) { throw DynamicException("Invalid message type."); }
+    if (message.command() != RequestBlockTxs) { throw DynamicException("Invalid command."); }
+    return SigVerifier::instance().verifyBatch<TxBlock>(splitTxs(message.message()), requiredChainId);
   }
 
   Message BroadcastEncoder::broadcastValidatorTx(const TxValidator& tx) {
-    Bytes message = getRequestTypePrefix(Broadcasting);
-    // We need to use std::hash instead of SafeHash
-    // Because hashing with SafeHash will always be different between nodes
-    Utils::appendBytes(message, Utils::uint64ToBytes(FNVHash()(tx.rlpSerialize())));
+    Bytes message = newMessage(Broadcasting, 8 + 2);
+    message.insert(message.end(), 8, 0x00); // ID, set once the data is in
     Utils::appendBytes(message, getCommandPrefix(BroadcastValidatorTx));
     Utils::appendBytes(message, tx.rlpSerialize());
+    setBroadcastId(message);
     return Message(std::move(message));
   }
 
   Message BroadcastEncoder::broadcastTx(const TxBlock& tx) {
-    Bytes message = getRequestTypePrefix(Broadcasting);
-    // We need to use std::hash instead of SafeHash
-    // Because hashing with SafeHash will always be different between nodes
-    Utils::appendBytes(message, Utils::uint64ToBytes(FNVHash()(tx.rlpSerialize())));
+    Bytes message = newMessage(Broadcasting, 8 + 2);
+    message.insert(message.end(), 8, 0x00); // ID, set once the data is in
     Utils::appendBytes(message, getCommandPrefix(BroadcastTx));
     Utils::appendBytes(message, tx.rlpSerialize());
+    setBroadcastId(message);
     return Message(std::move(message));
   }
 
   Message BroadcastEncoder::broadcastBlock(const std::shared_ptr<const Block>& block) {
-    Bytes message = getRequestTypePrefix(Broadcasting);
-    // We need to use std::hash instead of SafeHash
-    // Because hashing with SafeHash will always be different between nodes
-    Bytes serializedBlock = block->serializeBlock();
-    Utils::appendBytes(message, Utils::uint64ToBytes(FNVHash()(serializedBlock)));
+    Bytes message = newMessage(Broadcasting, 8 + 2);
+    message.insert(message.end(), 8, 0x00); // ID, set once the data is in
     Utils::appendBytes(message, getCommandPrefix(BroadcastBlock));
-    message.insert(message.end(), serializedBlock.begin(), serializedBlock.end());
+    block->serializeBlock(message);
+    setBroadcastId(message);
+    return Message(std::move(message));
+  }
+
+  Message BroadcastEncoder::broadcastCompactBlock(const std::shared_ptr<const Block>& block) {
+    Bytes message = newMessage(Broadcasting, 8 + 2 + 213 + (block->getTxs().size() * 8));
+    message.insert(message.end(), 8, 0x00); // ID, set once the data is in
+    Utils::appendBytes(message, getCommandPrefix(BroadcastCompactBlock));
+    // Signature + header, tx count, short tx IDs, then the Validator txs [4 Bytes + Tx Bytes]
+    message.insert(message.end(), block->getValidatorSig().cbegin(), block->getValidatorSig().cend());
+    Utils::appendBytes(message, block->serializeHeader());
+    Utils::appendBytes(message, Utils::uint32ToBytes(block->getTxs().size()));
+    for (const TxBlock& tx : block->getTxs()) {
+      const Hash& txHash = tx.hash();
+      message.insert(message.end(), txHash.cbegin(), txHash.cbegin() + 8);
+    }
+    for (const TxValidator& tx : block->getTxValidators()) {
+      Bytes rlp = tx.rlpSerialize();
+      Utils::appendBytes(message, Utils::uint32ToBytes(rlp.size()));
+      message.insert(message.end(), rlp.begin(), rlp.end());
+    }
+    setBroadcastId(message);
     return Message(std::move(message));
   }
 
@@ -329,5 +594,24 @@ namespace P2P {
     if (message.command() != BroadcastBlock) { throw DynamicException("Invalid command."); }
     return Block(message.message(), requiredChainId);
   }
-}
 
+  CompactBlock BroadcastDecoder::broadcastCompactBlock(const Message& message, const uint64_t& requiredChainId) {
+    if (message.type() != Broadcasting) { throw DynamicException("Invalid message type."); }
+    if (message.id().toUint64() != FNVHash()(message.message())) { throw DynamicException("Invalid message id."); }
+    if (message.command() != BroadcastCompactBlock) { throw DynamicException("Invalid command."); }
+    BytesArrView data = message.message();
+    if (data.size() < 213) { throw DynamicException("Invalid data size."); }
+    uint64_t txCount = Utils::bytesToUint32(data.subspan(209, 4));
+    if (data.size() - 213 < txCount * 8) { throw DynamicException("Invalid data size."); }
+    CompactBlock compact;
+    compact.header = Bytes(data.begin(), data.begin() + 209);
+    compact.hash = Utils::sha3(data.subspan(65, 144));
+    compact.nHeight = Utils::bytesToUint64(data.subspan(201, 8));
+    compact.shortIds.reserve(txCount);
+    for (uint64_t i = 0; i < txCount; i++) compact.shortIds.emplace_back(Utils::bytesToUint64(data.subspan(213 + (i * 8), 8)));
+    compact.txValidators = SigVerifier::instance().verifyBatch<TxValidator>(
+      splitTxs(data.subspan(213 + (txCount * 8))), requiredChainId
+    );
+    return compact;
+  }
+}
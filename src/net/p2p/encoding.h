@@ -15,6 +15,7 @@ See the LICENSE.txt file in the project root for more information.
 #include "../../utils/tx.h"
 #include "../../utils/block.h"
 #include "../../utils/options.h"
+#include "bufferpool.h"
 
 namespace P2P {
   // Forward declarations.
@@ -46,7 +47,39 @@ namespace P2P {
     BroadcastValidatorTx,
     BroadcastTx,
     BroadcastBlock,
-    RequestTxs
+    RequestTxs,
+    RequestBlocks,
+    RequestTxInventory,
+    RequestTxsByHash,
+    BroadcastCompactBlock,
+    RequestBlockTxs
+  };
+
+  /// Enum for identifying which mempool an inventory request refers to.
+  enum TxPool { BlockTxPool, ValidatorTxPool };
+
+  /**
+   * A block announced with `BroadcastCompactBlock`, before its transactions are resolved.
+   * Block transactions are only referenced by their short IDs (see Mempool::shortId()),
+   * receivers take them from their own mempool and request only the missing ones
+   * with `RequestBlockTxs`. Validator transactions are sent whole.
+   */
+  struct CompactBlock {
+    Bytes header;                          ///< Validator signature followed by the block header (209 bytes).
+    Hash hash;                             ///< Hash of the block.
+    uint64_t nHeight = 0;                  ///< Height of the block.
+    std::vector<uint64_t> shortIds;        ///< Short IDs of the block transactions, in block order.
+    std::vector<TxValidator> txValidators; ///< The Validator transactions, already verified.
+  };
+
+  /**
+   * Blocks received in a `RequestBlocks` answer.
+   * The blocks are views into the answer, which is kept alive along with them
+   * so they can be deserialized without copying them out of it first.
+   */
+  struct BlocksAnswer {
+    std::shared_ptr<const Message> message; ///< The answer holding the blocks.
+    std::vector<BytesArrView> blocks;       ///< The serialized blocks, in height order.
   };
 
   /**
@@ -73,6 +106,11 @@ namespace P2P {
    * - "0005" = BroadcastTx
    * - "0006" = BroadcastBlock
    * - "0007" = RequestTxs
+   * - "0008" = RequestBlocks
+   * - "0009" = RequestTxInventory
+   * - "000A" = RequestTxsByHash
+   * - "000B" = BroadcastCompactBlock
+   * - "000C" = RequestBlockTxs
    */
   inline extern const std::vector<Bytes> commandPrefixes {
     Bytes{0x00, 0x00}, // Ping
@@ -82,7 +120,12 @@ namespace P2P {
     Bytes{0x00, 0x04}, // BroadcastValidatorTx
     Bytes{0x00, 0x05}, // BroadcastTx
     Bytes{0x00, 0x06}, // BroadcastBlock
-    Bytes{0x00, 0x07}  // RequestTxs
+    Bytes{0x00, 0x07}, // RequestTxs
+    Bytes{0x00, 0x08}, // RequestBlocks
+    Bytes{0x00, 0x09}, // RequestTxInventory
+    Bytes{0x00, 0x0A}, // RequestTxsByHash
+    Bytes{0x00, 0x0B}, // BroadcastCompactBlock
+    Bytes{0x00, 0x0C}  // RequestBlockTxs
   };
 
   /**
@@ -180,6 +223,15 @@ namespace P2P {
        */
       static Message ping();
 
+      /**
+       * Create a `Ping` request advertising capability flags (see Session::Capability).
+       * The flags ride in the request ID, the only field older nodes ignore (they
+       * just echo it back), so to them it is a plain ping. See capabilities().
+       * @param flags The capability flags.
+       * @return The formatted request.
+       */
+      static Message capabilities(uint8_t flags);
+
       /**
        * Create a `Info` request.
        * @param latestBlock Pointer to the node's latest block.
@@ -208,6 +260,38 @@ namespace P2P {
        * @return The formatted request.
        */
       static Message requestTxs();
+
+      /**
+       * Create a `RequestBlocks` request.
+       * @param fromHeight Height of the first requested block.
+       * @param count Number of consecutive blocks requested.
+       * @return The formatted request.
+       */
+      static Message requestBlocks(const uint64_t& fromHeight, const uint64_t& count);
+
+      /**
+       * Create a `RequestTxInventory` request.
+       * @param pool The mempool to ask about.
+       * @param sinceSequence The last inventory sequence already known from the node (0 for none).
+       * @return The formatted request.
+       */
+      static Message requestTxInventory(const TxPool& pool, const uint64_t& sinceSequence);
+
+      /**
+       * Create a `RequestTxsByHash` request.
+       * @param pool The mempool to ask from.
+       * @param txHashes The hashes of the wanted transactions.
+       * @return The formatted request.
+       */
+      static Message requestTxsByHash(const TxPool& pool, const std::vector<Hash>& txHashes);
+
+      /**
+       * Create a `RequestBlockTxs` request.
+       * @param blockHash The hash of the block.
+       * @param indexes The positions of the wanted transactions within the block.
+       * @return The formatted request.
+       */
+      static Message requestBlockTxs(const Hash& blockHash, const std::vector<uint32_t>& indexes);
   };
 
   /// Helper class used to parse requests.
@@ -220,6 +304,14 @@ namespace P2P {
        */
       static bool ping(const Message& message);
 
+      /**
+       * Parse the capability flags of a `Ping` made by RequestEncoder::capabilities().
+       * Works on both the request and its answer, which echoes the same ID.
+       * @param message The message to parse.
+       * @return The flags, or `std::nullopt` if the message is not a capabilities ping.
+       */
+      static std::optional<uint8_t> capabilities(const Message& message);
+
       /**
        * Parse a `Info` message.
        * Throws if message is invalid.
@@ -248,6 +340,38 @@ namespace P2P {
        * @return `true` if the message is valid, `false` otherwise.
        */
       static bool requestTxs(const Message& message);
+
+      /**
+       * Parse a `RequestBlocks` message.
+       * Throws if message is invalid.
+       * @param message The message to parse.
+       * @return A pair with the height of the first requested block and the number of blocks.
+       */
+      static std::pair<uint64_t, uint64_t> requestBlocks(const Message& message);
+
+      /**
+       * Parse a `RequestTxInventory` message.
+       * Throws if message is invalid.
+       * @param message The message to parse.
+       * @return A pair with the mempool and the last inventory sequence known by the requester.
+       */
+      static std::pair<TxPool, uint64_t> requestTxInventory(const Message& message);
+
+      /**
+       * Parse a `RequestTxsByHash` message.
+       * Throws if message is invalid.
+       * @param message The message to parse.
+       * @return A pair with the mempool and the hashes of the wanted transactions.
+       */
+      static std::pair<TxPool, std::vector<Hash>> requestTxsByHash(const Message& message);
+
+      /**
+       * Parse a `RequestBlockTxs` message.
+       * Throws if message is invalid.
+       * @param message The message to parse.
+       * @return A pair with the hash of the block and the positions of the wanted transactions.
+       */
+      static std::pair<Hash, std::vector<uint32_t>> requestBlockTxs(const Message& message);
   };
 
   /// Helper class used to create answers to requests.
@@ -301,6 +425,55 @@ namespace P2P {
       static Message requestTxs(const Message& request,
         const std::unordered_map<Hash, TxBlock, SafeHash>& txs
       );
+
+      /**
+       * Create a `RequestBlocks` answer.
+       * Blocks are serialized straight into the answer, until it reaches `maxSize`
+       * (the block that crosses it is still sent).
+       * @param request The request message.
+       * @param blocks The consecutive blocks to send, starting at the requested
+       *               height (may be fewer than requested, or none).
+       * @param maxSize Soft cap for the size of the answer, in bytes.
+       * @return The formatted answer.
+       */
+      static Message requestBlocks(const Message& request,
+        const std::vector<std::shared_ptr<const Block>>& blocks, const uint64_t& maxSize
+      );
+
+      /**
+       * Create a `RequestTxInventory` answer.
+       * @param request The request message.
+       * @param sequence The inventory sequence the requester should ask from next time.
+       * @param txHashes The hashes being announced.
+       * @return The formatted answer.
+       */
+      static Message requestTxInventory(const Message& request,
+        const uint64_t& sequence, const std::vector<Hash>& txHashes
+      );
+
+      /**
+       * Create a `RequestTxsByHash` answer.
+       * @param request The request message.
+       * @param txs The requested transactions that were found.
+       * @return The formatted answer.
+       */
+      static Message requestTxsByHash(const Message& request, const std::vector<TxBlock>& txs);
+
+      /**
+       * Create a `RequestTxsByHash` answer for Validator transactions.
+       * @param request The request message.
+       * @param txs The requested transactions that were found.
+       * @return The formatted answer.
+       */
+      static Message requestTxsByHash(const Message& request, const std::vector<TxValidator>& txs);
+
+      /**
+       * Create a `RequestBlockTxs` answer.
+       * @param request The request message.
+       * @param txs The requested transactions, in the requested order (none if the block is unknown).
+       * @return The formatted answer.
+       */
+      static Message requestBlockTxs(const Message& request, const std::vector<TxBlock>& txs);
   };
 
   /// Helper class used to parse answers to requests.
@@ -348,6 +521,53 @@ namespace P2P {
       static std::vector<TxBlock> requestTxs(
         const Message& message, const uint64_t& requiredChainId
       );
+
+      /**
+       * Parse a `RequestBlocks` answer.
+       * Blocks are returned still serialized so their deserialization (and signature
+       * checking) can be done by the caller, off the networking threads.
+       * @param message The answer to parse.
+       * @return A list of views of the serialized blocks, in the order they were sent.
+       *         Only valid while the message is alive.
+       */
+      static std::vector<BytesArrView> requestBlocks(const Message& message);
+
+      /**
+       * Parse a `RequestTxInventory` answer.
+       * @param message The answer to parse.
+       * @return A pair with the sequence to ask from next time and the announced hashes.
+       */
+      static std::pair<uint64_t, std::vector<Hash>> requestTxInventory(const Message& message);
+
+      /**
+       * Parse a `RequestTxsByHash` answer.
+       * @param message The answer to parse.
+       * @param requiredChainId The chain ID to use as reference.
+       * @return A list of requested transactions.
+       */
+      static std::vector<TxBlock> requestTxsByHash(
+        const Message& message, const uint64_t& requiredChainId
+      );
+
+      /**
+       * Parse a `RequestTxsByHash` answer for Validator transactions.
+       * @param message The answer to parse.
+       * @param requiredChainId The chain ID to use as reference.
+       * @return A list of requested Validator transactions.
+       */
+      static std::vector<TxValidator> requestValidatorTxsByHash(
+        const Message& message, const uint64_t& requiredChainId
+      );
+
+      /**
+       * Parse a `RequestBlockTxs` answer.
+       * @param message The answer to parse.
+       * @param requiredChainId The chain ID to use as reference.
+       * @return A list of requested transactions, in the requested order.
+       */
+      static std::vector<TxBlock> requestBlockTxs(
+        const Message& message, const uint64_t& requiredChainId
+      );
   };
 
   /// Helper class used to create broadcast messages.
@@ -373,6 +593,13 @@ namespace P2P {
        * @return The formatted message.
        */
       static Message broadcastBlock(const std::shared_ptr<const Block>& block);
+
+      /**
+       * Create a message to broadcast a block in compact form (see CompactBlock).
+       * @param block The block to broadcast.
+       * @return The formatted message.
+       */
+      static Message broadcastCompactBlock(const std::shared_ptr<const Block>& block);
   };
 
   /// Helper class used to parse broadcast messages.
@@ -401,6 +628,16 @@ namespace P2P {
        * @return The build block object.
        */
       static Block broadcastBlock(const Message& message, const uint64_t& requiredChainId);
+
+      /**
+       * Parse a broadcasted message for a compact block.
+       * Only the Validator transactions are verified, the block itself is
+       * checked once it is rebuilt (see Block's constructor from parts).
+       * @param message The message that was broadcast.
+       * @param requiredChainId The chain ID to use as reference.
+       * @return The parsed compact block.
+       */
+      static CompactBlock broadcastCompactBlock(const Message& message, const uint64_t& requiredChainId);
   };
 
   /**
@@ -418,6 +655,7 @@ namespace P2P {
       /// The internal message data to be read/written, stored as bytes.
       /// Sessions has directly access to it
       /// As it can use the vector for its buffer.
+      /// Taken from the BufferPool and given back to it on destruction.
       Bytes rawMessage_;
 
       /// Raw string move constructor. Throws on invalid size.
@@ -440,6 +678,9 @@ namespace P2P {
       /// Move constructor.
       Message(Message&& message) { this->rawMessage_ = std::move(message.rawMessage_); }
 
+      /// Destructor. Gives the buffer back to the pool.
+      ~Message() { BufferPool::instance().release(std::move(this->rawMessage_)); }
+
       /// Get the request type of the message.
       RequestType type() const { return getRequestType(BytesArrView(rawMessage_).subspan(0,1)); }
 
@@ -20,11 +20,11 @@ namespace P2P {
     // The other endpoint will also see that we already have a connection and will close the new one.
     if (sessions_.contains(session->hostNodeId())) {
       lockSession.unlock(); // Unlock before calling logToDebug to avoid waiting for the lock in the logToDebug function.
-      Logger::logToDebug(LogType::ERROR, Log::P2PManager, __func__, "Session already exists at " +
+      LOGERROR(Log::P2PManager, "Session already exists at " +
                         session->hostNodeId().first.to_string() + ":" + std::to_string(session->hostNodeId().second));
       return false;
     }
-    Logger::logToDebug(LogType::INFO, Log::P2PManager, __func__, "Registering session at " +
+    LOGINFO(Log::P2PManager, "Registering session at " +
                       session->hostNodeId().first.to_string() + ":" + std::to_string(session->hostNodeId().second));
     sessions_.insert({session->hostNodeId(), session});
     return true;
@@ -37,7 +37,7 @@ namespace P2P {
     }
     if (!sessions_.contains(session->hostNodeId())) {
       lockSession.unlock(); // Unlock before calling logToDebug to avoid waiting for the lock in the logToDebug function.
-      Logger::logToDebug(LogType::ERROR, Log::P2PManager, __func__, "Session does not exist at " +
+      LOGERROR(Log::P2PManager, "Session does not exist at " +
                         session->hostNodeId().first.to_string() + ":" + std::to_string(session->hostNodeId().second));
       return false;
     }
@@ -52,10 +52,10 @@ namespace P2P {
     }
     if (!sessions_.contains(nodeId)) {
       lockSession.unlock(); // Unlock before calling logToDebug to avoid waiting for the lock in the logToDebug function.
-      Logger::logToDebug(LogType::ERROR, Log::P2PManager, __func__, "Session does not exist at " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second));
+      LOGERROR(Log::P2PManager, "Session does not exist at " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second));
       return false;
     }
-    Logger::logToDebug(LogType::INFO, Log::P2PManager, __func__, "Disconnecting session at " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second));
+    LOGINFO(Log::P2PManager, "Disconnecting session at " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second));
     // Get a copy of the pointer
     sessions_[nodeId]->close();
     sessions_.erase(nodeId);
@@ -67,7 +67,7 @@ namespace P2P {
     std::shared_lock<std::shared_mutex> lockSession(this->sessionsMutex_); // ManagerBase::sendRequestTo doesn't change sessions_ map.
     if(!sessions_.contains(nodeId)) {
       lockSession.unlock(); // Unlock before calling logToDebug to avoid waiting for the lock in the logToDebug function.
-      Logger::logToDebug(LogType::ERROR, Log::P2PManager, __func__, "Session does not exist at " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second));
+      LOGERROR(Log::P2PManager, "Session does not exist at " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second));
       return nullptr;
     }
     auto session = sessions_[nodeId];
@@ -76,7 +76,7 @@ namespace P2P {
       (message->command() == CommandType::Info || message->command() == CommandType::RequestValidatorTxs)
     ) {
       lockSession.unlock(); // Unlock before calling logToDebug to avoid waiting for the lock in the logToDebug function.
-      Logger::logToDebug(LogType::INFO, Log::P2PManager, __func__, "Session is discovery, cannot send message");
+      LOGINFO(Log::P2PManager, "Session is discovery, cannot send message");
       return nullptr;
     }
     std::unique_lock lockRequests(this->requestsMutex_);
@@ -92,7 +92,7 @@ namespace P2P {
     if (!this->started_) return;
     auto it = sessions_.find(nodeId);
     if (it == sessions_.end()) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PManager, __func__, "Cannot find session for " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second));
+      LOGERROR(Log::P2PManager, "Cannot find session for " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second));
       return;
     }
     it->second->write(message);
@@ -102,6 +102,7 @@ namespace P2P {
     std::scoped_lock lock(this->stateMutex_);
     if (this->started_) return;
     this->started_ = true;
+    this->fetchPool_ = std::make_unique<BS::thread_pool_light>(2);
     this->threadPool_ = std::make_unique<BS::thread_pool_light>(4);
     this->server_.start();
     this->clientfactory_.start();
@@ -122,6 +123,7 @@ namespace P2P {
     this->server_.stop();
     this->clientfactory_.stop();
     this->threadPool_.reset();
+    this->fetchPool_.reset();
   }
 
   void ManagerBase::asyncHandleMessage(const NodeID &nodeId, const std::shared_ptr<const Message> message) {
@@ -145,6 +147,20 @@ namespace P2P {
     return nodes;
   }
 
+  std::optional<Session::Traffic> ManagerBase::getSessionTraffic(const NodeID& nodeId) const {
+    std::shared_lock<std::shared_mutex> lock(this->sessionsMutex_);
+    auto it = this->sessions_.find(nodeId);
+    if (it == this->sessions_.end()) return std::nullopt;
+    return it->second->traffic();
+  }
+
+  Session::Traffic ManagerBase::getTraffic() const {
+    Session::Traffic traffic;
+    std::shared_lock<std::shared_mutex> lock(this->sessionsMutex_);
+    for (const auto& [nodeId, session] : this->sessions_) traffic += session->traffic();
+    return traffic;
+  }
+
   bool ManagerBase::registerSession(const std::shared_ptr<Session> &session) {
     return this->registerSessionInternal(session);
   }
@@ -169,7 +185,7 @@ namespace P2P {
 
   void ManagerBase::ping(const NodeID& nodeId) {
     auto request = std::make_shared<const Message>(RequestEncoder::ping());
-    Utils::logToFile("Pinging " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second));
+    LOGDEBUG(Log::P2PManager, "Pinging " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second));
     auto requestPtr = sendRequestTo(nodeId, request);
     if (requestPtr == nullptr) throw DynamicException(
       "Failed to send ping to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second)
@@ -181,23 +197,23 @@ namespace P2P {
   // Somehow change to wait_for.
   std::unordered_map<NodeID, NodeType, SafeHash> ManagerBase::requestNodes(const NodeID& nodeId) {
     auto request = std::make_shared<const Message>(RequestEncoder::requestNodes());
-    Utils::logToFile("Requesting nodes from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second));
+    LOGDEBUG(Log::P2PManager, "Requesting nodes from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second));
     auto requestPtr = sendRequestTo(nodeId, request);
     if (requestPtr == nullptr) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__, "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " failed.");
+      LOGERROR(Log::P2PParser, "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " failed.");
       return {};
     }
     auto answer = requestPtr->answerFuture();
     auto status = answer.wait_for(std::chrono::seconds(2));
     if (status == std::future_status::timeout) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__, "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " timed out.");
+      LOGERROR(Log::P2PParser, "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " timed out.");
       return {};
     }
     try {
       auto answerPtr = answer.get();
       return AnswerDecoder::requestNodes(*answerPtr);
     } catch (std::exception &e) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+      LOGERROR(Log::P2PParser,
         "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " failed with error: " + e.what()
       );
       return {};
@@ -8,6 +8,8 @@ See the LICENSE.txt file in the project root for more information.
 #ifndef P2P_MANAGER_BASE
 #define P2P_MANAGER_BASE
 
+#include <optional>
+
 #include "session.h"
 #include "encoding.h"
 #include "server.h"
@@ -30,6 +32,8 @@ namespace P2P {
       std::atomic<bool> started_ = false; ///< Check if manager is in the start() state (stop() not called yet).
       std::atomic<bool> closed_ = true; ///< Indicates whether the manager is closed to new connections.
       std::unique_ptr<BS::thread_pool_light> threadPool_; ///< Pointer to the thread pool.
+      /// Pointer to the thread pool for handler work that waits on peers (see asyncFetch()).
+      std::unique_ptr<BS::thread_pool_light> fetchPool_;
       const Options& options_; /// Reference to the options singleton.
       mutable std::shared_mutex stateMutex_; ///< Mutex for serializing start(), stop(), and threadPool_.
       mutable std::shared_mutex sessionsMutex_; ///< Mutex for managing read/write access to the sessions list.
@@ -69,6 +73,17 @@ namespace P2P {
        */
       void answerSession(const NodeID &nodeId, const std::shared_ptr<const Message>& message);
 
+      /**
+       * Run part of a handler that waits for answers from peers on a separate pool.
+       * Answers are handled by `threadPool_` itself, so waiting for them there could
+       * leave no thread free to deliver them. Must only be called from a handler.
+       * @param task The work to run.
+       */
+      template <typename F> void asyncFetch(F&& task) {
+        // stop() only drops fetchPool_ once no handler is running, so no lock is needed
+        if (this->fetchPool_) this->fetchPool_->push_task(std::forward<F>(task));
+      }
+
       // TODO: There is a bug with handleRequest that throws std::system_error.
       // I believe that this is related with the std::shared_ptr<Session> getting deleted or
       // the session itself being disconnected.
@@ -126,6 +141,16 @@ namespace P2P {
       /// Get the current Session ID's for the given NodeType.
       std::vector<NodeID> getSessionsIDs(const NodeType& nodeType) const;
 
+      /**
+       * Get the traffic that went through a session.
+       * @param nodeId The ID of the session's node.
+       * @return The session's traffic, or `std::nullopt` if there is no such session.
+       */
+      std::optional<Session::Traffic> getSessionTraffic(const NodeID& nodeId) const;
+
+      /// Get the traffic of every current session, added up.
+      Session::Traffic getTraffic() const;
+
       ///@{
       /** Getter. */
       unsigned int serverPort() const { return this->serverPort_; }
@@ -20,7 +20,7 @@ namespace P2P {
         handleAnswer(nodeId, message);
         break;
       default:
-        Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+        LOGERROR(Log::P2PParser,
                            "Invalid message type from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
                            " closing session.");
         this->disconnectSession(nodeId);
@@ -39,7 +39,7 @@ namespace P2P {
         handleRequestNodesRequest(nodeId, message);
         break;
       default:
-        Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+        LOGERROR(Log::P2PParser,
                            "Invalid Request Command Type from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
                            ", closing session.");
         this->disconnectSession(nodeId);
@@ -60,7 +60,7 @@ namespace P2P {
         handleRequestNodesAnswer(nodeId, message);
         break;
       default:
-        Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+        LOGERROR(Log::P2PParser,
                            "Invalid Answer Command Type from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
                            ", closing session.");
         this->disconnectSession(nodeId);
@@ -72,7 +72,7 @@ namespace P2P {
     const NodeID &nodeId, const std::shared_ptr<const Message>& message
   ) {
     if (!RequestDecoder::ping(*message)) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+      LOGERROR(Log::P2PParser,
                          "Invalid ping request from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
                          " closing session.");
       this->disconnectSession(nodeId);
@@ -85,7 +85,7 @@ namespace P2P {
     const NodeID &nodeId, const std::shared_ptr<const Message>& message
   ) {
     if (!RequestDecoder::requestNodes(*message)) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+      LOGERROR(Log::P2PParser,
                          "Invalid requestNodes request from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " closing session.");
       this->disconnectSession(nodeId);
       return;
@@ -110,7 +110,7 @@ namespace P2P {
     std::unique_lock lock(this->requestsMutex_);
     if (!requests_.contains(message->id())) {
       lock.unlock(); // Unlock before calling logToDebug to avoid waiting for the lock in the logToDebug function.
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+      LOGERROR(Log::P2PParser,
                          "Answer to invalid request from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
                          " closing session.");
       this->disconnectSession(nodeId);
@@ -125,7 +125,7 @@ namespace P2P {
     std::unique_lock lock(this->requestsMutex_);
     if (!requests_.contains(message->id())) {
       lock.unlock(); // Unlock before calling logToDebug to avoid waiting for the lock in the logToDebug function.
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+      LOGERROR(Log::P2PParser,
                          "Answer to invalid request from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
                          " closing session.");
       this->disconnectSession(nodeId);
@@ -13,21 +13,19 @@ See the LICENSE.txt file in the project root for more information.
 namespace P2P{
   void ManagerNormal::broadcastMessage(const std::shared_ptr<const Message> message) {
     if (!this->started_) return;
-    {
-      std::unique_lock broadcastLock(this->broadcastMutex_);
-      if (broadcastedMessages_[message->id().toUint64()] > 0) {
-        broadcastLock.unlock(); // Unlock before calling logToDebug to avoid waiting for the lock in the logToDebug function.
-        Logger::logToDebug(LogType::DEBUG, Log::P2PManager, __func__,
-          "Message " + message->id().hex().get() + " already broadcasted, skipping."
-        );
-        return;
-      } else {
-        broadcastedMessages_[message->id().toUint64()]++;
-      }
+    if (!this->seenMessages_.insert(message->id().toUint64())) {
+      LOGDEBUG(Log::P2PManager,
+        "Message " + message->id().hex().get() + " already broadcasted, skipping."
+      );
+      return;
     }
-    // ManagerNormal::broadcastMessage doesn't change sessions_ map
+    this->relayMessage(message);
+  }
+
+  void ManagerNormal::relayMessage(const std::shared_ptr<const Message>& message) {
+    // ManagerNormal::relayMessage doesn't change sessions_ map
     std::shared_lock sessionsLock(this->sessionsMutex_);
-    Logger::logToDebug(LogType::INFO, Log::P2PManager, __func__,
+    LOGINFO(Log::P2PManager,
       "Broadcasting message " + message->id().hex().get() + " to all nodes. "
     );
     for (const auto& [nodeId, session] : this->sessions_) {
@@ -50,7 +48,7 @@ namespace P2P{
         handleBroadcast(nodeId, message);
         break;
       default:
-        Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+        LOGERROR(Log::P2PParser,
                            "Invalid message type from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " , closing session.");
         this->disconnectSession(nodeId);
         break;
@@ -76,8 +74,20 @@ namespace P2P{
       case RequestTxs:
         handleTxRequest(nodeId, message);
         break;
+      case RequestBlocks:
+        handleBlocksRequest(nodeId, message);
+        break;
+      case RequestTxInventory:
+        handleTxInventoryRequest(nodeId, message);
+        break;
+      case RequestTxsByHash:
+        handleTxsByHashRequest(nodeId, message);
+        break;
+      case RequestBlockTxs:
+        handleBlockTxsRequest(nodeId, message);
+        break;
       default:
-        Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+        LOGERROR(Log::P2PParser,
                            "Invalid Request Command Type: " + std::to_string(message->command()) +
                            " from: " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
                            ", closing session.");
@@ -105,8 +115,18 @@ namespace P2P{
       case RequestTxs:
         handleTxAnswer(nodeId, message);
         break;
+      case RequestBlocks:
+        handleBlocksAnswer(nodeId, message);
+        break;
+      case RequestTxInventory:
+      case RequestTxsByHash:
+        handleTxInventoryAnswer(nodeId, message);
+        break;
+      case RequestBlockTxs:
+        handleBlockTxsAnswer(nodeId, message);
+        break;
       default:
-        Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+        LOGERROR(Log::P2PParser,
                            "Invalid Answer Command Type: " + std::to_string(message->command()) +
                            " from: " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
                            " , closing session.");
@@ -119,20 +139,15 @@ namespace P2P{
     const NodeID &nodeId, const std::shared_ptr<const Message>& message
   ) {
     if (!this->started_) return;
-    {
-      std::shared_lock broadcastLock(this->broadcastMutex_);
-      auto it = broadcastedMessages_.find(message->id().toUint64());
-      if (it != broadcastedMessages_.end() && it->second > 0) {
-        if (it->second == 1) {
-          broadcastLock.unlock(); // Unlock before calling logToDebug to avoid waiting for the lock in the logToDebug function.
-          Logger::logToDebug(LogType::DEBUG, Log::P2PManager, __func__,
-            "Already broadcasted message " + message->id().hex().get() +
-            " to all nodes. Skipping broadcast."
-          );
-          ++it->second;
-        }
-        return;
+    uint64_t duplicates = this->seenMessages_.duplicate(message->id().toUint64(), message->command());
+    if (duplicates > 0) {
+      if (duplicates == 1) {
+        LOGDEBUG(Log::P2PManager,
+          "Already broadcasted message " + message->id().hex().get() +
+          " to all nodes. Skipping broadcast."
+        );
       }
+      return;
     }
     switch (message->command()) {
       case BroadcastValidatorTx:
@@ -144,8 +159,11 @@ namespace P2P{
       case BroadcastBlock:
         handleBlockBroadcast(nodeId, message);
         break;
+      case BroadcastCompactBlock:
+        handleCompactBlockBroadcast(nodeId, message);
+        break;
       default:
-        Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+        LOGERROR(Log::P2PParser,
                            "Invalid Broadcast Command Type: " + std::to_string(message->command()) +
                            " from: " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
                            " , closing session.");
@@ -158,7 +176,7 @@ namespace P2P{
     const NodeID &nodeId, const std::shared_ptr<const Message>& message
   ) {
     if (!RequestDecoder::ping(*message)) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+      LOGERROR(Log::P2PParser,
                          "Invalid ping request from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
                          " , closing session.");
       this->disconnectSession(nodeId);
@@ -180,7 +198,7 @@ namespace P2P{
       const NodeID &nodeId, const std::shared_ptr<const Message>& message
   ) {
     if (!RequestDecoder::requestNodes(*message)) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+      LOGERROR(Log::P2PParser,
                          "Invalid requestNodes request from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
                          " , closing session.");
       this->disconnectSession(nodeId);
@@ -204,7 +222,7 @@ namespace P2P{
     const NodeID &nodeId, const std::shared_ptr<const Message>& message
   ) {
     if (!RequestDecoder::requestValidatorTxs(*message)) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+      LOGERROR(Log::P2PParser,
                          "Invalid requestValidatorTxs request from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
                          " , closing session.");
       this->disconnectSession(nodeId);
@@ -217,7 +235,7 @@ namespace P2P{
     const NodeID &nodeId, const std::shared_ptr<const Message>& message
   ) {
     if (!RequestDecoder::requestTxs(*message)) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+      LOGERROR(Log::P2PParser,
                          "Invalid requestTxs request from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
                          " , closing session.");
       this->disconnectSession(nodeId);
@@ -226,13 +244,125 @@ namespace P2P{
     this->answerSession(nodeId, std::make_shared<const Message>(AnswerEncoder::requestTxs(*message, this->state_.getMempool())));
   }
 
+  void ManagerNormal::handleBlocksRequest(
+    const NodeID &nodeId, const std::shared_ptr<const Message>& message
+  ) {
+    uint64_t fromHeight;
+    uint64_t count;
+    try {
+      std::tie(fromHeight, count) = RequestDecoder::requestBlocks(*message);
+    } catch (std::exception &e) {
+      LOGERROR(Log::P2PParser,
+                         "Invalid requestBlocks request from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
+                         " , error: " + e.what() + " closing session.");
+      this->disconnectSession(nodeId);
+      return;
+    }
+    // Answer with as many consecutive blocks as we have, within the caps
+    count = std::min(count, ManagerNormal::maxBlocksPerAnswer_);
+    std::vector<std::shared_ptr<const Block>> blocks;
+    for (uint64_t height = fromHeight; height - fromHeight < count; height++) {
+      auto block = this->storage_.getBlock(height);
+      if (block == nullptr) break;
+      blocks.emplace_back(std::move(block));
+    }
+    this->answerSession(nodeId, std::make_shared<const Message>(
+      AnswerEncoder::requestBlocks(*message, blocks, ManagerNormal::maxBlocksAnswerBytes_)
+    ));
+  }
+
+  void ManagerNormal::handleTxInventoryRequest(
+    const NodeID &nodeId, const std::shared_ptr<const Message>& message
+  ) {
+    TxPool pool;
+    uint64_t sinceSequence;
+    try {
+      std::tie(pool, sinceSequence) = RequestDecoder::requestTxInventory(*message);
+    } catch (std::exception &e) {
+      LOGERROR(Log::P2PParser,
+                         "Invalid requestTxInventory request from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
+                         " , error: " + e.what() + " closing session.");
+      this->disconnectSession(nodeId);
+      return;
+    }
+    const TxInventory& inventory = (pool == BlockTxPool) ? this->state_.getTxInventory() : this->state_.getValidatorTxInventory();
+    TxInventory::Delta delta = inventory.since(sinceSequence, ManagerNormal::maxInventoryHashes_);
+    if (!delta.complete) {
+      // The peer is new, too far behind, or we restarted: announce everything we have
+      delta.hashes = (pool == BlockTxPool) ? this->state_.getMempoolHashes() : this->state_.rdposGetMempoolHashes();
+    }
+    {
+      // Don't announce what the peer already has
+      std::unique_lock lock(this->peerTxsMutex_);
+      const auto& known = this->getPeerTxs(nodeId).known;
+      std::erase_if(delta.hashes, [&](const Hash& txHash) { return known.contains(txHash); });
+    }
+    this->answerSession(nodeId, std::make_shared<const Message>(
+      AnswerEncoder::requestTxInventory(*message, delta.sequence, delta.hashes)
+    ));
+  }
+
+  void ManagerNormal::handleTxsByHashRequest(
+    const NodeID &nodeId, const std::shared_ptr<const Message>& message
+  ) {
+    TxPool pool;
+    std::vector<Hash> txHashes;
+    try {
+      std::tie(pool, txHashes) = RequestDecoder::requestTxsByHash(*message);
+      if (txHashes.size() > ManagerNormal::maxTxsByHash_) throw DynamicException("Too many hashes requested.");
+    } catch (std::exception &e) {
+      LOGERROR(Log::P2PParser,
+                         "Invalid requestTxsByHash request from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
+                         " , error: " + e.what() + " closing session.");
+      this->disconnectSession(nodeId);
+      return;
+    }
+    this->markKnownTxs(nodeId, txHashes);
+    if (pool == BlockTxPool) {
+      this->answerSession(nodeId, std::make_shared<const Message>(
+        AnswerEncoder::requestTxsByHash(*message, this->state_.getMempoolTxs(txHashes))
+      ));
+    } else {
+      this->answerSession(nodeId, std::make_shared<const Message>(
+        AnswerEncoder::requestTxsByHash(*message, this->state_.rdposGetMempoolTxs(txHashes))
+      ));
+    }
+  }
+
+  void ManagerNormal::handleBlockTxsRequest(
+    const NodeID &nodeId, const std::shared_ptr<const Message>& message
+  ) {
+    Hash blockHash;
+    std::vector<uint32_t> indexes;
+    try {
+      std::tie(blockHash, indexes) = RequestDecoder::requestBlockTxs(*message);
+      if (indexes.size() > ManagerNormal::maxBlockTxsRequested_) throw DynamicException("Too many transactions requested.");
+    } catch (std::exception &e) {
+      LOGERROR(Log::P2PParser,
+                         "Invalid requestBlockTxs request from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
+                         " , error: " + e.what() + " closing session.");
+      this->disconnectSession(nodeId);
+      return;
+    }
+    // Answer with nothing if we don't know the block or an index is out of range
+    std::vector<TxBlock> txs;
+    auto block = this->storage_.getBlock(blockHash);
+    if (block != nullptr && std::all_of(indexes.begin(), indexes.end(),
+      [&](const uint32_t& index) { return index < block->getTxs().size(); }
+    )) {
+      txs.reserve(indexes.size());
+      for (const uint32_t& index : indexes) txs.emplace_back(block->getTxs()[index]);
+    }
+    this->answerSession(nodeId, std::make_shared<const Message>(AnswerEncoder::requestBlockTxs(*message, txs)));
+  }
+
   void ManagerNormal::handlePingAnswer(
     const NodeID &nodeId, const std::shared_ptr<const Message>& message
   ) {
     std::unique_lock lock(this->requestsMutex_);
     if (!requests_.contains(message->id())) {
       lock.unlock(); // Unlock before doing anything else to avoid waiting for other locks.
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+      LOGERROR(Log::P2PParser,
                          "Answer to invalid request from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
                          " , closing session.");
       this->disconnectSession(nodeId);
@@ -246,8 +376,8 @@ namespace P2P{
   ) {
     std::unique_lock lock(this->requestsMutex_);
     if (!requests_.contains(message->id())) {
-      lock.unlock(); // Unlock before calling logToDebug to avoid waiting for the lock in the logToDebug function.
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+      lock.unlock(); // Unlock before logging, so the log write doesn't happen under the lock.
+      LOGERROR(Log::P2PParser,
                          "Answer to invalid request from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
                          " , closing session.");
       this->disconnectSession(nodeId);
@@ -261,8 +391,8 @@ namespace P2P{
   ) {
     std::unique_lock lock(this->requestsMutex_);
     if (!requests_.contains(message->id())) {
-      lock.unlock(); // Unlock before calling logToDebug to avoid waiting for the lock in the logToDebug function.
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+      lock.unlock(); // Unlock before logging, so the log write doesn't happen under the lock.
+      LOGERROR(Log::P2PParser,
                          "Answer to invalid request from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
                          " , closing session.");
       this->disconnectSession(nodeId);
@@ -276,8 +406,8 @@ namespace P2P{
   ) {
     std::unique_lock lock(this->requestsMutex_);
     if (!requests_.contains(message->id())) {
-      lock.unlock(); // Unlock before calling logToDebug to avoid waiting for the lock in the logToDebug function.
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+      lock.unlock(); // Unlock before logging, so the log write doesn't happen under the lock.
+      LOGERROR(Log::P2PParser,
                          "Answer to invalid request from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
                          " , closing session.");
       this->disconnectSession(nodeId);
@@ -291,8 +421,53 @@ namespace P2P{
   ) {
     std::unique_lock lock(this->requestsMutex_);
     if (!requests_.contains(message->id())) {
-      lock.unlock(); // Unlock before calling logToDebug to avoid waiting for the lock in the logToDebug function.
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+      lock.unlock(); // Unlock before logging, so the log write doesn't happen under the lock.
+      LOGERROR(Log::P2PParser,
+                         "Answer to invalid request from " + nodeId.first.to_string() + ":" +
+                         std::to_string(nodeId.second) + " , closing session.");
+      this->disconnectSession(nodeId);
+      return;
+    }
+    requests_[message->id()]->setAnswer(message);
+  }
+
+  void ManagerNormal::handleBlocksAnswer(
+    const NodeID &nodeId, const std::shared_ptr<const Message>& message
+  ) {
+    std::unique_lock lock(this->requestsMutex_);
+    if (!requests_.contains(message->id())) {
+      lock.unlock(); // Unlock before logging, so the log write doesn't happen under the lock.
+      LOGERROR(Log::P2PParser,
+                         "Answer to invalid request from " + nodeId.first.to_string() + ":" +
+                         std::to_string(nodeId.second) + " , closing session.");
+      this->disconnectSession(nodeId);
+      return;
+    }
+    requests_[message->id()]->setAnswer(message);
+  }
+
+  void ManagerNormal::handleTxInventoryAnswer(
+    const NodeID &nodeId, const std::shared_ptr<const Message>& message
+  ) {
+    std::unique_lock lock(this->requestsMutex_);
+    if (!requests_.contains(message->id())) {
+      lock.unlock(); // Unlock before logging, so the log write doesn't happen under the lock.
+      LOGERROR(Log::P2PParser,
+                         "Answer to invalid request from " + nodeId.first.to_string() + ":" +
+                         std::to_string(nodeId.second) + " , closing session.");
+      this->disconnectSession(nodeId);
+      return;
+    }
+    requests_[message->id()]->setAnswer(message);
+  }
+
+  void ManagerNormal::handleBlockTxsAnswer(
+    const NodeID &nodeId, const std::shared_ptr<const Message>& message
+  ) {
+    std::unique_lock lock(this->requestsMutex_);
+    if (!requests_.contains(message->id())) {
+      lock.unlock(); // Unlock before logging, so the log write doesn't happen under the lock.
+      LOGERROR(Log::P2PParser,
                          "Answer to invalid request from " + nodeId.first.to_string() + ":" +
                          std::to_string(nodeId.second) + " , closing session.");
       this->disconnectSession(nodeId);
@@ -306,9 +481,10 @@ namespace P2P{
   ) {
     try {
       auto tx = BroadcastDecoder::broadcastValidatorTx(*message, this->options_.getChainID());
+      this->markKnownTxs(nodeId, {tx.hash()});
       if (this->state_.addValidatorTx(tx)) this->broadcastMessage(message);
     } catch (std::exception &e) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+      LOGERROR(Log::P2PParser,
                          "Invalid txValidatorBroadcast from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
                          " , error: " + e.what() + " closing session.");
       this->disconnectSession(nodeId);
@@ -320,9 +496,10 @@ namespace P2P{
   ) {
     try {
       auto tx = BroadcastDecoder::broadcastTx(*message, this->options_.getChainID());
+      this->markKnownTxs(nodeId, {tx.hash()});
       if (!this->state_.addTx(std::move(tx))) this->broadcastMessage(message);
     } catch (std::exception &e) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+      LOGERROR(Log::P2PParser,
                          "Invalid txBroadcast from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
                          " , error: " + e.what() + " closing session.");
       this->disconnectSession(nodeId);
@@ -349,7 +526,7 @@ namespace P2P{
         rebroadcast = true;
       }
     } catch (std::exception &e) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+      LOGERROR(Log::P2PParser,
                          "Invalid blockBroadcast from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
                          " , error: " + e.what() + " closing session.");
       this->disconnectSession(nodeId);
@@ -358,14 +535,137 @@ namespace P2P{
     if (rebroadcast) this->broadcastMessage(message);
   }
 
+  std::optional<Block> ManagerNormal::rebuildCompactBlock(const NodeID& nodeId, CompactBlock&& compact) {
+    // Take what we can from the mempool, senders are already recovered there
+    std::unordered_set<uint64_t> wanted(compact.shortIds.begin(), compact.shortIds.end());
+    std::unordered_map<uint64_t, TxBlock> found = this->state_.getMempoolTxsByShortId(wanted);
+    std::vector<uint32_t> missing;
+    for (uint32_t i = 0; i < compact.shortIds.size(); i++) {
+      if (!found.contains(compact.shortIds[i])) missing.emplace_back(i);
+    }
+    std::vector<TxBlock> fetched;
+    if (!missing.empty()) {
+      fetched = this->requestBlockTxs(nodeId, compact.hash, missing, ManagerNormal::blockTxsTimeout_);
+      // No answer in time proves nothing against the node, the syncer will get the block
+      if (fetched.empty()) return std::nullopt;
+    }
+    try {
+      if (fetched.size() != missing.size()) throw DynamicException("Got the wrong number of missing transactions.");
+      std::vector<TxBlock> txs;
+      txs.reserve(compact.shortIds.size());
+      auto fetchedIt = fetched.begin();
+      for (const uint64_t& shortId : compact.shortIds) {
+        auto foundIt = found.find(shortId);
+        if (foundIt != found.end()) {
+          txs.emplace_back(foundIt->second);
+        } else {
+          if (Mempool::shortId(fetchedIt->hash()) != shortId) throw DynamicException("Fetched transaction does not match its short ID.");
+          txs.emplace_back(std::move(*fetchedIt++));
+        }
+      }
+      return Block(compact.header, std::move(txs), std::move(compact.txValidators));
+    } catch (std::exception &e) {
+      // Two transactions may share a short ID, get the whole block to be sure
+      LOGWARNING(Log::P2PParser,
+        "Could not rebuild compact block " + compact.hash.hex().get() + ": " + e.what() + ", requesting the whole block"
+      );
+    }
+    BlocksAnswer answer = this->requestBlocks(nodeId, compact.nHeight, 1, ManagerNormal::blockTxsTimeout_);
+    if (answer.blocks.empty()) return std::nullopt;
+    if (answer.blocks.size() != 1) throw DynamicException("Got more than the requested block.");
+    Block block(answer.blocks.front(), this->options_.getChainID());
+    if (block.hash() != compact.hash) throw DynamicException("Whole block does not match the compact block.");
+    return block;
+  }
+
+  void ManagerNormal::handleCompactBlockBroadcast(
+    const NodeID &nodeId, const std::shared_ptr<const Message>& message
+  ) {
+    CompactBlock compact;
+    try {
+      compact = BroadcastDecoder::broadcastCompactBlock(*message, this->options_.getChainID());
+    } catch (std::exception &e) {
+      LOGERROR(Log::P2PParser,
+                         "Invalid compactBlockBroadcast from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
+                         " , error: " + e.what() + " closing session.");
+      this->disconnectSession(nodeId);
+      return;
+    }
+    // Don't fetch anything for a block we can't process right now (the syncer will get it)
+    if (this->storage_.blockExists(compact.hash)) return;
+    if (compact.nHeight != this->storage_.latest()->getNHeight() + 1) return;
+    // Anyone can announce a block, only fetch the ones signed by who should create it
+    Signature sig(Utils::create_view_span(compact.header, 0, 65));
+    if (!Secp256k1::verifySig(sig.r(), sig.s(), sig.v())) {
+      LOGERROR(Log::P2PParser,
+        "Invalid compact block signature from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second)
+        + ", closing session."
+      );
+      this->disconnectSession(nodeId);
+      return;
+    }
+    const Address creator = Secp256k1::toAddress(Secp256k1::recover(sig, compact.hash));
+    if (!this->state_.rdposIsNextBlockCreator(creator)) {
+      LOGDEBUG(Log::P2PParser,
+        "Ignoring compact block " + compact.hash.hex().get() + " not signed by the next block creator"
+      );
+      return;
+    }
+    {
+      std::unique_lock lock(this->compactFetchesMutex_);
+      if (this->compactFetches_.size() >= ManagerNormal::maxCompactFetches_) return;
+      if (!this->compactFetches_.insert(compact.nHeight).second) return;
+    }
+    // Seen from now on, so the copies relayed by other nodes while we fetch are dropped
+    this->seenMessages_.insert(message->id().toUint64());
+    this->asyncFetch([this, nodeId, message, compact = std::move(compact)]() mutable {
+      const uint64_t nHeight = compact.nHeight;
+      this->processCompactBlock(nodeId, message, std::move(compact));
+      std::unique_lock lock(this->compactFetchesMutex_);
+      this->compactFetches_.erase(nHeight);
+    });
+  }
+
+  void ManagerNormal::processCompactBlock(
+    const NodeID& nodeId, const std::shared_ptr<const Message>& message, CompactBlock&& compact
+  ) {
+    bool rebroadcast = false;
+    try {
+      const Hash hash = compact.hash;
+      std::optional<Block> block = this->rebuildCompactBlock(nodeId, std::move(compact));
+      if (!block) {
+        LOGWARNING(Log::P2PParser,
+          "Could not fetch compact block " + hash.hex().get() + " from "
+          + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + ", leaving it to the syncer"
+        );
+        return;
+      }
+      // Same lock as in handleBlockBroadcast(), see the reason there
+      std::unique_lock lock(this->blockBroadcastMutex_);
+      if (this->storage_.blockExists(block->hash())) return;
+      if (this->state_.validateNextBlock(*block)) {
+        this->state_.processNextBlock(std::move(*block));
+        rebroadcast = true;
+      }
+    } catch (std::exception &e) {
+      LOGERROR(Log::P2PParser,
+                         "Invalid compactBlockBroadcast from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) +
+                         " , error: " + e.what() + " closing session.");
+      this->disconnectSession(nodeId);
+      return;
+    }
+    // Already marked as seen by handleCompactBlockBroadcast()
+    if (rebroadcast) this->relayMessage(message);
+  }
+
   // TODO: Both ping and requestNodes is a blocking call on .wait()
   // Somehow change to wait_for.
   std::vector<TxValidator> ManagerNormal::requestValidatorTxs(const NodeID& nodeId) {
     auto request = std::make_shared<const Message>(RequestEncoder::requestValidatorTxs());
-    Utils::logToFile("Requesting nodes from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second));
+    LOGDEBUG(Log::P2PManager, "Requesting nodes from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second));
     auto requestPtr = this->sendRequestTo(nodeId, request);
     if (requestPtr == nullptr) {
-      Logger::logToDebug(LogType::WARNING, Log::P2PParser, __func__,
+      LOGWARNING(Log::P2PParser,
         "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " failed."
       );
       return {};
@@ -373,7 +673,7 @@ namespace P2P{
     auto answer = requestPtr->answerFuture();
     auto status = answer.wait_for(std::chrono::seconds(2)); // 2000ms timeout.
     if (status == std::future_status::timeout) {
-      Logger::logToDebug(LogType::WARNING, Log::P2PParser, __func__,
+      LOGWARNING(Log::P2PParser,
         "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " timed out."
       );
       return {};
@@ -382,7 +682,7 @@ namespace P2P{
       auto answerPtr = answer.get();
       return AnswerDecoder::requestValidatorTxs(*answerPtr, this->options_.getChainID());
     } catch (std::exception &e) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+      LOGERROR(Log::P2PParser,
         "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " failed with error: " + e.what()
       );
       return {};
@@ -391,10 +691,10 @@ namespace P2P{
 
   std::vector<TxBlock> ManagerNormal::requestTxs(const NodeID& nodeId) {
     auto request = std::make_shared<const Message>(RequestEncoder::requestTxs());
-    Utils::logToFile("Requesting nodes from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second));
+    LOGDEBUG(Log::P2PManager, "Requesting nodes from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second));
     auto requestPtr = this->sendRequestTo(nodeId, request);
     if (requestPtr == nullptr) {
-      Logger::logToDebug(LogType::WARNING, Log::P2PParser, __func__,
+      LOGWARNING(Log::P2PParser,
         "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " failed."
       );
       return {};
@@ -402,7 +702,7 @@ namespace P2P{
     auto answer = requestPtr->answerFuture();
     auto status = answer.wait_for(std::chrono::seconds(2)); // 2000ms timeout.
     if (status == std::future_status::timeout) {
-      Logger::logToDebug(LogType::WARNING, Log::P2PParser, __func__,
+      LOGWARNING(Log::P2PParser,
         "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " timed out."
       );
       return {};
@@ -411,7 +711,188 @@ namespace P2P{
       auto answerPtr = answer.get();
       return AnswerDecoder::requestTxs(*answerPtr, this->options_.getChainID());
     } catch (std::exception &e) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+      LOGERROR(Log::P2PParser,
+        "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " failed with error: " + e.what()
+      );
+      return {};
+    }
+  }
+
+  BlocksAnswer ManagerNormal::requestBlocks(
+    const NodeID& nodeId, const uint64_t& fromHeight, const uint64_t& count,
+    const std::chrono::milliseconds& timeout
+  ) {
+    auto request = std::make_shared<const Message>(RequestEncoder::requestBlocks(fromHeight, count));
+    LOGDEBUG(Log::P2PManager, "Requesting blocks from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second));
+    auto requestPtr = this->sendRequestTo(nodeId, request);
+    if (requestPtr == nullptr) {
+      LOGWARNING(Log::P2PParser,
+        "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " failed."
+      );
+      return {};
+    }
+    auto answer = requestPtr->answerFuture();
+    auto status = answer.wait_for(timeout);
+    if (status == std::future_status::timeout) {
+      LOGWARNING(Log::P2PParser,
+        "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " timed out."
+      );
+      return {};
+    }
+    try {
+      auto answerPtr = answer.get();
+      auto blocks = AnswerDecoder::requestBlocks(*answerPtr);
+      return {answerPtr, std::move(blocks)};
+    } catch (std::exception &e) {
+      LOGERROR(Log::P2PParser,
+        "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " failed with error: " + e.what()
+      );
+      return {};
+    }
+  }
+
+  std::vector<TxBlock> ManagerNormal::requestBlockTxs(
+    const NodeID& nodeId, const Hash& blockHash, const std::vector<uint32_t>& indexes,
+    const std::chrono::milliseconds& timeout
+  ) {
+    auto answer = this->requestAndWait(nodeId, std::make_shared<const Message>(
+      RequestEncoder::requestBlockTxs(blockHash, indexes)
+    ), timeout);
+    if (answer == nullptr) return {};
+    try {
+      return AnswerDecoder::requestBlockTxs(*answer, this->options_.getChainID());
+    } catch (std::exception &e) {
+      LOGERROR(Log::P2PParser,
+        "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " failed with error: " + e.what()
+      );
+      return {};
+    }
+  }
+
+  ManagerNormal::PeerTxs& ManagerNormal::getPeerTxs(const NodeID& nodeId) {
+    auto it = this->peerTxs_.find(nodeId);
+    if (it != this->peerTxs_.end()) return it->second;
+    // New peer, good time to forget the ones that are gone
+    std::vector<NodeID> connected = this->getSessionsIDs();
+    std::erase_if(this->peerTxs_, [&](const auto& entry) {
+      return std::find(connected.begin(), connected.end(), entry.first) == connected.end();
+    });
+    return this->peerTxs_[nodeId];
+  }
+
+  void ManagerNormal::markKnownTxs(const NodeID& nodeId, const std::vector<Hash>& txHashes) {
+    std::unique_lock lock(this->peerTxsMutex_);
+    auto& known = this->getPeerTxs(nodeId).known;
+    for (const Hash& txHash : txHashes) known.put(txHash, true);
+    known.trim();
+  }
+
+  std::shared_ptr<const Message> ManagerNormal::requestAndWait(
+    const NodeID& nodeId, const std::shared_ptr<const Message>& request,
+    const std::chrono::milliseconds& timeout
+  ) {
+    auto requestPtr = this->sendRequestTo(nodeId, request);
+    if (requestPtr == nullptr) {
+      LOGWARNING(Log::P2PParser,
+        "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " failed."
+      );
+      return nullptr;
+    }
+    auto answer = requestPtr->answerFuture();
+    if (answer.wait_for(timeout) == std::future_status::timeout) {
+      LOGWARNING(Log::P2PParser,
+        "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " timed out."
+      );
+      return nullptr;
+    }
+    return answer.get();
+  }
+
+  std::optional<ManagerNormal::MissingTxs> ManagerNormal::requestMissingTxHashes(
+    const NodeID& nodeId, const TxPool& pool
+  ) {
+    uint64_t sinceSequence;
+    {
+      std::unique_lock lock(this->peerTxsMutex_);
+      const PeerTxs& peer = this->getPeerTxs(nodeId);
+      sinceSequence = (pool == BlockTxPool) ? peer.txSequence : peer.validatorTxSequence;
+    }
+    auto answer = this->requestAndWait(nodeId, std::make_shared<const Message>(
+      RequestEncoder::requestTxInventory(pool, sinceSequence)
+    ));
+    if (answer == nullptr) return std::nullopt;
+    MissingTxs delta;
+    try {
+      std::tie(delta.sequence, delta.covered) = AnswerDecoder::requestTxInventory(*answer);
+    } catch (std::exception &e) {
+      LOGERROR(Log::P2PParser,
+        "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " failed with error: " + e.what()
+      );
+      return std::nullopt;
+    }
+    delta.missing = delta.covered;
+    std::erase_if(delta.missing, [&](const Hash& txHash) {
+      return (pool == BlockTxPool) ? this->state_.isTxInMempool(txHash) : this->state_.rdposIsTxInMempool(txHash);
+    });
+    {
+      // Hashes already covered by a previous fetch (or relayed by us) were either taken or
+      // rejected by our mempool, re-fetching them on every full announcement would loop forever
+      std::unique_lock lock(this->peerTxsMutex_);
+      const auto& known = this->getPeerTxs(nodeId).known;
+      std::erase_if(delta.missing, [&](const Hash& txHash) { return known.contains(txHash); });
+    }
+    if (delta.missing.size() > ManagerNormal::maxTxsByHash_) {
+      // Both lists keep the announced order, so the covered part ends at the last hash we'll fetch
+      delta.missing.resize(ManagerNormal::maxTxsByHash_);
+      delta.covered.erase(std::next(std::find(delta.covered.begin(), delta.covered.end(), delta.missing.back())), delta.covered.end());
+      delta.truncated = true;
+    }
+    return delta;
+  }
+
+  void ManagerNormal::commitMissingTxs(const NodeID& nodeId, const TxPool& pool, const MissingTxs& delta) {
+    // The peer has everything it announced, no need to announce it back
+    std::unique_lock lock(this->peerTxsMutex_);
+    PeerTxs& peer = this->getPeerTxs(nodeId);
+    if (!delta.truncated) ((pool == BlockTxPool) ? peer.txSequence : peer.validatorTxSequence) = delta.sequence;
+    for (const Hash& txHash : delta.covered) peer.known.put(txHash, true);
+    peer.known.trim();
+  }
+
+  std::vector<TxBlock> ManagerNormal::requestNewTxs(const NodeID& nodeId) {
+    std::optional<MissingTxs> delta = this->requestMissingTxHashes(nodeId, BlockTxPool);
+    if (!delta) return {};
+    if (delta->missing.empty()) { this->commitMissingTxs(nodeId, BlockTxPool, *delta); return {}; }
+    auto answer = this->requestAndWait(nodeId, std::make_shared<const Message>(
+      RequestEncoder::requestTxsByHash(BlockTxPool, delta->missing)
+    ));
+    if (answer == nullptr) return {};
+    try {
+      auto txs = AnswerDecoder::requestTxsByHash(*answer, this->options_.getChainID());
+      this->commitMissingTxs(nodeId, BlockTxPool, *delta);
+      return txs;
+    } catch (std::exception &e) {
+      LOGERROR(Log::P2PParser,
+        "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " failed with error: " + e.what()
+      );
+      return {};
+    }
+  }
+
+  std::vector<TxValidator> ManagerNormal::requestNewValidatorTxs(const NodeID& nodeId) {
+    std::optional<MissingTxs> delta = this->requestMissingTxHashes(nodeId, ValidatorTxPool);
+    if (!delta) return {};
+    if (delta->missing.empty()) { this->commitMissingTxs(nodeId, ValidatorTxPool, *delta); return {}; }
+    auto answer = this->requestAndWait(nodeId, std::make_shared<const Message>(
+      RequestEncoder::requestTxsByHash(ValidatorTxPool, delta->missing)
+    ));
+    if (answer == nullptr) return {};
+    try {
+      auto txs = AnswerDecoder::requestValidatorTxsByHash(*answer, this->options_.getChainID());
+      this->commitMissingTxs(nodeId, ValidatorTxPool, *delta);
+      return txs;
+    } catch (std::exception &e) {
+      LOGERROR(Log::P2PParser,
         "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " failed with error: " + e.what()
       );
       return {};
@@ -420,10 +901,10 @@ namespace P2P{
 
   NodeInfo ManagerNormal::requestNodeInfo(const NodeID& nodeId) {
     auto request = std::make_shared<const Message>(RequestEncoder::info(this->storage_.latest(), this->options_));
-    Utils::logToFile("Requesting nodes from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second));
+    LOGDEBUG(Log::P2PManager, "Requesting nodes from " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second));
     auto requestPtr = sendRequestTo(nodeId, request);
     if (requestPtr == nullptr) {
-      Logger::logToDebug(LogType::WARNING, Log::P2PParser, __func__,
+      LOGWARNING(Log::P2PParser,
         "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " failed."
       );
       return {};
@@ -431,7 +912,7 @@ namespace P2P{
     auto answer = requestPtr->answerFuture();
     auto status = answer.wait_for(std::chrono::seconds(2)); // 2000ms timeout.
     if (status == std::future_status::timeout) {
-      Logger::logToDebug(LogType::WARNING, Log::P2PParser, __func__,
+      LOGWARNING(Log::P2PParser,
         "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " timed out."
       );
       return {};
@@ -440,7 +921,7 @@ namespace P2P{
       auto answerPtr = answer.get();
       return AnswerDecoder::info(*answerPtr);
     } catch (std::exception &e) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PParser, __func__,
+      LOGERROR(Log::P2PParser,
         "Request to " + nodeId.first.to_string() + ":" + std::to_string(nodeId.second) + " failed with error: " + e.what()
       );
       return {};
@@ -460,7 +941,7 @@ namespace P2P{
   }
 
   void ManagerNormal::broadcastBlock(const std::shared_ptr<const Block> block) {
-    auto broadcast = std::make_shared<const Message>(BroadcastEncoder::broadcastBlock(block));
+    auto broadcast = std::make_shared<const Message>(BroadcastEncoder::broadcastCompactBlock(block));
     this->broadcastMessage(broadcast);
     return;
   }
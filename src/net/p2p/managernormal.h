@@ -9,6 +9,8 @@ See the LICENSE.txt file in the project root for more information.
 #define P2P_MANAGER_NORMAL_H
 
 #include "managerbase.h"
+#include "seenmessages.h"
+#include "../../utils/lrucache.h"
 
 // Forward declaration.
 class Storage;
@@ -44,17 +46,113 @@ namespace P2P {
       State& state_; ///< Reference to the blockchain's state.
 
       /**
-       * Map with broadcasted messages and a counter of how many times they were broadcast.
-       * Used to avoid broadcasting the same message multiple times.
+       * IDs of the broadcast messages already seen, with how many duplicates of them were received.
+       * Used to avoid handling and broadcasting the same message multiple times.
        */
-      std::unordered_map <uint64_t, unsigned int, SafeHash> broadcastedMessages_;
-
-      /// Mutex for managing read/write access to broadcasted messages.
-      std::shared_mutex broadcastMutex_;
+      SeenMessages seenMessages_;
 
       /// Mutex for managing read/write access to block broadcasts.
       std::mutex blockBroadcastMutex_;
 
+      /// Maximum number of blocks sent in a single `RequestBlocks` answer.
+      static constexpr uint64_t maxBlocksPerAnswer_ = 256;
+
+      /// Soft cap for the size of a `RequestBlocks` answer, see AnswerEncoder::requestBlocks().
+      static constexpr uint64_t maxBlocksAnswerBytes_ = 16 * 1024 * 1024;
+
+      /// Maximum number of hashes announced in a single `RequestTxInventory` delta answer.
+      static constexpr uint64_t maxInventoryHashes_ = 4096;
+
+      /// Maximum number of transactions asked for in a single `RequestTxsByHash`.
+      static constexpr uint64_t maxTxsByHash_ = 4096;
+
+      /// Maximum number of transactions asked for in a single `RequestBlockTxs`.
+      static constexpr uint64_t maxBlockTxsRequested_ = 65536;
+
+      /// Timeout for fetching the missing transactions of a compact block.
+      static constexpr std::chrono::milliseconds blockTxsTimeout_{2000};
+
+      /// Maximum number of compact block rebuilds queued or running on the fetch pool.
+      static constexpr uint64_t maxCompactFetches_ = 4;
+
+      /// Mutex for `compactFetches_`.
+      std::mutex compactFetchesMutex_;
+
+      /// Heights with a compact block rebuild queued or running, at most one per height.
+      std::unordered_set<uint64_t> compactFetches_;
+
+      /// Number of transaction hashes remembered per peer as known by it.
+      static constexpr uint64_t knownTxsPerPeer_ = 32768;
+
+      /// What is known about the mempools of a peer, for inventory gossip.
+      struct PeerTxs {
+        uint64_t txSequence = 0;          ///< Last block tx inventory sequence received from the peer.
+        uint64_t validatorTxSequence = 0; ///< Last Validator tx inventory sequence received from the peer.
+        LRUCache<Hash, bool, SafeHash> known{ManagerNormal::knownTxsPerPeer_}; ///< Hashes the peer is known to have.
+      };
+
+      /// What is known about the mempools of each peer.
+      std::unordered_map<NodeID, PeerTxs, SafeHash> peerTxs_;
+
+      /// Mutex for managing read/write access to `peerTxs_`.
+      std::mutex peerTxsMutex_;
+
+      /**
+       * Get what is known about a peer's mempools, creating it if needed (and then
+       * forgetting the peers that disconnected). Must be called with `peerTxsMutex_` locked.
+       * @param nodeId The ID of the peer.
+       * @return The peer's entry.
+       */
+      PeerTxs& getPeerTxs(const NodeID& nodeId);
+
+      /**
+       * Remember that a peer has the given transactions, so they are not announced to it.
+       * @param nodeId The ID of the peer.
+       * @param txHashes The hashes of the transactions.
+       */
+      void markKnownTxs(const NodeID& nodeId, const std::vector<Hash>& txHashes);
+
+      /**
+       * Send a request to a node and wait for its answer.
+       * @param nodeId The ID of the node to request.
+       * @param request The request to send.
+       * @param timeout How long to wait for the answer.
+       * @return The answer, or `nullptr` on failure or timeout.
+       */
+      std::shared_ptr<const Message> requestAndWait(
+        const NodeID& nodeId, const std::shared_ptr<const Message>& request,
+        const std::chrono::milliseconds& timeout = std::chrono::seconds(2)
+      );
+
+      /// Inventory delta received from a peer, see requestMissingTxHashes().
+      struct MissingTxs {
+        uint64_t sequence = 0;     ///< Sequence the peer told us to ask from next time.
+        bool truncated = false;    ///< Whether `missing` was cut to `maxTxsByHash_` (the sequence can't be used then).
+        std::vector<Hash> covered; ///< Announced hashes up to the last one in `missing`.
+        std::vector<Hash> missing; ///< Hashes of the transactions we should request (at most `maxTxsByHash_`).
+      };
+
+      /**
+       * Ask a node for the transactions it got since the last time, and keep the ones we lack
+       * and haven't already fetched from it (those our mempool rejected stay rejected).
+       * Nothing is remembered about the peer until commitMissingTxs() is called.
+       * @param nodeId The ID of the node to request.
+       * @param pool The mempool to ask about.
+       * @return The delta, or `std::nullopt` on failure.
+       */
+      std::optional<MissingTxs> requestMissingTxHashes(const NodeID& nodeId, const TxPool& pool);
+
+      /**
+       * Remember what a peer announced once the missing transactions were fetched:
+       * the covered hashes as known by it and, unless the list was truncated, its
+       * inventory sequence. A truncated list is asked again from the same sequence,
+       * minus what we fetched in the meantime.
+       * @param nodeId The ID of the peer.
+       * @param pool The mempool the delta is about.
+       * @param delta The delta returned by requestMissingTxHashes().
+       */
+      void commitMissingTxs(const NodeID& nodeId, const TxPool& pool, const MissingTxs& delta);
+
       /**
        * Broadcast a message to all connected nodes.
        * @param message The message to broadcast.
@@ -96,6 +194,34 @@ namespace P2P {
        */
       void handleTxRequest(const NodeID &nodeId, const std::shared_ptr<const Message>& message);
 
+      /**
+       * Handle a `RequestBlocks` request.
+       * @param session The session that sent the request.
+       * @param message The request message to handle.
+       */
+      void handleBlocksRequest(const NodeID &nodeId, const std::shared_ptr<const Message>& message);
+
+      /**
+       * Handle a `RequestTxInventory` request.
+       * @param session The session that sent the request.
+       * @param message The request message to handle.
+       */
+      void handleTxInventoryRequest(const NodeID &nodeId, const std::shared_ptr<const Message>& message);
+
+      /**
+       * Handle a `RequestTxsByHash` request.
+       * @param session The session that sent the request.
+       * @param message The request message to handle.
+       */
+      void handleTxsByHashRequest(const NodeID &nodeId, const std::shared_ptr<const Message>& message);
+
+      /**
+       * Handle a `RequestBlockTxs` request.
+       * @param session The session that sent the request.
+       * @param message The request message to handle.
+       */
+      void handleBlockTxsRequest(const NodeID &nodeId, const std::shared_ptr<const Message>& message);
+
       /**
        * Handle a `Ping` answer.
        * @param session The session that sent the answer.
@@ -131,6 +257,27 @@ namespace P2P {
        */
       void handleTxAnswer(const NodeID &nodeId, const std::shared_ptr<const Message>& message);
 
+      /**
+       * Handle a `RequestBlocks` answer.
+       * @param session The session that sent the answer.
+       * @param message The answer message to handle.
+       */
+      void handleBlocksAnswer(const NodeID &nodeId, const std::shared_ptr<const Message>& message);
+
+      /**
+       * Handle a `RequestTxInventory` or `RequestTxsByHash` answer.
+       * @param session The session that sent the answer.
+       * @param message The answer message to handle.
+       */
+      void handleTxInventoryAnswer(const NodeID &nodeId, const std::shared_ptr<const Message>& message);
+
+      /**
+       * Handle a `RequestBlockTxs` answer.
+       * @param session The session that sent the answer.
+       * @param message The answer message to handle.
+       */
+      void handleBlockTxsAnswer(const NodeID &nodeId, const std::shared_ptr<const Message>& message);
+
       /**
        * Handle a Validator transaction broadcast message.
        * @param session The node that sent the broadcast.
@@ -152,6 +299,45 @@ namespace P2P {
        */
       void handleBlockBroadcast(const NodeID &nodeId, const std::shared_ptr<const Message>& message);
 
+      /**
+       * Handle a compact block broadcast message.
+       * The block is rebuilt from the mempool, asking the sender only for the
+       * transactions we don't have. If the rebuilt block doesn't match its
+       * header (e.g. a short ID collision), the whole block is requested instead.
+       * Only blocks signed by the expected rdPoS creator are fetched, one per height
+       * and at most `maxCompactFetches_` at a time, the others are left to the syncer.
+       * The block is marked as seen before anything is fetched, and the rest is
+       * done by processCompactBlock() on the fetch pool (see asyncFetch()).
+       * @param session The node that sent the broadcast.
+       * @param message The message that was broadcast.
+       */
+      void handleCompactBlockBroadcast(const NodeID &nodeId, const std::shared_ptr<const Message>& message);
+
+      /**
+       * Rebuild, process and relay a compact block.
+       * @param nodeId The node that sent the compact block.
+       * @param message The message that was broadcast.
+       * @param compact The decoded compact block.
+       */
+      void processCompactBlock(
+        const NodeID& nodeId, const std::shared_ptr<const Message>& message, CompactBlock&& compact
+      );
+
+      /**
+       * Rebuild a block from its compact form.
+       * @param nodeId The node that sent the compact block.
+       * @param compact The compact block.
+       * @return The rebuilt block, or `std::nullopt` if the node didn't answer in time.
+       * @throw DynamicException if the block can't be rebuilt from what the node sent, or is invalid.
+       */
+      std::optional<Block> rebuildCompactBlock(const NodeID& nodeId, CompactBlock&& compact);
+
+      /**
+       * Send a broadcast message to all connected normal nodes, whether it was seen or not.
+       * @param message The message to send.
+       */
+      void relayMessage(const std::shared_ptr<const Message>& message);
+
     public:
       /**
        * Constructor.
@@ -176,6 +362,9 @@ namespace P2P {
        */
       void handleMessage(const NodeID &nodeId, const std::shared_ptr<const Message> message) override;
 
+      /// Getter for `seenMessages_` (e.g. for the duplicates suppressed per command).
+      const SeenMessages& getSeenMessages() const { return this->seenMessages_; }
+
       /**
        * Request Validator transactions from a given node.
        * @param nodeId The ID of the node to request.
@@ -190,6 +379,51 @@ namespace P2P {
        */
       std::vector<TxBlock> requestTxs(const NodeID& nodeId);
 
+      /**
+       * Request the block transactions a node got since the last time we asked it,
+       * and that we don't have yet (delta inventory, see TxInventory).
+       * Much cheaper than requestTxs(), which always ships the whole mempool.
+       * @param nodeId The ID of the node to request.
+       * @return A list of transactions missing from our mempool.
+       */
+      std::vector<TxBlock> requestNewTxs(const NodeID& nodeId);
+
+      /**
+       * Request the Validator transactions a node got since the last time we asked it,
+       * and that we don't have yet (delta inventory, see TxInventory).
+       * @param nodeId The ID of the node to request.
+       * @return A list of Validator transactions missing from our rdPoS mempool.
+       */
+      std::vector<TxValidator> requestNewValidatorTxs(const NodeID& nodeId);
+
+      /**
+       * Request a range of consecutive blocks from a given node.
+       * The node may answer with fewer blocks than requested (it caps the size of
+       * its answers), or none if it doesn't have the first one.
+       * @param nodeId The ID of the node to request.
+       * @param fromHeight Height of the first requested block.
+       * @param count Number of blocks requested.
+       * @param timeout How long to wait for the answer.
+       * @return The serialized blocks, in height order (none on failure).
+       */
+      BlocksAnswer requestBlocks(
+        const NodeID& nodeId, const uint64_t& fromHeight, const uint64_t& count,
+        const std::chrono::milliseconds& timeout = std::chrono::seconds(10)
+      );
+
+      /**
+       * Request some transactions of a block from a given node.
+       * @param nodeId The ID of the node to request.
+       * @param blockHash The hash of the block.
+       * @param indexes The positions of the wanted transactions within the block.
+       * @param timeout How long to wait for the answer.
+       * @return The transactions, in the requested order (empty on failure).
+       */
+      std::vector<TxBlock> requestBlockTxs(
+        const NodeID& nodeId, const Hash& blockHash, const std::vector<uint32_t>& indexes,
+        const std::chrono::milliseconds& timeout = std::chrono::seconds(2)
+      );
+
       /**
        * Request info about a given node.
        * @param nodeId The ID of the node to request.
@@ -210,7 +444,7 @@ namespace P2P {
       void broadcastTxBlock(const TxBlock& txBlock);
 
       /**
-       * Broadcast a block to all connected nodes.
+       * Broadcast a block to all connected nodes, in compact form (see CompactBlock).
        * @param block The block to broadcast.
        */
       void broadcastBlock(const std::shared_ptr<const Block> block);
@@ -0,0 +1,64 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "seenmessages.h"
+
+namespace P2P {
+  void SeenMessages::rotate(Shard& shard) const {
+    auto now = std::chrono::steady_clock::now();
+    if (now - shard.rotatedAt < this->window_ && shard.current.size() < this->generationCapacity_) return;
+    if (now - shard.rotatedAt >= 2 * this->window_) {
+      shard.previous.clear(); // Idle for two windows, both generations expired
+    } else {
+      shard.previous = std::move(shard.current);
+    }
+    shard.current.clear();
+    shard.rotatedAt = now;
+  }
+
+  bool SeenMessages::insert(uint64_t id) {
+    Shard& shard = this->shardOf(id);
+    std::lock_guard lock(shard.mutex);
+    this->rotate(shard);
+    if (shard.current.contains(id)) return false;
+    auto it = shard.previous.find(id);
+    if (it != shard.previous.end()) {
+      // Still seen recently, keep it for another generation
+      shard.current.emplace(id, it->second);
+      shard.previous.erase(it);
+      return false;
+    }
+    shard.current.emplace(id, 0);
+    return true;
+  }
+
+  uint64_t SeenMessages::duplicate(uint64_t id, CommandType command) {
+    Shard& shard = this->shardOf(id);
+    std::unique_lock lock(shard.mutex);
+    this->rotate(shard);
+    auto it = shard.current.find(id);
+    if (it == shard.current.end()) {
+      auto prevIt = shard.previous.find(id);
+      if (prevIt == shard.previous.end()) return 0;
+      it = shard.current.emplace(id, prevIt->second).first;
+      shard.previous.erase(prevIt);
+    }
+    uint64_t count = ++it->second;
+    lock.unlock();
+    if (command < maxCommands_) this->duplicates_[command]++;
+    return count;
+  }
+
+  uint64_t SeenMessages::size() const {
+    uint64_t size = 0;
+    for (const Shard& shard : this->shards_) {
+      std::lock_guard lock(shard.mutex);
+      size += shard.current.size() + shard.previous.size();
+    }
+    return size;
+  }
+};
@@ -0,0 +1,97 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#ifndef P2P_SEEN_MESSAGES_H
+#define P2P_SEEN_MESSAGES_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+
+#include "encoding.h"
+
+namespace P2P {
+  /**
+   * De-duplication cache for broadcast message IDs.
+   * IDs are spread over lock-striped shards, so concurrent broadcasts only contend
+   * when they land on the same shard. Each shard keeps two generations: lookups
+   * check both, inserts go to the current one, and the current generation becomes
+   * the previous one (dropping the old previous) once it is older than the window
+   * or reaches its share of the capacity. An ID is thus remembered for at least
+   * one window unless the cache is under pressure, and memory never goes over
+   * `capacity` entries. Also counts the duplicates it suppressed, per command.
+   */
+  class SeenMessages {
+    private:
+      /// Number of shards (lock stripes).
+      static constexpr uint64_t shardCount_ = 16;
+
+      /// Number of commands duplicates are counted for (IDs beyond it are not counted).
+      static constexpr uint64_t maxCommands_ = 32;
+
+      /// A single lock stripe.
+      struct Shard {
+        mutable std::mutex mutex; ///< Mutex for managing read/write access to the shard.
+        std::unordered_map<uint64_t, uint64_t> current;  ///< Current generation (ID -> duplicates seen).
+        std::unordered_map<uint64_t, uint64_t> previous; ///< Previous generation (ID -> duplicates seen).
+        std::chrono::steady_clock::time_point rotatedAt = std::chrono::steady_clock::now(); ///< When `current` started.
+      };
+
+      std::array<Shard, shardCount_> shards_; ///< The shards.
+      const uint64_t generationCapacity_;     ///< Maximum number of IDs per generation per shard.
+      const std::chrono::milliseconds window_; ///< Minimum time an ID is remembered for.
+      std::array<std::atomic<uint64_t>, maxCommands_> duplicates_{}; ///< Duplicates suppressed per command.
+
+      /// Get the shard for a given ID.
+      Shard& shardOf(uint64_t id) { return this->shards_[(id ^ (id >> 32)) % shardCount_]; }
+
+      /**
+       * Rotate the generations of a shard if needed. Must be called with the shard locked.
+       * @param shard The shard to rotate.
+       */
+      void rotate(Shard& shard) const;
+
+    public:
+      /**
+       * Constructor.
+       * @param capacity Maximum number of IDs remembered. Defaults to 131072.
+       * @param window Minimum time an ID is remembered for (if there's room). Defaults to 2 minutes.
+       */
+      explicit SeenMessages(
+        uint64_t capacity = 131072, std::chrono::milliseconds window = std::chrono::minutes(2)
+      ) : generationCapacity_(std::max<uint64_t>(capacity / (2 * shardCount_), 1)), window_(window) {}
+
+      /**
+       * Mark an ID as seen.
+       * @param id The message ID.
+       * @return `true` if it wasn't seen before, `false` otherwise.
+       */
+      bool insert(uint64_t id);
+
+      /**
+       * Check if a received message is a duplicate, counting it as such if so.
+       * @param id The message ID.
+       * @param command The message's command.
+       * @return How many duplicates of the message were suppressed so far,
+       *         including this one (0 if it wasn't seen before).
+       */
+      uint64_t duplicate(uint64_t id, CommandType command);
+
+      /// Get the number of duplicates suppressed for a given command.
+      uint64_t duplicates(CommandType command) const {
+        return (command < maxCommands_) ? this->duplicates_[command].load() : 0;
+      }
+
+      /// Get the number of IDs currently remembered.
+      uint64_t size() const;
+  };
+};
+
+#endif  // P2P_SEEN_MESSAGES_H
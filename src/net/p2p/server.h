@@ -43,13 +43,13 @@ namespace P2P {
         manager_(manager) {
          boost::system::error_code ec;
          acceptor_.open(endpoint.protocol(), ec); // Open the acceptor
-         if (ec) { Logger::logToDebug(LogType::ERROR, Log::P2PServerListener, __func__, "Open Acceptor: " + ec.message()); return; }
+         if (ec) { LOGERROR(Log::P2PServerListener, "Open Acceptor: " + ec.message()); return; }
          acceptor_.set_option(net::socket_base::reuse_address(true), ec); // Allow address reuse
-         if (ec) { Logger::logToDebug(LogType::ERROR, Log::P2PServerListener, __func__, "Set Option: " + ec.message()); return; }
+         if (ec) { LOGERROR(Log::P2PServerListener, "Set Option: " + ec.message()); return; }
          acceptor_.bind(endpoint, ec); // Bind to the server address
-         if (ec) { Logger::logToDebug(LogType::ERROR, Log::P2PServerListener, __func__, "Bind Acceptor: " + ec.message()); return; }
+         if (ec) { LOGERROR(Log::P2PServerListener, "Bind Acceptor: " + ec.message()); return; }
          acceptor_.listen(net::socket_base::max_listen_connections, ec); // Start listening
-         if (ec) { Logger::logToDebug(LogType::ERROR, Log::P2PServerListener, __func__, "Listen Acceptor: " + ec.message()); return; }
+         if (ec) { LOGERROR(Log::P2PServerListener, "Listen Acceptor: " + ec.message()); return; }
       }
 
       void run();   ///< Start accepting incoming connections.
@@ -7,6 +7,7 @@ See the LICENSE.txt file in the project root for more information.
 
 #include "session.h"
 #include "managerbase.h"
+#include "../../utils/metrics.h"
 #include <functional>
 
 namespace P2P {
@@ -65,7 +66,7 @@ namespace P2P {
   void Session::finish_handshake(boost::system::error_code ec, std::size_t) {
     if (ec && this->handle_error(__func__, ec)) return;
     if (this->inboundHandshake_.size() != 3) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PSession, __func__, "Invalid handshake size");
+      LOGERROR(Log::P2PSession, "Invalid handshake size");
       this->close();
       return;
     }
@@ -73,6 +74,8 @@ namespace P2P {
     this->serverPort_ = Utils::bytesToUint16(Utils::create_view_span(this->inboundHandshake_, 1, 2));
     this->doneHandshake_ = true;
     this->nodeId_ = {this->address_, this->serverPort_};
+    // Capabilities go first, so the peer knows them before anything that depends on them
+    this->write(std::make_shared<const Message>(RequestEncoder::capabilities(Session::localCapabilities_)));
     if (!this->manager_.registerSession(shared_from_this())) { this->close(); return; }
     this->do_read_header(); // Start reading messages.
   }
@@ -89,8 +92,17 @@ namespace P2P {
   void Session::on_read_header(boost::system::error_code ec, std::size_t) {
     if (ec && this->handle_error(__func__, ec)) return;
     uint64_t messageSize = Utils::bytesToUint64(this->inboundHeader_);
+    this->inboundCompressed_ = messageSize & Session::compressedFlag_;
+    messageSize &= ~Session::compressedFlag_;
+    if (this->inboundCompressed_ && !this->hasCapability(Capability::Compression)) {
+      LOGWARNING(Log::P2PSession,
+        "Compressed message from a peer that did not negotiate compression, closing session..."
+      );
+      this->close();
+      return;
+    }
     if (messageSize > this->maxMessageSize_) {
-      Logger::logToDebug(LogType::WARNING, Log::P2PSession, __func__,
+      LOGWARNING(Log::P2PSession,
         "Message size too large: " + std::to_string(messageSize)
         + " max: " + std::to_string(this->maxMessageSize_) + " closing session..."
       );
@@ -101,63 +113,123 @@ namespace P2P {
   }
 
   void Session::do_read_message(const uint64_t& messageSize) {
+    // Read straight into a pooled buffer, the message is parsed in place from it
     this->inboundMessage_ = std::make_shared<Message>();
-    net::dynamic_vector_buffer readBuffer(this->inboundMessage_->rawMessage_);
-    auto mutableBuffer = readBuffer.prepare(messageSize);
-    net::async_read(this->socket_, mutableBuffer, net::bind_executor(this->readStrand_, std::bind(
-      &Session::on_read_message, shared_from_this(), std::placeholders::_1, std::placeholders::_2
-    )));
+    this->inboundMessage_->rawMessage_ = BufferPool::instance().acquire(messageSize);
+    this->inboundMessage_->rawMessage_.resize(messageSize);
+    net::async_read(this->socket_, net::buffer(this->inboundMessage_->rawMessage_), net::bind_executor(
+      this->readStrand_, std::bind(
+        &Session::on_read_message, shared_from_this(), std::placeholders::_1, std::placeholders::_2
+      )
+    ));
   }
 
   void Session::on_read_message(boost::system::error_code ec, std::size_t) {
+    static Metrics::Counter& bytesReceived = Metrics::counter(
+      "orbiter_p2p_bytes_received_total", "Bytes read from P2P sockets (headers included)."
+    );
+    static Metrics::Counter& messagesReceived = Metrics::counter(
+      "orbiter_p2p_messages_received_total", "Messages received from P2P peers."
+    );
     if (ec && this->handle_error(__func__, ec)) return;
+    this->bytesReceived_ += 8 + this->inboundMessage_->rawMessage_.size();
+    bytesReceived.inc(8 + this->inboundMessage_->rawMessage_.size());
+    messagesReceived.inc();
+    if (this->inboundCompressed_) {
+      Bytes compressed = std::move(this->inboundMessage_->rawMessage_);
+      try {
+        this->inboundMessage_->rawMessage_ = Compression::decompress(compressed, this->maxMessageSize_);
+      } catch (std::exception& e) {
+        LOGWARNING(Log::P2PSession,
+          std::string("Invalid compressed message: ") + e.what() + " closing session..."
+        );
+        BufferPool::instance().release(std::move(compressed));
+        this->close();
+        return;
+      }
+      BufferPool::instance().release(std::move(compressed));
+    }
+    this->payloadBytesReceived_ += 8 + this->inboundMessage_->rawMessage_.size();
+    // Capabilities are taken here rather than by the manager, as they apply to the very next message
+    if (auto flags = RequestDecoder::capabilities(*this->inboundMessage_)) {
+      if (this->inboundMessage_->type() == Answering) {
+        // Answer to our own capabilities ping, nobody is waiting for it
+        this->inboundMessage_ = nullptr;
+        this->do_read_header();
+        return;
+      }
+      this->capabilities_ = *flags & Session::localCapabilities_;
+    }
     this->manager_.asyncHandleMessage(this->nodeId_, this->inboundMessage_);
     this->inboundMessage_ = nullptr;
     this->do_read_header();
   }
 
-  void Session::do_write_header() {
-    // Nothing to do, someone called us by mistake.
-    if (this->outboundMessage_ == nullptr) return;
-    this->outboundHeader_ = Utils::uint64ToBytes(this->outboundMessage_->rawMessage_.size());
-    net::async_write(this->socket_, net::buffer(this->outboundHeader_), net::bind_executor(
+  void Session::do_write_messages() {
+    static Metrics::Counter& bytesSent = Metrics::counter(
+      "orbiter_p2p_bytes_sent_total", "Bytes written to P2P sockets (headers included)."
+    );
+    static Metrics::Counter& messagesSent = Metrics::counter(
+      "orbiter_p2p_messages_sent_total", "Messages sent to P2P peers."
+    );
+    this->writingMessages_.clear();
+    for (Bytes& compressed : this->writingCompressed_) BufferPool::instance().release(std::move(compressed));
+    this->writingCompressed_.clear();
+    {
+      std::unique_lock lock(this->writeQueueMutex_);
+      while (!this->outboundMessages_.empty() && this->writingMessages_.size() < Session::maxMessagesPerWrite_) {
+        this->writingMessages_.emplace_back(std::move(this->outboundMessages_.front()));
+        this->outboundMessages_.pop_front();
+      }
+      if (this->writingMessages_.empty()) { this->writeInProgress_ = false; return; }
+    }
+    // Headers and payloads first, so the buffers below don't point into vectors that reallocate
+    const bool compress = this->hasCapability(Capability::Compression);
+    this->writingHeaders_.clear();
+    for (const auto& message : this->writingMessages_) {
+      const Bytes& raw = message->rawMessage_;
+      Bytes compressed;
+      if (compress && raw.size() >= Session::compressionThreshold_) {
+        compressed = Compression::compress(raw);
+        // Incompressible payloads (e.g. already dense data) are sent as is
+        if (compressed.size() >= raw.size()) {
+          BufferPool::instance().release(std::move(compressed));
+          compressed = Bytes();
+        }
+      }
+      uint64_t header = compressed.empty() ? raw.size() : (compressed.size() | Session::compressedFlag_);
+      this->writingHeaders_.emplace_back(Utils::uint64ToBytes(header));
+      this->bytesSent_ += 8 + (compressed.empty() ? raw.size() : compressed.size());
+      bytesSent.inc(8 + (compressed.empty() ? raw.size() : compressed.size()));
+      this->payloadBytesSent_ += 8 + raw.size();
+      this->writingCompressed_.emplace_back(std::move(compressed));
+    }
+    messagesSent.inc(this->writingMessages_.size());
+    this->writingBuffers_.clear();
+    for (size_t i = 0; i < this->writingMessages_.size(); i++) {
+      this->writingBuffers_.emplace_back(net::buffer(this->writingHeaders_[i]));
+      this->writingBuffers_.emplace_back(net::buffer(this->writingCompressed_[i].empty()
+        ? this->writingMessages_[i]->rawMessage_ : this->writingCompressed_[i]
+      ));
+    }
+    net::async_write(this->socket_, this->writingBuffers_, net::bind_executor(
       this->writeStrand_, std::bind(
-        &Session::on_write_header, shared_from_this(), std::placeholders::_1, std::placeholders::_2
+        &Session::on_write_messages, shared_from_this(), std::placeholders::_1, std::placeholders::_2
       )
     ));
   }
 
-  void Session::on_write_header(boost::system::error_code ec, std::size_t) {
+  void Session::on_write_messages(boost::system::error_code ec, std::size_t) {
     if (ec && this->handle_error(__func__, ec)) return;
-    this->do_write_message();
-  }
-
-  void Session::do_write_message() {
-    net::async_write(this->socket_, net::buffer(
-      this->outboundMessage_->rawMessage_, this->outboundMessage_->rawMessage_.size()
-    ), net::bind_executor(this->writeStrand_, std::bind(
-      &Session::on_write_message, shared_from_this(), std::placeholders::_1, std::placeholders::_2
-    )));
-  }
-
-  void Session::on_write_message(boost::system::error_code ec, std::size_t) {
-    if (ec && this->handle_error(__func__, ec)) return;
-    std::unique_lock lock(this->writeQueueMutex_);
-    if (this->outboundMessages_.empty()) {
-      this->outboundMessage_ = nullptr;
-    } else {
-      this->outboundMessage_ = this->outboundMessages_.front();
-      this->outboundMessages_.pop_front();
-      this->do_write_header();
-    }
+    this->do_write_messages();
   }
 
   void Session::run() {
     if (this->connectionType_ == ConnectionType::INBOUND) {
-      Logger::logToDebug(LogType::INFO, Log::P2PSession, __func__, "Starting new inbound session");
+      LOGINFO(Log::P2PSession, "Starting new inbound session");
       boost::asio::dispatch(this->socket_.get_executor(), std::bind(&Session::write_handshake, shared_from_this()));
     } else {
-      Logger::logToDebug(LogType::INFO, Log::P2PSession, __func__, "Starting new outbound session");
+      LOGINFO(Log::P2PSession, "Starting new outbound session");
       boost::asio::dispatch(this->socket_.get_executor(), std::bind(&Session::do_connect, shared_from_this()));
     }
   }
@@ -171,31 +243,29 @@ namespace P2P {
     // Cancel all pending operations.
     this->socket_.cancel(ec);
     if (ec) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PSession, __func__, "Failed to cancel socket operations: " + ec.message());
+      LOGERROR(Log::P2PSession, "Failed to cancel socket operations: " + ec.message());
       return;
     }
     // Shutdown the socket;
     this->socket_.shutdown(net::socket_base::shutdown_both, ec);
     if (ec) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PSession, __func__, "Failed to shutdown socket: " + ec.message());
+      LOGERROR(Log::P2PSession, "Failed to shutdown socket: " + ec.message());
       return;
     }
     // Close the socket.
     this->socket_.close(ec);
     if (ec) {
-      Logger::logToDebug(LogType::ERROR, Log::P2PSession, __func__, "Failed to close socket: " + ec.message());
+      LOGERROR(Log::P2PSession, "Failed to close socket: " + ec.message());
       return;
     }
   }
 
   void Session::write(const std::shared_ptr<const Message>& message) {
     std::unique_lock lock(this->writeQueueMutex_);
-    if (this->outboundMessage_ == nullptr) {
-      this->outboundMessage_ = message;
-      net::post(this->writeStrand_, std::bind(&Session::do_write_header, shared_from_this()));
-    } else {
-      this->outboundMessages_.push_back(message);
+    this->outboundMessages_.push_back(message);
+    if (!this->writeInProgress_) {
+      this->writeInProgress_ = true;
+      net::post(this->writeStrand_, std::bind(&Session::do_write_messages, shared_from_this()));
     }
   }
 }
-
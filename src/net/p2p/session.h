@@ -20,6 +20,7 @@ See the LICENSE.txt file in the project root for more information.
 
 #include "../../utils/utils.h"
 #include "encoding.h"
+#include "compression.h"
 
 using boost::asio::ip::tcp;
 namespace net = boost::asio;  // from <boost/asio.hpp>
@@ -34,6 +35,34 @@ namespace P2P {
   * socket.
   */
   class Session : public std::enable_shared_from_this<Session> {
+    public:
+      /**
+       * Optional protocol features. Right after the handshake, each side sends a
+       * `Ping` carrying its flags in the request ID (see RequestEncoder::capabilities()),
+       * which older nodes answer as any other ping. A feature is used on a session
+       * only once both sides advertised it.
+       */
+      enum class Capability : uint8_t {
+        Compression = 0x02  ///< Payloads above `compressionThreshold_` may be sent compressed.
+      };
+
+      /// Bytes that went through a session, on the wire and before compression.
+      struct Traffic {
+        uint64_t bytesSent = 0;         ///< Bytes written to the socket.
+        uint64_t bytesReceived = 0;     ///< Bytes read from the socket.
+        uint64_t payloadBytesSent = 0;  ///< Bytes that would have been written without compression.
+        uint64_t payloadBytesReceived = 0;  ///< Bytes received, once decompressed.
+
+        /// Add another session's traffic to this one.
+        Traffic& operator+=(const Traffic& other) {
+          this->bytesSent += other.bytesSent;
+          this->bytesReceived += other.bytesReceived;
+          this->payloadBytesSent += other.payloadBytesSent;
+          this->payloadBytesReceived += other.payloadBytesReceived;
+          return *this;
+        }
+      };
+
     protected:
       /// The socket used to communicate with the client.
       net::ip::tcp::socket socket_;
@@ -63,20 +92,55 @@ namespace P2P {
       net::strand<net::any_io_executor> writeStrand_; ///< Strand for write operations.
 
       std::shared_ptr<Message> inboundMessage_; ///< Pointer to the inbound message.
-      std::shared_ptr<const Message> outboundMessage_; ///< Pointer to the outbound message.
 
       BytesArr<3> inboundHandshake_; ///< Array for the inbound handshake.
       BytesArr<3> outboundHandshake_; ///< Array for the outbound handshake.
 
       BytesArr<8> inboundHeader_; ///< Array for the inbound header.
-      BytesArr<8> outboundHeader_; ///< Array for the outbound header.
 
-      /// Queue and mutex for outgoing messages.
+      bool inboundCompressed_ = false; ///< Whether the message being read is compressed.
+
+      /// Capabilities supported by both sides, known once the peer's capabilities ping is read.
+      std::atomic<uint8_t> capabilities_ = 0;
+
+      std::atomic<uint64_t> bytesSent_ = 0;           ///< See Traffic.
+      std::atomic<uint64_t> bytesReceived_ = 0;       ///< See Traffic.
+      std::atomic<uint64_t> payloadBytesSent_ = 0;    ///< See Traffic.
+      std::atomic<uint64_t> payloadBytesReceived_ = 0; ///< See Traffic.
+
+      /// Queue for outgoing messages.
       std::deque<std::shared_ptr<const Message>> outboundMessages_;
 
-      /// Mutex for adding to the queue.
+      /// Mutex for the queue and `writeInProgress_`.
       std::mutex writeQueueMutex_;
 
+      /// Whether a write is in progress. The members below belong to it until it is done.
+      bool writeInProgress_ = false;
+
+      /// Messages being written, kept alive until the write is done.
+      std::vector<std::shared_ptr<const Message>> writingMessages_;
+
+      /// Size headers of the messages being written.
+      std::vector<BytesArr<8>> writingHeaders_;
+
+      /// Compressed payloads of the messages being written (empty if sent as is).
+      std::vector<Bytes> writingCompressed_;
+
+      /// Gather list for the write in progress (header and body of every message, in order).
+      std::vector<net::const_buffer> writingBuffers_;
+
+      /// Maximum number of queued messages sent in a single write.
+      static constexpr size_t maxMessagesPerWrite_ = 64;
+
+      /// Capabilities advertised by this node.
+      static constexpr uint8_t localCapabilities_ = uint8_t(Capability::Compression);
+
+      /// Minimum payload size for compression, smaller payloads are not worth it.
+      static constexpr uint64_t compressionThreshold_ = 1024;
+
+      /// Flag set in the size header of a compressed message.
+      static constexpr uint64_t compressedFlag_ = uint64_t(1) << 63;
+
       /// Handshake flag
       std::atomic<bool> doneHandshake_ = false;
 
@@ -112,17 +176,11 @@ namespace P2P {
       /// Callback for reading the message.
       void on_read_message(boost::system::error_code ec, std::size_t);
 
-      /// Write a message to the socket.
-      void do_write_header();
+      /// Write the queued messages to the socket, up to `maxMessagesPerWrite_` in a single gather write.
+      void do_write_messages();
 
-      /// Callback for writing the header.
-      void on_write_header(boost::system::error_code ec, std::size_t);
-
-      /// Write a message to the socket.
-      void do_write_message();
-
-      /// Callback for writing the message.
-      void on_write_message(boost::system::error_code ec, std::size_t);
+      /// Callback for writing the messages.
+      void on_write_messages(boost::system::error_code ec, std::size_t);
 
       /// do_close, for closing using the io_context
       void do_close();
@@ -211,6 +269,14 @@ namespace P2P {
 
       /// Getter for `doneHandshake_`.
       const std::atomic<bool>& doneHandshake() const { return this->doneHandshake_; }
+
+      /// Check if both sides of the session support a given capability.
+      bool hasCapability(Capability capability) const { return this->capabilities_ & uint8_t(capability); }
+
+      /// Get the traffic that went through the session so far.
+      Traffic traffic() const {
+        return {this->bytesSent_, this->bytesReceived_, this->payloadBytesSent_, this->payloadBytesReceived_};
+      }
   };
 }
 
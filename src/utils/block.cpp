@@ -6,135 +6,77 @@ See the LICENSE.txt file in the project root for more information.
 */
 
 #include "block.h"
+#include "sigverifier.h"
 #include "../core/rdpos.h"
 
+void Block::parseHeader(const BytesArrView bytes) {
+  this->validatorSig_ = Signature(bytes.subspan(0, 65));
+  this->prevBlockHash_ = Hash(bytes.subspan(65, 32));
+  this->blockRandomness_= Hash(bytes.subspan(97, 32));
+  this->validatorMerkleRoot_ = Hash(bytes.subspan(129, 32));
+  this->txMerkleRoot_ = Hash(bytes.subspan(161, 32));
+  this->timestamp_ = Utils::bytesToUint64(bytes.subspan(193, 8));
+  this->nHeight_ = Utils::bytesToUint64(bytes.subspan(201, 8));
+}
+
+void Block::verifyAndFinalize() {
+  for (const TxValidator& tx : this->txValidators_) {
+    if (tx.getNHeight() != this->nHeight_) {
+      throw DynamicException("Invalid validator tx height");
+    }
+  }
+  // Sanity check the Merkle roots, block randomness and signature
+  auto expectedTxMerkleRoot = Merkle(this->txs_).getRoot();
+  auto expectedValidatorMerkleRoot = Merkle(this->txValidators_).getRoot();
+  auto expectedRandomness = rdPoS::parseTxSeedList(this->txValidators_);
+  if (expectedTxMerkleRoot != this->txMerkleRoot_) {
+    throw DynamicException("Invalid tx merkle root");
+  }
+  if (expectedValidatorMerkleRoot != this->validatorMerkleRoot_) {
+    throw DynamicException("Invalid validator merkle root");
+  }
+  if (expectedRandomness != this->blockRandomness_) {
+    throw DynamicException("Invalid block randomness");
+  }
+  this->hash_ = Utils::sha3(this->serializeHeader());
+  Hash msgHash = this->hash();
+  if (!Secp256k1::verifySig(
+    this->validatorSig_.r(), this->validatorSig_.s(), this->validatorSig_.v()
+  )) {
+    throw DynamicException("Invalid validator signature");
+  }
+  // Get the signature and finalize the block
+  this->validatorPubKey_ = Secp256k1::recover(this->validatorSig_, msgHash);
+  this->finalized_ = true;
+}
+
 Block::Block(const BytesArrView bytes, const uint64_t& requiredChainId) {
   try {
     // Split the bytes string
     if (bytes.size() < 217) throw DynamicException("Invalid block size - too short");
-    this->validatorSig_ = Signature(bytes.subspan(0, 65));
-    this->prevBlockHash_ = Hash(bytes.subspan(65, 32));
-    this->blockRandomness_= Hash(bytes.subspan(97, 32));
-    this->validatorMerkleRoot_ = Hash(bytes.subspan(129, 32));
-    this->txMerkleRoot_ = Hash(bytes.subspan(161, 32));
-    this->timestamp_ = Utils::bytesToUint64(bytes.subspan(193, 8));
-    this->nHeight_ = Utils::bytesToUint64(bytes.subspan(201, 8));
+    this->parseHeader(bytes);
     uint64_t txValidatorStart = Utils::bytesToUint64(bytes.subspan(209, 8));
 
-    // Count how many block txs are in the block
-    uint64_t txCount = 0;
+    // Slice the block txs and the Validator txs, then deserialize (and verify) them in parallel
+    std::vector<BytesArrView> rawTxs;
     uint64_t index = 217; // Start of block tx range
     while (index < txValidatorStart) {
       uint64_t txSize = Utils::bytesToUint32(bytes.subspan(index, 4));
+      rawTxs.emplace_back(bytes.subspan(index + 4, txSize));
       index += txSize + 4;
-      txCount++;
     }
-
-    // Count how many Validator txs are in the block
-    uint64_t valTxCount = 0;
+    std::vector<BytesArrView> rawValidatorTxs;
     index = txValidatorStart;
     while (index < bytes.size()) {
       uint64_t txSize = Utils::bytesToUint32(bytes.subspan(index, 4));
+      rawValidatorTxs.emplace_back(bytes.subspan(index + 4, txSize));
       index += txSize + 4;
-      valTxCount++;
-    }
-    index = 217;  // Rewind to start of block tx range
-
-    // If we have up to X block txs or only one physical thread
-    // for some reason, deserialize normally.
-    // Otherwise, parallelize into threads/asyncs.
-    unsigned int thrNum = 4;
-    if (thrNum <= 1 || txCount <= 2000) {
-      for (uint64_t i = 0; i < txCount; ++i) {
-        uint64_t txSize = Utils::bytesToUint32(bytes.subspan(index, 4));
-        index += 4;
-        this->txs_.emplace_back(bytes.subspan(index, txSize), requiredChainId);
-        index += txSize;
-      }
-    } else {
-      // Logically divide txs equally into one-time hardware threads/asyncs.
-      // Division reminder always goes to the LAST thread (e.g. 11/4 = 2+2+2+5)
-      std::vector<uint64_t> txsPerThr(thrNum, txCount / thrNum);
-      txsPerThr.back() += txCount % thrNum;
-
-      // Deserialize the txs with parallelized asyncs
-      std::vector<std::future<std::vector<TxBlock>>> f;
-      f.reserve(thrNum);
-      uint64_t thrOff = index;
-      for (uint64_t i = 0; i < txsPerThr.size(); i++) {
-        // Find out how many txs this thread will work with,
-        // then update offset for next thread
-        uint64_t startIdx = thrOff;
-        uint64_t nTxs = txsPerThr[i];
-
-        // Work that sucker to death, c'mon now
-        std::future<std::vector<TxBlock>> txF = std::async(
-          [&, startIdx, nTxs](){
-            std::vector<TxBlock> txVec;
-            uint64_t idx = startIdx;
-            for (uint64_t ii = 0; ii < nTxs; ii++) {
-              uint64_t len = Utils::bytesToUint32(bytes.subspan(idx, 4));
-              idx += 4;
-              txVec.emplace_back(bytes.subspan(idx, len), requiredChainId);
-              idx += len;
-            }
-            return txVec;
-          }
-        );
-        f.emplace_back(std::move(txF));
-
-        // Update offset, skip if this is the last thread
-        if (i < txsPerThr.size() - 1) {
-          for (uint64_t ii = 0; ii < nTxs; ii++) {
-            uint64_t len = Utils::bytesToUint32(bytes.subspan(thrOff, 4));
-            thrOff += len + 4;
-          }
-        }
-      }
-
-      // Wait for asyncs and fill the block tx vector
-      for (int i = 0; i < f.size(); i++) {
-        f[i].wait();
-        for (TxBlock tx : f[i].get()) this->txs_.emplace_back(tx);
-      }
-    }
-
-    // Deserialize the Validator transactions normally, no need to thread
-    index = txValidatorStart;
-    for (uint64_t i = 0; i < valTxCount; ++i) {
-      uint64_t txSize = Utils::bytesToUint32(bytes.subspan(index, 4));
-      index += 4;
-      this->txValidators_.emplace_back(bytes.subspan(index, txSize), requiredChainId);
-      if (this->txValidators_.back().getNHeight() != this->nHeight_) {
-        throw DynamicException("Invalid validator tx height");
-      }
-      index += txSize;
-    }
-    // Sanity check the Merkle roots, block randomness and signature
-    auto expectedTxMerkleRoot = Merkle(this->txs_).getRoot();
-    auto expectedValidatorMerkleRoot = Merkle(this->txValidators_).getRoot();
-    auto expectedRandomness = rdPoS::parseTxSeedList(this->txValidators_);
-    if (expectedTxMerkleRoot != this->txMerkleRoot_) {
-      throw DynamicException("Invalid tx merkle root");
-    }
-    if (expectedValidatorMerkleRoot != this->validatorMerkleRoot_) {
-      throw DynamicException("Invalid validator merkle root");
-    }
-    if (expectedRandomness != this->blockRandomness_) {
-      throw DynamicException("Invalid block randomness");
-    }
-    this->hash_ = Utils::sha3(this->serializeHeader());
-    Hash msgHash = this->hash();
-    if (!Secp256k1::verifySig(
-      this->validatorSig_.r(), this->validatorSig_.s(), this->validatorSig_.v()
-    )) {
-      throw DynamicException("Invalid validator signature");
     }
-    // Get the signature and finalize the block
-    this->validatorPubKey_ = Secp256k1::recover(this->validatorSig_, msgHash);
-    this->finalized_ = true;
+    this->txs_ = SigVerifier::instance().verifyBatch<TxBlock>(rawTxs, requiredChainId);
+    this->txValidators_ = SigVerifier::instance().verifyBatch<TxValidator>(rawValidatorTxs, requiredChainId);
+    this->verifyAndFinalize();
   } catch (std::exception &e) {
-    Logger::logToDebug(LogType::ERROR, Log::block, __func__,
+    LOGERROR(Log::block,
       "Error when deserializing a block: " + std::string(e.what())
     );
     // Throw again because invalid blocks should not be created at all.
@@ -142,6 +84,21 @@ Block::Block(const BytesArrView bytes, const uint64_t& requiredChainId) {
   }
 }
 
+Block::Block(const BytesArrView header, std::vector<TxBlock>&& txs, std::vector<TxValidator>&& txValidators)
+  : txValidators_(std::move(txValidators)), txs_(std::move(txs))
+{
+  try {
+    if (header.size() != 209) throw DynamicException("Invalid block header size");
+    this->parseHeader(header);
+    this->verifyAndFinalize();
+  } catch (std::exception &e) {
+    LOGERROR(Log::block,
+      "Error when rebuilding a block: " + std::string(e.what())
+    );
+    throw DynamicException(std::string(__func__) + ": " + e.what());
+  }
+}
+
 Bytes Block::serializeHeader() const {
   Bytes ret;
   ret.reserve(144);
@@ -156,39 +113,43 @@ Bytes Block::serializeHeader() const {
 
 Bytes Block::serializeBlock() const {
   Bytes ret;
-  ret.insert(ret.end(), this->validatorSig_.cbegin(), this->validatorSig_.cend());
-  Utils::appendBytes(ret, this->serializeHeader());
+  this->serializeBlock(ret);
+  return ret;
+}
+
+void Block::serializeBlock(Bytes& out) const {
+  const size_t start = out.size();
+  out.insert(out.end(), this->validatorSig_.cbegin(), this->validatorSig_.cend());
+  Utils::appendBytes(out, this->serializeHeader());
 
   // Fill in the txValidatorStart with 0s for now, keep track of the index
-  uint64_t txValidatorStartLoc = ret.size();
-  ret.insert(ret.end(), 8, 0x00);
+  size_t txValidatorStartLoc = out.size();
+  out.insert(out.end(), 8, 0x00);
 
   // Serialize the transactions [4 Bytes + Tx Bytes]
   for (const auto &tx : this->txs_) {
     Bytes txBytes = tx.rlpSerialize();
-    Utils::appendBytes(ret, Utils::uint32ToBytes(txBytes.size()));
-    ret.insert(ret.end(), txBytes.begin(), txBytes.end());
+    Utils::appendBytes(out, Utils::uint32ToBytes(txBytes.size()));
+    out.insert(out.end(), txBytes.begin(), txBytes.end());
   }
 
-  // Insert the txValidatorStart
-  BytesArr<8> txValidatorStart = Utils::uint64ToBytes(ret.size());
-  std::memcpy(&ret[txValidatorStartLoc], txValidatorStart.data(), 8);
+  // Insert the txValidatorStart (relative to the start of the block)
+  BytesArr<8> txValidatorStart = Utils::uint64ToBytes(out.size() - start);
+  std::memcpy(&out[txValidatorStartLoc], txValidatorStart.data(), 8);
 
   // Serialize the Validator Transactions [4 Bytes + Tx Bytes]
   for (const auto &tx : this->txValidators_) {
     Bytes txBytes = tx.rlpSerialize();
-    Utils::appendBytes(ret, Utils::uint32ToBytes(txBytes.size()));
-    ret.insert(ret.end(), txBytes.begin(), txBytes.end());
+    Utils::appendBytes(out, Utils::uint32ToBytes(txBytes.size()));
+    out.insert(out.end(), txBytes.begin(), txBytes.end());
   }
-
-  return ret;
 }
 
 const Hash& Block::hash() const { return this->hash_; }
 
 bool Block::appendTx(const TxBlock &tx) {
   if (this->finalized_) {
-    Logger::logToDebug(LogType::ERROR, Log::block, __func__,
+    LOGERROR(Log::block,
       "Cannot append tx to finalized block"
     );
     return false;
@@ -199,7 +160,7 @@ bool Block::appendTx(const TxBlock &tx) {
 
 bool Block::appendTxValidator(const TxValidator &tx) {
   if (this->finalized_) {
-    Logger::logToDebug(LogType::ERROR, Log::block, __func__,
+    LOGERROR(Log::block,
       "Cannot append tx to finalized block"
     );
     return false;
@@ -210,12 +171,12 @@ bool Block::appendTxValidator(const TxValidator &tx) {
 
 bool Block::finalize(const PrivKey& validatorPrivKey, const uint64_t& newTimestamp) {
   if (this->finalized_) {
-    Logger::logToDebug(LogType::ERROR, Log::block, __func__, "Block is already finalized");
+    LOGERROR(Log::block, "Block is already finalized");
     return false;
   }
   // Allow rdPoS to improve block time only if new timestamp is better than old timestamp
   if (this->timestamp_ > newTimestamp) {
-    Logger::logToDebug(LogType::ERROR, Log::block, __func__,
+    LOGERROR(Log::block,
       "Block timestamp not satisfiable, expected higher than " +
       std::to_string(this->timestamp_) + " got " + std::to_string(newTimestamp)
     );
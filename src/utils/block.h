@@ -65,6 +65,19 @@ class Block {
     bool finalized_ = false;                ///< Indicates whether the block is finalized or not. See finalize().
     Hash hash_;                             ///< Cached hash of the block.
 
+    /**
+     * Parse the validator signature and the block header.
+     * @param bytes The raw block data, starting with the validator signature (at least 209 bytes).
+     */
+    void parseHeader(const BytesArrView bytes);
+
+    /**
+     * Check the transactions against the header (heights, Merkle roots and block
+     * randomness), check the validator signature and finalize the block.
+     * @throw DynamicException if any of the checks fail.
+     */
+    void verifyAndFinalize();
+
   public:
     /**
      * Constructor from network/RPC.
@@ -74,6 +87,19 @@ class Block {
      */
     Block(const BytesArrView bytes, const uint64_t& requiredChainId);
 
+    /**
+     * Constructor from the parts of a compact block (see P2P::CompactBlock).
+     * The transactions are NOT verified again, they are expected to come from
+     * the mempool or to be already verified by the caller. Only the header is
+     * checked against them (Merkle roots, block randomness) along with the
+     * validator signature.
+     * @param header The validator signature followed by the block header (209 bytes).
+     * @param txs The block transactions, in block order.
+     * @param txValidators The Validator transactions, in block order.
+     * @throw DynamicException on any invalid block parameter.
+     */
+    Block(const BytesArrView header, std::vector<TxBlock>&& txs, std::vector<TxValidator>&& txValidators);
+
     /**
      * Constructor from creation.
      * @param prevBlockHash_ The previous block hash.
@@ -144,6 +170,13 @@ class Block {
      */
     Bytes serializeBlock() const;
 
+    /**
+     * Append the serialized block to a buffer (see serializeBlock()), so it can be
+     * written straight into a message without an intermediate copy.
+     * @param out The buffer to append to.
+     */
+    void serializeBlock(Bytes& out) const;
+
     /**
      * SHA3-hash the block header (calls serializeHeader() internally).
      * @return The hash of the block header.
@@ -7,23 +7,184 @@ See the LICENSE.txt file in the project root for more information.
 
 #include "db.h"
 
+#include <algorithm>
+
+#include <rocksdb/convenience.h>
+
+const std::vector<DBFamily> DB::families = {
+  {"blocks",          DBPrefix::blocks,          DBFamilyProfile::Cold,  0.10},
+  {"blockHeightMaps", DBPrefix::blockHeightMaps, DBFamilyProfile::Point, 0.05},
+  {"nativeAccounts",  DBPrefix::nativeAccounts,  DBFamilyProfile::Point, 0.25},
+  {"txToBlocks",      DBPrefix::txToBlocks,      DBFamilyProfile::Point, 0.10},
+  {"rdPoS",           DBPrefix::rdPoS,           DBFamilyProfile::Point, 0.02},
+  {"contracts",       DBPrefix::contracts,       DBFamilyProfile::Point, 0.10},
+  {"contractManager", DBPrefix::contractManager, DBFamilyProfile::Point, 0.02},
+  {"events",          DBPrefix::events,          DBFamilyProfile::Scan,  0.04},
+  {"evmHost",         DBPrefix::evmHost,         DBFamilyProfile::Point, 0.25},
+  {"eventBlooms",     DBPrefix::eventBlooms,     DBFamilyProfile::Point, 0.02},
+  {"eventAddressIndex", DBPrefix::eventAddressIndex, DBFamilyProfile::Scan, 0.01},
+  {"eventTopicIndex", DBPrefix::eventTopicIndex, DBFamilyProfile::Scan,  0.01}
+};
+
+/// Pick the best compression the linked library supports (compression libraries are optional at build time).
+static rocksdb::CompressionType bestCompression() {
+  const auto supported = rocksdb::GetSupportedCompressions();
+  for (const auto& type : {
+    rocksdb::kLZ4Compression, rocksdb::kZSTD, rocksdb::kSnappyCompression, rocksdb::kZlibCompression
+  }) {
+    if (std::find(supported.begin(), supported.end(), type) != supported.end()) return type;
+  }
+  return rocksdb::kNoCompression;
+}
+
 DB::DB(const std::filesystem::path& path) {
   this->opts_.create_if_missing = true;
+  this->opts_.create_missing_column_families = true;
   if (!std::filesystem::exists(path)) { // Ensure the database path can actually be found
     std::filesystem::create_directories(path);
   }
-  auto status = rocksdb::DB::Open(this->opts_, path, &this->db_);
+
+  // Every family that already exists has to be opened too. Databases created
+  // before column families were introduced only have "default" (see migrateFromDefaultFamily()).
+  std::vector<std::string> existingFamilies;
+  rocksdb::DB::ListColumnFamilies(this->opts_, path, &existingFamilies); // Fails on new databases, which is fine
+
+  double defaultShare = 1.0;
+  for (const DBFamily& family : DB::families) defaultShare -= family.cacheShare;
+  const DBFamily defaultFamily{rocksdb::kDefaultColumnFamilyName, {}, DBFamilyProfile::Point, defaultShare};
+  std::vector<DBFamily> ownFamilies{defaultFamily};
+  ownFamilies.insert(ownFamilies.end(), DB::families.begin(), DB::families.end());
+  std::vector<rocksdb::ColumnFamilyDescriptor> descriptors;
+  for (const DBFamily& family : ownFamilies) {
+    auto cache = rocksdb::NewLRUCache(uint64_t(blockCacheSize_ * family.cacheShare));
+    this->caches_[family.name] = cache;
+    descriptors.emplace_back(family.name, DB::familyOptions(family, cache));
+  }
+  for (const std::string& name : existingFamilies) {
+    if (this->caches_.contains(name)) continue;
+    LOGWARNING(Log::db, "Opening unknown column family: " + name);
+    descriptors.emplace_back(name, rocksdb::ColumnFamilyOptions());
+  }
+
+  auto status = rocksdb::DB::Open(rocksdb::DBOptions(this->opts_), path, descriptors, &this->handles_, &this->db_);
   if (!status.ok()) {
-    Logger::logToDebug(LogType::ERROR, Log::db, __func__, "Failed to open DB: " + status.ToString());
+    LOGERROR(Log::db, "Failed to open DB: " + status.ToString());
     throw DynamicException("Failed to open DB: " + status.ToString());
   }
+  for (rocksdb::ColumnFamilyHandle* handle : this->handles_) {
+    for (const DBFamily& family : DB::families) {
+      if (family.name != handle->GetName()) continue;
+      this->familyByPrefix_[(uint16_t(family.prefix[0]) << 8) | family.prefix[1]] = handle;
+    }
+  }
+  this->migrateFromDefaultFamily();
+}
+
+bool DB::close() {
+  if (this->db_ != nullptr) {
+    for (rocksdb::ColumnFamilyHandle* handle : this->handles_) this->db_->DestroyColumnFamilyHandle(handle);
+    this->handles_.clear();
+    this->familyByPrefix_.clear();
+    delete this->db_;
+    this->db_ = nullptr;
+  }
+  return (this->db_ == nullptr);
+}
+
+rocksdb::ColumnFamilyOptions DB::familyOptions(const DBFamily& family, const std::shared_ptr<rocksdb::Cache>& cache) {
+  rocksdb::ColumnFamilyOptions cfOpts;
+  rocksdb::BlockBasedTableOptions tableOpts;
+  tableOpts.block_cache = cache;
+  switch (family.profile) {
+    case DBFamilyProfile::Cold:
+      // Big values written once and rarely read again, still looked up by hash
+      tableOpts.block_size = 64 * 1024;
+      tableOpts.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10));
+      cfOpts.compression = bestCompression();
+      cfOpts.level_compaction_dynamic_level_bytes = true;
+      break;
+    case DBFamilyProfile::Point:
+      // Small hot values read by exact key, keep filters/indexes cached and skip compression
+      tableOpts.block_size = 4 * 1024;
+      tableOpts.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10));
+      tableOpts.cache_index_and_filter_blocks = true;
+      tableOpts.pin_l0_filter_and_index_blocks_in_cache = true;
+      cfOpts.compression = rocksdb::kNoCompression;
+      cfOpts.memtable_whole_key_filtering = true;
+      cfOpts.memtable_prefix_bloom_size_ratio = 0.02;
+      break;
+    case DBFamilyProfile::Scan:
+      // Write-once, range-scanned values, bloom filters don't help range scans
+      tableOpts.block_size = 32 * 1024;
+      cfOpts.compression = bestCompression();
+      cfOpts.compaction_style = rocksdb::kCompactionStyleUniversal;
+      break;
+  }
+  cfOpts.table_factory.reset(rocksdb::NewBlockBasedTableFactory(tableOpts));
+  return cfOpts;
+}
+
+void DB::migrateFromDefaultFamily() {
+  uint64_t moved = 0;
+  rocksdb::ColumnFamilyHandle* defaultFamily = this->db_->DefaultColumnFamily();
+  std::unique_ptr<rocksdb::Iterator> it(this->db_->NewIterator(rocksdb::ReadOptions(), defaultFamily));
+  rocksdb::WriteBatch wb;
+  auto flush = [&]() {
+    auto status = this->db_->Write(rocksdb::WriteOptions(), &wb);
+    if (!status.ok()) {
+      LOGERROR(Log::db, "Failed to migrate entries: " + status.ToString());
+      throw DynamicException("Failed to migrate DB entries to column families: " + status.ToString());
+    }
+    wb.Clear();
+  };
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    rocksdb::ColumnFamilyHandle* family = this->familyFor(it->key());
+    if (family == defaultFamily) continue;
+    wb.Put(family, it->key(), it->value());
+    wb.Delete(defaultFamily, it->key());
+    if (++moved % migrationBatchSize_ == 0) flush();
+  }
+  it.reset();
+  if (moved == 0) return;
+  flush();
+  // Get rid of the tombstones left behind
+  this->db_->CompactRange(rocksdb::CompactRangeOptions(), defaultFamily, nullptr, nullptr);
+  LOGINFO(Log::db,
+    "Migrated " + std::to_string(moved) + " entries to their own column families"
+  );
+}
+
+std::vector<DBFamilyStats> DB::getStats() const {
+  std::vector<DBFamilyStats> ret;
+  for (rocksdb::ColumnFamilyHandle* handle : this->handles_) {
+    DBFamilyStats stats{handle->GetName(), 0, 0, 0, 0, 0, 0};
+    this->db_->GetIntProperty(handle, rocksdb::DB::Properties::kEstimateNumKeys, &stats.estimatedKeys);
+    this->db_->GetIntProperty(handle, rocksdb::DB::Properties::kEstimateLiveDataSize, &stats.liveDataSize);
+    this->db_->GetIntProperty(handle, rocksdb::DB::Properties::kTotalSstFilesSize, &stats.sstFilesSize);
+    this->db_->GetIntProperty(handle, rocksdb::DB::Properties::kCurSizeAllMemTables, &stats.memtablesSize);
+    auto cache = this->caches_.find(stats.name);
+    if (cache != this->caches_.end()) {
+      stats.blockCacheUsage = cache->second->GetUsage();
+      stats.blockCacheCapacity = cache->second->GetCapacity();
+    }
+    ret.push_back(std::move(stats));
+  }
+  return ret;
 }
 
 bool DB::putBatch(const DBBatch& batch) const {
+  static Metrics::Histogram& batchSeconds = Metrics::histogram(
+    "orbiter_db_batch_write_seconds", "Time spent writing a batch to the database (lock wait included)."
+  );
+  static Metrics::Counter& batchEntries = Metrics::counter(
+    "orbiter_db_batch_entries_total", "Puts and deletes written to the database in batches."
+  );
+  Metrics::Timer timer(batchSeconds);
+  batchEntries.inc(batch.getPutsSlices().size() + batch.getDelsSlices().size());
   std::lock_guard lock(this->batchLock_);
   rocksdb::WriteBatch wb;
-  for (const rocksdb::Slice& dels : batch.getDelsSlices()) { wb.Delete(dels); }
-  for (const auto& [key, value] : batch.getPutsSlices()) wb.Put(key, value);
+  for (const rocksdb::Slice& dels : batch.getDelsSlices()) { wb.Delete(this->familyFor(dels), dels); }
+  for (const auto& [key, value] : batch.getPutsSlices()) wb.Put(this->familyFor(key), key, value);
   rocksdb::Status s = this->db_->Write(rocksdb::WriteOptions(), &wb);
   return s.ok();
 }
@@ -31,39 +192,61 @@ bool DB::putBatch(const DBBatch& batch) const {
 std::vector<DBEntry> DB::getBatch(
   const Bytes& bytesPfx, const std::vector<Bytes>& keys
 ) const {
+  // Search for specific entries from keys
+  if (!keys.empty()) return this->multiGet(bytesPfx, keys);
+
+  // Search for all entries
   std::lock_guard lock(this->batchLock_);
   std::vector<DBEntry> ret;
-  std::unique_ptr<rocksdb::Iterator> it(this->db_->NewIterator(rocksdb::ReadOptions()));
   rocksdb::Slice pfx(reinterpret_cast<const char*>(bytesPfx.data()), bytesPfx.size());
-
-  // Search for all entries
-  if (keys.empty()) {
-    for (it->Seek(pfx); it->Valid() && it->key().starts_with(pfx); it->Next()) {
-      auto keySlice = it->key();
-      keySlice.remove_prefix(pfx.size());
-      ret.emplace_back(Bytes(keySlice.data(), keySlice.data() + keySlice.size()), Bytes(it->value().data(), it->value().data() + it->value().size()));
-    }
-    it.reset();
-    return ret;
-  }
-
-  // Search for specific entries from keys
+  std::unique_ptr<rocksdb::Iterator> it(this->db_->NewIterator(rocksdb::ReadOptions(), this->familyFor(pfx)));
   for (it->Seek(pfx); it->Valid() && it->key().starts_with(pfx); it->Next()) {
     auto keySlice = it->key();
     keySlice.remove_prefix(pfx.size());
-    for (const Bytes& key : keys) {
-      if (keySlice == rocksdb::Slice(reinterpret_cast<const char*>(key.data()), key.size())) {
-        ret.emplace_back(Bytes(keySlice.data(), keySlice.data() + keySlice.size()), Bytes(it->value().data(), it->value().data() + it->value().size()));
-      }
-    }
+    ret.emplace_back(Bytes(keySlice.data(), keySlice.data() + keySlice.size()), Bytes(it->value().data(), it->value().data() + it->value().size()));
   }
   it.reset();
   return ret;
 }
 
+std::vector<DBEntry> DB::multiGet(const Bytes& bytesPfx, const std::vector<Bytes>& keys) const {
+  std::vector<DBEntry> ret;
+  if (keys.empty()) return ret;
+  std::vector<Bytes> fullKeys;
+  std::vector<rocksdb::Slice> keySlices;
+  std::vector<rocksdb::ColumnFamilyHandle*> keyFamilies;
+  fullKeys.reserve(keys.size());
+  keySlices.reserve(keys.size());
+  keyFamilies.reserve(keys.size());
+  for (const Bytes& key : keys) {
+    Bytes& fullKey = fullKeys.emplace_back(bytesPfx);
+    Utils::appendBytes(fullKey, key);
+    keySlices.emplace_back(reinterpret_cast<const char*>(fullKey.data()), fullKey.size());
+    keyFamilies.emplace_back(this->familyFor(keySlices.back()));
+  }
+  std::vector<rocksdb::PinnableSlice> values(keys.size());
+  std::vector<rocksdb::Status> statuses(keys.size());
+  this->db_->MultiGet(
+    rocksdb::ReadOptions(), keySlices.size(), keyFamilies.data(),
+    keySlices.data(), values.data(), statuses.data()
+  );
+  ret.reserve(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (statuses[i].ok()) {
+      ret.emplace_back(keys[i], Bytes(values[i].data(), values[i].data() + values[i].size()));
+    } else if (!statuses[i].IsNotFound()) {
+      LOGERROR(Log::db,
+        "Failed to get key: " + Hex::fromBytes(fullKeys[i]).get() + " - " + statuses[i].ToString()
+      );
+    }
+  }
+  return ret;
+}
+
 std::vector<Bytes> DB::getKeys(const Bytes& pfx, const Bytes& start, const Bytes& end) {
   std::vector<Bytes> ret;
-  std::unique_ptr<rocksdb::Iterator> it(this->db_->NewIterator(rocksdb::ReadOptions()));
+  rocksdb::Slice pfxSlice(reinterpret_cast<const char*>(pfx.data()), pfx.size());
+  std::unique_ptr<rocksdb::Iterator> it(this->db_->NewIterator(rocksdb::ReadOptions(), this->familyFor(pfxSlice)));
   Bytes startBytes = pfx;
   Bytes endBytes = pfx;
   if (!start.empty()) Utils::appendBytes(startBytes, start);
@@ -12,13 +12,18 @@ See the LICENSE.txt file in the project root for more information.
 #include <filesystem>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include <rocksdb/cache.h>
 #include <rocksdb/db.h>
+#include <rocksdb/filter_policy.h>
+#include <rocksdb/table.h>
 #include <rocksdb/write_batch.h>
 
 #include "utils.h"
 #include "dynamicexception.h"
+#include "metrics.h"
 
 /// Namespace for accessing database prefixes.
 namespace DBPrefix {
@@ -31,6 +36,35 @@ namespace DBPrefix {
   const Bytes contractManager = { 0x00, 0x07 }; ///< "contractManager" = "0007"
   const Bytes events =          { 0x00, 0x08 }; ///< "events" = "0008"
   const Bytes evmHost =         { 0x00, 0x09 }; ///< "EVMHost" = "0009"
+  const Bytes eventBlooms =     { 0x00, 0x0A }; ///< "eventBlooms" = "000A"
+  const Bytes eventAddressIndex = { 0x00, 0x0B }; ///< "eventAddressIndex" = "000B"
+  const Bytes eventTopicIndex = { 0x00, 0x0C }; ///< "eventTopicIndex" = "000C"
+};
+
+/// Tuning profiles for the database's column families, based on their access patterns.
+enum class DBFamilyProfile {
+  Cold,   ///< Large, append-only, rarely re-read values (e.g. blocks). Big blocks, compressed.
+  Point,  ///< Small values mostly read by exact key (e.g. accounts, storage slots). Small blocks, bloom filters.
+  Scan    ///< Write-once values mostly read by range (e.g. events). Compressed, universal compaction.
+};
+
+/// Struct for a database column family's layout.
+struct DBFamily {
+  std::string name;         ///< Column family name.
+  Bytes prefix;             ///< DBPrefix routed to this family.
+  DBFamilyProfile profile;  ///< Tuning profile.
+  double cacheShare;        ///< Share of the total block cache given to this family (0 to 1).
+};
+
+/// Struct for a database column family's statistics.
+struct DBFamilyStats {
+  std::string name;             ///< Column family name.
+  uint64_t estimatedKeys;       ///< Estimated number of keys.
+  uint64_t liveDataSize;        ///< Estimated size of live data, in bytes.
+  uint64_t sstFilesSize;        ///< Total size of all SST files, in bytes.
+  uint64_t memtablesSize;       ///< Size of all memtables, in bytes.
+  uint64_t blockCacheUsage;     ///< Current block cache usage, in bytes.
+  uint64_t blockCacheCapacity;  ///< Block cache capacity, in bytes.
 };
 
 /// Struct for a database connection/endpoint.
@@ -133,15 +167,60 @@ class DBBatch {
 /**
  * Abstraction of a [Speedb](https://github.com/speedb-io/speedb) database (Speedb is a RocksDB drop-in replacement).
  * Keys begin with prefixes that separate entries in several categories.
+ * Each known prefix lives in its own column family (see DB::families), tuned for
+ * its access pattern. Keys are routed by their first two bytes, and still keep
+ * their prefix inside the family, so callers never have to know about families.
+ * Keys without a known prefix go to the default family.
  * @see DBPrefix
  */
 class DB {
   private:
-    rocksdb::DB* db_;               ///< Pointer to the database object itself.
+    rocksdb::DB* db_ = nullptr;     ///< Pointer to the database object itself.
     rocksdb::Options opts_;         ///< Struct with options for managing the database.
     mutable std::mutex batchLock_;  ///< Mutex for managing read/write access to batch operations.
+    std::vector<rocksdb::ColumnFamilyHandle*> handles_; ///< Handles for every opened column family (including default).
+    std::unordered_map<uint16_t, rocksdb::ColumnFamilyHandle*> familyByPrefix_; ///< Column family for each known prefix.
+    std::unordered_map<std::string, std::shared_ptr<rocksdb::Cache>> caches_; ///< Block cache of each column family.
+
+    /// Total block cache size shared between all column families, in bytes.
+    static constexpr uint64_t blockCacheSize_ = uint64_t(512) * 1024 * 1024;
+
+    /// Max number of entries moved per batch when migrating from the single keyspace layout.
+    static constexpr uint64_t migrationBatchSize_ = 10000;
+
+    /**
+     * Build the options for a column family.
+     * @param family The family to build the options for.
+     * @param cache The block cache the family will use.
+     * @return The column family options.
+     */
+    static rocksdb::ColumnFamilyOptions familyOptions(const DBFamily& family, const std::shared_ptr<rocksdb::Cache>& cache);
+
+    /**
+     * Move every entry with a known prefix out of the default column family
+     * into its own family. Used to migrate databases created before column
+     * families existed. Does nothing if there's nothing to migrate.
+     */
+    void migrateFromDefaultFamily();
+
+    /**
+     * Get the column family a key belongs to, based on its first two bytes.
+     * @param key The full key (with prefix).
+     * @return The column family handle.
+     */
+    rocksdb::ColumnFamilyHandle* familyFor(const rocksdb::Slice& key) const {
+      if (key.size() >= 2) {
+        uint16_t pfx = (uint16_t(uint8_t(key[0])) << 8) | uint8_t(key[1]);
+        auto it = this->familyByPrefix_.find(pfx);
+        if (it != this->familyByPrefix_.end()) return it->second;
+      }
+      return this->db_->DefaultColumnFamily();
+    }
 
   public:
+    /// Column family layout, one family per DBPrefix.
+    static const std::vector<DBFamily> families;
+
     /**
      * Constructor. Automatically creates the database if it doesn't exist.
      * @param path The database's filesystem path (relative to the binary's current working directory).
@@ -153,10 +232,14 @@ class DB {
     ~DB() { this->close(); }
 
     /**
-     * Close the database (which is really just deleting its object from memory).
+     * Close the database (which is really just deleting its object from memory,
+     * after releasing the column family handles).
      * @return `true` if the database is closed successfully, `false` otherwise.
      */
-    inline bool close() { delete this->db_; this->db_ = nullptr; return (this->db_ == nullptr); }
+    bool close();
+
+    /// Get statistics for every column family.
+    std::vector<DBFamilyStats> getStats() const;
 
     static Bytes makeNewPrefix(Bytes prefix, const std::string& newPrefix) {
       prefix.reserve(prefix.size() + newPrefix.size());
@@ -171,17 +254,17 @@ class DB {
      * @param pfx (optional) The prefix to search for. Defaults to none.
      * @return `true` if the key exists, `false` otherwise.
      */
-    template <typename BytesContainer> bool has(const BytesContainer& key, const Bytes& pfx = {}) {
-      std::unique_ptr<rocksdb::Iterator> it(this->db_->NewIterator(rocksdb::ReadOptions()));
+    template <typename BytesContainer> bool has(const BytesContainer& key, const Bytes& pfx = {}) const {
       Bytes keyTmp = pfx;
       keyTmp.reserve(pfx.size() + key.size());
       keyTmp.insert(keyTmp.end(), key.begin(), key.end());
       rocksdb::Slice keySlice(reinterpret_cast<const char*>(keyTmp.data()), keyTmp.size());
-      for (it->Seek(keySlice); it->Valid(); it->Next()) {
-        if (it->key() == keySlice) { it.reset(); return true; }
-      }
-      it.reset();
-      return false;
+      // Bloom filters answer most misses without touching the disk
+      std::string unused;
+      auto family = this->familyFor(keySlice);
+      if (!this->db_->KeyMayExist(rocksdb::ReadOptions(), family, keySlice, &unused)) return false;
+      rocksdb::PinnableSlice value;
+      return this->db_->Get(rocksdb::ReadOptions(), family, keySlice, &value).ok();
     }
 
     /**
@@ -192,20 +275,24 @@ class DB {
      * @return The requested value, or an empty Bytes object if the key doesn't exist.
      */
     template <typename BytesContainer> Bytes get(const BytesContainer& key, const Bytes& pfx = {}) const {
-      std::unique_ptr<rocksdb::Iterator> it(this->db_->NewIterator(rocksdb::ReadOptions()));
+      static Metrics::Histogram& getSeconds = Metrics::histogram(
+        "orbiter_db_get_seconds", "Time spent reading a single key from the database."
+      );
+      Metrics::Timer timer(getSeconds);
       Bytes keyTmp = pfx;
       keyTmp.reserve(pfx.size() + key.size());
       keyTmp.insert(keyTmp.end(), key.cbegin(), key.cend());
       rocksdb::Slice keySlice(reinterpret_cast<const char*>(keyTmp.data()), keyTmp.size());
-      for (it->Seek(keySlice); it->Valid(); it->Next()) {
-        if (it->key().ToString() == keySlice) {
-          Bytes value(it->value().data(), it->value().data() + it->value().size());
-          it.reset();
-          return value;
+      // PinnableSlice avoids an extra copy of the value out of the block cache
+      rocksdb::PinnableSlice value;
+      auto status = this->db_->Get(rocksdb::ReadOptions(), this->familyFor(keySlice), keySlice, &value);
+      if (!status.ok()) {
+        if (!status.IsNotFound()) {
+          LOGERROR(Log::db, "Failed to get key: " + Hex::fromBytes(keyTmp).get());
         }
+        return {};
       }
-      it.reset();
-      return {};
+      return Bytes(value.data(), value.data() + value.size());
     }
 
     /**
@@ -224,9 +311,9 @@ class DB {
       keyTmp.insert(keyTmp.end(), key.begin(), key.end());
       rocksdb::Slice keySlice(reinterpret_cast<const char*>(keyTmp.data()), keyTmp.size());
       rocksdb::Slice valueSlice(reinterpret_cast<const char*>(value.data()), value.size());
-      auto status = this->db_->Put(rocksdb::WriteOptions(), keySlice, valueSlice);
+      auto status = this->db_->Put(rocksdb::WriteOptions(), this->familyFor(keySlice), keySlice, valueSlice);
       if (!status.ok()) {
-        Logger::logToDebug(LogType::ERROR, Log::db, __func__, "Failed to put key: " + Hex::fromBytes(keyTmp).get());
+        LOGERROR(Log::db, "Failed to put key: " + Hex::fromBytes(keyTmp).get());
         return false;
       }
       return true;
@@ -244,9 +331,9 @@ class DB {
       keyTmp.reserve(pfx.size() + key.size());
       keyTmp.insert(keyTmp.end(), key.begin(), key.end());
       rocksdb::Slice keySlice(reinterpret_cast<const char*>(keyTmp.data()), keyTmp.size());
-      auto status = this->db_->Delete(rocksdb::WriteOptions(), keySlice);
+      auto status = this->db_->Delete(rocksdb::WriteOptions(), this->familyFor(keySlice), keySlice);
       if (!status.ok()) {
-        Logger::logToDebug(LogType::ERROR, Log::db, __func__, "Failed to delete key: " + Hex::fromBytes(keyTmp).get());
+        LOGERROR(Log::db, "Failed to delete key: " + Hex::fromBytes(keyTmp).get());
         return false;
       }
       return true;
@@ -272,12 +359,22 @@ class DB {
      * Get all entries from a given prefix.
      * @param bytesPfx The prefix to search for.
      * @param keys (optional) A list of keys to search for. Defaults to an empty list.
+     *             If not empty, this is the same as calling multiGet().
      * @return A list of found entries.
      */
     std::vector<DBEntry> getBatch(
       const Bytes& bytesPfx, const std::vector<Bytes>& keys = {}
     ) const;
 
+    /**
+     * Get several specific entries from a given prefix in one go, using point lookups.
+     * @param bytesPfx The prefix of the keys.
+     * @param keys The keys to search for, WITHOUT their prefixes.
+     * @return A list of found entries (keys WITHOUT their prefixes), in the same order
+     *         as the requested keys. Keys that don't exist are skipped.
+     */
+    std::vector<DBEntry> multiGet(const Bytes& bytesPfx, const std::vector<Bytes>& keys) const;
+
     /**
      * Get all keys from a given prefix.
      * Ranges can be used to mitigate very expensive operations
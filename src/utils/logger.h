@@ -10,11 +10,31 @@ See the LICENSE.txt file in the project root for more information.
 
 #include <string>
 #include <iostream>
-#include <queue>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <chrono>
+#include <cctype>
 #include <condition_variable>
+#include <filesystem>
 #include <future>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
 
-/// Enum for the // message types.
+#include "dynamicexception.h"
+#include "mpscringbuffer.h"
+
+/**
+ * Minimum log level compiled into the binary (0 = DEBUG, 1 = INFO, 2 = WARNING, 3 = ERROR).
+ * Calls made through the LOG* macros below this level are discarded at compile time,
+ * message formatting included. Set by CMake through the `LOG_MIN_LEVEL` option.
+ */
+#ifndef ORBITER_LOG_MIN_LEVEL
+#define ORBITER_LOG_MIN_LEVEL 0
+#endif
+
+/// Enum for the message types, in increasing order of severity.
 enum class LogType { DEBUG, INFO, WARNING, ERROR };
 
 /// Namespace with string prefixes for each blockchain module, for printing log/debug messages.
@@ -47,7 +67,10 @@ namespace Log {
   const std::string P2PDiscoveryWorker = "P2P::DiscoveryWorker";   ///< String for `P2P::DiscoveryWorker`.
   const std::string contractManager = "ContractManager";           ///< String for `ContractManager`.
   const std::string syncer = "Syncer";                             ///< String for `Syncer`.
+  const std::string syncEngine = "SyncEngine";                     ///< String for `SyncEngine`.
   const std::string event = "Event";                               ///< String for `Event`.
+  const std::string websocketSession = "WebsocketSession";         ///< String for `WebsocketSession`.
+  const std::string subscriptions = "Subscriptions";               ///< String for `Subscriptions`.
 }
 
 /// Class for storing log information.
@@ -57,6 +80,7 @@ class LogInfo {
     std::string logSrc_;  ///< Log source.
     std::string func_;    ///< Function name.
     std::string message_; ///< Message to log.
+    std::chrono::system_clock::time_point time_; ///< When the message was logged.
 
   public:
     /// Empty constructor.
@@ -70,14 +94,15 @@ class LogInfo {
      * @param message The message to log.
      */
     LogInfo(LogType type, const std::string& logSrc, std::string&& func, std::string&& message) :
-      type_(type), logSrc_(logSrc), func_(std::move(func)), message_(std::move(message)) {};
+      type_(type), logSrc_(logSrc), func_(std::move(func)), message_(std::move(message)),
+      time_(std::chrono::system_clock::now()) {};
 
     ~LogInfo() = default; ///< Default destructor.
 
     /// Move constructor
     LogInfo(LogInfo&& other) noexcept :
       type_(other.type_), func_(std::move(other.func_)),
-      logSrc_(std::move(other.logSrc_)), message_(std::move(other.message_))
+      logSrc_(std::move(other.logSrc_)), message_(std::move(other.message_)), time_(other.time_)
     {};
 
     /// Move assign operator
@@ -86,6 +111,7 @@ class LogInfo {
       this->func_ = std::move(other.func_);
       this->logSrc_ = std::move(other.logSrc_);
       this->message_ = std::move(other.message_);
+      this->time_ = other.time_;
       return *this;
     }
 
@@ -95,14 +121,32 @@ class LogInfo {
     inline const std::string& getLogSrc() const noexcept { return this->logSrc_; };
     inline const std::string& getFunc() const noexcept { return this->func_; };
     inline const std::string& getMessage() const noexcept { return this->message_; };
+    inline const std::chrono::system_clock::time_point& getTime() const noexcept { return this->time_; };
     ///@}
 };
 
-/// Singleton class for logging.
+/**
+ * Singleton class for logging.
+ * Messages go through a lock-free ring buffer to a writer thread, which appends
+ * them to `debug.log` and rotates the file once it grows past a given size.
+ * Messages can be filtered at runtime by level, globally or per module (the
+ * `Log` namespace strings). Hot paths should log through the LOG* macros, which
+ * check the filters before the message is even built, and strip levels below
+ * `ORBITER_LOG_MIN_LEVEL` from the binary altogether.
+ * If the writer falls behind and the buffer fills up, DEBUG and INFO messages
+ * are dropped (and counted), while WARNING and ERROR messages wait for room.
+ */
 class Logger {
+  public:
+    /// Minimum log level compiled into the binary.
+    static constexpr LogType minLevel = static_cast<LogType>(ORBITER_LOG_MIN_LEVEL);
+
   private:
     /// Private constructor as it is a singleton.
-    Logger() : logFile_("debug.log", std::ios::out | std::ios::app) {
+    Logger() : logFile_(logFileName_, std::ios::out | std::ios::app) {
+      std::error_code ec;
+      auto size = std::filesystem::file_size(logFileName_, ec);
+      this->fileSize_ = ec ? 0 : size;
       logThreadFuture_ = std::async(std::launch::async, &Logger::logger, this);
     }
     Logger(const Logger&) = delete;             ///< Make it non-copyable
@@ -111,65 +155,192 @@ class Logger {
     /// Get the instance.
     static Logger& getInstance() { static Logger instance; return instance; }
 
+    /// Number of messages the ring buffer can hold.
+    static constexpr size_t queueCapacity_ = 8192;
+    /// Upper bound for the writer's sleep when idle, in case a wakeup is missed.
+    static constexpr std::chrono::milliseconds idleWait_{50};
+
+    const std::string logFileName_ = "debug.log"; ///< Name of the log file.
     std::ofstream logFile_;                 ///< The file stream.
-    std::mutex logQueueMutex_;              ///< Mutex for protecting access to the log queue.
+    uint64_t fileSize_ = 0;                 ///< Current size of the log file (writer thread only).
+    std::atomic<uint64_t> maxFileSize_ = 64 * 1024 * 1024; ///< Size at which the file is rotated (0 = never).
+    std::atomic<uint64_t> maxFiles_ = 5;    ///< Number of rotated files kept (`debug.log.1` is the newest).
+    MPSCRingBuffer<LogInfo> logQueue_{queueCapacity_}; ///< Queue for the log tasks.
+    std::mutex wakeMutex_;                  ///< Mutex for waking the writer thread.
     std::condition_variable cv_;            ///< Conditional variable to wait for new tasks.
-    std::queue<LogInfo> logQueue_;          ///< Queue for the log tasks.
-    LogInfo curTask_;                       ///< Current task being executed.
+    std::atomic<bool> writerIdle_ = false;  ///< Whether the writer thread is (about to go) sleeping.
+    std::atomic<uint64_t> dropped_ = 0;     ///< Messages dropped since the writer last reported it.
+    std::atomic<LogType> level_ = LogType::DEBUG; ///< Runtime minimum level.
+    std::atomic<bool> hasModuleLevels_ = false;   ///< Whether `moduleLevels_` has any entry.
+    std::shared_mutex moduleLevelsMutex_;   ///< Mutex for `moduleLevels_`.
+    std::unordered_map<std::string, LogType> moduleLevels_; ///< Per-module minimum levels (override `level_`).
     std::atomic<bool> stopWorker_ = false;  ///< Flag for stopping the thread.
     std::future<void> logThreadFuture_;     ///< Future object used to wait for the log thread to finish.
 
     /// Function for the future object.
     void logger() {
       while (true) {
-        std::unique_lock<std::mutex> lock(logQueueMutex_);
-        // Wait until there's a task in the queue or stopWorker_ is true.
-        cv_.wait(lock, [this] { return !logQueue_.empty() || stopWorker_; });
-        if (stopWorker_) return;  // If stopWorker_ is true, return.
-        curTask_ = std::move(logQueue_.front());
-        logQueue_.pop();
-        lock.unlock();
-        logFileInternal();
+        bool wrote = false;
+        while (auto info = this->logQueue_.tryPop()) { this->logFileInternal(*info); wrote = true; }
+        if (uint64_t dropped = this->dropped_.exchange(0)) {
+          this->logFileInternal(LogInfo(LogType::WARNING, "Logger", __func__,
+            std::to_string(dropped) + " messages dropped, log buffer was full"
+          ));
+          wrote = true;
+        }
+        // Flush once per batch instead of once per line
+        if (wrote) this->logFile_.flush();
+        if (this->stopWorker_) return;
+        std::unique_lock<std::mutex> lock(this->wakeMutex_);
+        this->writerIdle_ = true;
+        if (this->logQueue_.empty() && !this->stopWorker_) this->cv_.wait_for(lock, idleWait_);
+        this->writerIdle_ = false;
       }
     };
 
     /**
-     * Log something to the debug file.
-     * Does not consume a parameter as it will use the `curTask_` variable.
+     * Log something to the debug file, rotating it if it got too big.
+     * @param info The message to log.
      */
-    void logFileInternal() {
+    void logFileInternal(const LogInfo& info) {
       std::string logType = "";
-      switch (curTask_.getType()) {
+      switch (info.getType()) {
         case LogType::DEBUG: logType = "DEBUG"; break;
         case LogType::INFO: logType = "INFO"; break;
         case LogType::WARNING: logType = "WARNING"; break;
         case LogType::ERROR: logType = "ERROR"; break;
       }
-      this->logFile_ << "[" << getCurrentTimestamp() << " " << logType << "] "
-        << curTask_.getLogSrc() << "::" << curTask_.getFunc()
-        << " - " << curTask_.getMessage() << std::endl;
+      std::string line = "[" + formatTimestamp(info.getTime()) + " " + logType + "] "
+        + info.getLogSrc() + "::" + info.getFunc() + " - " + info.getMessage() + "\n";
+      this->logFile_ << line;
+      this->fileSize_ += line.size();
+      uint64_t maxFileSize = this->maxFileSize_;
+      if (maxFileSize != 0 && this->fileSize_ >= maxFileSize) {
+        this->logFile_.close();
+        rotateFiles(this->logFileName_, this->maxFiles_);
+        this->logFile_.open(this->logFileName_, std::ios::out | std::ios::app);
+        this->fileSize_ = 0;
+      }
     };
 
     /// Post a task to the queue.
     void postLogTask(LogInfo&& infoToLog) noexcept {
-      {
-        std::unique_lock<std::mutex> lock(logQueueMutex_);
-        logQueue_.emplace(std::move(infoToLog));
+      while (!this->logQueue_.tryPush(std::move(infoToLog))) {
+        if (infoToLog.getType() < LogType::WARNING) { this->dropped_++; return; }
+        { std::lock_guard<std::mutex> lock(this->wakeMutex_); this->cv_.notify_one(); }
+        std::this_thread::yield();
+      }
+      if (this->writerIdle_) {
+        std::lock_guard<std::mutex> lock(this->wakeMutex_);
+        this->cv_.notify_one();
       }
-      cv_.notify_one();
     };
 
+    /// Check the runtime filters for a message (see enabled()).
+    bool isEnabled(LogType type, const std::string& logSrc) {
+      if (this->hasModuleLevels_.load(std::memory_order_relaxed)) {
+        std::shared_lock lock(this->moduleLevelsMutex_);
+        auto it = this->moduleLevels_.find(logSrc);
+        if (it != this->moduleLevels_.end()) return type >= it->second;
+      }
+      return type >= this->level_.load(std::memory_order_relaxed);
+    }
+
   public:
+    /**
+     * Check if a message would be logged, so callers can skip building it if not.
+     * @param type The type of the log.
+     * @param logSrc The source of the log.
+     * @return `true` if the message passes both the compile-time and the runtime filters.
+     */
+    static inline bool enabled(LogType type, const std::string& logSrc) noexcept {
+      return type >= minLevel && getInstance().isEnabled(type, logSrc);
+    }
+
+    /**
+     * Set the runtime minimum level for every module without a level of its own.
+     * @param level The minimum level.
+     */
+    static inline void setLevel(LogType level) { getInstance().level_ = level; }
+
+    /// Get the runtime minimum level.
+    static inline LogType getLevel() { return getInstance().level_; }
+
+    /**
+     * Parse a level name ("DEBUG", "INFO", "WARNING" or "ERROR", case-insensitive).
+     * @param name The level name.
+     * @return The level.
+     * @throw DynamicException if the name is not a level.
+     */
+    static inline LogType levelFromString(std::string name) {
+      for (char& c : name) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+      if (name == "DEBUG") return LogType::DEBUG;
+      if (name == "INFO") return LogType::INFO;
+      if (name == "WARNING") return LogType::WARNING;
+      if (name == "ERROR") return LogType::ERROR;
+      throw DynamicException("Invalid log level: " + name);
+    }
+
+    /**
+     * Set the runtime minimum level for a single module, overriding the global one.
+     * @param logSrc The module (one of the `Log` namespace strings).
+     * @param level The minimum level.
+     */
+    static inline void setModuleLevel(const std::string& logSrc, LogType level) {
+      Logger& instance = getInstance();
+      std::unique_lock lock(instance.moduleLevelsMutex_);
+      instance.moduleLevels_[logSrc] = level;
+      instance.hasModuleLevels_ = true;
+    }
+
+    /**
+     * Remove the level of a module, so it follows the global one again.
+     * @param logSrc The module.
+     */
+    static inline void clearModuleLevel(const std::string& logSrc) {
+      Logger& instance = getInstance();
+      std::unique_lock lock(instance.moduleLevelsMutex_);
+      instance.moduleLevels_.erase(logSrc);
+      instance.hasModuleLevels_ = !instance.moduleLevels_.empty();
+    }
+
+    /**
+     * Set the log file rotation.
+     * @param maxFileSize Size at which the file is rotated, in bytes (0 = never).
+     * @param maxFiles Number of rotated files kept.
+     */
+    static inline void setRotation(uint64_t maxFileSize, uint64_t maxFiles) {
+      getInstance().maxFileSize_ = maxFileSize;
+      getInstance().maxFiles_ = maxFiles;
+    }
+
+    /**
+     * Shift the rotated copies of a file (`file.1` to `file.2` and so on, dropping
+     * the oldest), then move the file itself to `file.1`.
+     * @param file The file to rotate.
+     * @param maxFiles Number of rotated copies to keep (0 just deletes the file).
+     */
+    static inline void rotateFiles(const std::filesystem::path& file, uint64_t maxFiles) {
+      std::error_code ec;
+      auto rotated = [&](uint64_t i) { return std::filesystem::path(file.string() + "." + std::to_string(i)); };
+      if (maxFiles == 0) { std::filesystem::remove(file, ec); return; }
+      std::filesystem::remove(rotated(maxFiles), ec);
+      for (uint64_t i = maxFiles - 1; i > 0; i--) std::filesystem::rename(rotated(i), rotated(i + 1), ec);
+      std::filesystem::rename(file, rotated(1), ec);
+    }
+
     /**
      * Log debug data to the debug file.
      * @param infoToLog The data to log.
      */
     static inline void logToDebug(LogInfo&& infoToLog) noexcept {
+      if (!enabled(infoToLog.getType(), infoToLog.getLogSrc())) return;
       getInstance().postLogTask(std::move(infoToLog));
     }
 
     /**
      * Log debug data to the debug file.
+     * Prefer the LOG* macros on hot paths, as the message is built here even if it gets filtered out.
      * @param type The type of the log.
      * @param logSrc The source of the log.
      * @param func The function name.
@@ -178,33 +349,61 @@ class Logger {
     static inline void logToDebug(
       LogType type, const std::string& logSrc, std::string&& func, std::string&& message
     ) noexcept {
+      if (!enabled(type, logSrc)) return;
       auto log = LogInfo(type, logSrc, std::move(func), std::move(message));
       getInstance().postLogTask(std::move(log));
     }
 
     /// Destructor.
     ~Logger() {
-      stopWorker_ = true;
-      cv_.notify_one();
+      {
+        std::lock_guard<std::mutex> lock(this->wakeMutex_);
+        stopWorker_ = true;
+        cv_.notify_one();
+      }
       logThreadFuture_.get();
       // Flush the remaining queue
-      while (!logQueue_.empty()) {
-        curTask_ = std::move(logQueue_.front());
-        logQueue_.pop();
-        logFileInternal();
-      }
+      while (auto info = this->logQueue_.tryPop()) this->logFileInternal(*info);
+      this->logFile_.flush();
     }
 
-    /// Get the current timestamp as a string in the "%Y-%m-%d %H:%M:%S.ms" format.
-    static inline std::string getCurrentTimestamp() {
-      auto now = std::chrono::system_clock::now();
-      auto itt = std::chrono::system_clock::to_time_t(now);
+    /**
+     * Format a point in time as a string in the "%Y-%m-%d %H:%M:%S.ms" format.
+     * @param time The point in time.
+     */
+    static inline std::string formatTimestamp(const std::chrono::system_clock::time_point& time) {
+      auto itt = std::chrono::system_clock::to_time_t(time);
+      std::tm tm{};
+      gmtime_r(&itt, &tm);
       std::ostringstream ss;
-      ss << std::put_time(gmtime(&itt), "%Y-%m-%d %H:%M:%S");
-      auto millisec = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
+      ss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
+      auto millisec = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()) % 1000;
       ss << '.' << std::setfill('0') << std::setw(3) << millisec.count();
       return ss.str();
     }
+
+    /// Get the current timestamp as a string in the "%Y-%m-%d %H:%M:%S.ms" format.
+    static inline std::string getCurrentTimestamp() {
+      return formatTimestamp(std::chrono::system_clock::now());
+    }
 };
 
+/**
+ * Log a message from the calling function, only building it if it will actually be logged.
+ * Levels below `ORBITER_LOG_MIN_LEVEL` compile to nothing.
+ * @param type The type of the log (must be a constant, e.g. `LogType::DEBUG`).
+ * @param logSrc The source of the log.
+ * @param message Expression for the message, only evaluated if the message is logged.
+ */
+#define LOGMSG(type, logSrc, message) do { \
+  if constexpr ((type) >= Logger::minLevel) { \
+    if (Logger::enabled((type), (logSrc))) Logger::logToDebug((type), (logSrc), __func__, (message)); \
+  } \
+} while (0)
+
+#define LOGDEBUG(logSrc, message) LOGMSG(LogType::DEBUG, logSrc, message)     ///< LOGMSG() at DEBUG level.
+#define LOGINFO(logSrc, message) LOGMSG(LogType::INFO, logSrc, message)       ///< LOGMSG() at INFO level.
+#define LOGWARNING(logSrc, message) LOGMSG(LogType::WARNING, logSrc, message) ///< LOGMSG() at WARNING level.
+#define LOGERROR(logSrc, message) LOGMSG(LogType::ERROR, logSrc, message)     ///< LOGMSG() at ERROR level.
+
 #endif // LOGGER_H
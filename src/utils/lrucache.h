@@ -0,0 +1,132 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#ifndef LRUCACHE_H
+#define LRUCACHE_H
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * Least-recently-used cache with a cost budget.
+ * Every entry carries a cost (e.g. its approximate size in bytes) and the cache
+ * tracks the sum of all costs. Inserting never evicts by itself, callers decide
+ * when it is safe to drop entries by calling trim() (e.g. once nothing is
+ * pinned anymore), which evicts from the least recently used end until the
+ * total cost fits the budget again.
+ * NOT thread-safe, callers are expected to provide their own locking.
+ * @tparam Key The key type.
+ * @tparam Value The value type.
+ * @tparam Hasher The hasher for the key type.
+ */
+template <typename Key, typename Value, typename Hasher = std::hash<Key>> class LRUCache {
+  private:
+    using Entry = std::tuple<Key, Value, uint64_t>; ///< Key, value and cost.
+    std::list<Entry> entries_;  ///< Entries, most recently used first.
+    std::unordered_map<Key, typename std::list<Entry>::iterator, Hasher> index_;  ///< Lookup index into `entries_`.
+    uint64_t budget_; ///< Maximum total cost before trim() starts evicting.
+    uint64_t cost_ = 0; ///< Current total cost.
+
+  public:
+    /**
+     * Constructor.
+     * @param budget The maximum total cost allowed after a trim().
+     */
+    explicit LRUCache(uint64_t budget) : budget_(budget) {}
+
+    /**
+     * Insert or replace an entry, marking it as the most recently used.
+     * @param key The entry's key.
+     * @param value The entry's value.
+     * @param cost The entry's cost. Defaults to 1 (budget counts entries).
+     */
+    void put(const Key& key, Value value, uint64_t cost = 1) {
+      auto it = this->index_.find(key);
+      if (it != this->index_.end()) {
+        this->cost_ -= std::get<2>(*it->second);
+        this->entries_.erase(it->second);
+        this->index_.erase(it);
+      }
+      this->entries_.emplace_front(key, std::move(value), cost);
+      this->index_.emplace(key, this->entries_.begin());
+      this->cost_ += cost;
+    }
+
+    /**
+     * Get an entry, marking it as the most recently used.
+     * @param key The entry's key.
+     * @return A pointer to the value, or `nullptr` if the key is not cached.
+     *         Only valid until the next mutating call.
+     */
+    Value* get(const Key& key) {
+      auto it = this->index_.find(key);
+      if (it == this->index_.end()) return nullptr;
+      this->entries_.splice(this->entries_.begin(), this->entries_, it->second);
+      return &std::get<1>(*it->second);
+    }
+
+    /**
+     * Mark an entry as the most recently used, without returning it.
+     * @param key The entry's key.
+     * @return `true` if the key is cached, `false` otherwise.
+     */
+    bool touch(const Key& key) { return this->get(key) != nullptr; }
+
+    /// Check if a key is cached (does NOT change the usage order).
+    bool contains(const Key& key) const { return this->index_.contains(key); }
+
+    /**
+     * Remove an entry from the cache.
+     * @param key The entry's key.
+     * @return `true` if the entry was removed, `false` if it wasn't cached.
+     */
+    bool erase(const Key& key) {
+      auto it = this->index_.find(key);
+      if (it == this->index_.end()) return false;
+      this->cost_ -= std::get<2>(*it->second);
+      this->entries_.erase(it->second);
+      this->index_.erase(it);
+      return true;
+    }
+
+    /**
+     * Evict least recently used entries until the total cost fits the budget.
+     * @param onEvict Optional callback called for every evicted entry, before it is dropped.
+     * @return The number of evicted entries.
+     */
+    uint64_t trim(const std::function<void(const Key&, Value&)>& onEvict = nullptr) {
+      uint64_t evicted = 0;
+      while (this->cost_ > this->budget_ && !this->entries_.empty()) {
+        auto& [key, value, cost] = this->entries_.back();
+        if (onEvict) onEvict(key, value);
+        this->cost_ -= cost;
+        this->index_.erase(key);
+        this->entries_.pop_back();
+        evicted++;
+      }
+      return evicted;
+    }
+
+    /// Drop every entry.
+    void clear() { this->entries_.clear(); this->index_.clear(); this->cost_ = 0; }
+
+    ///@{
+    /** Getter. */
+    uint64_t size() const { return this->index_.size(); }
+    uint64_t cost() const { return this->cost_; }
+    uint64_t budget() const { return this->budget_; }
+    ///@}
+
+    /// Setter for `budget_`. Takes effect on the next trim().
+    void setBudget(uint64_t budget) { this->budget_ = budget; }
+};
+
+#endif // LRUCACHE_H
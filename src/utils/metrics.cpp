@@ -0,0 +1,138 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "metrics.h"
+#include "dynamicexception.h"
+
+#include <algorithm>
+#include <charconv>
+
+namespace Metrics {
+  /// Format a number for the Prometheus text format (shortest representation that round-trips).
+  static std::string formatNumber(double value) {
+    char buf[32];
+    auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value);
+    return std::string(buf, end);
+  }
+
+  /// Append a sample line (`name{labels} value`).
+  static void appendSample(std::string& out, const std::string& name, const std::string& labels, const std::string& value) {
+    out += name;
+    if (!labels.empty()) out += "{" + labels + "}";
+    out += " " + value + "\n";
+  }
+
+  size_t shardIndex() {
+    static std::atomic<size_t> nextShard = 0;
+    thread_local const size_t index = nextShard.fetch_add(1, std::memory_order_relaxed) % shardCount;
+    return index;
+  }
+
+  uint64_t Counter::value() const {
+    uint64_t ret = 0;
+    for (const Shard& shard : this->shards_) ret += shard.value.load(std::memory_order_relaxed);
+    return ret;
+  }
+
+  void Counter::serialize(std::string& out, const std::string& name, const std::string& labels) const {
+    appendSample(out, name, labels, std::to_string(this->value()));
+  }
+
+  void Gauge::serialize(std::string& out, const std::string& name, const std::string& labels) const {
+    appendSample(out, name, labels, std::to_string(this->value()));
+  }
+
+  const std::vector<double> Histogram::defaultBounds = {
+    0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10
+  };
+
+  Histogram::Histogram(const std::vector<double>& bounds) : bounds_(bounds) {
+    for (Shard& shard : this->shards_) {
+      shard.buckets = std::make_unique<std::atomic<uint64_t>[]>(this->bounds_.size() + 1);
+    }
+  }
+
+  void Histogram::observe(double value) {
+    Shard& shard = this->shards_[shardIndex()];
+    // Buckets are few and sorted, the first one that fits is the one (or +Inf)
+    size_t bucket = std::lower_bound(this->bounds_.begin(), this->bounds_.end(), value) - this->bounds_.begin();
+    shard.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot ret;
+    ret.buckets.assign(this->bounds_.size() + 1, 0);
+    for (const Shard& shard : this->shards_) {
+      for (size_t i = 0; i < ret.buckets.size(); i++) ret.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+      ret.sum += shard.sum.load(std::memory_order_relaxed);
+    }
+    for (size_t i = 1; i < ret.buckets.size(); i++) ret.buckets[i] += ret.buckets[i - 1];
+    ret.count = ret.buckets.back();
+    return ret;
+  }
+
+  void Histogram::serialize(std::string& out, const std::string& name, const std::string& labels) const {
+    Snapshot snapshot = this->snapshot();
+    const std::string prefix = labels.empty() ? "" : labels + ",";
+    for (size_t i = 0; i < this->bounds_.size(); i++) {
+      appendSample(out, name + "_bucket", prefix + "le=\"" + formatNumber(this->bounds_[i]) + "\"", std::to_string(snapshot.buckets[i]));
+    }
+    appendSample(out, name + "_bucket", prefix + "le=\"+Inf\"", std::to_string(snapshot.count));
+    appendSample(out, name + "_sum", labels, formatNumber(snapshot.sum));
+    appendSample(out, name + "_count", labels, std::to_string(snapshot.count));
+  }
+
+  Metric& Registry::getOrCreate(
+    const std::string& name, const std::string& help, const std::string& type,
+    const std::string& labels, const std::function<std::unique_ptr<Metric>()>& create
+  ) {
+    std::lock_guard lock(this->mutex_);
+    auto [familyIt, newFamily] = this->families_.try_emplace(name);
+    Family& family = familyIt->second;
+    if (newFamily) {
+      family.help = help;
+      family.type = type;
+    } else if (family.type != type) {
+      throw DynamicException("Metric " + name + " is already registered as a " + family.type);
+    }
+    auto seriesIt = family.series.find(labels);
+    if (seriesIt == family.series.end()) seriesIt = family.series.emplace(labels, create()).first;
+    return *seriesIt->second;
+  }
+
+  Counter& Registry::counter(const std::string& name, const std::string& help, const std::string& labels) {
+    return static_cast<Counter&>(this->getOrCreate(name, help, "counter", labels,
+      []() { return std::make_unique<Counter>(); }
+    ));
+  }
+
+  Gauge& Registry::gauge(const std::string& name, const std::string& help, const std::string& labels) {
+    return static_cast<Gauge&>(this->getOrCreate(name, help, "gauge", labels,
+      []() { return std::make_unique<Gauge>(); }
+    ));
+  }
+
+  Histogram& Registry::histogram(
+    const std::string& name, const std::string& help, const std::string& labels, const std::vector<double>& bounds
+  ) {
+    return static_cast<Histogram&>(this->getOrCreate(name, help, "histogram", labels,
+      [&bounds]() { return std::make_unique<Histogram>(bounds); }
+    ));
+  }
+
+  std::string Registry::serialize() const {
+    std::string out;
+    std::lock_guard lock(this->mutex_);
+    for (const auto& [name, family] : this->families_) {
+      out += "# HELP " + name + " " + family.help + "\n";
+      out += "# TYPE " + name + " " + family.type + "\n";
+      for (const auto& [labels, metric] : family.series) metric->serialize(out, name, labels);
+    }
+    return out;
+  }
+};
@@ -0,0 +1,243 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Numeric metrics (counters, gauges and histograms), exposed in the Prometheus
+ * text format on the `/metrics` path of the HTTP server.
+ * Metrics are registered once by name (plus an optional label set) and the
+ * returned references stay valid for the whole program, so hot paths keep them
+ * in a function-local static and only ever touch atomics: counters and histograms
+ * are split in per-thread shards so concurrent updates don't fight over the same
+ * cache line, and shards are only added up when the metrics are scraped.
+ * Only registering a new series takes a lock.
+ */
+namespace Metrics {
+  /// Number of shards of counters and histograms.
+  static constexpr size_t shardCount = 16;
+
+  /// Get the shard used by the calling thread (threads are spread round-robin).
+  size_t shardIndex();
+
+  /// Base class for every metric.
+  class Metric {
+    public:
+      virtual ~Metric() = default; ///< Default destructor.
+
+      /**
+       * Append the metric's samples in the Prometheus text format.
+       * @param out The string to append to.
+       * @param name The metric's name.
+       * @param labels The metric's labels (e.g. `method="eth_call"`), empty for none.
+       */
+      virtual void serialize(std::string& out, const std::string& name, const std::string& labels) const = 0;
+  };
+
+  /// Monotonically increasing counter.
+  class Counter : public Metric {
+    private:
+      /// A shard, on its own cache line.
+      struct alignas(64) Shard { std::atomic<uint64_t> value = 0; };
+      std::array<Shard, shardCount> shards_; ///< Per-thread shards.
+
+    public:
+      /**
+       * Increase the counter.
+       * @param n The amount to increase by.
+       */
+      void inc(uint64_t n = 1) { this->shards_[shardIndex()].value.fetch_add(n, std::memory_order_relaxed); }
+
+      /// Get the current value of the counter.
+      uint64_t value() const;
+
+      void serialize(std::string& out, const std::string& name, const std::string& labels) const override;
+  };
+
+  /// Value that can go up and down.
+  class Gauge : public Metric {
+    private:
+      std::atomic<int64_t> value_ = 0; ///< Current value.
+
+    public:
+      /// Set the gauge to a value.
+      void set(int64_t value) { this->value_.store(value, std::memory_order_relaxed); }
+
+      /// Increase the gauge.
+      void inc(int64_t n = 1) { this->value_.fetch_add(n, std::memory_order_relaxed); }
+
+      /// Decrease the gauge.
+      void dec(int64_t n = 1) { this->value_.fetch_sub(n, std::memory_order_relaxed); }
+
+      /// Get the current value of the gauge.
+      int64_t value() const { return this->value_.load(std::memory_order_relaxed); }
+
+      void serialize(std::string& out, const std::string& name, const std::string& labels) const override;
+  };
+
+  /// Distribution of observed values (e.g. latencies) in fixed buckets.
+  class Histogram : public Metric {
+    public:
+      /// Default buckets, for latencies in seconds (100us to 10s).
+      static const std::vector<double> defaultBounds;
+
+      /// Aggregated state of the histogram.
+      struct Snapshot {
+        std::vector<uint64_t> buckets; ///< Cumulative count of each bucket (same order as the bounds), plus +Inf.
+        double sum = 0;                ///< Sum of every observed value.
+        uint64_t count = 0;            ///< Number of observed values.
+      };
+
+    private:
+      /// A shard, on its own cache line.
+      struct alignas(64) Shard {
+        std::unique_ptr<std::atomic<uint64_t>[]> buckets; ///< Count of each bucket, plus +Inf (not cumulative).
+        std::atomic<double> sum = 0;  ///< Sum of the values observed in this shard.
+      };
+      const std::vector<double> bounds_; ///< Upper bounds of the buckets, in increasing order.
+      std::array<Shard, shardCount> shards_; ///< Per-thread shards.
+
+    public:
+      /**
+       * Constructor.
+       * @param bounds Upper bounds of the buckets, in increasing order.
+       */
+      explicit Histogram(const std::vector<double>& bounds = defaultBounds);
+
+      /**
+       * Record a value.
+       * @param value The value to record.
+       */
+      void observe(double value);
+
+      /// Aggregate the shards.
+      Snapshot snapshot() const;
+
+      void serialize(std::string& out, const std::string& name, const std::string& labels) const override;
+  };
+
+  /// Records the lifetime of the object, in seconds, into a histogram.
+  class Timer {
+    private:
+      Histogram& histogram_; ///< The histogram to record into.
+      const std::chrono::steady_clock::time_point start_; ///< When the timer was created.
+
+    public:
+      /**
+       * Constructor. Starts the timer.
+       * @param histogram The histogram to record into.
+       */
+      explicit Timer(Histogram& histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+
+      /// Destructor. Records the elapsed time.
+      ~Timer() {
+        this->histogram_.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - this->start_).count());
+      }
+
+      Timer(const Timer&) = delete; ///< Not copyable.
+      Timer& operator=(const Timer&) = delete; ///< Not copyable.
+  };
+
+  /// Set of every registered metric.
+  class Registry {
+    private:
+      /// Every series of a metric, by labels.
+      struct Family {
+        std::string help; ///< Description of the metric.
+        std::string type; ///< Prometheus type of the metric.
+        std::map<std::string, std::unique_ptr<Metric>> series; ///< Series by labels.
+      };
+      mutable std::mutex mutex_;  ///< Mutex for `families_`.
+      std::map<std::string, Family> families_; ///< Metrics by name.
+
+      /**
+       * Get a series, registering it if needed.
+       * @param name The metric's name.
+       * @param help The metric's description.
+       * @param type The metric's Prometheus type.
+       * @param labels The series' labels.
+       * @param create Function that creates the series.
+       * @return The series.
+       * @throw DynamicException if the name is already registered with another type.
+       */
+      Metric& getOrCreate(
+        const std::string& name, const std::string& help, const std::string& type,
+        const std::string& labels, const std::function<std::unique_ptr<Metric>()>& create
+      );
+
+    public:
+      /// Get the registry used by the whole program.
+      static Registry& instance() { static Registry registry; return registry; }
+
+      /**
+       * Get a counter, registering it if needed.
+       * @param name The counter's name.
+       * @param help The counter's description.
+       * @param labels The series' labels (e.g. `method="eth_call"`), empty for none.
+       * @return The counter.
+       */
+      Counter& counter(const std::string& name, const std::string& help, const std::string& labels = "");
+
+      /**
+       * Get a gauge, registering it if needed.
+       * @param name The gauge's name.
+       * @param help The gauge's description.
+       * @param labels The series' labels, empty for none.
+       * @return The gauge.
+       */
+      Gauge& gauge(const std::string& name, const std::string& help, const std::string& labels = "");
+
+      /**
+       * Get a histogram, registering it if needed.
+       * @param name The histogram's name.
+       * @param help The histogram's description.
+       * @param labels The series' labels, empty for none.
+       * @param bounds Upper bounds of the buckets (only used if the series is new).
+       * @return The histogram.
+       */
+      Histogram& histogram(
+        const std::string& name, const std::string& help, const std::string& labels = "",
+        const std::vector<double>& bounds = Histogram::defaultBounds
+      );
+
+      /// Serialize every metric in the Prometheus text format.
+      std::string serialize() const;
+  };
+
+  /// Shortcut for Registry::instance().counter().
+  inline Counter& counter(const std::string& name, const std::string& help, const std::string& labels = "") {
+    return Registry::instance().counter(name, help, labels);
+  }
+
+  /// Shortcut for Registry::instance().gauge().
+  inline Gauge& gauge(const std::string& name, const std::string& help, const std::string& labels = "") {
+    return Registry::instance().gauge(name, help, labels);
+  }
+
+  /// Shortcut for Registry::instance().histogram().
+  inline Histogram& histogram(
+    const std::string& name, const std::string& help, const std::string& labels = "",
+    const std::vector<double>& bounds = Histogram::defaultBounds
+  ) {
+    return Registry::instance().histogram(name, help, labels, bounds);
+  }
+};
+
+#endif // METRICS_H
@@ -0,0 +1,104 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#ifndef MPSCRINGBUFFER_H
+#define MPSCRINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+/**
+ * Bounded lock-free queue for many producers and a single consumer.
+ * Every slot carries a sequence number that tells whether it is free for the
+ * producer of a given position or ready for the consumer, so producers only
+ * race on a single atomic position (with a CAS) and never wait on each other
+ * nor on the consumer. When the buffer is full, tryPush() fails right away and
+ * it is up to the caller to retry or drop the item.
+ * @tparam T The type of the items. Must be default-constructible and movable.
+ */
+template <typename T> class MPSCRingBuffer {
+  private:
+    /// A slot, on its own cache line so producers writing neighbouring slots don't fight over it.
+    struct alignas(64) Slot {
+      std::atomic<size_t> sequence; ///< Position the slot is expecting next (see class description).
+      T value;                      ///< The item.
+    };
+
+    const size_t mask_;                 ///< Capacity minus one (capacity is a power of two).
+    std::unique_ptr<Slot[]> slots_;     ///< The slots.
+    alignas(64) std::atomic<size_t> head_ = 0; ///< Next position to push to.
+    alignas(64) size_t tail_ = 0;       ///< Next position to pop from (consumer only).
+
+    /// Round a number up to the next power of two (at least 2).
+    static size_t roundCapacity(size_t n) { size_t c = 2; while (c < n) c <<= 1; return c; }
+
+  public:
+    /**
+     * Constructor.
+     * @param capacity Maximum number of items in the buffer, rounded up to a power of two.
+     */
+    explicit MPSCRingBuffer(size_t capacity)
+      : mask_(roundCapacity(capacity) - 1), slots_(std::make_unique<Slot[]>(mask_ + 1))
+    {
+      for (size_t i = 0; i <= this->mask_; i++) this->slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    MPSCRingBuffer(const MPSCRingBuffer&) = delete; ///< Not copyable.
+    MPSCRingBuffer& operator=(const MPSCRingBuffer&) = delete; ///< Not copyable.
+
+    /// Get the capacity of the buffer.
+    size_t capacity() const { return this->mask_ + 1; }
+
+    /**
+     * Push an item. Safe to call from any number of threads.
+     * @param value The item. Only moved from if the push succeeds.
+     * @return `true` if pushed, `false` if the buffer is full.
+     */
+    bool tryPush(T&& value) {
+      size_t pos = this->head_.load(std::memory_order_relaxed);
+      while (true) {
+        Slot& slot = this->slots_[pos & this->mask_];
+        size_t seq = slot.sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0) {
+          // Slot is free for this position, claim it
+          if (this->head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+            slot.value = std::move(value);
+            slot.sequence.store(pos + 1, std::memory_order_release);
+            return true;
+          }
+        } else if (diff < 0) {
+          return false; // The consumer didn't free the slot yet, buffer is full
+        } else {
+          pos = this->head_.load(std::memory_order_relaxed); // Another producer took it
+        }
+      }
+    }
+
+    /**
+     * Pop the oldest item. Must only be called from the consumer thread.
+     * @return The item, or an empty optional if the buffer is empty.
+     */
+    std::optional<T> tryPop() {
+      Slot& slot = this->slots_[this->tail_ & this->mask_];
+      if (slot.sequence.load(std::memory_order_acquire) != this->tail_ + 1) return std::nullopt;
+      std::optional<T> value(std::move(slot.value));
+      slot.value = T();
+      slot.sequence.store(this->tail_ + this->mask_ + 1, std::memory_order_release);
+      this->tail_++;
+      return value;
+    }
+
+    /// Check if there's an item ready to be popped. Must only be called from the consumer thread.
+    bool empty() const {
+      return this->slots_[this->tail_ & this->mask_].sequence.load(std::memory_order_acquire) != this->tail_ + 1;
+    }
+};
+
+#endif // MPSCRINGBUFFER_H
@@ -18,7 +18,12 @@ Options::Options(
   const std::vector<std::pair<boost::asio::ip::address, uint64_t>>& discoveryNodes,
   const Block& genesisBlock, const uint64_t genesisTimestamp, const PrivKey& genesisSigner,
   const std::vector<std::pair<Address, uint256_t>>& genesisBalances,
-  const std::vector<Address>& genesisValidators
+  const std::vector<Address>& genesisValidators,
+  const bool& parallelExecution, const uint32_t& executionThreads,
+  const bool& activityFeed, const uint64_t& rpcMaxBatchSize,
+  const std::string& logLevel, const std::map<std::string, std::string>& logModuleLevels,
+  const uint64_t& logRotateBytes, const uint64_t& logRotateFiles,
+  const uint64_t& evmStorageCacheBytes, const uint64_t& evmCodeCacheBytes
 ) : rootPath_(rootPath), web3clientVersion_(web3clientVersion),
   version_(version), chainID_(chainID), chainOwner_(chainOwner), wsPort_(wsPort), httpPort_(httpPort),
   minDiscoveryConns_(minDiscoveryConns), minNormalConns_(minNormalConns),
@@ -26,7 +31,12 @@ Options::Options(
   eventBlockCap_(eventBlockCap), eventLogCap_(eventLogCap),
   minValidators_(minValidators),
   coinbase_(Address()), isValidator_(false), discoveryNodes_(discoveryNodes),
-  genesisBlock_(genesisBlock), genesisBalances_(genesisBalances), genesisValidators_(genesisValidators)
+  genesisBlock_(genesisBlock), genesisBalances_(genesisBalances), genesisValidators_(genesisValidators),
+  parallelExecution_(parallelExecution), executionThreads_(executionThreads),
+  activityFeed_(activityFeed), rpcMaxBatchSize_(rpcMaxBatchSize),
+  logLevel_(logLevel), logModuleLevels_(logModuleLevels),
+  logRotateBytes_(logRotateBytes), logRotateFiles_(logRotateFiles),
+  evmStorageCacheBytes_(evmStorageCacheBytes), evmCodeCacheBytes_(evmCodeCacheBytes)
 {
   json options;
   if (std::filesystem::exists(rootPath + "/options.json")) return;
@@ -44,6 +54,16 @@ Options::Options(
   options["eventBlockCap"] = eventBlockCap;
   options["eventLogCap"] = eventLogCap;
   options["minValidators"] = minValidators;
+  options["parallelExecution"] = parallelExecution;
+  options["executionThreads"] = executionThreads;
+  options["activityFeed"] = activityFeed;
+  options["rpcMaxBatchSize"] = rpcMaxBatchSize;
+  options["logLevel"] = logLevel;
+  options["logModuleLevels"] = logModuleLevels;
+  options["logRotateBytes"] = logRotateBytes;
+  options["logRotateFiles"] = logRotateFiles;
+  options["evmStorageCacheBytes"] = evmStorageCacheBytes;
+  options["evmCodeCacheBytes"] = evmCodeCacheBytes;
   options["discoveryNodes"] = json::array();
   for (const auto& [address, port] : discoveryNodes) {
     options["discoveryNodes"].push_back(json::object({
@@ -83,7 +103,12 @@ Options::Options(
   const Block& genesisBlock, const uint64_t genesisTimestamp, const PrivKey& genesisSigner,
   const std::vector<std::pair<Address, uint256_t>>& genesisBalances,
   const std::vector<Address>& genesisValidators,
-  const PrivKey& privKey
+  const PrivKey& privKey,
+  const bool& parallelExecution, const uint32_t& executionThreads,
+  const bool& activityFeed, const uint64_t& rpcMaxBatchSize,
+  const std::string& logLevel, const std::map<std::string, std::string>& logModuleLevels,
+  const uint64_t& logRotateBytes, const uint64_t& logRotateFiles,
+  const uint64_t& evmStorageCacheBytes, const uint64_t& evmCodeCacheBytes
 ) : rootPath_(rootPath), web3clientVersion_(web3clientVersion),
   version_(version), chainID_(chainID), chainOwner_(chainOwner), wsPort_(wsPort), httpPort_(httpPort),
   minDiscoveryConns_(minDiscoveryConns), minNormalConns_(minNormalConns),
@@ -91,7 +116,12 @@ Options::Options(
   eventBlockCap_(eventBlockCap), eventLogCap_(eventLogCap),
   minValidators_(minValidators),
   discoveryNodes_(discoveryNodes), coinbase_(Secp256k1::toAddress(Secp256k1::toUPub(privKey))),
-  isValidator_(true), genesisBlock_(genesisBlock), genesisBalances_(genesisBalances), genesisValidators_(genesisValidators)
+  isValidator_(true), genesisBlock_(genesisBlock), genesisBalances_(genesisBalances), genesisValidators_(genesisValidators),
+  parallelExecution_(parallelExecution), executionThreads_(executionThreads),
+  activityFeed_(activityFeed), rpcMaxBatchSize_(rpcMaxBatchSize),
+  logLevel_(logLevel), logModuleLevels_(logModuleLevels),
+  logRotateBytes_(logRotateBytes), logRotateFiles_(logRotateFiles),
+  evmStorageCacheBytes_(evmStorageCacheBytes), evmCodeCacheBytes_(evmCodeCacheBytes)
 {
   if (std::filesystem::exists(rootPath + "/options.json")) return;
   json options;
@@ -109,6 +139,16 @@ Options::Options(
   options["eventBlockCap"] = eventBlockCap;
   options["eventLogCap"] = eventLogCap;
   options["minValidators"] = minValidators;
+  options["parallelExecution"] = parallelExecution;
+  options["executionThreads"] = executionThreads;
+  options["activityFeed"] = activityFeed;
+  options["rpcMaxBatchSize"] = rpcMaxBatchSize;
+  options["logLevel"] = logLevel;
+  options["logModuleLevels"] = logModuleLevels;
+  options["logRotateBytes"] = logRotateBytes;
+  options["logRotateFiles"] = logRotateFiles;
+  options["evmStorageCacheBytes"] = evmStorageCacheBytes;
+  options["evmCodeCacheBytes"] = evmCodeCacheBytes;
   options["discoveryNodes"] = json::array();
   for (const auto& [address, port] : discoveryNodes) {
     options["discoveryNodes"].push_back(json::object({
@@ -187,6 +227,19 @@ Options Options::fromFile(const std::string& rootPath) {
       );
     }
 
+    // Optional, older options.json files don't have them
+    const bool parallelExecution = options.value("parallelExecution", false);
+    const uint32_t executionThreads = options.value("executionThreads", uint32_t(0));
+    const bool activityFeed = options.value("activityFeed", false);
+    const uint64_t rpcMaxBatchSize = options.value("rpcMaxBatchSize", uint64_t(1000));
+    const std::string logLevel = options.value("logLevel", std::string("DEBUG"));
+    const std::map<std::string, std::string> logModuleLevels =
+      options.value("logModuleLevels", std::map<std::string, std::string>());
+    const uint64_t logRotateBytes = options.value("logRotateBytes", uint64_t(64 * 1024 * 1024));
+    const uint64_t logRotateFiles = options.value("logRotateFiles", uint64_t(5));
+    const uint64_t evmStorageCacheBytes = options.value("evmStorageCacheBytes", uint64_t(512) * 1024 * 1024);
+    const uint64_t evmCodeCacheBytes = options.value("evmCodeCacheBytes", uint64_t(128) * 1024 * 1024);
+
     if (options.contains("privKey")) {
       return Options(
         options["rootPath"].get<std::string>(),
@@ -209,7 +262,17 @@ Options Options::fromFile(const std::string& rootPath) {
         genesisSigner,
         genesisBalances,
         genesisValidators,
-        PrivKey(Hex::toBytes(options["privKey"].get<std::string>()))
+        PrivKey(Hex::toBytes(options["privKey"].get<std::string>())),
+        parallelExecution,
+        executionThreads,
+        activityFeed,
+        rpcMaxBatchSize,
+        logLevel,
+        logModuleLevels,
+        logRotateBytes,
+        logRotateFiles,
+        evmStorageCacheBytes,
+        evmCodeCacheBytes
       );
     }
 
@@ -233,7 +296,17 @@ Options Options::fromFile(const std::string& rootPath) {
       options["genesis"]["timestamp"].get<uint64_t>(),
       genesisSigner,
       genesisBalances,
-      genesisValidators
+      genesisValidators,
+      parallelExecution,
+      executionThreads,
+      activityFeed,
+      rpcMaxBatchSize,
+      logLevel,
+      logModuleLevels,
+      logRotateBytes,
+      logRotateFiles,
+      evmStorageCacheBytes,
+      evmCodeCacheBytes
     );
   } catch (std::exception &e) {
     throw DynamicException("Could not create blockchain directory: " + std::string(e.what()));
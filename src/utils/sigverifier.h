@@ -0,0 +1,113 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#ifndef SIGVERIFIER_H
+#define SIGVERIFIER_H
+
+#include <algorithm>
+#include <exception>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "utils.h"
+#include "../libs/BS_thread_pool_light.hpp"
+
+/**
+ * Shared signature verification service (singleton).
+ * Deserializing a transaction verifies its signature and recovers its sender
+ * (`from`), which is by far the most expensive part of it. This spreads batches
+ * of transactions (block bodies, Validator transactions, transaction lists
+ * received from peers) over a persistent thread pool sized from the hardware
+ * concurrency, instead of spawning threads per batch or verifying serially.
+ */
+class SigVerifier {
+  private:
+    BS::thread_pool_light pool_;  ///< Workers shared by every batch.
+
+    /// Minimum number of transactions per worker, smaller batches aren't worth the hand-off.
+    static constexpr uint64_t minTxsPerTask_ = 16;
+
+    /// Constructor. Sized from the hardware concurrency.
+    SigVerifier() : pool_(std::thread::hardware_concurrency()) {}
+
+    /**
+     * Deserialize a contiguous range of a batch.
+     * @tparam TxType TxBlock or TxValidator.
+     * @param raw The serialized transactions.
+     * @param begin First index of the range.
+     * @param end Index after the last one of the range.
+     * @param requiredChainId The chain ID the transactions must have.
+     * @return The deserialized transactions.
+     */
+    template <typename TxType> static std::vector<TxType> verifyRange(
+      const std::vector<BytesArrView>& raw, uint64_t begin, uint64_t end, const uint64_t& requiredChainId
+    ) {
+      std::vector<TxType> txs;
+      txs.reserve(end - begin);
+      for (uint64_t i = begin; i < end; i++) txs.emplace_back(raw[i], requiredChainId);
+      return txs;
+    }
+
+  public:
+    /// Get the service instance.
+    static SigVerifier& instance() { static SigVerifier verifier; return verifier; }
+
+    SigVerifier(const SigVerifier&) = delete; ///< Not copyable.
+    SigVerifier& operator=(const SigVerifier&) = delete; ///< Not copyable.
+
+    /// Getter for the number of workers.
+    uint64_t threadCount() const { return this->pool_.get_thread_count(); }
+
+    /**
+     * Deserialize a batch of transactions, verifying every signature and recovering
+     * every sender in parallel. The calling thread works on the batch too.
+     * @tparam TxType TxBlock or TxValidator.
+     * @param raw The serialized transactions.
+     * @param requiredChainId The chain ID the transactions must have.
+     * @return The deserialized transactions, in the same order as `raw`.
+     * @throw DynamicException (or whatever the transaction constructor throws) for the
+     *        first invalid transaction in batch order, after the whole batch is done.
+     */
+    template <typename TxType> std::vector<TxType> verifyBatch(
+      const std::vector<BytesArrView>& raw, const uint64_t& requiredChainId
+    ) {
+      uint64_t tasks = std::min<uint64_t>(this->threadCount() + 1, raw.size() / minTxsPerTask_);
+      if (tasks <= 1) return SigVerifier::verifyRange<TxType>(raw, 0, raw.size(), requiredChainId);
+
+      // Division remainder goes to the last range, which is the caller's own
+      uint64_t perTask = raw.size() / tasks;
+      std::vector<std::future<std::vector<TxType>>> futures;
+      futures.reserve(tasks - 1);
+      for (uint64_t i = 0; i < tasks - 1; i++) {
+        futures.emplace_back(this->pool_.submit([&raw, &requiredChainId, i, perTask]() {
+          return SigVerifier::verifyRange<TxType>(raw, i * perTask, (i + 1) * perTask, requiredChainId);
+        }));
+      }
+      std::exception_ptr error;
+      std::exception_ptr lastError;
+      std::vector<TxType> last;
+      try {
+        last = SigVerifier::verifyRange<TxType>(raw, (tasks - 1) * perTask, raw.size(), requiredChainId);
+      } catch (...) { lastError = std::current_exception(); }
+
+      // Wait for every range even on failure, they reference `raw`
+      std::vector<TxType> txs;
+      txs.reserve(raw.size());
+      for (auto& future : futures) {
+        try {
+          for (TxType& tx : future.get()) txs.emplace_back(std::move(tx));
+        } catch (...) { if (!error) error = std::current_exception(); }
+      }
+      if (!error) error = lastError;
+      if (error) std::rethrow_exception(error);
+      for (TxType& tx : last) txs.emplace_back(std::move(tx));
+      return txs;
+    }
+};
+
+#endif // SIGVERIFIER_H
@@ -750,7 +750,7 @@ Bytes Utils::padRightBytes(const BytesArrView bytes, unsigned int charAmount, ui
 
 json Utils::readConfigFile() {
   if (!std::filesystem::exists("config.json")) {
-    Logger::logToDebug(LogType::INFO, Log::utils, __func__, "No config file found, generating default");
+    LOGINFO(Log::utils, "No config file found, generating default");
     json config;
     config["rpcport"] = 8080;
     config["p2pport"] = 8081;
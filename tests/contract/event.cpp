@@ -0,0 +1,125 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "../../src/libs/catch2/catch_amalgamated.hpp"
+#include "../../src/utils/db.h"
+#include "../../src/contract/event.h"
+
+#include "../sdktestsuite.hpp"
+
+#include <filesystem>
+
+namespace TEvent {
+  // Event emitted by `address` at the given height, with the given topics
+  Event createEvent(const Address& address, uint64_t height, uint64_t txIndex, const std::vector<Hash>& topics) {
+    return Event(
+      "Transfer", 0, Hash::random(), txIndex, Hash::random(), height,
+      address, Utils::randBytes(64), topics, false
+    );
+  }
+
+  TEST_CASE("Event Class", "[contract][event]") {
+    SECTION("Event binary serialization round trip") {
+      Event e = createEvent(Address(Utils::randBytes(20)), 42, 3, {Hash::random(), Hash::random()});
+      Bytes bytes = e.serializeToBytes();
+      REQUIRE(bytes[0] != '{');
+      Event decoded(bytes);
+      REQUIRE(decoded.serialize() == e.serialize());
+      REQUIRE(decoded.getTopics() == e.getTopics());
+      REQUIRE(decoded.getData() == e.getData());
+
+      bytes.resize(bytes.size() - e.getData().size() - 40); // Cut into the topics
+      REQUIRE_THROWS(Event(bytes));
+      REQUIRE_THROWS(Event(BytesArrView(Bytes{0x02, 0x00})));
+    }
+
+    SECTION("EventBloom matches added items") {
+      Address address(Utils::randBytes(20));
+      Hash topic = Hash::random();
+      EventBloom bloom;
+      REQUIRE(!bloom.mayContain(address.view()));
+      bloom.add(createEvent(address, 1, 0, {topic}));
+      REQUIRE(bloom.mayContain(address.view()));
+      REQUIRE(bloom.mayContain(topic.view()));
+      REQUIRE(!bloom.mayContain(Hash::random().view()));
+      EventBloom copy(bloom.serialize());
+      REQUIRE(copy.serialize() == bloom.serialize());
+      REQUIRE_THROWS(EventBloom(Bytes(255, 0x00)));
+    }
+  }
+
+  TEST_CASE("EventManager Class", "[contract][event]") {
+    SECTION("EventManager flushes events and queries them through the indexes") {
+      SDKTestSuite sdk = SDKTestSuite::createNewEnvironment("testEventManagerFlush");
+      if (std::filesystem::exists("testEventManagerDB")) std::filesystem::remove_all("testEventManagerDB");
+      Address alice(Utils::randBytes(20));
+      Address bob(Utils::randBytes(20));
+      Hash transfer = Hash::random();
+      Hash approval = Hash::random();
+      Hash txHash;
+      {
+        DB db("testEventManagerDB");
+        EventManager manager(db, sdk.getOptions());
+        for (uint64_t height = 1; height <= 100; height++) {
+          manager.commitEvent(createEvent(alice, height, 0, {transfer}));
+          if (height % 10 == 0) {
+            Event e = createEvent(bob, height, 1, {approval, Hash::random()});
+            txHash = e.getTxHash();
+            manager.commitEvent(std::move(e));
+          }
+          // Same as the State does once per block
+          DBBatch batch;
+          REQUIRE(manager.flushEvents(batch) == ((height % 10 == 0) ? 2 : 1));
+          REQUIRE(db.putBatch(batch));
+        }
+        manager.commitEvent(createEvent(bob, 101, 0, {approval})); // Not flushed, saved by the destructor
+
+        REQUIRE(manager.getEvents(1, 101).size() == 111);
+        REQUIRE(manager.getEvents(1, 101, alice).size() == 100);
+        REQUIRE(manager.getEvents(1, 101, bob).size() == 11);
+        REQUIRE(manager.getEvents(1, 101, Address(), {approval}).size() == 11);
+        REQUIRE(manager.getEvents(1, 101, alice, {approval}).empty());
+        REQUIRE(manager.getEvents(15, 30, bob).size() == 2);
+        auto byTx = manager.getEvents(txHash, 100, 1);
+        REQUIRE(byTx.size() == 1);
+        REQUIRE(byTx[0].getAddress() == bob);
+      }
+      // Reopen, everything comes from the database now
+      DB db("testEventManagerDB");
+      EventManager manager(db, sdk.getOptions());
+      auto events = manager.getEvents(90, 101, bob);
+      REQUIRE(events.size() == 3);
+      REQUIRE(events[0].getBlockIndex() == 90);
+      REQUIRE(events[2].getBlockIndex() == 101);
+      REQUIRE(manager.getEvents(1, 101).size() == 111);
+      REQUIRE(manager.getEvents(1, 101, alice).size() == 100);
+      REQUIRE(manager.getEvents(1, 101, bob, {approval}).size() == 11);
+      REQUIRE(manager.getEvents(1, 101, alice, {approval}).empty());
+    }
+
+    SECTION("EventManager migrates events stored as JSON") {
+      SDKTestSuite sdk = SDKTestSuite::createNewEnvironment("testEventManagerMigration");
+      if (std::filesystem::exists("testEventManagerDB")) std::filesystem::remove_all("testEventManagerDB");
+      Address alice(Utils::randBytes(20));
+      Hash topic = Hash::random();
+      DB db("testEventManagerDB");
+      for (uint64_t height = 1; height <= 5; height++) {
+        Event e = createEvent(alice, height, 0, {topic});
+        Bytes key;
+        Utils::appendBytes(key, Utils::uint64ToBytes(height));
+        Utils::appendBytes(key, Utils::uint64ToBytes(0));
+        Utils::appendBytes(key, Utils::uint64ToBytes(0));
+        Utils::appendBytes(key, alice.asBytes());
+        REQUIRE(db.put(key, Utils::stringToBytes(e.serialize()), DBPrefix::events));
+      }
+      EventManager manager(db, sdk.getOptions());
+      REQUIRE(manager.getEvents(1, 5, alice).size() == 5);
+      REQUIRE(manager.getEvents(2, 3, Address(), {topic}).size() == 2);
+      for (const DBEntry& entry : db.getBatch(DBPrefix::events)) REQUIRE(entry.value[0] == 0x01);
+    }
+  }
+}
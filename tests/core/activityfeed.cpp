@@ -0,0 +1,30 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "../../src/libs/catch2/catch_amalgamated.hpp"
+#include "../../src/core/activityfeed.h"
+#include "../../src/utils/utils.h"
+
+namespace TActivityFeed {
+  TEST_CASE("ActivityFeed Class", "[core][activityfeed]") {
+    SECTION("ActivityFeed describes the activity between two samples") {
+      ActivityFeed::Sample from{10, Hash(Utils::randBytes(32)), 100, 5000, 6000};
+      ActivityFeed::Sample to{13, Hash(Utils::randBytes(32)), 103, 5500, 6700};
+      REQUIRE(ActivityFeed::describe(from, from, std::chrono::milliseconds(1000)).empty());
+      REQUIRE(ActivityFeed::describe(from, to, std::chrono::milliseconds(1250)) ==
+        "Block 13 (" + to.hash.hex(true).get() + ") - 3 blocks, 500 transactions accepted, "
+        "700 added to the mempool in the last 1.2s"
+      );
+      // Mempool activity alone is reported too
+      ActivityFeed::Sample mempoolOnly = from;
+      mempoolOnly.mempoolTxs += 42;
+      REQUIRE(ActivityFeed::describe(from, mempoolOnly, std::chrono::milliseconds(1000)).find(
+        "0 blocks, 0 transactions accepted, 42 added to the mempool in the last 1.0s"
+      ) != std::string::npos);
+    }
+  }
+}
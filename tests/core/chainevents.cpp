@@ -0,0 +1,53 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "../../src/libs/catch2/catch_amalgamated.hpp"
+#include "../../src/core/chainevents.h"
+
+#include <atomic>
+#include <thread>
+
+namespace TChainEvents {
+  TEST_CASE("ChainEvents Class", "[core][chainevents]") {
+    SECTION("ChainEvents wakes waiters as soon as their condition is met") {
+      ChainEvents events;
+      std::atomic<uint64_t> height = 0;
+      REQUIRE(events.waitUntil([&]() { return height == 0; }, std::chrono::milliseconds(0)));
+      REQUIRE(!events.waitUntil([&]() { return height == 1; }, std::chrono::milliseconds(10)));
+
+      std::thread producer([&]() {
+        for (uint64_t i = 0; i < 3; i++) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(5));
+          height++;
+          events.notify(ChainEvents::Type::BlockAppended);
+        }
+      });
+      auto start = std::chrono::steady_clock::now();
+      REQUIRE(events.waitUntil([&]() { return height == 3; }, std::chrono::seconds(10)));
+      REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+      producer.join();
+    }
+
+    SECTION("ChainEvents calls subscribers of the published type only") {
+      ChainEvents events;
+      uint64_t blocks = 0;
+      uint64_t txs = 0;
+      uint64_t blockSub = events.subscribe(ChainEvents::Type::BlockAppended, [&](ChainEvents::Type) { blocks++; });
+      events.subscribe(ChainEvents::Type::TxAdded, [&](ChainEvents::Type) { txs++; });
+      events.notify(ChainEvents::Type::BlockAppended);
+      events.notify(ChainEvents::Type::TxAdded);
+      events.notify(ChainEvents::Type::TxAdded);
+      events.notify(ChainEvents::Type::ValidatorTxAdded);
+      REQUIRE(blocks == 1);
+      REQUIRE(txs == 2);
+      REQUIRE(events.unsubscribe(blockSub));
+      REQUIRE(!events.unsubscribe(blockSub));
+      events.notify(ChainEvents::Type::BlockAppended);
+      REQUIRE(blocks == 1);
+    }
+  }
+}
@@ -0,0 +1,105 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "../../src/libs/catch2/catch_amalgamated.hpp"
+#include "../../src/core/mempool.h"
+
+namespace TMempool {
+  // Creates a signed transaction costing at most 1000000 (value) + 21000 * 10000 (fees)
+  TxBlock createTx(const PrivKey& privKey, uint64_t nonce, uint64_t tip) {
+    return TxBlock(
+      Address(Utils::randBytes(20)), Secp256k1::toAddress(Secp256k1::toUPub(privKey)),
+      Bytes(), 8080, nonce, 1000000, tip, 10000, 21000, privKey
+    );
+  }
+
+  TEST_CASE("Mempool Class", "[core][mempool]") {
+    SECTION("Mempool holds future nonces and builds blocks by tip and nonce order") {
+      PrivKey alice(Utils::randBytes(32));
+      PrivKey bob(Utils::randBytes(32));
+      Address aliceAddr = Secp256k1::toAddress(Secp256k1::toUPub(alice));
+      Address bobAddr = Secp256k1::toAddress(Secp256k1::toUPub(bob));
+      Mempool mempool;
+      // Alice's later nonces pay more than her first one, Bob sits in between
+      REQUIRE(mempool.add(createTx(alice, 2, 900)) == TxInvalid::NotInvalid);
+      REQUIRE(mempool.add(createTx(alice, 1, 800)) == TxInvalid::NotInvalid);
+      REQUIRE(mempool.add(createTx(alice, 0, 100)) == TxInvalid::NotInvalid);
+      REQUIRE(mempool.add(createTx(bob, 0, 500)) == TxInvalid::NotInvalid);
+      REQUIRE(mempool.add(createTx(bob, 5, 999)) == TxInvalid::NotInvalid); // Gap, not executable
+      REQUIRE(mempool.size() == 5);
+      REQUIRE(mempool.senderCount() == 2);
+
+      auto txs = mempool.collect([&](const Address&) { return Mempool::AccountInfo(0, uint256_t("1000000000000")); });
+      REQUIRE(txs.size() == 4);
+      REQUIRE(txs[0].getFrom() == bobAddr);
+      for (uint64_t i = 0; i < 3; i++) {
+        REQUIRE(txs[i + 1].getFrom() == aliceAddr);
+        REQUIRE(txs[i + 1].getNonce() == i);
+      }
+
+      // Balance only covers two of Alice's transactions
+      const uint256_t cost = Mempool::maxCost(txs[1]);
+      txs = mempool.collect([&](const Address& sender) {
+        return Mempool::AccountInfo(0, (sender == aliceAddr) ? cost * 2 : uint256_t(0));
+      });
+      REQUIRE(txs.size() == 2);
+      REQUIRE(txs[1].getNonce() == 1);
+
+      // Only the queues of revalidated senders change
+      REQUIRE(mempool.revalidate(aliceAddr, {2, uint256_t("1000000000000")}) == 2);
+      REQUIRE(mempool.size() == 3);
+      REQUIRE(mempool.revalidate(bobAddr, {1, 0}) == 2);
+      REQUIRE(mempool.size() == 1);
+      REQUIRE(mempool.senderCount() == 1);
+    }
+
+    SECTION("Mempool replacement and capacity eviction") {
+      PrivKey alice(Utils::randBytes(32));
+      Mempool mempool(4, 64);
+      TxBlock original = createTx(alice, 0, 1000);
+      REQUIRE(mempool.add(TxBlock(original)) == TxInvalid::NotInvalid);
+      REQUIRE(mempool.add(TxBlock(original)) == TxInvalid::NotInvalid); // Already in
+      REQUIRE(mempool.add(createTx(alice, 0, 1050)) == TxInvalid::Underpriced); // Less than 10% more
+      TxBlock replacement = createTx(alice, 0, 1100);
+      REQUIRE(mempool.add(TxBlock(replacement)) == TxInvalid::NotInvalid);
+      REQUIRE(mempool.size() == 1);
+      REQUIRE(!mempool.contains(original.hash()));
+      REQUIRE(mempool.get(replacement.hash())->getMaxPriorityFeePerGas() == 1100);
+
+      // Fill the pool, then the cheapest sender (along with its later nonces) makes room
+      PrivKey bob(Utils::randBytes(32));
+      PrivKey carol(Utils::randBytes(32));
+      TxBlock bob0 = createTx(bob, 0, 10);
+      TxBlock bob1 = createTx(bob, 1, 900);
+      REQUIRE(mempool.add(TxBlock(bob0)) == TxInvalid::NotInvalid);
+      REQUIRE(mempool.add(TxBlock(bob1)) == TxInvalid::NotInvalid);
+      REQUIRE(mempool.add(createTx(carol, 0, 500)) == TxInvalid::NotInvalid);
+      REQUIRE(mempool.size() == 4);
+      REQUIRE(mempool.add(createTx(carol, 1, 10)) == TxInvalid::Underpriced);
+      REQUIRE(mempool.add(createTx(carol, 1, 20)) == TxInvalid::NotInvalid);
+      REQUIRE(mempool.size() == 3);
+      REQUIRE(!mempool.contains(bob0.hash()));
+      REQUIRE(!mempool.contains(bob1.hash()));
+      REQUIRE(mempool.getTxs().size() == 3);
+    }
+
+    SECTION("Mempool finds transactions by short ID") {
+      PrivKey alice(Utils::randBytes(32));
+      Mempool mempool;
+      TxBlock tx0 = createTx(alice, 0, 100);
+      TxBlock tx1 = createTx(alice, 1, 100);
+      REQUIRE(mempool.add(TxBlock(tx0)) == TxInvalid::NotInvalid);
+      REQUIRE(mempool.add(TxBlock(tx1)) == TxInvalid::NotInvalid);
+      uint64_t unknown = Mempool::shortId(createTx(alice, 2, 100).hash());
+      auto found = mempool.getByShortIds({Mempool::shortId(tx1.hash()), unknown});
+      REQUIRE(found.size() == 1);
+      REQUIRE(found.at(Mempool::shortId(tx1.hash())) == tx1);
+      REQUIRE(found.at(Mempool::shortId(tx1.hash())).getFrom() == tx1.getFrom());
+      REQUIRE(mempool.getByShortIds({}).empty());
+    }
+  }
+}
@@ -158,6 +158,80 @@ namespace TState {
       }
     }
 
+    SECTION("Test State flushes touched accounts to DB after each block") {
+      auto blockchainWrapper = initialize(validatorPrivKeysState, validatorPrivKeysState[0], 8080, true, testDumpPath + "/stateBlockFlushTest");
+      PrivKey privkey(Utils::randBytes(32));
+      Address me = Secp256k1::toAddress(Secp256k1::toUPub(privkey));
+      Address targetOfTransactions = Address(Utils::randBytes(20));
+      blockchainWrapper.state.addBalance(me);
+      TxBlock tx(
+          targetOfTransactions,
+          me,
+          Bytes(),
+          8080,
+          blockchainWrapper.state.getNativeNonce(me),
+          1000000000000000000,
+          21000,
+          1000000000,
+          1000000000,
+          privkey
+      );
+      Hash txHash = tx.hash();
+
+      auto newBestBlock = createValidBlock(validatorPrivKeysState, blockchainWrapper.state, blockchainWrapper.storage, {tx});
+      REQUIRE(blockchainWrapper.state.validateNextBlock(newBestBlock));
+      blockchainWrapper.state.processNextBlock(std::move(newBestBlock));
+
+      // Nothing was destructed yet, but the block and the accounts it touched should already be in the DB.
+      REQUIRE(blockchainWrapper.db.has(txHash.get(), DBPrefix::txToBlocks));
+      REQUIRE(Block(blockchainWrapper.db.get(std::string("latest"), DBPrefix::blocks), blockchainWrapper.options.getChainID()).hash() == blockchainWrapper.storage.latest()->hash());
+      REQUIRE(Utils::bytesToUint64(blockchainWrapper.db.get(std::string("latest"), DBPrefix::evmHost)) == 1);
+      for (const auto& addr : {me, targetOfTransactions}) {
+        Bytes value = blockchainWrapper.db.get(addr.get(), DBPrefix::nativeAccounts);
+        BytesArrView data(value);
+        REQUIRE(Utils::bytesToUint256(data.subspan(0, 32)) == blockchainWrapper.state.getNativeBalance(addr));
+        REQUIRE(Utils::bytesToUint64(data.subspan(32)) == blockchainWrapper.state.getNativeNonce(addr));
+      }
+    }
+
+    SECTION("Test State flushes C++ contracts to DB after each block") {
+      auto blockchainWrapper = initialize(validatorPrivKeysState, validatorPrivKeysState[0], 8080, true, testDumpPath + "/stateContractFlushTest");
+      PrivKey privkey(Utils::randBytes(32));
+      Address me = Secp256k1::toAddress(Secp256k1::toUPub(privkey));
+      blockchainWrapper.state.addBalance(me);
+      Bytes createNewERC20ContractData = Hex::toBytes("0xb74e5ed5");
+      Utils::appendBytes(createNewERC20ContractData, ABI::Encoder::encodeData(
+        std::string("TestToken"), std::string("TT"), uint256_t(18), uint256_t("1000000000000000000")
+      ));
+      TxBlock tx(
+          ProtocolContractAddresses.at("ContractManager"),
+          me,
+          createNewERC20ContractData,
+          8080,
+          blockchainWrapper.state.getNativeNonce(me),
+          0,
+          21000,
+          1000000000,
+          1000000000,
+          privkey
+      );
+
+      auto newBestBlock = createValidBlock(validatorPrivKeysState, blockchainWrapper.state, blockchainWrapper.storage, {tx});
+      REQUIRE(blockchainWrapper.state.validateNextBlock(newBestBlock));
+      blockchainWrapper.state.processNextBlock(std::move(newBestBlock));
+      REQUIRE(blockchainWrapper.state.getContracts().size() == 1);
+      const Address erc20 = blockchainWrapper.state.getContracts()[0].second;
+
+      // Nothing was destructed yet, but the contract, its state and the validators should already be in the DB.
+      REQUIRE(Utils::bytesToString(blockchainWrapper.db.get(erc20.get(), DBPrefix::contractManager)) == "ERC20");
+      Bytes erc20Prefix = DBPrefix::contracts;
+      Utils::appendBytes(erc20Prefix, erc20.get());
+      REQUIRE(Utils::bytesToUint256(blockchainWrapper.db.get(std::string("totalSupply_"), erc20Prefix)) == uint256_t("1000000000000000000"));
+      Utils::appendBytes(erc20Prefix, Utils::stringToBytes("balances_"));
+      REQUIRE(Utils::fromBigEndian<uint256_t>(blockchainWrapper.db.get(me.get(), erc20Prefix)) == uint256_t("1000000000000000000"));
+      REQUIRE(blockchainWrapper.db.getBatch(DBPrefix::rdPoS).size() == validatorPrivKeysState.size());
+    }
+
     SECTION("Test State mempool") {
       std::unordered_map<PrivKey, std::pair<uint256_t, uint64_t>, SafeHash> randomAccounts;
       for (uint64_t i = 0; i < 500; ++i) {
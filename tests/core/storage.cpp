@@ -205,7 +205,11 @@ namespace TStorage {
         }
 
         REQUIRE(blockchainWrapper.storage.currentChainSize() == 2001);
-        // Check if the chain is filled with the correct blocks.
+        // Keep only the latest 1000 blocks in memory, the periodic save thread may have done part of it already
+        REQUIRE(blockchainWrapper.storage.trimChain() <= 1001);
+        REQUIRE(blockchainWrapper.storage.trimChain() == 0);
+        REQUIRE(blockchainWrapper.storage.currentChainSize() == 2001);
+        // Check if the chain (or the DB, for evicted blocks) is filled with the correct blocks.
         for (uint64_t i = 0; i < 2000; i++) {
           auto block = blockchainWrapper.storage.getBlock(i + 1);
           const auto& [requiredBlock, requiredTxs] = blocksWithTxs[i];
@@ -222,6 +226,12 @@ namespace TStorage {
           REQUIRE(block->getTxs().size() == requiredBlock.getTxs().size());
           REQUIRE(block->getValidatorPubKey() == requiredBlock.getValidatorPubKey());
           REQUIRE(block->isFinalized() == requiredBlock.isFinalized());
+          for (uint64_t ii = 0; ii < requiredTxs.size(); ii++) {
+            const auto& [tx, blockHash, blockIndex, blockHeight] = blockchainWrapper.storage.getTx(requiredTxs[ii].hash());
+            REQUIRE(tx->hash() == requiredTxs[ii].hash());
+            REQUIRE(blockIndex == ii);
+            REQUIRE(blockHeight == i + 1);
+          }
         }
       }
       // Load DB again...
@@ -0,0 +1,58 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "../../src/libs/catch2/catch_amalgamated.hpp"
+#include "../../src/core/txinventory.h"
+
+namespace TTxInventory {
+  TEST_CASE("TxInventory Class", "[core][txinventory]") {
+    SECTION("TxInventory returns the hashes added after a sequence") {
+      TxInventory inventory;
+      std::vector<Hash> hashes;
+      for (uint64_t i = 0; i < 10; i++) {
+        hashes.emplace_back(Hash::random());
+        REQUIRE(inventory.add(hashes.back()) == i + 1);
+      }
+      REQUIRE(inventory.sequence() == 10);
+
+      auto delta = inventory.since(0, 100);
+      REQUIRE(delta.complete);
+      REQUIRE(delta.sequence == 10);
+      REQUIRE(delta.hashes == hashes);
+
+      delta = inventory.since(7, 100);
+      REQUIRE(delta.sequence == 10);
+      REQUIRE(delta.hashes == std::vector<Hash>(hashes.begin() + 7, hashes.end()));
+
+      delta = inventory.since(10, 100);
+      REQUIRE(delta.complete);
+      REQUIRE(delta.sequence == 10);
+      REQUIRE(delta.hashes.empty());
+
+      // Capped, the rest comes next time
+      delta = inventory.since(2, 3);
+      REQUIRE(delta.sequence == 5);
+      REQUIRE(delta.hashes == std::vector<Hash>(hashes.begin() + 2, hashes.begin() + 5));
+    }
+
+    SECTION("TxInventory asks to start over when the log can't serve the sequence") {
+      TxInventory inventory(4);
+      for (uint64_t i = 0; i < 10; i++) inventory.add(Hash::random());
+      REQUIRE(inventory.since(6, 100).complete);
+      REQUIRE(inventory.since(6, 100).hashes.size() == 4);
+
+      auto delta = inventory.since(5, 100); // Sequence 6 was dropped from the log
+      REQUIRE(!delta.complete);
+      REQUIRE(delta.sequence == 10);
+      REQUIRE(delta.hashes.empty());
+
+      delta = inventory.since(42, 100); // Sequence from before a restart
+      REQUIRE(!delta.complete);
+      REQUIRE(delta.sequence == 10);
+    }
+  }
+}
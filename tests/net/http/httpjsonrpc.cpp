@@ -268,6 +268,14 @@ namespace THTTPJsonRPC{
         REQUIRE(txJson["s"] == Hex::fromBytes(Utils::uintToBytes(tx.getS()),true).forRPC());
       }
 
+      // Blocks are served from the response cache, the same bytes every time
+      std::string blockRequest = R"({"jsonrpc":"2.0","method":"eth_getBlockByNumber","params":["0x1",true],"id":1})";
+      std::string cachedBlock = makeHTTPRequest(blockRequest, "127.0.0.1", std::to_string(9999), "/", "POST", "application/json");
+      REQUIRE(makeHTTPRequest(blockRequest, "127.0.0.1", std::to_string(9999), "/", "POST", "application/json") == cachedBlock);
+      REQUIRE(json::parse(cachedBlock)["result"] == eth_getBlockByNumberResponse["result"]);
+      REQUIRE(json::parse(cachedBlock)["id"] == 1);
+      REQUIRE(blockchainWrapper.http.getResponseCache().size() > 0);
+
       json eth_getBlockTransactionCountByHashResponse = requestMethod("eth_getBlockTransactionCountByHash", json::array({newBestBlock.hash().hex(true)}));
       REQUIRE(eth_getBlockTransactionCountByHashResponse["result"] == Hex::fromBytes(Utils::uintToBytes(uint64_t(transactions.size())),true).forRPC());
 
@@ -397,6 +405,137 @@ namespace THTTPJsonRPC{
         REQUIRE(eth_getTransactionReceiptResponse["result"]["root"] == Hash().hex(true));
         REQUIRE(eth_getTransactionReceiptResponse["result"]["status"] == "0x1");
       }
+
+      // Everything above shows up in the metrics
+      std::string metrics = makeHTTPRequest("", "127.0.0.1", std::to_string(9999), "/metrics", "GET", "text/plain");
+      REQUIRE(metrics.find("# TYPE orbiter_rpc_requests_total counter") != std::string::npos);
+      REQUIRE(metrics.find("orbiter_rpc_requests_total{method=\"eth_getTransactionReceipt\"} " + std::to_string(transactions.size())) != std::string::npos);
+      REQUIRE(metrics.find("orbiter_rpc_request_seconds_count{method=\"eth_getTransactionReceipt\"} " + std::to_string(transactions.size())) != std::string::npos);
+      REQUIRE(metrics.find("# TYPE orbiter_rpc_cache_hits_total counter") != std::string::npos);
+      REQUIRE(metrics.find("orbiter_block_height 1") != std::string::npos);
+      REQUIRE(metrics.find("orbiter_mempool_txs 0") != std::string::npos);
+      REQUIRE(metrics.find("orbiter_db_estimated_keys{family=\"default\"}") != std::string::npos);
+      REQUIRE(metrics.find("# TYPE orbiter_db_block_cache_usage_bytes gauge") != std::string::npos);
+      REQUIRE(metrics.find("orbiter_p2p_duplicates_suppressed_total{command=\"BroadcastTx\"} 0") != std::string::npos);
+
+      // Batch requests are answered item by item, in the same order
+      json batch = json::array();
+      for (uint64_t i = 0; i < transactions.size(); ++i) {
+        batch.push_back({
+          {"jsonrpc", "2.0"}, {"id", i}, {"method", "eth_getTransactionReceipt"},
+          {"params", json::array({transactions[i].hash().hex(true)})}
+        });
+      }
+      batch.push_back({{"jsonrpc", "2.0"}, {"id", "last"}, {"method", "eth_blockNumber"}, {"params", json::array()}});
+      batch.push_back(42);
+      batch.push_back({{"jsonrpc", "2.0"}, {"id", "broken"}, {"method", "eth_getTransactionReceipt"}, {"params", json::array({"0xzz"})}});
+      json batchResponse = json::parse(makeHTTPRequest(
+        batch.dump(), "127.0.0.1", std::to_string(9999), "/", "POST", "application/json"
+      ));
+      REQUIRE(batchResponse.is_array());
+      REQUIRE(batchResponse.size() == transactions.size() + 3);
+      for (uint64_t i = 0; i < transactions.size(); ++i) {
+        REQUIRE(batchResponse[i]["id"] == i);
+        REQUIRE(batchResponse[i]["result"]["transactionHash"] == transactions[i].hash().hex(true));
+      }
+      REQUIRE(batchResponse[transactions.size()]["id"] == "last");
+      REQUIRE(batchResponse[transactions.size()]["result"] == "0x1");
+      REQUIRE(batchResponse[transactions.size() + 1]["error"]["code"] == -32600);
+      REQUIRE(batchResponse[transactions.size() + 1]["jsonrpc"] == "2.0");
+      REQUIRE(batchResponse[transactions.size() + 1]["id"].is_null());
+      // Failed items keep their id, so clients can still match them
+      REQUIRE(batchResponse[transactions.size() + 2]["error"]["code"] == -32603);
+      REQUIRE(batchResponse[transactions.size() + 2]["jsonrpc"] == "2.0");
+      REQUIRE(batchResponse[transactions.size() + 2]["id"] == "broken");
+      json emptyBatchResponse = json::parse(makeHTTPRequest(
+        "[]", "127.0.0.1", std::to_string(9999), "/", "POST", "application/json"
+      ));
+      REQUIRE(emptyBatchResponse["error"]["code"] == -32600);
+
+      // Filters only return what's new since they were created or last polled
+      json blockFilter = requestMethod("eth_newBlockFilter", json::array());
+      json pendingFilter = requestMethod("eth_newPendingTransactionFilter", json::array());
+      json logFilter = requestMethod("eth_newFilter", json::array({{{"fromBlock", "0x0"}}}));
+      REQUIRE(blockFilter["result"].is_string());
+      REQUIRE(pendingFilter["result"].is_string());
+      REQUIRE(logFilter["result"].is_string());
+      REQUIRE(requestMethod("eth_newFilter", json::array({{{"address", "0x1234"}}}))["error"]["code"] == -32603);
+      REQUIRE(requestMethod("eth_getFilterChanges", json::array({blockFilter["result"]}))["result"] == json::array());
+      REQUIRE(blockchainWrapper.http.getFilters().size() == 3);
+
+      // WebSocket clients upgrade on the same port and get pushed what they subscribed to
+      net::io_context wsIoc;
+      websocket::stream<tcp::socket> ws(wsIoc);
+      net::connect(ws.next_layer(), tcp::resolver(wsIoc).resolve("127.0.0.1", std::to_string(9999)));
+      ws.handshake("127.0.0.1", "/");
+      auto wsRead = [&ws]() {
+        beast::flat_buffer buffer;
+        ws.read(buffer);
+        return json::parse(beast::buffers_to_string(buffer.data()));
+      };
+      auto wsRequest = [&ws, &wsRead](const std::string& method, const json& params) {
+        ws.write(net::buffer(json({{"jsonrpc", "2.0"}, {"id", 1}, {"method", method}, {"params", params}}).dump()));
+        return wsRead();
+      };
+      REQUIRE(wsRequest("eth_blockNumber", json::array())["result"] == "0x1");
+      json headsSubscription = wsRequest("eth_subscribe", json::array({"newHeads"}));
+      json txsSubscription = wsRequest("eth_subscribe", json::array({"newPendingTransactions"}));
+      REQUIRE(headsSubscription["result"].is_string());
+      REQUIRE(txsSubscription["result"].is_string());
+      REQUIRE(headsSubscription["result"] != txsSubscription["result"]);
+      REQUIRE(wsRequest("eth_subscribe", json::array({"logs", {{"address", "0x1234"}}}))["error"]["code"] == -32603);
+      REQUIRE(wsRequest("eth_subscribe", json::array({"syncing"}))["error"]["code"] == -32603);
+      REQUIRE(blockchainWrapper.http.getSubscriptions().size() == 2);
+
+      const auto& [pendingKey, pendingVal] = *randomAccounts.begin();
+      Address pendingFrom = Secp256k1::toAddress(Secp256k1::toUPub(pendingKey));
+      TxBlock pendingTx(
+        targetOfTransactions, pendingFrom, Bytes(), 8080,
+        blockchainWrapper.state.getNativeNonce(pendingFrom), 1, 21000, 1000000000, 1000000000, pendingKey
+      );
+      REQUIRE(blockchainWrapper.state.addTx(TxBlock(pendingTx)) == TxInvalid::NotInvalid);
+      json txNotification = wsRead();
+      REQUIRE(txNotification["method"] == "eth_subscription");
+      REQUIRE(txNotification["params"]["subscription"] == txsSubscription["result"]);
+      REQUIRE(txNotification["params"]["result"] == pendingTx.hash().hex(true).get());
+
+      auto secondBlock = createValidBlock(validatorPrivKeysHttpJsonRpc, blockchainWrapper.state, blockchainWrapper.storage);
+      REQUIRE(blockchainWrapper.state.validateNextBlock(secondBlock));
+      blockchainWrapper.state.processNextBlock(Block(secondBlock));
+      json headNotification = wsRead();
+      REQUIRE(headNotification["method"] == "eth_subscription");
+      REQUIRE(headNotification["params"]["subscription"] == headsSubscription["result"]);
+      REQUIRE(headNotification["params"]["result"]["number"] == "0x2");
+      REQUIRE(headNotification["params"]["result"]["hash"] == secondBlock.hash().hex(true).get());
+
+      REQUIRE(wsRequest("eth_unsubscribe", json::array({headsSubscription["result"]}))["result"] == true);
+      REQUIRE(wsRequest("eth_unsubscribe", json::array({headsSubscription["result"]}))["result"] == false);
+      REQUIRE(blockchainWrapper.http.getSubscriptions().size() == 1);
+      ws.close(websocket::close_code::normal);
+
+      // Polling the filters created before block 2 and the pending transaction
+      REQUIRE(requestMethod("eth_getFilterChanges", json::array({blockFilter["result"]}))["result"] == json::array({secondBlock.hash().hex(true).get()}));
+      REQUIRE(requestMethod("eth_getFilterChanges", json::array({blockFilter["result"]}))["result"] == json::array());
+      REQUIRE(requestMethod("eth_getFilterChanges", json::array({pendingFilter["result"]}))["result"] == json::array({pendingTx.hash().hex(true).get()}));
+      REQUIRE(requestMethod("eth_getFilterChanges", json::array({pendingFilter["result"]}))["result"] == json::array());
+      REQUIRE(requestMethod("eth_getFilterChanges", json::array({logFilter["result"]}))["result"] == json::array());
+      REQUIRE(requestMethod("eth_getFilterLogs", json::array({logFilter["result"]}))["result"] == json::array());
+      REQUIRE(requestMethod("eth_getFilterLogs", json::array({blockFilter["result"]}))["error"]["code"] == -32000);
+      REQUIRE(requestMethod("eth_uninstallFilter", json::array({blockFilter["result"]}))["result"] == true);
+      REQUIRE(requestMethod("eth_uninstallFilter", json::array({blockFilter["result"]}))["result"] == false);
+      REQUIRE(requestMethod("eth_getFilterChanges", json::array({blockFilter["result"]}))["error"]["code"] == -32000);
+      REQUIRE(blockchainWrapper.http.getFilters().size() == 2);
+
+      // The number of filters is capped, and filters that aren't polled expire
+      Filters filters(blockchainWrapper.state, blockchainWrapper.storage, blockchainWrapper.options, 2, std::chrono::milliseconds(100));
+      std::string firstFilter = filters.newBlockFilter();
+      std::string secondFilter = filters.newPendingTransactionFilter();
+      REQUIRE_THROWS(filters.newBlockFilter());
+      REQUIRE(filters.changes(firstFilter) == json::array());
+      std::this_thread::sleep_for(std::chrono::milliseconds(150));
+      REQUIRE_THROWS(filters.changes(firstFilter));
+      REQUIRE_NOTHROW(filters.newBlockFilter());
+      REQUIRE(filters.size() == 1);
     }
   }
 }
@@ -0,0 +1,65 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "../../src/libs/catch2/catch_amalgamated.hpp"
+#include "../../src/net/p2p/bufferpool.h"
+
+namespace TBufferPool {
+  TEST_CASE("P2P BufferPool", "[p2p][bufferpool]") {
+    SECTION("BufferPool reuses released buffers") {
+      P2P::BufferPool pool(2, 1024);
+      Bytes buffer = pool.acquire(100);
+      REQUIRE(buffer.empty());
+      REQUIRE(buffer.capacity() >= 100);
+      buffer.assign(100, 0xFF);
+      const Byte* data = buffer.data();
+      pool.release(std::move(buffer));
+      REQUIRE(pool.size() == 1);
+
+      Bytes reused = pool.acquire(50);
+      REQUIRE(reused.empty());
+      REQUIRE(reused.data() == data);
+      REQUIRE(pool.size() == 0);
+    }
+
+    SECTION("BufferPool keeps a bounded amount of memory") {
+      P2P::BufferPool pool(2, 1024);
+      pool.release(Bytes());             // Nothing to keep
+      pool.release(Bytes(2048, 0x00));   // Too large
+      REQUIRE(pool.size() == 0);
+      for (int i = 0; i < 4; i++) pool.release(Bytes(512, 0x00));
+      REQUIRE(pool.size() == 2);
+    }
+
+    SECTION("BufferPool caps the total bytes it keeps") {
+      P2P::BufferPool pool(16, 1024, 2048);
+      pool.release(Bytes(32, 0x00));     // Too small to be worth keeping
+      REQUIRE(pool.size() == 0);
+      for (int i = 0; i < 4; i++) pool.release(Bytes(1024, 0x00));
+      REQUIRE(pool.size() == 2);
+      REQUIRE(pool.bytes() == 2048);
+      Bytes buffer = pool.acquire(1024);
+      REQUIRE(pool.bytes() == 1024);
+    }
+
+    SECTION("BufferPool doesn't hand large buffers to small messages") {
+      P2P::BufferPool pool(16, 4096);
+      Bytes large = pool.acquire(4096);
+      const Byte* largeData = large.data();
+      pool.release(std::move(large));
+      Bytes small = pool.acquire(100);
+      REQUIRE(small.data() != largeData);
+      REQUIRE(small.capacity() == 128);  // Rounded up to its size class
+      REQUIRE(pool.size() == 1);
+
+      // Requests of the same size class do reuse it
+      Bytes medium = pool.acquire(3000);
+      REQUIRE(medium.data() == largeData);
+      REQUIRE(pool.size() == 0);
+    }
+  }
+}
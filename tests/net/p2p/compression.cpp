@@ -0,0 +1,38 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "../../src/libs/catch2/catch_amalgamated.hpp"
+#include "../../src/net/p2p/compression.h"
+
+namespace TCompression {
+  TEST_CASE("P2P Compression", "[p2p][compression]") {
+    SECTION("Compression round trip") {
+      Bytes payload;
+      for (uint64_t i = 0; i < 4096; i++) Utils::appendBytes(payload, Utils::uint64ToBytes(i % 16));
+      Bytes compressed = P2P::Compression::compress(payload);
+      REQUIRE(compressed.size() < payload.size());
+      REQUIRE(Utils::bytesToUint64(Utils::create_view_span(compressed, 0, 8)) == payload.size());
+      REQUIRE(P2P::Compression::decompress(compressed, payload.size()) == payload);
+    }
+
+    SECTION("Compression rejects invalid payloads") {
+      Bytes payload(4096, 0x42);
+      Bytes compressed = P2P::Compression::compress(payload);
+      // Too large once decompressed
+      REQUIRE_THROWS(P2P::Compression::decompress(compressed, payload.size() - 1));
+      // Missing the size
+      REQUIRE_THROWS(P2P::Compression::decompress(Bytes(7, 0x00), payload.size()));
+      // Truncated stream
+      Bytes truncated(compressed.begin(), compressed.end() - 4);
+      REQUIRE_THROWS(P2P::Compression::decompress(truncated, payload.size()));
+      // Size does not match the stream
+      Bytes wrongSize = compressed;
+      wrongSize[7]--;
+      REQUIRE_THROWS(P2P::Compression::decompress(wrongSize, payload.size()));
+    }
+  }
+}
@@ -12,6 +12,7 @@ See the LICENSE.txt file in the project root for more information.
 #include "../../src/core/rdpos.h"
 #include "../../src/core/storage.h"
 #include "../../src/core/state.h"
+#include "../../src/core/syncengine.h"
 #include "../../src/utils/db.h"
 #include "../../blockchainwrapper.hpp"
 
@@ -25,6 +26,10 @@ TestBlockchainWrapper initialize(const std::vector<Hash>& validatorPrivKeys,
                                  bool clearDb,
                                  const std::string& folderName);
 
+// Creates a valid block signing every TxValidator transaction, used to give a node blocks to be synced.
+// Defined in rdpos.cpp
+Block createValidBlock(const std::vector<Hash>& validatorPrivKeys, State& state, Storage& storage, const std::vector<TxBlock>& txs = {});
+
 namespace TP2P {
 
   const std::vector<Hash> validatorPrivKeysP2P {
@@ -205,6 +210,92 @@ namespace TP2P {
       REQUIRE(p2p2NodeInfo.nodeVersion == blockchainWrapper2.options.getVersion());
       REQUIRE(p2p2NodeInfo.latestBlockHeight == blockchainWrapper2.storage.latest()->getNHeight());
       REQUIRE(p2p2NodeInfo.latestBlockHash == blockchainWrapper2.storage.latest()->hash());
+
+      // Traffic is accounted per session, compression can only shrink it
+      auto traffic = blockchainWrapper1.p2p.getSessionTraffic(p2p2NodeId);
+      REQUIRE(traffic.has_value());
+      REQUIRE(traffic->bytesSent > 0);
+      REQUIRE(traffic->bytesReceived > 0);
+      REQUIRE(traffic->payloadBytesSent >= traffic->bytesSent);
+      REQUIRE(traffic->payloadBytesReceived >= traffic->bytesReceived);
+      REQUIRE(blockchainWrapper1.p2p.getTraffic().bytesSent == traffic->bytesSent);
+    }
+
+    SECTION("2 Node Network, request blocks and sync") {
+      auto blockchainWrapper1 = initialize(validatorPrivKeysP2P, PrivKey(), 8080, true, testDumpPath + "/p2pRequestBlocksNode1");
+      auto blockchainWrapper2 = initialize(validatorPrivKeysP2P, PrivKey(), 8081, true, testDumpPath + "/p2pRequestBlocksNode2");
+
+      // Node 1 is 100 blocks ahead of node 2
+      for (uint64_t i = 0; i < 100; i++) {
+        auto block = createValidBlock(validatorPrivKeysP2P, blockchainWrapper1.state, blockchainWrapper1.storage);
+        REQUIRE(blockchainWrapper1.state.validateNextBlock(block));
+        blockchainWrapper1.state.processNextBlock(std::move(block));
+      }
+      REQUIRE(blockchainWrapper1.storage.latest()->getNHeight() == 100);
+
+      blockchainWrapper1.p2p.start();
+      blockchainWrapper2.p2p.start();
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      blockchainWrapper2.p2p.connectToServer(boost::asio::ip::address::from_string("127.0.0.1"), 8080);
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      REQUIRE(blockchainWrapper2.p2p.getSessionsIDs().size() == 1);
+      auto p2p1NodeId = blockchainWrapper2.p2p.getSessionsIDs()[0];
+
+      // Answers only have the blocks the node has
+      auto answer = blockchainWrapper2.p2p.requestBlocks(p2p1NodeId, 95, 10);
+      REQUIRE(answer.blocks.size() == 6);
+      REQUIRE(Block(answer.blocks[0], blockchainWrapper2.options.getChainID()).hash() == blockchainWrapper1.storage.getBlock(95)->hash());
+      REQUIRE(blockchainWrapper2.p2p.requestBlocks(p2p1NodeId, 101, 10).blocks.empty());
+
+      SyncEngine engine(blockchainWrapper2.p2p, blockchainWrapper2.state, blockchainWrapper2.storage, blockchainWrapper2.options, 2);
+      std::atomic<bool> stop = false;
+      auto stats = engine.sync({{p2p1NodeId, 100}}, stop);
+      REQUIRE(stats.blocks == 100);
+      REQUIRE(stats.bytes > 0);
+      REQUIRE(blockchainWrapper2.storage.latest()->getNHeight() == 100);
+      REQUIRE(blockchainWrapper2.storage.latest()->hash() == blockchainWrapper1.storage.latest()->hash());
+
+      // Nothing left to sync
+      REQUIRE(engine.sync({{p2p1NodeId, 100}}, stop).blocks == 0);
+    }
+
+    SECTION("2 Node Network, delta transaction inventory") {
+      auto blockchainWrapper1 = initialize(validatorPrivKeysP2P, PrivKey(), 8080, true, testDumpPath + "/p2pTxInventoryNode1");
+      auto blockchainWrapper2 = initialize(validatorPrivKeysP2P, PrivKey(), 8081, true, testDumpPath + "/p2pTxInventoryNode2");
+      blockchainWrapper1.p2p.start();
+      blockchainWrapper2.p2p.start();
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      blockchainWrapper2.p2p.connectToServer(boost::asio::ip::address::from_string("127.0.0.1"), 8080);
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      REQUIRE(blockchainWrapper2.p2p.getSessionsIDs().size() == 1);
+      auto p2p1NodeId = blockchainWrapper2.p2p.getSessionsIDs()[0];
+
+      // Add transactions to node 1 only, without broadcasting them
+      auto addTxs = [&](uint64_t count) {
+        for (uint64_t i = 0; i < count; i++) {
+          PrivKey privKey(Utils::randBytes(32));
+          Address me = Secp256k1::toAddress(Secp256k1::toUPub(privKey));
+          blockchainWrapper1.state.addBalance(me);
+          blockchainWrapper2.state.addBalance(me);
+          TxBlock tx(Address(Utils::randBytes(20)), me, Bytes(), 8080, 0, 1000000000000000000, 21000, 1000000000, 1000000000, privKey);
+          REQUIRE(blockchainWrapper1.state.addTx(std::move(tx)) == TxInvalid::NotInvalid);
+        }
+      };
+
+      addTxs(10);
+      auto txs = blockchainWrapper2.p2p.requestNewTxs(p2p1NodeId);
+      REQUIRE(txs.size() == 10);
+      for (auto& tx : txs) REQUIRE(blockchainWrapper2.state.addTx(std::move(tx)) == TxInvalid::NotInvalid);
+      REQUIRE(blockchainWrapper1.state.getTxInventory().sequence() == 10);
+
+      // Nothing new since the last time, then only the delta
+      REQUIRE(blockchainWrapper2.p2p.requestNewTxs(p2p1NodeId).empty());
+      addTxs(5);
+      REQUIRE(blockchainWrapper2.p2p.requestNewTxs(p2p1NodeId).size() == 5);
+      REQUIRE(blockchainWrapper2.p2p.requestNewTxs(p2p1NodeId).empty());
+
+      // Node 2 doesn't announce back what it got from node 1
+      REQUIRE(blockchainWrapper1.p2p.requestNewTxs(blockchainWrapper1.p2p.getSessionsIDs()[0]).empty());
     }
 
     SECTION("10 P2P::ManagerNormal 1 P2P::ManagerDiscovery") {
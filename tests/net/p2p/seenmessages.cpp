@@ -0,0 +1,48 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "../../src/libs/catch2/catch_amalgamated.hpp"
+#include "../../src/net/p2p/seenmessages.h"
+
+#include <thread>
+
+namespace TSeenMessages {
+  TEST_CASE("P2P SeenMessages", "[p2p][seenmessages]") {
+    SECTION("SeenMessages suppresses and counts duplicates") {
+      P2P::SeenMessages seen;
+      REQUIRE(seen.duplicate(42, P2P::BroadcastTx) == 0);
+      REQUIRE(seen.insert(42));
+      REQUIRE(!seen.insert(42));
+      REQUIRE(seen.duplicate(42, P2P::BroadcastTx) == 1);
+      REQUIRE(seen.duplicate(42, P2P::BroadcastTx) == 2);
+      REQUIRE(seen.insert(43));
+      REQUIRE(seen.duplicate(43, P2P::BroadcastBlock) == 1);
+      REQUIRE(seen.duplicates(P2P::BroadcastTx) == 2);
+      REQUIRE(seen.duplicates(P2P::BroadcastBlock) == 1);
+      REQUIRE(seen.duplicates(P2P::BroadcastValidatorTx) == 0);
+      REQUIRE(seen.size() == 2);
+    }
+
+    SECTION("SeenMessages is bounded by its capacity") {
+      P2P::SeenMessages seen(320);
+      for (uint64_t id = 0; id < 100000; id++) seen.insert(id);
+      REQUIRE(seen.size() <= 320);
+      REQUIRE(!seen.insert(99999)); // Recent IDs are still there
+      REQUIRE(seen.insert(0));      // Old ones were dropped
+    }
+
+    SECTION("SeenMessages forgets IDs after two windows") {
+      P2P::SeenMessages seen(131072, std::chrono::milliseconds(50));
+      REQUIRE(seen.insert(42));
+      std::this_thread::sleep_for(std::chrono::milliseconds(60));
+      REQUIRE(!seen.insert(42));  // One window old, promoted back to the current generation
+      std::this_thread::sleep_for(std::chrono::milliseconds(120));
+      REQUIRE(seen.size() == 1);
+      REQUIRE(seen.insert(42));   // Untouched for two windows
+    }
+  }
+}
@@ -119,11 +119,13 @@ class SDKTestSuite {
      * @param sdkPath Path to the SDK folder.
      * @param accounts (optional) List of accounts to initialize the blockchain with. Defaults to none (empty vector).
      * @param options (optional) Options to initialize the blockchain with. Defaults to none (nullptr).
+     * @param parallelExecution (optional) Turn on parallel execution in the default options. Ignored if `options` is given. Defaults to false.
      */
     static SDKTestSuite createNewEnvironment(
       const std::string& sdkPath,
       const std::vector<TestAccount>& accounts = {},
-      const Options* const options = nullptr
+      const Options* const options = nullptr,
+      const bool parallelExecution = false
     ) {
       // Initialize the DB
       std::string dbPath = sdkPath + "/db";
@@ -170,7 +172,8 @@ class SDKTestSuite {
           genesisTimestamp,
           genesisSigner,
           genesisBalances,
-          genesisValidators
+          genesisValidators,
+          parallelExecution
         );
       } else {
         options_ = std::make_unique<Options>(*options);
@@ -197,13 +200,12 @@ class SDKTestSuite {
     }
 
     /**
-     * Create a new valid block, finalize it, and add it to the chain.
+     * Create a new valid block on top of the latest one and finalize it, without adding it to the chain.
      * @param timestamp (optional) Timestamp to use for the block in microseconds. Defaults to 0.
      * @param txs (optional) List of transactions to include in the block. Defaults to none (empty vector).
-     * @return A pointer to the new block.
+     * @return The finalized block.
      */
-    const std::shared_ptr<const Block> advanceChain(const uint64_t& timestamp = 0, const std::vector<TxBlock>& txs = {}) {
-      std::cout << "Creating a new block..." << std::endl;
+    Block createNewBlock(const uint64_t& timestamp = 0, const std::vector<TxBlock>& txs = {}) {
       auto validators = state_.rdposGetValidators();
       auto randomList = state_.rdposGetRandomList();
       Hash blockSignerPrivKey;           // Private key for the block signer.
@@ -269,6 +271,18 @@ class SDKTestSuite {
       } else {
         newBlock.finalize(blockSignerPrivKey, timestamp);
       }
+      return newBlock;
+    }
+
+    /**
+     * Create a new valid block, finalize it, and add it to the chain.
+     * @param timestamp (optional) Timestamp to use for the block in microseconds. Defaults to 0.
+     * @param txs (optional) List of transactions to include in the block. Defaults to none (empty vector).
+     * @return A pointer to the new block.
+     */
+    const std::shared_ptr<const Block> advanceChain(const uint64_t& timestamp = 0, const std::vector<TxBlock>& txs = {}) {
+      std::cout << "Creating a new block..." << std::endl;
+      Block newBlock = this->createNewBlock(timestamp, txs);
 
       // After finalization, the block should be valid. If it is, process the next one.
       if (!this->state_.validateNextBlock(newBlock)) throw DynamicException(
@@ -166,6 +166,30 @@ namespace TBlock {
       REQUIRE(newBlock.isFinalized() == false);
     }
 
+    SECTION("Block rebuilt from its header and transactions") {
+      PrivKey validatorPrivKey(Hex::toBytes("0x4d5db4107d237df6a3d58ee5f70ae63d73d765d8a1214214d8a13340d0f2750d"));
+      Hash nPrevBlockHash(Hex::toBytes("97a5ebd9bbb5e330b0b3c74b9816d595ffb7a04d4a29fb117ea93f8a333b43be"));
+      uint64_t timestamp = 1678400843315;
+      Block newBlock = Block(nPrevBlockHash, timestamp, 100);
+      TxBlock tx(Hex::toBytes("0x02f874821f9080849502f900849502f900825208942e951aa58c8b9b504a97f597bbb2765c011a8802880de0b6b3a764000080c001a0f56fe87778b4420d3b0f8eba91d28093abfdbea281a188b8516dd8411dc223d7a05c2d2d71ad3473571ff637907d72e6ac399fe4804641dbd9e2d863586c57717d"), 1);
+      for (uint64_t i = 0; i < 10; i++) newBlock.appendTx(tx);
+      newBlock.finalize(validatorPrivKey, timestamp+1);
+
+      Bytes header(newBlock.getValidatorSig().cbegin(), newBlock.getValidatorSig().cend());
+      Utils::appendBytes(header, newBlock.serializeHeader());
+      Block rebuiltBlock(header, std::vector<TxBlock>(newBlock.getTxs()), std::vector<TxValidator>(newBlock.getTxValidators()));
+      REQUIRE(rebuiltBlock == newBlock);
+      REQUIRE(rebuiltBlock.getTxs() == newBlock.getTxs());
+      REQUIRE(rebuiltBlock.getValidatorPubKey() == newBlock.getValidatorPubKey());
+      REQUIRE(rebuiltBlock.isFinalized());
+      REQUIRE(rebuiltBlock.serializeBlock() == newBlock.serializeBlock());
+
+      // Transactions that don't match the header are rejected
+      std::vector<TxBlock> missingTx(newBlock.getTxs().begin(), newBlock.getTxs().end() - 1);
+      REQUIRE_THROWS(Block(header, std::move(missingTx), {}));
+      REQUIRE_THROWS(Block(BytesArrView(header).subspan(0, 208), std::vector<TxBlock>(newBlock.getTxs()), {}));
+    }
+
 
     SECTION("Block creation with 64 TxBlock transactions and 16 TxValidator transactions") {
       // There is 16 TxValidator transactions, but only 8 of them are used for block randomness.
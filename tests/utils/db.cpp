@@ -85,6 +85,21 @@ namespace TDB {
         }
       }
 
+      // Read specific keys (plus one that doesn't exist)
+      std::vector<Bytes> someKeys;
+      for (int i = 0; i < 32; i += 4) {
+        const Bytes& fullKey = batchP.getPuts()[i].key;
+        someKeys.emplace_back(fullKey.begin() + pfx.size(), fullKey.end());
+      }
+      someKeys.insert(someKeys.begin() + 1, Hash::random().asBytes());
+      std::vector<DBEntry> multiB = db.multiGet(pfx, someKeys);
+      REQUIRE(multiB.size() == someKeys.size() - 1);
+      for (size_t i = 0; i < multiB.size(); i++) {
+        // Results keep the requested order and have no prefix
+        REQUIRE(multiB[i].key == someKeys[(i == 0) ? 0 : i + 1]);
+        REQUIRE(multiB[i].value == db.get(multiB[i].key, pfx));
+      }
+
       // Update
       DBBatch newPutB;
       for (int i = 0; i < 32; i++) {
@@ -118,7 +133,49 @@ namespace TDB {
       REQUIRE(!db.has(Utils::stringToBytes("dummy")));
       REQUIRE(db.get(Utils::stringToBytes("dummy")).empty());
       REQUIRE(db.getBatch(Utils::stringToBytes("0001"), {Utils::stringToBytes(("dummy"))}).empty());
+      REQUIRE(db.multiGet(Utils::stringToBytes("0001"), {Utils::stringToBytes(("dummy"))}).empty());
+      REQUIRE(db.close());
+    }
+
+    SECTION("Column families (routing, migration and stats)") {
+      std::filesystem::remove_all(std::filesystem::current_path().string() + "/testDB");
+      // Write a few entries with the old single keyspace layout
+      Bytes blockKey = DB::makeNewPrefix(DBPrefix::blocks, "latest");
+      Bytes accKey = DBPrefix::nativeAccounts;
+      Utils::appendBytes(accKey, Hash::random().asBytes());
+      Bytes unknownKey = Utils::stringToBytes("unknown");
+      {
+        rocksdb::Options opts;
+        opts.create_if_missing = true;
+        rocksdb::DB* raw = nullptr;
+        REQUIRE(rocksdb::DB::Open(opts, "testDB", &raw).ok());
+        for (const Bytes& key : {blockKey, accKey, unknownKey}) {
+          rocksdb::Slice keySlice(reinterpret_cast<const char*>(key.data()), key.size());
+          REQUIRE(raw->Put(rocksdb::WriteOptions(), keySlice, keySlice).ok());
+        }
+        delete raw;
+      }
+
+      // Opening it moves known prefixes to their own families, everything stays readable
+      DB db("testDB");
+      for (const Bytes& key : {blockKey, accKey, unknownKey}) {
+        REQUIRE(db.has(key));
+        REQUIRE(db.get(key) == key);
+      }
+      REQUIRE(db.getBatch(DBPrefix::nativeAccounts).size() == 1);
+      REQUIRE(db.getKeys(DBPrefix::blocks).size() == 1);
+
+      std::vector<DBFamilyStats> stats = db.getStats();
+      REQUIRE(stats.size() == DB::families.size() + 1); // Plus "default"
+      uint64_t totalCache = 0;
+      for (const DBFamilyStats& stat : stats) totalCache += stat.blockCacheCapacity;
+      REQUIRE(totalCache > 0);
       REQUIRE(db.close());
+
+      // Reopening does not migrate anything again
+      DB db2("testDB");
+      REQUIRE(db2.get(blockKey) == blockKey);
+      REQUIRE(db2.close());
     }
 
     // Clean up last test so DB creation can be properly tested next time
@@ -0,0 +1,113 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "../../src/libs/catch2/catch_amalgamated.hpp"
+#include "../../src/utils/logger.h"
+#include "../../src/utils/mpscringbuffer.h"
+
+#include <fstream>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace TLogger {
+  TEST_CASE("MPSCRingBuffer Class", "[utils][logger]") {
+    SECTION("MPSCRingBuffer push/pop in order and fails when full") {
+      MPSCRingBuffer<std::string> buffer(3); // Rounded up to 4
+      REQUIRE(buffer.capacity() == 4);
+      REQUIRE(buffer.empty());
+      REQUIRE(!buffer.tryPop());
+      for (int i = 0; i < 4; i++) REQUIRE(buffer.tryPush(std::to_string(i)));
+      std::string extra = "extra";
+      REQUIRE(!buffer.tryPush(std::move(extra)));
+      REQUIRE(extra == "extra"); // Not moved from on failure
+      REQUIRE(*buffer.tryPop() == "0");
+      REQUIRE(buffer.tryPush(std::move(extra)));
+      for (auto expected : {"1", "2", "3", "extra"}) REQUIRE(*buffer.tryPop() == expected);
+      REQUIRE(buffer.empty());
+    }
+
+    SECTION("MPSCRingBuffer with concurrent producers") {
+      MPSCRingBuffer<uint64_t> buffer(64);
+      const uint64_t producers = 4;
+      const uint64_t perProducer = 10000;
+      std::vector<std::thread> threads;
+      for (uint64_t p = 0; p < producers; p++) {
+        threads.emplace_back([&buffer, p, perProducer]() {
+          for (uint64_t i = 0; i < perProducer; i++) {
+            uint64_t value = p * perProducer + i;
+            while (!buffer.tryPush(std::move(value))) std::this_thread::yield();
+          }
+        });
+      }
+      std::set<uint64_t> seen;
+      std::vector<uint64_t> lastByProducer(producers, 0);
+      bool ordered = true;
+      while (seen.size() < producers * perProducer) {
+        auto value = buffer.tryPop();
+        if (!value) { std::this_thread::yield(); continue; }
+        uint64_t p = *value / perProducer;
+        uint64_t i = *value % perProducer;
+        if (i != 0 && lastByProducer[p] + 1 != i) ordered = false; // Each producer's items keep their order
+        lastByProducer[p] = i;
+        seen.insert(*value);
+      }
+      for (auto& thread : threads) thread.join();
+      REQUIRE(ordered);
+      REQUIRE(seen.size() == producers * perProducer);
+      REQUIRE(buffer.empty());
+    }
+  }
+
+  TEST_CASE("Logger Class", "[utils][logger]") {
+    SECTION("Logger runtime level and module filters") {
+      LogType previous = Logger::getLevel();
+      Logger::setLevel(LogType::WARNING);
+      REQUIRE(!Logger::enabled(LogType::INFO, Log::state));
+      REQUIRE(Logger::enabled(LogType::ERROR, Log::state));
+      Logger::setModuleLevel(Log::state, LogType::DEBUG);
+      REQUIRE(Logger::enabled(LogType::INFO, Log::state));
+      REQUIRE(!Logger::enabled(LogType::INFO, Log::storage));
+      Logger::clearModuleLevel(Log::state);
+      REQUIRE(!Logger::enabled(LogType::INFO, Log::state));
+
+      // Disabled messages are never built
+      bool built = false;
+      auto build = [&]() { built = true; return std::string("message"); };
+      LOGINFO(Log::state, build());
+      REQUIRE(!built);
+      Logger::setLevel(previous);
+    }
+
+    SECTION("Logger parses level names") {
+      REQUIRE(Logger::levelFromString("DEBUG") == LogType::DEBUG);
+      REQUIRE(Logger::levelFromString("info") == LogType::INFO);
+      REQUIRE(Logger::levelFromString("Warning") == LogType::WARNING);
+      REQUIRE(Logger::levelFromString("ERROR") == LogType::ERROR);
+      REQUIRE_THROWS(Logger::levelFromString("VERBOSE"));
+    }
+
+    SECTION("Logger rotates files") {
+      std::filesystem::path dir = std::filesystem::temp_directory_path() / "loggerRotationTest";
+      std::filesystem::remove_all(dir);
+      std::filesystem::create_directories(dir);
+      std::filesystem::path file = dir / "test.log";
+      for (int i = 0; i < 4; i++) {
+        std::ofstream(file) << i;
+        Logger::rotateFiles(file, 2);
+      }
+      REQUIRE(!std::filesystem::exists(file));
+      std::string newest, oldest;
+      std::ifstream(dir / "test.log.1") >> newest;
+      std::ifstream(dir / "test.log.2") >> oldest;
+      REQUIRE(newest == "3");
+      REQUIRE(oldest == "2");
+      REQUIRE(!std::filesystem::exists(dir / "test.log.3"));
+      std::filesystem::remove_all(dir);
+    }
+  }
+}
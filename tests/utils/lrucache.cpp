@@ -0,0 +1,56 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "../../src/libs/catch2/catch_amalgamated.hpp"
+#include "../../src/utils/lrucache.h"
+#include "../../src/utils/safehash.h"
+
+namespace TLRUCache {
+  TEST_CASE("LRUCache Class", "[utils][lrucache]") {
+    SECTION("LRUCache put/get/erase") {
+      LRUCache<Hash, uint64_t, SafeHash> cache(10);
+      Hash a(Utils::randBytes(32));
+      Hash b(Utils::randBytes(32));
+      cache.put(a, 1, 4);
+      cache.put(b, 2, 4);
+      REQUIRE(cache.size() == 2);
+      REQUIRE(cache.cost() == 8);
+      REQUIRE(*cache.get(a) == 1);
+      REQUIRE(*cache.get(b) == 2);
+      cache.put(a, 3, 2); // Replacing updates both the value and the cost
+      REQUIRE(*cache.get(a) == 3);
+      REQUIRE(cache.cost() == 6);
+      REQUIRE(cache.erase(b));
+      REQUIRE(!cache.erase(b));
+      REQUIRE(cache.get(b) == nullptr);
+      REQUIRE(cache.size() == 1);
+      REQUIRE(cache.cost() == 2);
+    }
+
+    SECTION("LRUCache trim evicts least recently used first") {
+      LRUCache<Hash, uint64_t, SafeHash> cache(3);
+      std::vector<Hash> keys;
+      for (uint64_t i = 0; i < 5; i++) {
+        keys.emplace_back(Utils::randBytes(32));
+        cache.put(keys.back(), i);
+      }
+      // Nothing is evicted until trim() is called
+      REQUIRE(cache.size() == 5);
+      REQUIRE(cache.touch(keys[0]));
+      std::vector<uint64_t> evicted;
+      REQUIRE(cache.trim([&](const Hash&, uint64_t& value) { evicted.push_back(value); }) == 2);
+      REQUIRE(evicted == std::vector<uint64_t>{1, 2});
+      REQUIRE(cache.size() == 3);
+      REQUIRE(cache.contains(keys[0]));
+      REQUIRE(!cache.contains(keys[1]));
+      REQUIRE(!cache.contains(keys[2]));
+      cache.setBudget(0);
+      REQUIRE(cache.trim() == 3);
+      REQUIRE(cache.cost() == 0);
+    }
+  }
+}
@@ -0,0 +1,68 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "../../src/libs/catch2/catch_amalgamated.hpp"
+#include "../../src/utils/metrics.h"
+
+#include <thread>
+
+namespace TMetrics {
+  TEST_CASE("Metrics Namespace", "[utils][metrics]") {
+    SECTION("Counter adds up every thread's shard") {
+      Metrics::Counter counter;
+      std::vector<std::thread> threads;
+      for (int i = 0; i < 8; i++) {
+        threads.emplace_back([&counter]() { for (int j = 0; j < 1000; j++) counter.inc(); });
+      }
+      for (auto& thread : threads) thread.join();
+      counter.inc(5);
+      REQUIRE(counter.value() == 8005);
+    }
+
+    SECTION("Histogram puts values in cumulative buckets") {
+      Metrics::Histogram histogram({0.1, 1, 10});
+      histogram.observe(0.05);
+      histogram.observe(0.1);
+      histogram.observe(5);
+      histogram.observe(50);
+      auto snapshot = histogram.snapshot();
+      REQUIRE(snapshot.buckets == std::vector<uint64_t>{2, 2, 3, 4});
+      REQUIRE(snapshot.count == 4);
+      REQUIRE(snapshot.sum == Catch::Approx(55.15));
+    }
+
+    SECTION("Registry returns the same series for the same name and labels") {
+      Metrics::Registry registry;
+      Metrics::Counter& calls = registry.counter("test_calls_total", "Calls.", "method=\"a\"");
+      REQUIRE(&calls == &registry.counter("test_calls_total", "Calls.", "method=\"a\""));
+      REQUIRE(&calls != &registry.counter("test_calls_total", "Calls.", "method=\"b\""));
+      REQUIRE_THROWS(registry.gauge("test_calls_total", "Calls."));
+    }
+
+    SECTION("Registry serializes in the Prometheus text format") {
+      Metrics::Registry registry;
+      registry.counter("test_calls_total", "Calls.", "method=\"a\"").inc(3);
+      registry.gauge("test_height", "Height.").set(-2);
+      registry.histogram("test_seconds", "Latency.", "", {0.5, 1}).observe(0.75);
+      REQUIRE(registry.serialize() ==
+        "# HELP test_calls_total Calls.\n"
+        "# TYPE test_calls_total counter\n"
+        "test_calls_total{method=\"a\"} 3\n"
+        "# HELP test_height Height.\n"
+        "# TYPE test_height gauge\n"
+        "test_height -2\n"
+        "# HELP test_seconds Latency.\n"
+        "# TYPE test_seconds histogram\n"
+        "test_seconds_bucket{le=\"0.5\"} 0\n"
+        "test_seconds_bucket{le=\"1\"} 1\n"
+        "test_seconds_bucket{le=\"+Inf\"} 1\n"
+        "test_seconds_sum 0.75\n"
+        "test_seconds_count 1\n"
+      );
+    }
+  }
+}
@@ -57,7 +57,17 @@ namespace TOptions {
         genesisPrivKey,
         genesisBalances,
         genesisValidators,
-        PrivKey(Hex::toBytes("0xb254f12b4ca3f0120f305cabf1188fe74f0bd38e58c932a3df79c4c55df8fa66"))
+        PrivKey(Hex::toBytes("0xb254f12b4ca3f0120f305cabf1188fe74f0bd38e58c932a3df79c4c55df8fa66")),
+        true,
+        4,
+        true,
+        50,
+        "INFO",
+        {{"P2P::Manager", "WARNING"}},
+        1024,
+        2,
+        4096,
+        2048
       );
 
       Options optionsFromFileWithPrivKey(Options::fromFile(testDumpPath + "/optionClassFromFileWithPrivKey"));
@@ -75,6 +85,16 @@ namespace TOptions {
       REQUIRE(optionsFromFileWithPrivKey.getGenesisBlock() == optionsWithPrivKey.getGenesisBlock());
       REQUIRE(optionsFromFileWithPrivKey.getGenesisBalances() == optionsWithPrivKey.getGenesisBalances());
       REQUIRE(optionsFromFileWithPrivKey.getGenesisValidators() == optionsWithPrivKey.getGenesisValidators());
+      REQUIRE(optionsFromFileWithPrivKey.getParallelExecution() == true);
+      REQUIRE(optionsFromFileWithPrivKey.getExecutionThreads() == 4);
+      REQUIRE(optionsFromFileWithPrivKey.getActivityFeed() == true);
+      REQUIRE(optionsFromFileWithPrivKey.getRpcMaxBatchSize() == 50);
+      REQUIRE(optionsFromFileWithPrivKey.getLogLevel() == "INFO");
+      REQUIRE(optionsFromFileWithPrivKey.getLogModuleLevels() == optionsWithPrivKey.getLogModuleLevels());
+      REQUIRE(optionsFromFileWithPrivKey.getLogRotateBytes() == 1024);
+      REQUIRE(optionsFromFileWithPrivKey.getLogRotateFiles() == 2);
+      REQUIRE(optionsFromFileWithPrivKey.getEvmStorageCacheBytes() == 4096);
+      REQUIRE(optionsFromFileWithPrivKey.getEvmCodeCacheBytes() == 2048);
     }
   }
 }
@@ -0,0 +1,51 @@
+/*
+Copyright (c) [2023-2024] [Sparq Network]
+
+This software is distributed under the MIT License.
+See the LICENSE.txt file in the project root for more information.
+*/
+
+#include "../../src/libs/catch2/catch_amalgamated.hpp"
+#include "../../src/utils/sigverifier.h"
+#include "../../src/utils/tx.h"
+
+namespace TSigVerifier {
+  // Creates `count` signed transactions from random senders
+  std::vector<TxBlock> createTxs(uint64_t count) {
+    std::vector<TxBlock> txs;
+    for (uint64_t i = 0; i < count; i++) {
+      PrivKey privKey(Utils::randBytes(32));
+      txs.emplace_back(
+        Address(Utils::randBytes(20)), Secp256k1::toAddress(Secp256k1::toUPub(privKey)),
+        Bytes(), 8080, i, 1000000000, 21000, 1000000000, 1000000000, privKey
+      );
+    }
+    return txs;
+  }
+
+  TEST_CASE("SigVerifier Class", "[utils][sigverifier]") {
+    SECTION("SigVerifier verifyBatch keeps order and recovers senders") {
+      for (uint64_t count : {0, 1, 15, 500}) {
+        std::vector<TxBlock> txs = createTxs(count);
+        std::vector<Bytes> serialized;
+        for (const TxBlock& tx : txs) serialized.emplace_back(tx.rlpSerialize());
+        std::vector<BytesArrView> raw(serialized.begin(), serialized.end());
+        std::vector<TxBlock> verified = SigVerifier::instance().verifyBatch<TxBlock>(raw, 8080);
+        REQUIRE(verified.size() == txs.size());
+        for (uint64_t i = 0; i < txs.size(); i++) {
+          REQUIRE(verified[i] == txs[i]);
+          REQUIRE(verified[i].getFrom() == txs[i].getFrom());
+        }
+      }
+    }
+
+    SECTION("SigVerifier verifyBatch throws on invalid transactions") {
+      std::vector<TxBlock> txs = createTxs(200);
+      std::vector<Bytes> serialized;
+      for (const TxBlock& tx : txs) serialized.emplace_back(tx.rlpSerialize());
+      serialized[137] = Bytes{0x01, 0xf8}; // Not a type 2 tx
+      std::vector<BytesArrView> raw(serialized.begin(), serialized.end());
+      REQUIRE_THROWS(SigVerifier::instance().verifyBatch<TxBlock>(raw, 8080));
+    }
+  }
+}